@@ -12,9 +12,11 @@
 #include <cstdio>
 #include <limits>
 #include <sstream>
+#include <utility>
 #include "../game.hpp"
 #include "../gfx/blit.hpp"
 #include "../gfx/renderer.hpp"
+#include "../profiling.hpp"
 #include "../stats.hpp"
 
 static double TotalHealth(Worm* w) {
@@ -444,9 +446,9 @@ static void Evaluate(EvaluateResult& result, FollowAI& ai, Worm* me, Game& game,
   }
   result.score_over_time[0] = 0.0;
 
-  std::vector<int> weapon_changes_left;
+  std::vector<int>& weapon_changes_left = ai.weapon_changes_left;
   if (ms.type == kMtOptimize) {
-    weapon_changes_left.resize(plan_size);
+    weapon_changes_left.assign(plan_size, 0);
     int changes_left = 0;
     for (std::size_t j = std::min(plan_size, plan.size()); j-- > 0;) {
       if (plan[j].IsFiring()) {
@@ -506,7 +508,7 @@ static void Evaluate(EvaluateResult& result, FollowAI& ai, Worm* me, Game& game,
       simple_ai.Process(copy, *target_copy);
     }
 
-    copy.ProcessFrame();
+    copy.ProcessFrame<Game::FrameMode::kSimOnly>();
 
     // NOLINTNEXTLINE(readability-suspicious-call-argument) — see comment on the call above; `copy` is sandbox, `game` is the original.
     double const kS = EvaluateState(ai, me_copy, copy, context, target_copy, game, i + 1);
@@ -595,6 +597,7 @@ struct MutateWork : Work {
 #endif
 
 void FollowAI::Process(Game& game, Worm& worm) {
+  ZoneScopedN("AI::Process");
   Common& common = *game.common;
 
   Worm* target = game.worms[worm.index ^ 1].get();
@@ -624,7 +627,7 @@ void FollowAI::Process(Game& game, Worm& worm) {
 
     evaluation_budget += (game.settings->ai_mutations + 1) * game.settings->ai_frames;
 
-    std::vector<std::pair<double, int>> prio;
+    prio.clear();
 
     for (cand_idx = 0; cand_idx < cand_plan.size(); ++cand_idx) {
       auto& cand = cand_plan[cand_idx];
@@ -658,17 +661,19 @@ void FollowAI::Process(Game& game, Worm& worm) {
 
     for (cand_idx = 0; evaluation_budget > 0;) {
       auto& cand = cand_plan[prio[cand_idx].second];
-      auto candidate = cand.plan;
-      EvaluateResult result;
-      Mutate(result, *this, game, worm, target, candidate, cand.prev_result);
+      // Copy-assign into the scratch plan so its buffer is reused; a win
+      // swaps buffers with the candidate instead of giving one up.
+      mutate_plan = cand.plan;
+      mutate_result.score_over_time.clear();
+      Mutate(mutate_result, *this, game, worm, target, mutate_plan, cand.prev_result);
       evaluation_budget -= game.settings->ai_frames;
 
-      double const kWeightedScore = result.WeightedScore();
+      double const kWeightedScore = mutate_result.WeightedScore();
       if (kWeightedScore > best_score) {
-        cand.plan = std::move(candidate);
+        std::swap(cand.plan, mutate_plan);
         best = &cand;
         best_score = kWeightedScore;
-        cand.prev_result = std::move(result);
+        std::swap(cand.prev_result, mutate_result);
         cand.prev_result_age = 0;
       } else {
         cand_idx = (cand_idx + 1) % cand_plan.size();
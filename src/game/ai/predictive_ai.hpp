@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <functional>
 #include <numeric>
+#include <utility>
+#include <vector>
 #include "../math.hpp"
 #include "../rand.hpp"
 #include "../worm.hpp"
@@ -355,6 +357,13 @@ struct FollowAI : WormAI, AiContext {
   std::vector<CandPlan> cand_plan;
   CandPlan* best{nullptr};
 
+  // Scratch for Process() and Evaluate(), kept so that thinking doesn't
+  // allocate once their capacity has settled.
+  std::vector<std::pair<double, int>> prio;
+  Plan mutate_plan;
+  EvaluateResult mutate_result;
+  std::vector<int> weapon_changes_left;
+
   bool testing;
 
 #if AI_THREADS
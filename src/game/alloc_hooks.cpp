@@ -0,0 +1,121 @@
+// Replacement global operator new/delete that report every allocation to
+// alloc_tracker (see alloc_tracker.hpp). Built as the `alloc_hooks` object
+// library rather than into `game`, so only the targets that ask for the
+// counting get the replacement.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_tracker.hpp"
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace {
+
+// Runs during static initialisation of whatever links this file.
+[[maybe_unused]] bool const kInstalled = (alloc_tracker::MarkInstalled(), true);
+
+void* TryAllocate(std::size_t size, std::size_t align) noexcept {
+  if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return std::malloc(size);
+  }
+#ifdef _MSC_VER
+  return _aligned_malloc(size, align);
+#else
+  // aligned_alloc wants a multiple of the alignment.
+  return std::aligned_alloc(align, (size + align - 1) & ~(align - 1));
+#endif
+}
+
+void Release(void* p, std::size_t align) noexcept {
+#ifdef _MSC_VER
+  if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    _aligned_free(p);
+    return;
+  }
+#else
+  (void)align;
+#endif
+  std::free(p);
+}
+
+void* Allocate(std::size_t size, std::size_t align) {
+  alloc_tracker::Record(size);
+  if (size == 0) {
+    size = 1;
+  }
+  for (;;) {
+    if (void* p = TryAllocate(size, align)) {
+      return p;
+    }
+    std::new_handler const kHandler = std::get_new_handler();
+    if (!kHandler) {
+      throw std::bad_alloc();
+    }
+    kHandler();
+  }
+}
+
+void* AllocateNoThrow(std::size_t size, std::size_t align) noexcept {
+  try {
+    return Allocate(size, align);
+  } catch (std::bad_alloc const&) {
+    return nullptr;
+  }
+}
+
+constexpr std::size_t kDefault = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+}  // namespace
+
+// NOLINTBEGIN(misc-new-delete-overloads) — the full replaceable set, all
+// forwarding to the helpers above.
+void* operator new(std::size_t size) { return Allocate(size, kDefault); }
+void* operator new[](std::size_t size) { return Allocate(size, kDefault); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+  return AllocateNoThrow(size, kDefault);
+}
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+  return AllocateNoThrow(size, kDefault);
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+  return Allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return Allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new(std::size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+  return AllocateNoThrow(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+  return AllocateNoThrow(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { Release(p, kDefault); }
+void operator delete[](void* p) noexcept { Release(p, kDefault); }
+void operator delete(void* p, std::size_t /*size*/) noexcept { Release(p, kDefault); }
+void operator delete[](void* p, std::size_t /*size*/) noexcept { Release(p, kDefault); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { Release(p, kDefault); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { Release(p, kDefault); }
+void operator delete(void* p, std::align_val_t align) noexcept {
+  Release(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::align_val_t align) noexcept {
+  Release(p, static_cast<std::size_t>(align));
+}
+void operator delete(void* p, std::size_t /*size*/, std::align_val_t align) noexcept {
+  Release(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::size_t /*size*/, std::align_val_t align) noexcept {
+  Release(p, static_cast<std::size_t>(align));
+}
+void operator delete(void* p, std::align_val_t align, std::nothrow_t const&) noexcept {
+  Release(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::align_val_t align, std::nothrow_t const&) noexcept {
+  Release(p, static_cast<std::size_t>(align));
+}
+// NOLINTEND(misc-new-delete-overloads)
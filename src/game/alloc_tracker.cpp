@@ -0,0 +1,92 @@
+#include "alloc_tracker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+
+namespace alloc_tracker {
+
+namespace {
+
+char const kOtherZones[] = "(other zones)";
+
+// Record() runs inside operator new, so this state must never allocate:
+// constant-initialised, trivially destructible and fixed size.
+struct ThreadState {
+  Counts total;
+  char const* zone{nullptr};
+  std::array<ZoneCounts, kMaxZones> zones{};
+  std::size_t zone_count{0};
+};
+
+constinit thread_local ThreadState t_state;
+constinit std::atomic<bool> g_installed{false};
+
+ZoneCounts& Slot(ThreadState& s, char const* name) {
+  for (std::size_t i = 0; i < s.zone_count; ++i) {
+    if (s.zones[i].name == name) {
+      return s.zones[i];
+    }
+  }
+  if (s.zone_count < kMaxZones - 1) {
+    s.zones[s.zone_count].name = name;
+    return s.zones[s.zone_count++];
+  }
+  // The last slot collects whatever doesn't fit.
+  ZoneCounts& other = s.zones[kMaxZones - 1];
+  other.name = kOtherZones;
+  s.zone_count = kMaxZones;
+  return other;
+}
+
+}  // namespace
+
+bool Installed() { return g_installed.load(std::memory_order_relaxed); }
+
+Counts ThreadCounts() { return t_state.total; }
+
+Zone::Zone(char const* name) : parent_(t_state.zone) { t_state.zone = name; }
+
+Zone::~Zone() { t_state.zone = parent_; }
+
+std::vector<ZoneCounts> ThreadZones() {
+  // Copy first: the vector's own allocation would otherwise land in the
+  // table while it's being read.
+  ThreadState const kState = t_state;
+  std::vector<ZoneCounts> zones(kState.zones.begin(), kState.zones.begin() + kState.zone_count);
+  std::ranges::stable_sort(zones, [](ZoneCounts const& a, ZoneCounts const& b) {
+    return a.counts.allocations > b.counts.allocations;
+  });
+  return zones;
+}
+
+void ResetThreadZones() {
+  t_state.zones = {};
+  t_state.zone_count = 0;
+}
+
+void PrintThreadReport(std::FILE* out) {
+  Counts const kTotal = ThreadCounts();
+  std::fprintf(out, "[alloc] %" PRIu64 " allocations, %" PRIu64 " bytes on this thread\n",
+               kTotal.allocations, kTotal.bytes);
+  for (ZoneCounts const& z : ThreadZones()) {
+    std::fprintf(out, "[alloc]   %-40s %10" PRIu64 " allocations %12" PRIu64 " bytes\n", z.name,
+                 z.counts.allocations, z.counts.bytes);
+  }
+}
+
+void Record(std::size_t bytes) noexcept {
+  ThreadState& s = t_state;
+  ++s.total.allocations;
+  s.total.bytes += bytes;
+  if (s.zone) {
+    ZoneCounts& z = Slot(s, s.zone);
+    ++z.counts.allocations;
+    z.counts.bytes += bytes;
+  }
+}
+
+void MarkInstalled() noexcept { g_installed.store(true, std::memory_order_relaxed); }
+
+}  // namespace alloc_tracker
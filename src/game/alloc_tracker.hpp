@@ -0,0 +1,74 @@
+#pragma once
+
+// Heap allocation counting, for keeping per-frame paths allocation-free.
+//
+// alloc_hooks.cpp replaces the global operator new/delete with versions
+// that report every allocation to Record(). It is linked only where the
+// counting is wanted: the allocation tests always link it, the game does
+// when configured with -DOPENLIERO_ENABLE_ALLOC_TRACKING=ON. Without it
+// Installed() is false and every count stays zero.
+//
+// Counts are per thread, so work handed to other threads (the stats
+// consumer, ParallelFor helpers) never shows up on the thread measuring.
+// Each allocation is also charged to the innermost live Zone on its
+// thread; with tracking enabled, ZoneScoped/ZoneScopedN (profiling.hpp)
+// open one, so the report follows the Tracy zones.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace alloc_tracker {
+
+struct Counts {
+  uint64_t allocations{0};
+  uint64_t bytes{0};
+
+  Counts operator-(Counts const& other) const {
+    return {.allocations = allocations - other.allocations, .bytes = bytes - other.bytes};
+  }
+};
+
+struct ZoneCounts {
+  char const* name{nullptr};
+  Counts counts;
+};
+
+// True when the counting operator new is linked into this program.
+bool Installed();
+
+// Everything allocated on the calling thread so far.
+Counts ThreadCounts();
+
+// Charges the calling thread's allocations to `name` until destroyed.
+// Zones nest; an allocation counts towards the innermost one only. `name`
+// identifies the zone by address, so it must be a string literal (or
+// otherwise outlive the report).
+class Zone {
+ public:
+  explicit Zone(char const* name);
+  ~Zone();
+  Zone(Zone const&) = delete;
+  Zone& operator=(Zone const&) = delete;
+
+ private:
+  char const* parent_;
+};
+
+// Per-zone counts on the calling thread since the last ResetThreadZones(),
+// most allocations first. A thread keeps kMaxZones distinct zones; the
+// rest are lumped under "(other zones)". Allocates, so call it outside
+// the code being measured.
+constexpr std::size_t kMaxZones = 64;
+std::vector<ZoneCounts> ThreadZones();
+void ResetThreadZones();
+
+// Prints ThreadCounts() and ThreadZones() to `out`.
+void PrintThreadReport(std::FILE* out);
+
+// The hooks' side. Neither allocates.
+void Record(std::size_t bytes) noexcept;
+void MarkInstalled() noexcept;
+
+}  // namespace alloc_tracker
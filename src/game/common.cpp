@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <map>
+#include <span>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -273,10 +274,12 @@ static int ReadSpriteTga(io::Reader& r, int dest_image_width, int dest_image_hei
     // Quantize the 24-bit TGA palette to the classic 6-bit VGA grid
     // (entries are 8-bit; dropping the low 2 bits keeps classic rendering
     // byte-identical to the original >>2-then-<<2 pipeline).
-    for (auto& entry : pal->entries) {
-      entry.b = r.Get() & 0xfc;
-      entry.g = r.Get() & 0xfc;
-      entry.r = r.Get() & 0xfc;
+    std::vector<uint8_t> scratch;
+    std::span<uint8_t const> const kBgr = r.Borrow(256 * 3, scratch);
+    for (std::size_t i = 0; i < 256; ++i) {
+      pal->entries[i].b = kBgr[(i * 3) + 0] & 0xfc;
+      pal->entries[i].g = kBgr[(i * 3) + 1] & 0xfc;
+      pal->entries[i].r = kBgr[(i * 3) + 2] & 0xfc;
     }
   } else {
     r.TrySkip(256 * 3);  // Ignore palette
@@ -308,17 +311,7 @@ static inline uint32_t Quad(char a, char b, char c, char d) {
 void Common::load(const FsNode& node) {
   {
     auto text_reader_ptr = (node / "tc.cfg").ToReader();
-    io::Reader& text_reader = *text_reader_ptr;
-    // Read entire content into a string for istringstream
-    std::string content;
-    try {
-      for (;;) {
-        content.push_back(static_cast<char>(text_reader.Get()));
-      }
-    } catch (std::runtime_error&) {  // NOLINT(bugprone-empty-catch) — EOF signalled by exception
-                                     // from text_reader.Get(); content is the full read.
-    }
-    std::istringstream is(content);
+    std::istringstream is(io::ReadAll(*text_reader_ptr));
     LoadTcConfig(*this, is);
   }
 
@@ -349,11 +342,11 @@ void Common::load(const FsNode& node) {
           io::ReadUint16Le(r) == 8 && io::ReadUint32Le(r) == Quad('d', 'a', 't', 'a')) {
         std::size_t const kDataSize = io::ReadUint32Le(r);
 
+        std::vector<uint8_t> scratch;
+        std::span<uint8_t const> const kPcm = r.Borrow(kDataSize, scratch);
         s.original_data.resize(kDataSize);
-
-        for (auto& z : s.original_data) {
-          z = r.Get() - 128;
-        }
+        std::ranges::transform(kPcm, s.original_data.begin(),
+                               [](uint8_t v) { return static_cast<uint8_t>(v - 128); });
 
         s.sound = SfxNewSound(kDataSize * 2);
 
@@ -438,16 +431,7 @@ void Common::load(const FsNode& node) {
     auto dir = node / "weapons";
 
     auto w_reader_ptr = (dir / (w.id_str + ".cfg")).ToReader();
-    io::Reader& w_reader = *w_reader_ptr;
-    std::string content;
-    try {
-      for (;;) {
-        content.push_back(static_cast<char>(w_reader.Get()));
-      }
-    } catch (std::runtime_error&) {  // NOLINT(bugprone-empty-catch) — EOF signalled by exception
-                                     // from reader; the partial read is the result.
-    }
-    std::istringstream is(content);
+    std::istringstream is(io::ReadAll(*w_reader_ptr));
     LoadWeaponConfig(*this, w, is);
   }
 
@@ -455,16 +439,7 @@ void Common::load(const FsNode& node) {
     auto dir = node / "nobjects";
 
     auto n_reader_ptr = (dir / (w.id_str + ".cfg")).ToReader();
-    io::Reader& n_reader = *n_reader_ptr;
-    std::string content;
-    try {
-      for (;;) {
-        content.push_back(static_cast<char>(n_reader.Get()));
-      }
-    } catch (std::runtime_error&) {  // NOLINT(bugprone-empty-catch) — EOF signalled by exception
-                                     // from reader; the partial read is the result.
-    }
-    std::istringstream is(content);
+    std::istringstream is(io::ReadAll(*n_reader_ptr));
     LoadNObjectConfig(*this, w, is);
   }
 
@@ -472,16 +447,7 @@ void Common::load(const FsNode& node) {
     auto dir = node / "sobjects";
 
     auto s_reader_ptr = (dir / (w.id_str + ".cfg")).ToReader();
-    io::Reader& s_reader = *s_reader_ptr;
-    std::string content;
-    try {
-      for (;;) {
-        content.push_back(static_cast<char>(s_reader.Get()));
-      }
-    } catch (std::runtime_error&) {  // NOLINT(bugprone-empty-catch) — EOF signalled by exception
-                                     // from reader; the partial read is the result.
-    }
-    std::istringstream is(content);
+    std::istringstream is(io::ReadAll(*s_reader_ptr));
     LoadSObjectConfig(*this, w, is);
   }
 
@@ -142,13 +142,13 @@ struct Common {
   // -1 is the existing "no sound" sentinel used at play sites.
   int SoundIndex(std::string_view name) const;
 
+  static int WormSpriteFrame(int f, int dir, int w) { return f + dir * 7 * 3 + w * 2 * 7 * 3; }
+
   PalIdx* WormSprite(int f, int dir, int w) {
-    return worm_sprites.SpritePtr(f + dir * 7 * 3 + w * 2 * 7 * 3);
+    return worm_sprites.SpritePtr(WormSpriteFrame(f, dir, w));
   }
 
-  Sprite WormSpriteObj(int f, int dir, int w) {
-    return worm_sprites[f + dir * 7 * 3 + w * 2 * 7 * 3];
-  }
+  Sprite WormSpriteObj(int f, int dir, int w) { return worm_sprites[WormSpriteFrame(f, dir, w)]; }
 
   PalIdx* FireConeSprite(int f, int dir) { return fire_cone_sprites.SpritePtr(f + dir * 7); }
 
@@ -51,9 +51,11 @@ inline int SoundRefFromStr(std::string const& str, Common const& common) {
   return common.SoundIndex(str);
 }
 
-// Save/load NObjectType config (individual .cfg file)
-inline void SaveNObjectConfig(Common const& common, NObjectType const& n, std::ostream& os) {
-  cereal::TomlOutputArchive ar(os);
+// Save/load NObjectType config (individual .cfg file). The *Fields halves
+// take any cereal archive; the TC cache (tc_cache.hpp) writes the same
+// field lists in binary.
+template <typename Archive>
+void SaveNObjectFields(Archive& ar, Common const& common, NObjectType const& n) {
   ar(cereal::make_nvp("wormExplode", n.worm_explode));
   ar(cereal::make_nvp("explGround", n.expl_ground));
   ar(cereal::make_nvp("wormDestroy", n.worm_destroy));
@@ -93,8 +95,13 @@ inline void SaveNObjectConfig(Common const& common, NObjectType const& n, std::o
   ar(cereal::make_nvp("timeToExploV", n.time_to_explo_v));
 }
 
-inline void LoadNObjectConfig(Common& common, NObjectType& n, std::istream& is) {
-  cereal::TomlInputArchive ar(is);
+inline void SaveNObjectConfig(Common const& common, NObjectType const& n, std::ostream& os) {
+  cereal::TomlOutputArchive ar(os);
+  SaveNObjectFields(ar, common, n);
+}
+
+template <typename Archive>
+void LoadNObjectFields(Archive& ar, Common& common, NObjectType& n) {
   ar(cereal::make_nvp("wormExplode", n.worm_explode));
   ar(cereal::make_nvp("explGround", n.expl_ground));
   ar(cereal::make_nvp("wormDestroy", n.worm_destroy));
@@ -137,9 +144,14 @@ inline void LoadNObjectConfig(Common& common, NObjectType& n, std::istream& is)
   ar(cereal::make_nvp("timeToExploV", n.time_to_explo_v));
 }
 
+inline void LoadNObjectConfig(Common& common, NObjectType& n, std::istream& is) {
+  cereal::TomlInputArchive ar(is);
+  LoadNObjectFields(ar, common, n);
+}
+
 // Save/load SObjectType config
-inline void SaveSObjectConfig(Common const& common, SObjectType const& s, std::ostream& os) {
-  cereal::TomlOutputArchive ar(os);
+template <typename Archive>
+void SaveSObjectFields(Archive& ar, Common const& common, SObjectType const& s) {
   ar(cereal::make_nvp("shadow", s.shadow));
   {
     std::string ref = SoundRefToStr(s.start_sound, common);
@@ -157,8 +169,13 @@ inline void SaveSObjectConfig(Common const& common, SObjectType const& s, std::o
   ar(cereal::make_nvp("dirtEffect", s.dirt_effect));
 }
 
-inline void LoadSObjectConfig(Common const& common, SObjectType& s, std::istream& is) {
-  cereal::TomlInputArchive ar(is);
+inline void SaveSObjectConfig(Common const& common, SObjectType const& s, std::ostream& os) {
+  cereal::TomlOutputArchive ar(os);
+  SaveSObjectFields(ar, common, s);
+}
+
+template <typename Archive>
+void LoadSObjectFields(Archive& ar, Common const& common, SObjectType& s) {
   ar(cereal::make_nvp("shadow", s.shadow));
   {
     std::string ref;
@@ -177,9 +194,14 @@ inline void LoadSObjectConfig(Common const& common, SObjectType& s, std::istream
   ar(cereal::make_nvp("dirtEffect", s.dirt_effect));
 }
 
+inline void LoadSObjectConfig(Common const& common, SObjectType& s, std::istream& is) {
+  cereal::TomlInputArchive ar(is);
+  LoadSObjectFields(ar, common, s);
+}
+
 // Save/load Weapon config
-inline void SaveWeaponConfig(Common const& common, Weapon const& w, std::ostream& os) {
-  cereal::TomlOutputArchive ar(os);
+template <typename Archive>
+void SaveWeaponFields(Archive& ar, Common const& common, Weapon const& w) {
   ar(cereal::make_nvp("name", w.name));
   ar(cereal::make_nvp("affectByWorm", w.affect_by_worm));
   ar(cereal::make_nvp("shadow", w.shadow));
@@ -253,8 +275,13 @@ inline void SaveWeaponConfig(Common const& common, Weapon const& w, std::ostream
   ar(cereal::make_nvp("chainExplosion", w.chain_explosion));
 }
 
-inline void LoadWeaponConfig(Common& common, Weapon& w, std::istream& is) {
-  cereal::TomlInputArchive ar(is);
+inline void SaveWeaponConfig(Common const& common, Weapon const& w, std::ostream& os) {
+  cereal::TomlOutputArchive ar(os);
+  SaveWeaponFields(ar, common, w);
+}
+
+template <typename Archive>
+void LoadWeaponFields(Archive& ar, Common& common, Weapon& w) {
   ar(cereal::make_nvp("name", w.name));
   ar(cereal::make_nvp("affectByWorm", w.affect_by_worm));
   ar(cereal::make_nvp("shadow", w.shadow));
@@ -335,6 +362,11 @@ inline void LoadWeaponConfig(Common& common, Weapon& w, std::istream& is) {
   ar(cereal::make_nvp("chainExplosion", w.chain_explosion));
 }
 
+inline void LoadWeaponConfig(Common& common, Weapon& w, std::istream& is) {
+  cereal::TomlInputArchive ar(is);
+  LoadWeaponFields(ar, common, w);
+}
+
 // --- Helper structs for tc.cfg serialization (must be at file scope for templates) ---
 namespace tc_cfg {
 
@@ -273,6 +273,12 @@ void LocalController::ChangeState(GameState new_state) {
       }
     }
 
+    if (game.settings->export_match_stats) {
+      if (auto* stats = dynamic_cast<NormalStatsRecorder*>(game.stats_recorder.get())) {
+        stats->ExportTo(MatchStatsNode(gfx.GetUserConfigNode()));
+      }
+    }
+
     game.StartGame();
   } else if (new_state == kStateGameEnded) {
     if (!going_to_menu) {
@@ -7,6 +7,7 @@
 #include "../game.hpp"
 #include "../gfx.hpp"
 #include "../mixer/player.hpp"
+#include "../profiling.hpp"
 #include "../spectatorviewport.hpp"
 #include "../viewport.hpp"
 
@@ -52,6 +53,7 @@ void ReplayController::Focus() {
 }
 
 bool ReplayController::Process() {
+  ZoneScopedN("Replay::Process");
   if (state == kStateGame || state == kStateGameEnded) {
     if (gfx.TestSdlKeyOnce(SDL_SCANCODE_R)) {
       *game = *initial_game;
@@ -117,6 +119,7 @@ bool ReplayController::Process() {
 }
 
 void ReplayController::Draw(Renderer& renderer, bool use_spectator_viewports) {
+  ZoneScopedN("Replay::Draw");
   if (state == kStateGame || state == kStateGameEnded) {
     game->Draw(renderer, state, use_spectator_viewports, /*is_replay=*/true);
   }
@@ -4,7 +4,10 @@
 #include "../mixer/player.hpp"
 #include "../profiling.hpp"
 #include "../replay.hpp"
+#include "../serialization/resync_state.hpp"
+#include "../serialization/snapshot_checksum.hpp"
 #include "../spectatorviewport.hpp"
+#include "../stateHash.hpp"
 #include "../viewport.hpp"
 
 #include <miniz.h>
@@ -132,10 +135,8 @@ void RollbackController::LoadLevelFromData(const std::vector<uint8_t>& data) {
   Common const& common = *game.common;
 
   const uint8_t* pixels = raw.data() + kPixelsOffset;
-  for (size_t i = 0; i < kPixelDataSize; ++i) {
-    game.level.material_id[i] = pixels[i];
-    game.level.materials[i] = common.materials[pixels[i]];
-  }
+  std::memcpy(game.level.material_id.data(), pixels, kPixelDataSize);
+  game.level.RebuildMaterials(common);
 
   const uint8_t* pal_data = raw.data() + kPixelsOffset + kPixelDataSize;
   for (int i = 0; i < 256; ++i) {
@@ -231,25 +232,99 @@ void RollbackController::SetInputCallbacks(InputBatchSendCallback send) {
   sendInputBatch_ = std::move(send);
 }
 
+void RollbackController::SetMaxRollback(int frames) {
+  maxRollback_ = std::clamp(frames, 1, rollback::kMaxRollbackLimit);
+  rollbackBuffer_.Resize(static_cast<std::size_t>(maxRollback_) + 1);
+  rollbackBufferPrepared_ = false;
+  if (frameAdvantageThreshold_ != INT32_MAX) {
+    SetFrameAdvantageEnabled(/*enabled=*/true);
+  }
+  SetInputDelay(minInputDelay_);
+}
+
 void RollbackController::SendInputWindow(uint32_t newest_frame, uint32_t local_frame) {
   if (!sendInputBatch_) {
     return;
   }
-  constexpr auto kK = static_cast<uint8_t>(rollback::kMaxRollback + 1);
-  uint8_t count = 0;
-  uint32_t base_frame = 0;
-  if (newest_frame + 1U < kK) {
-    count = static_cast<uint8_t>(newest_frame + 1U);
-    base_frame = 0;
-  } else {
-    count = kK;
-    base_frame = newest_frame - (kK - 1U);
+  auto const kK = static_cast<uint8_t>(maxRollback_ + 1);
+  uint32_t const kOldest = newest_frame + 1U < kK ? 0 : newest_frame - (kK - 1U);
+  // Unacked frames go out every tick until acked, so a drop costs one
+  // tick. On a lossy link a few acked frames ride along as well so a
+  // single drop usually costs nothing: 2 at no loss, 1 more per ~6%.
+  uint32_t const kMinCount = std::min<uint32_t>(kK, 2U + (peerLossQ8_ / 16U));
+  uint32_t const kRedundant = newest_frame + 1U < kMinCount ? 0 : newest_frame + 1U - kMinCount;
+  uint32_t const kBase = std::max(kOldest, std::min(peerNeededFrame_, kRedundant));
+  auto const kCount = static_cast<uint8_t>(newest_frame - kBase + 1U);
+  std::array<uint8_t, rollback::kMaxRollbackLimit + 1> window{};
+  for (uint8_t i = 0; i < kCount; ++i) {
+    window[i] = localInputs_[(kBase + i) % kInputBufferSize];
+  }
+  sendInputBatch_(generation_, kBase, kCount, window.data(), local_frame);
+}
+
+void RollbackController::WriteLocalInput() {
+  uint32_t const kInputFrame = simFrame_ + inputDelay_;
+  if (lastSentFrameValid_ && kInputFrame <= lastSentFrame_) {
+    // Stalled, or the delay just shrank: this frame already went out.
+    return;
+  }
+  // Mask to the 7 ControlState bits (Up/Down/Left/Right/Fire/Change/
+  // Jump); bit 7 is reserved and must not leak onto the wire.
+  uint8_t const kPacked = localControlState_.Pack() & 0x7f;
+  uint32_t const kFirst = lastSentFrameValid_ ? lastSentFrame_ + 1 : kInputFrame;
+  for (uint32_t f = kFirst; f <= kInputFrame; ++f) {
+    localInputs_[f % kInputBufferSize] = kPacked;
+  }
+  lastSentFrame_ = kInputFrame;
+  lastSentFrameValid_ = true;
+}
+
+float RollbackController::LocalLead() const {
+  if (lastKnownRemoteFrame_ < 0) {
+    return 0.0F;
+  }
+  // The peer has kept advancing since its last batch left it.
+  float const kRemoteNow = static_cast<float>(lastKnownRemoteFrame_) +
+                           static_cast<float>(timeSync_.Now() - lastKnownRemoteTick_) +
+                           timeSync_.OneWayTicks();
+  // Bound the outliers around a phase transition, where the two frame
+  // counters briefly describe different phases.
+  float const kLimit = 2.0F * static_cast<float>(maxRollback_);
+  return std::clamp(static_cast<float>(simFrame_) - kRemoteNow, -kLimit, kLimit);
+}
+
+void RollbackController::UpdateTimeSync() {
+  frameStretchMs_ = 0;
+  if (!sendTimeSync_) {
+    return;
+  }
+  bool const kDue = timeSync_.Tick();
+  frameStretchMs_ = timeSync_.TakeStretchMs();
+  auto const kCeiling = static_cast<uint32_t>(maxRollback_);
+  if (kDue) {
+    auto const kWanted = static_cast<uint8_t>(timeSync_.DesiredDelay(minInputDelay_, kCeiling));
+    sendTimeSync_(timeSync_.MakeMessage(LocalLead(), kWanted));
+  }
+
+  // The tick start is the safe point for a delay change: no local input
+  // has been written for this tick yet, and WriteLocalInput fills or
+  // skips so every frame is still written exactly once.
+  uint32_t const kAgreed = timeSync_.AgreedDelay(minInputDelay_, kCeiling);
+  if (kAgreed != inputDelay_ && timeSync_.Now() - lastDelayStepTick_ >= kDelayStepTicks) {
+    inputDelay_ = kAgreed > inputDelay_ ? inputDelay_ + 1 : inputDelay_ - 1;
+    lastDelayStepTick_ = timeSync_.Now();
+  }
+}
+
+void RollbackController::NoteStall(bool stalled) {
+  if (stalled) {
+    ++stallRun_;
+    return;
   }
-  std::array<uint8_t, kK> window{};
-  for (uint8_t i = 0; i < count; ++i) {
-    window[i] = localInputs_[(base_frame + i) % kInputBufferSize];
+  if (stallRun_ > 0) {
+    stallRuns_.Add(stallRun_);
+    stallRun_ = 0;
   }
-  sendInputBatch_(generation_, base_frame, count, window.data(), local_frame);
 }
 
 void RollbackController::InjectRemoteBatch(uint8_t generation, uint32_t base_frame, uint8_t count,
@@ -264,12 +339,16 @@ void RollbackController::InjectRemoteBatch(uint8_t generation, uint32_t base_fra
     // Monotonic — an out-of-order stale packet must not pull our
     // knowledge of the remote's progress backwards.
     auto const kF = static_cast<int32_t>(remote_local_frame);
-    lastKnownRemoteFrame_ = std::max(kF, lastKnownRemoteFrame_);
+    if (kF > lastKnownRemoteFrame_) {
+      lastKnownRemoteFrame_ = kF;
+      lastKnownRemoteTick_ = timeSync_.Now();
+    }
     return;
   }
 
-  if (generation == static_cast<uint8_t>(generation_ + 1) && count <= kMaxPendingFutureBatches) {
-    if (pendingFutureCount_ < kMaxPendingFutureBatches) {
+  auto const kK = static_cast<uint8_t>(maxRollback_ + 1);
+  if (generation == static_cast<uint8_t>(generation_ + 1) && count <= kK) {
+    if (pendingFutureCount_ < kK) {
       auto& slot = pendingFutureBatches_[pendingFutureCount_++];
       slot.base_frame = base_frame;
       slot.count = count;
@@ -284,6 +363,31 @@ void RollbackController::InjectRemoteBatch(uint8_t generation, uint32_t base_fra
   ++droppedOldGenerationBatches_;
 }
 
+void RollbackController::InjectInputAck(uint8_t generation, uint32_t next_frame,
+                                        uint8_t loss_q8) {
+  if (generation != generation_) {
+    return;
+  }
+  peerLossQ8_ = loss_q8;
+  // Acks beyond what we've sent are corrupt; a stale one from a
+  // reordered packet is simply smaller, so take the max.
+  if (!lastSentFrameValid_ || next_frame > lastSentFrame_ + 1U) {
+    return;
+  }
+  peerNeededFrame_ = std::max(peerNeededFrame_, next_frame);
+}
+
+uint32_t RollbackController::RemoteInputNeeded() const {
+  // Everything up to confirmedSimFrame_ was consumed; past it, ready
+  // slots may already run a few frames ahead.
+  auto frame = static_cast<uint32_t>(confirmedSimFrame_ + 1);
+  for (uint32_t i = 0; i < kInputBufferSize / 2 && remoteInputReady_[frame % kInputBufferSize];
+       ++i) {
+    ++frame;
+  }
+  return frame;
+}
+
 void RollbackController::InjectRemoteInput(uint32_t frame, uint8_t input) {
   // Redundant batch packets routinely overlap the confirmation boundary;
   // re-injecting already-confirmed frames would re-set remoteInputReady
@@ -413,6 +517,7 @@ void RollbackController::Focus() {
   // GameSnapshot vector sizes) are known.
   if (!rollbackBufferPrepared_) {
     rollbackBuffer_.Prepare(game);
+    rebaseLater_.reserve(rollbackBuffer_.Capacity());
     rollbackBufferPrepared_ = true;
   }
 }
@@ -472,6 +577,7 @@ bool RollbackController::Process() {
   }
 
   lastTickResimFrames_ = 0;
+  UpdateTimeSync();
 
   if (state_ == kStateWeaponSelection) {
     AdvanceWeaponSelection();
@@ -619,6 +725,7 @@ void RollbackController::ResetForGamePhase() {
   lastSentFrameValid_ = false;
   lastRemoteInput_ = 0;
   lastKnownRemoteFrame_ = -1;
+  peerNeededFrame_ = 0;
 
   // Edge-detection state — carrying these across the phase boundary
   // would produce a spurious rising/released edge on the first frame.
@@ -681,6 +788,7 @@ void RollbackController::SeedRollbackAndShadow() {
   // here so the slot-0 snapshot below captures the right widths.
   if (!rollbackBufferPrepared_) {
     rollbackBuffer_.Prepare(game);
+    rebaseLater_.reserve(rollbackBuffer_.Capacity());
     rollbackBufferPrepared_ = true;
   }
 
@@ -694,7 +802,7 @@ void RollbackController::SeedRollbackAndShadow() {
   seed.remote_state = rollback::RemoteState::kConfirmed;
   seed.ws_snap.valid = false;
   game.SaveSnapshotFast(seed.snapshot);
-  seed.checksum = WideRollbackChecksum(game);
+  seed.checksum = SnapshotChecksum(seed.snapshot, game.level);
 
   SetupShadowGame();
 }
@@ -707,6 +815,7 @@ void RollbackController::SetupShadowGame() {
   // g_sound_player with its NullSoundPlayer — that would mute every
   // menu/UI sound for the rest of the match (and leave a dangling
   // global after a rematch cycle).
+  DropShadow();
   shadowGame_ =
       std::make_unique<Game>(game.common, game.settings, std::make_shared<NullSoundPlayer>(),
                              /*install_global_sound_player=*/false);
@@ -714,16 +823,18 @@ void RollbackController::SetupShadowGame() {
   ConfigureGameSlots(*shadowGame_, {game.worms[0]->settings, game.worms[1]->settings});
 
   // loadSnapshotFast assumes level buffers are already sized; the
-  // snapshot itself carries pixel data but not dimensions.
+  // snapshot itself carries pixel data but not dimensions. A delta slot
+  // doesn't carry the level at all, so start from the live level, which
+  // is still in its frame-0 state here.
   shadowGame_->level.width = game.level.width;
   shadowGame_->level.height = game.level.height;
   std::size_t const kCells =
       static_cast<std::size_t>(game.level.width) * static_cast<std::size_t>(game.level.height);
-  shadowGame_->level.material_id.resize(kCells);
+  shadowGame_->level.material_id = game.level.material_id;
   shadowGame_->level.materials.resize(kCells);
   if (!game.level.display_data.empty()) {
     shadowGame_->level.display_data.resize(kCells);
-    shadowGame_->level.display_valid.resize(kCells);
+    shadowGame_->level.display_valid = game.level.display_valid;
   }
   if (!game.level.argb_ramps.empty()) {
     shadowGame_->level.argb_ramps = game.level.argb_ramps;
@@ -754,9 +865,6 @@ void RollbackController::SetupShadowGame() {
   }
 
   shadowFrame_ = -1;
-  shadowLocalPrevInput_ = 0;
-  shadowRemotePrevInput_ = 0;
-  shadowMismatchLogged_ = false;
 
   // The live game runs each frame speculatively (forward predicted +
   // resims), so its NormalStatsRecorder would over-count and — worse —
@@ -767,29 +875,39 @@ void RollbackController::SetupShadowGame() {
   // afterSpawn, …) become silent on the live side.
   game.stats_recorder = std::make_shared<StatsRecorder>();
 
-  StartReplayRecording();
+  if (game.settings->export_match_stats && gfx.GetUserConfigNode().imp) {
+    if (auto* stats = dynamic_cast<NormalStatsRecorder*>(shadowGame_->stats_recorder.get())) {
+      char suffix[8];
+      // NOLINTNEXTLINE(cert-err33-c) — fixed 7-char output ("mpN\0") fits the 8-byte buffer.
+      std::snprintf(suffix, sizeof(suffix), " mp%d", localIdx_);
+      stats->ExportTo(MatchStatsNode(gfx.GetUserConfigNode(), suffix));
+    }
+  }
+
+  // BeginRecord serializes the shadow here, before the worker owns it.
+  shadowWorker_ = std::make_unique<ShadowWorker>(*shadowGame_, StartReplayRecording());
 }
 
-void RollbackController::StartReplayRecording() {
+std::unique_ptr<ReplayWriter> RollbackController::StartReplayRecording() {
   if (!shadowGame_) {
-    return;
+    return nullptr;
   }
 
   // Test path: caller provided a writer directly; skip the gfx-driven
   // file-naming logic and just hand it to ReplayWriter.
   if (replayWriterOverride_) {
     try {
-      shadowReplay_ = std::make_unique<ReplayWriter>(std::move(replayWriterOverride_));
-      shadowReplay_->BeginRecord(*shadowGame_);
+      auto replay = std::make_unique<ReplayWriter>(std::move(replayWriterOverride_));
+      replay->BeginRecord(*shadowGame_);
+      return replay;
     } catch (std::runtime_error& e) {
       std::fprintf(stderr, "[replay] failed to start recording: %s\n", e.what());
-      shadowReplay_.reset();
+      return nullptr;
     }
-    return;
   }
 
   if (!Settings::kExtensions || !game.settings->record_replays) {
-    return;
+    return nullptr;
   }
 
   // Tests construct RollbackControllers without first wiring up gfx,
@@ -797,7 +915,7 @@ void RollbackController::StartReplayRecording() {
   // a null impl pointer. Operator/ would dereference that and segv.
   FsNode const kConfigRoot = gfx.GetUserConfigNode();
   if (!kConfigRoot.imp) {
-    return;
+    return nullptr;
   }
 
   try {
@@ -832,21 +950,34 @@ void RollbackController::StartReplayRecording() {
 
     auto node = kConfigRoot / "Replays" / (std::string(time_buf) + player_names + suffix + ".lrp");
 
-    shadowReplay_ = std::make_unique<ReplayWriter>(node.ToWriter());
-    shadowReplay_->BeginRecord(*shadowGame_);
+    auto replay = std::make_unique<ReplayWriter>(node.ToWriter());
+    replay->BeginRecord(*shadowGame_);
+    return replay;
   } catch (std::runtime_error& e) {
     std::fprintf(stderr, "[replay] failed to start recording: %s\n", e.what());
-    shadowReplay_.reset();
+    return nullptr;
   }
 }
 
 void RollbackController::StopReplayRecording() {
-  // ReplayWriter destructor writes the 0x83 terminator.
-  shadowReplay_.reset();
+  if (shadowWorker_) {
+    shadowWorker_->StopRecording();
+  }
+}
+
+void RollbackController::SyncShadow() {
+  if (shadowWorker_) {
+    shadowWorker_->Wait();
+  }
+}
+
+void RollbackController::DropShadow() {
+  shadowWorker_.reset();
+  shadowGame_.reset();
 }
 
 void RollbackController::DriveShadow() {
-  if (!shadowGame_) {
+  if (!shadowWorker_) {
     return;
   }
 
@@ -854,55 +985,191 @@ void RollbackController::DriveShadow() {
     int32_t const kF = shadowFrame_ + 1;
     rollback::Slot const* slot = rollbackBuffer_.Find(kF);
     if (!slot) {
-      // The ring only holds kMaxRollback+1 slots; if the shadow ever
+      // The ring only holds window+1 slots; if the shadow ever
       // falls more than that behind, we can't reconstruct the missing
       // frame's inputs and have to give up on this match's recording.
-      shadowGame_.reset();
+      DropShadow();
       return;
     }
 
-    uint8_t const kCurLocal = (localIdx_ == 0) ? slot->local_input : slot->remote_input;
-    uint8_t const kCurRemote = (localIdx_ == 0) ? slot->remote_input : slot->local_input;
-
-    uint8_t const kRisingLocal = kCurLocal & ~shadowLocalPrevInput_;
-    uint8_t const kRisingRemote = kCurRemote & ~shadowRemotePrevInput_;
-    uint8_t const kReleasedLocal = shadowLocalPrevInput_ & ~kCurLocal;
-    uint8_t const kReleasedRemote = shadowRemotePrevInput_ & ~kCurRemote;
-    shadowGame_->worms[localIdx_]->control_states.istate |= kRisingLocal;
-    shadowGame_->worms[remoteIdx_]->control_states.istate |= kRisingRemote;
-    shadowGame_->worms[localIdx_]->control_states.istate &= ~kReleasedLocal;
-    shadowGame_->worms[remoteIdx_]->control_states.istate &= ~kReleasedRemote;
-    shadowLocalPrevInput_ = kCurLocal;
-    shadowRemotePrevInput_ = kCurRemote;
-
-    // recordFrame() reads worm.controlStates ^ prevControlStates, so it
-    // must run after edge detection but before processFrame() (which
-    // sets prev = current at end of tick, wiping the delta).
-    if (shadowReplay_) {
-      try {
-        shadowReplay_->RecordFrame();
-      } catch (std::runtime_error& e) {
-        std::fprintf(stderr, "[replay] aborting recording at frame %d: %s\n", kF, e.what());
-        shadowReplay_.reset();
-      }
+    ShadowWorker::Frame frame{.frame = kF, .checksum = slot->checksum};
+    frame.inputs[localIdx_] = (localIdx_ == 0) ? slot->local_input : slot->remote_input;
+    frame.inputs[remoteIdx_] = (localIdx_ == 0) ? slot->remote_input : slot->local_input;
+    shadowWorker_->Push(frame);
+    shadowFrame_ = kF;
+  }
+}
+
+void RollbackController::RebaseLevel() {
+  rollback::Slot* base = rollbackBuffer_.Find(confirmedSimFrame_);
+  if (!base) {
+    return;
+  }
+  rebaseLater_.clear();
+  // Not NewestFrame(): input for future frames may already hold a slot
+  // whose snapshot is left over from an older frame.
+  for (int32_t f = confirmedSimFrame_ + 1; f < static_cast<int32_t>(simFrame_); ++f) {
+    if (rollback::Slot* slot = rollbackBuffer_.Find(f)) {
+      rebaseLater_.push_back(&slot->snapshot);
     }
+  }
+  game.RebaseLevelDelta(base->snapshot, rebaseLater_);
+}
 
-    shadowGame_->ProcessFrame();
-    shadowFrame_ = kF;
+bool RollbackController::ComponentHashesAt(int32_t frame, ComponentHashes& out) {
+  if (state_ != kStateGame || !gamePhaseEntered_) {
+    return false;
+  }
+  rollback::Slot const* at = rollbackBuffer_.Find(frame);
+  rollback::Slot const* newest = rollbackBuffer_.Find(static_cast<int32_t>(simFrame_) - 1);
+  if (!at || !newest || !game.CanLoadSnapshotFast(at->snapshot)) {
+    return false;
+  }
+  // The live game always matches the newest slot between ticks.
+  game.LoadSnapshotFast(at->snapshot);
+  out = HashGameComponents(game);
+  game.LoadSnapshotFast(newest->snapshot);
+  return true;
+}
+
+bool RollbackController::ExportResyncState(std::vector<uint8_t>& out) {
+  if (state_ != kStateGame || !gamePhaseEntered_ || confirmedSimFrame_ < 0 ||
+      !game.level.DirtyTracking()) {
+    return false;
+  }
+  rollback::Slot const* slot = rollbackBuffer_.Find(confirmedSimFrame_);
+  if (!slot) {
+    return false;
+  }
+  ResyncHeader header{.frame = static_cast<uint32_t>(confirmedSimFrame_),
+                      .inputs = {slot->local_input, slot->remote_input}};
+  if (!ComponentHashesAt(confirmedSimFrame_, header.hashes)) {
+    return false;
+  }
+  std::vector<uint8_t> raw;
+  SaveResyncState(raw, game, header, slot->snapshot);
+
+  // Same envelope as the map data: compressed flag(1) + rawSize(4) + data.
+  mz_ulong comp_size = mz_compressBound(static_cast<mz_ulong>(raw.size()));
+  out.resize(5 + comp_size);
+  int const kStatus = mz_compress(out.data() + 5, &comp_size, raw.data(),
+                                  static_cast<mz_ulong>(raw.size()));
+  if (kStatus == MZ_OK) {
+    out.resize(5 + comp_size);
+  } else {
+    out.resize(5 + raw.size());
+    std::memcpy(out.data() + 5, raw.data(), raw.size());
+  }
+  out[0] = (kStatus == MZ_OK) ? 1 : 0;
+  auto const kRawSize = static_cast<uint32_t>(raw.size());
+  std::memcpy(out.data() + 1, &kRawSize, 4);
+  return true;
+}
+
+bool RollbackController::ApplyResyncState(uint8_t const* data, std::size_t len) {
+  if (state_ != kStateGame || !gamePhaseEntered_ || !game.level.DirtyTracking() || len < 5) {
+    return false;
+  }
 
-    // Sanity check: the shadow must match the live game's confirmed
-    // state for the same frame. Log once on divergence so the breakage
-    // surfaces without spamming stderr.
-    uint32_t const kShadowChk = WideRollbackChecksum(*shadowGame_);
-    if (kShadowChk != slot->checksum && !shadowMismatchLogged_) {
-      std::fprintf(stderr,
-                   "[replay shadow] mismatch at frame %d: shadow=%08x live=%08x curLocal=%02x "
-                   "curRemote=%02x slot.localInput=%02x slot.remoteInput=%02x shadowRand=%08x\n",
-                   kF, kShadowChk, slot->checksum, kCurLocal, kCurRemote, slot->local_input,
-                   slot->remote_input, shadowGame_->rand.last);
-      shadowMismatchLogged_ = true;
+  uint32_t raw_size = 0;
+  std::memcpy(&raw_size, data + 1, 4);
+  // Sim fields plus one 6-byte entry per dug cell of the largest map.
+  static constexpr uint32_t kMaxRawSize = 128 * 1024 * 1024;
+  if (raw_size > kMaxRawSize) {
+    return false;
+  }
+  std::vector<uint8_t> raw;
+  if (data[0] != 0) {
+    raw.resize(raw_size);
+    mz_ulong dest_len = raw_size;
+    if (mz_uncompress(raw.data(), &dest_len, data + 5, static_cast<mz_ulong>(len - 5)) != MZ_OK) {
+      return false;
+    }
+    raw.resize(dest_len);
+  } else {
+    raw.assign(data + 5, data + len);
+  }
+
+  // Sim fields only: the slot is never saved, so LoadSnapshotFast leaves
+  // the level alone and the cells are applied over the match's base.
+  auto snap = std::make_unique<GameSnapshot>();
+  snap->Prepare(game, GameSnapshot::LevelStorage::kDelta);
+  ResyncHeader header;
+  std::vector<ResyncCell> cells;
+  if (!LoadResyncState(raw.data(), raw.size(), game, header, *snap, cells)) {
+    std::fprintf(stderr, "[resync] rejected: state does not fit this match\n");
+    return false;
+  }
+  if (header.base_digest != game.level.dirty_base_digest) {
+    std::fprintf(stderr, "[resync] rejected: match started from a different level\n");
+    return false;
+  }
+
+  // Frames between the old and new position are replayed from the input
+  // rings, so both must still hold them, and the host can only have
+  // confirmed inputs we sent.
+  auto const kFrame = static_cast<int32_t>(header.frame);
+  int32_t const kOldConfirmed = confirmedSimFrame_;
+  int32_t const kSpan = std::abs(static_cast<int32_t>(simFrame_) - kFrame);
+  if (kFrame < 0 || !lastSentFrameValid_ || header.frame > lastSentFrame_ ||
+      kSpan >= static_cast<int32_t>(kInputBufferSize / 2)) {
+    std::fprintf(stderr, "[resync] rejected: frame %u is outside the input window\n",
+                 header.frame);
+    return false;
+  }
+
+  PrintComponentHashes("host", header.frame, header.hashes);
+  ComponentHashes local{};
+  if (ComponentHashesAt(kFrame, local)) {
+    PrintComponentHashes("local", header.frame, local);
+  }
+
+  game.LoadSnapshotFast(*snap);
+  game.level.RevertToDirtyBase(*game.common);
+  bool const kHasDv = !game.level.display_valid.empty();
+  for (ResyncCell const& c : cells) {
+    game.level.material_id[c.idx] = c.material;
+    game.level.materials[c.idx] = game.common->materials[c.material];
+    if (kHasDv) {
+      game.level.display_valid[c.idx] = c.display_valid;
     }
+    game.level.MarkDirty(static_cast<int>(c.idx));
+  }
+  // Delta slots restart from the adopted level as their base.
+  if (!game.level.delta_bits.empty()) {
+    game.level.InitDeltaTracking();
   }
+
+  // Later slots describe the abandoned state; start the ring over from
+  // the adopted frame.
+  rollbackBuffer_.Clear();
+  rollback::Slot& slot = rollbackBuffer_.Write(kFrame);
+  slot.local_input = header.inputs[0];
+  slot.remote_input = header.inputs[1];
+  slot.remote_state = rollback::RemoteState::kConfirmed;
+  game.SaveSnapshotFast(slot.snapshot);
+  slot.checksum = SnapshotChecksum(slot.snapshot, game.level);
+
+  // Remote input consumed for frames we are about to run again is still
+  // in the ring, so re-arm it; anything armed at or before the adopted
+  // frame is stale.
+  for (int32_t f = kFrame + 1; f <= kOldConfirmed; ++f) {
+    remoteInputReady_[static_cast<uint32_t>(f) % kInputBufferSize] = true;
+  }
+  for (int32_t f = std::max(kOldConfirmed + 1, 0); f <= kFrame; ++f) {
+    remoteInputReady_[static_cast<uint32_t>(f) % kInputBufferSize] = false;
+  }
+  simFrame_ = header.frame + 1;
+  confirmedSimFrame_ = kFrame;
+  localPrevInput_ = header.inputs[localIdx_];
+  remotePrevInput_ = header.inputs[remoteIdx_];
+  lastRemoteInput_ = remotePrevInput_;
+
+  DropShadow();
+  ++resyncCount_;
+  std::fprintf(stderr, "[resync] adopted host state at frame %u (%zu cells)\n", header.frame,
+               cells.size());
+  return true;
 }
 
 // Mirror of advanceSimulation() for the weapon-select phase: same
@@ -911,16 +1178,11 @@ void RollbackController::DriveShadow() {
 // processFrame and saving into wsSnap instead of snapshot. Keep the two
 // in sync — a fix here likely needs to land in the sibling too.
 void RollbackController::AdvanceWeaponSelection() {
-  uint32_t const kInputFrame = simFrame_ + inputDelay_;
-  if (!lastSentFrameValid_ || kInputFrame != lastSentFrame_) {
-    uint32_t const kSlot = kInputFrame % kInputBufferSize;
-    // Mask to the 7 ControlState bits (Up/Down/Left/Right/Fire/Change/
-    // Jump); bit 7 is reserved and must not leak onto the wire.
-    localInputs_[kSlot] = localControlState_.Pack() & 0x7f;
-    lastSentFrame_ = kInputFrame;
-    lastSentFrameValid_ = true;
+  if (inputPump_) {
+    inputPump_();
   }
-  SendInputWindow(kInputFrame, simFrame_);
+  WriteLocalInput();
+  SendInputWindow(lastSentFrame_, simFrame_);
 
   // Promote previously-predicted WS frames whose real remote input has
   // now arrived and matches the prediction.
@@ -961,6 +1223,7 @@ void RollbackController::AdvanceWeaponSelection() {
     ++rollbackCount_;
     lastTickResimFrames_ +=
         static_cast<uint32_t>(static_cast<int32_t>(simFrame_) - rollback_to - 1);
+    rollbackDepth_.Add(static_cast<uint32_t>(static_cast<int32_t>(simFrame_) - rollback_to - 1));
     auto* last_good = rollbackBuffer_.Find(rollback_to);
     if (last_good && last_good->ws_snap.valid) {
       LoadWeaponSelectSnap(last_good->ws_snap);
@@ -1014,14 +1277,17 @@ void RollbackController::AdvanceWeaponSelection() {
   }
 
   // Stall guards — same thresholds as advanceSimulation.
-  if (static_cast<int32_t>(simFrame_) - confirmedSimFrame_ > rollback::kMaxRollback) {
+  if (static_cast<int32_t>(simFrame_) - confirmedSimFrame_ > maxRollback_) {
+    NoteStall(/*stalled=*/true);
     return;
   }
   if (lastKnownRemoteFrame_ >= 0 &&
       static_cast<int32_t>(simFrame_) - lastKnownRemoteFrame_ >= frameAdvantageThreshold_) {
     ++frameAdvantageStalls_;
+    NoteStall(/*stalled=*/true);
     return;
   }
+  NoteStall(/*stalled=*/false);
 
   // Predict if remote input not yet ready, run ws tick, snapshot.
   uint32_t const kCurrentSlot = simFrame_ % kInputBufferSize;
@@ -1077,21 +1343,16 @@ void RollbackController::AdvanceWeaponSelection() {
 // in sync — a fix here likely needs to land in the sibling too.
 void RollbackController::AdvanceSimulation() {
   ZoneScopedN("Rollback::AdvanceSimulation");
-  uint32_t const kInputFrame = simFrame_ + inputDelay_;
-  if (!lastSentFrameValid_ || kInputFrame != lastSentFrame_) {
-    uint32_t const kSlot = kInputFrame % kInputBufferSize;
-    // Mask to the 7 ControlState bits (Up/Down/Left/Right/Fire/Change/
-    // Jump); bit 7 is reserved and must not leak onto the wire.
-    localInputs_[kSlot] = localControlState_.Pack() & 0x7f;
-    lastSentFrame_ = kInputFrame;
-    lastSentFrameValid_ = true;
+  if (inputPump_) {
+    inputPump_();
   }
+  WriteLocalInput();
 
-  // Emit the last K = kMaxRollback + 1 local inputs as a redundant
-  // batch every tick. The redundancy covers single dropped packets
+  // Emit every local input the peer hasn't acked (at most the last
+  // K = window + 1) every tick. The redundancy covers dropped packets
   // without a retransmit RTT. Send continues even when stalled below so
   // the remote peer can promote out of its own stall.
-  SendInputWindow(kInputFrame, simFrame_);
+  SendInputWindow(lastSentFrame_, simFrame_);
 
   // Walk confirmedSimFrame_+1 .. simFrame-1 in order: promote slots whose
   // prediction matched, stop at the first mismatch and let the resim
@@ -1143,9 +1404,10 @@ void RollbackController::AdvanceSimulation() {
     ++rollbackCount_;
     lastTickResimFrames_ +=
         static_cast<uint32_t>(static_cast<int32_t>(simFrame_) - rollback_to - 1);
+    rollbackDepth_.Add(static_cast<uint32_t>(static_cast<int32_t>(simFrame_) - rollback_to - 1));
     auto* last_good = rollbackBuffer_.Find(rollback_to);
     // Resident by construction: the stall guard caps simFrame - confirmedSimFrame_
-    // at kMaxRollback, and the ring holds kMaxRollback+1 slots.
+    // at maxRollback_, and the ring holds maxRollback_+1 slots.
     game.LoadSnapshotFast(last_good->snapshot);
 
     uint8_t const kLastGoodWorm0 = last_good->local_input;
@@ -1185,7 +1447,9 @@ void RollbackController::AdvanceSimulation() {
       localPrevInput_ = kCurLocal;
       remotePrevInput_ = cur_remote;
 
-      game.ProcessFrame();
+      // Resim frames are never displayed on their own; the forward frame
+      // that follows moves the viewports once for the whole tick.
+      game.ProcessFrame<Game::FrameMode::kSimOnly>();
 
       auto& out_slot = rollbackBuffer_.Write(static_cast<int>(f));
       out_slot.local_input = (localIdx_ == 0) ? kCurLocal : cur_remote;
@@ -1193,7 +1457,7 @@ void RollbackController::AdvanceSimulation() {
       out_slot.remote_state =
           frame_predicted ? rollback::RemoteState::kPredicted : rollback::RemoteState::kConfirmed;
       game.SaveSnapshotFast(out_slot.snapshot);
-      out_slot.checksum = WideRollbackChecksum(game);
+      out_slot.checksum = SnapshotChecksum(out_slot.snapshot, game.level);
 
       // Predicted resim frames stay silent — their checksum is cached
       // for a later promote/resim pass.
@@ -1204,22 +1468,26 @@ void RollbackController::AdvanceSimulation() {
     game.SetSpeculative(/*s=*/false);
   }
 
-  // Stall guard: cap in-flight predicted frames at kMaxRollback so the
-  // ring buffer (kMaxRollback+1 slots) can still cover the post-tick
+  // Stall guard: cap in-flight predicted frames at maxRollback_ so the
+  // ring buffer (maxRollback_+1 slots) can still cover the post-tick
   // window.
-  if (static_cast<int32_t>(simFrame_) - confirmedSimFrame_ > rollback::kMaxRollback) {
+  if (static_cast<int32_t>(simFrame_) - confirmedSimFrame_ > maxRollback_) {
+    NoteStall(/*stalled=*/true);
     return;
   }
 
   // Frame-advantage stall: hold simFrame when too far ahead of the
   // remote's last reported simFrame. The send above already ran, so the
   // remote still hears from us this tick. -1 keeps this disarmed before
-  // any packet has arrived.
+  // any packet has arrived. With time sync running this is only the
+  // backstop; frame stretching normally keeps the gap well inside it.
   if (lastKnownRemoteFrame_ >= 0 &&
       static_cast<int32_t>(simFrame_) - lastKnownRemoteFrame_ >= frameAdvantageThreshold_) {
     ++frameAdvantageStalls_;
+    NoteStall(/*stalled=*/true);
     return;
   }
+  NoteStall(/*stalled=*/false);
 
   uint32_t const kCurrentSlot = simFrame_ % kInputBufferSize;
 
@@ -1278,12 +1546,13 @@ void RollbackController::AdvanceSimulation() {
     slot.remote_state =
         predicted ? rollback::RemoteState::kPredicted : rollback::RemoteState::kConfirmed;
     game.SaveSnapshotFast(slot.snapshot);
-    slot.checksum = WideRollbackChecksum(game);
+    slot.checksum = SnapshotChecksum(slot.snapshot, game.level);
 
     if (!predicted && sendChecksum_) {
       sendChecksum_(generation_, simFrame_ - 1, slot.checksum);
     }
   }
+  RebaseLevel();
 
   if (game.IsGameOver()) {
     state_ = kStateGameEnded;
@@ -1352,7 +1621,13 @@ Level* RollbackController::CurrentLevel() { return &game.level; }
 
 Game* RollbackController::CurrentGame() { return &game; }
 
-Game* RollbackController::StatsGame() { return shadowGame_ ? shadowGame_.get() : &game; }
+Game* RollbackController::StatsGame() {
+  SyncShadow();
+  Game* g = shadowGame_ ? shadowGame_.get() : &game;
+  // The shadow's recorder folds events in on its own thread.
+  g->stats_recorder->Sync();
+  return g;
+}
 
 bool RollbackController::Running() {
   return state_ != kStateGameEnded && state_ != kStateInitial && resumable_;
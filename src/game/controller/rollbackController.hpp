@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -11,14 +13,18 @@
 #include "../io/stream.hpp"
 #include "../menu/menu.hpp"
 #include "../rollback/buffer.hpp"
+#include "../rollback/time_sync.hpp"
 #include "../weapsel.hpp"
 #include "../worm.hpp"
 #include "commonController.hpp"
+#include "shadowWorker.hpp"
 
+struct ComponentHashes;
 struct ReplayWriter;
 
-// Batched input send: emits the last K = kMaxRollback + 1 local inputs
-// per tick so a dropped packet is covered by the next K-1.
+// Batched input send: emits every local input the peer hasn't acked,
+// at most the last K = window + 1, so a dropped packet is covered by
+// the next one.
 // `localFrame` = sender's simFrame at send time (frame-advantage
 // tracking); `generation` = sender's phase generation (receivers drop
 // stale ones).
@@ -31,6 +37,9 @@ using InputBatchSendCallback =
 using ChecksumSendCallback =
     std::function<void(uint8_t generation, uint32_t frame, uint32_t checksum)>;
 
+// Periodic link-estimation / time-sync message (see rollback/time_sync.hpp).
+using TimeSyncSendCallback = std::function<void(rollback::TimeSyncMessage const& msg)>;
+
 struct RollbackController : CommonController {
   RollbackController(const std::shared_ptr<Common>& common,
                      const std::shared_ptr<Settings>& settings, int local_player_idx);
@@ -49,9 +58,23 @@ struct RollbackController : CommonController {
 
   void SetInputCallbacks(InputBatchSendCallback send);
   void SetChecksumCallback(ChecksumSendCallback cb) { sendChecksum_ = std::move(cb); }
+  // Wiring this turns on time sync and adaptive input delay: RTT and
+  // jitter are estimated from the exchanged messages, the leading peer
+  // stretches its frames (FrameStretchMs) instead of stalling, and the
+  // input delay follows the link between the SetInputDelay floor and
+  // the rollback window.
+  void SetTimeSyncCallback(TimeSyncSendCallback cb) { sendTimeSync_ = std::move(cb); }
+  void InjectTimeSync(rollback::TimeSyncMessage const& msg) { timeSync_.OnMessage(msg); }
 
   void InjectRemoteInput(uint32_t frame, uint8_t input);
 
+  // Peer's ack from its latest packet: it holds every local input before
+  // `nextFrame`, and lost `lossQ8`/256 of our recent packets. Later input
+  // windows start at the first unacked frame. Other generations ignored.
+  void InjectInputAck(uint8_t generation, uint32_t next_frame, uint8_t loss_q8);
+  // First remote frame whose input hasn't arrived yet: the ack we send.
+  uint32_t RemoteInputNeeded() const;
+
   // `generation` is the sender's phase generation. Batches from an older
   // generation are dropped (their simFrame numbering describes a phase
   // the local controller has already abandoned, and slots are reused
@@ -76,6 +99,9 @@ struct RollbackController : CommonController {
 
   void SetEndMatchCallback(std::function<void()> cb) { onEndMatch_ = std::move(cb); }
   void SetPeerLeftCallback(std::function<void()> cb) { onPeerLeft_ = std::move(cb); }
+  // Called at the start of every tick, before remote input is consumed,
+  // so input received off-thread since the last poll is used this tick.
+  void SetInputPump(std::function<void()> pump) { inputPump_ = std::move(pump); }
 
   // Test/embedding hook: redirect the multiplayer replay writer to a
   // user-supplied io::Writer instead of the gfx-configured Replays/
@@ -88,7 +114,11 @@ struct RollbackController : CommonController {
   // Test accessor: the shadow Game tracking confirmed frames. Used by
   // the replay round-trip test to compare the shadow's final state
   // against the replayed file's playback state.
-  Game* ShadowGameForTest() { return shadowGame_.get(); }
+  // Waits for the shadow worker to catch up first.
+  Game* ShadowGameForTest() {
+    SyncShadow();
+    return shadowGame_.get();
+  }
   // Single entry into the goingToMenu fade. Clears pause flags so
   // process()'s paused-branch early-return can't strand fadeValue.
   void EnterGoingToMenu(int fade);
@@ -111,13 +141,24 @@ struct RollbackController : CommonController {
   GameState State() const { return state_; }
   bool InWeaponSelection() override { return state_ == kStateWeaponSelection; }
   void SetLocalControlState(uint8_t packed) { localControlState_.Unpack(packed); }
-  // Must be called before the first sim tick. Clamped to kMaxRollback:
-  // the send path encodes (localFrame - baseFrame) as a uint8_t equal to
-  // (K-1) - inputDelay, which underflows once inputDelay exceeds K-1.
+  // Must be called before the first sim tick. Clamped to the rollback
+  // window: the send path encodes (localFrame - baseFrame) as a uint8_t
+  // equal to (K-1) - inputDelay, which underflows once inputDelay exceeds
+  // K-1. With time sync wired this is the floor adaptive delay never goes
+  // below (the session pre-fills that many frames of remote input).
   void SetInputDelay(uint32_t frames) {
-    inputDelay_ =
-        frames > rollback::kMaxRollback ? static_cast<uint32_t>(rollback::kMaxRollback) : frames;
+    inputDelay_ = std::min(frames, static_cast<uint32_t>(maxRollback_));
+    minInputDelay_ = inputDelay_;
   }
+  uint32_t InputDelay() const { return inputDelay_; }
+
+  // Frames we may run ahead of the last confirmed one before stalling,
+  // clamped to [1, kMaxRollbackLimit]. Both peers must use the same value
+  // (NetSession negotiates it in the handshake): it sets the width of the
+  // redundant input window. Must be called before focus() prepares the
+  // snapshot ring; re-clamps the input delay.
+  void SetMaxRollback(int frames);
+  int MaxRollback() const { return maxRollback_; }
 
   rollback::RollbackBuffer const& RollbackBuffer() const { return rollbackBuffer_; }
 
@@ -126,6 +167,33 @@ struct RollbackController : CommonController {
   int32_t ConfirmedFrame() const { return confirmedSimFrame_; }
 
   uint64_t RollbackCount() const { return rollbackCount_; }
+  // Rollbacks bucketed by frames resimulated, and stalls bucketed by how
+  // many consecutive ticks they held the sim.
+  rollback::Histogram const& RollbackDepthHistogram() const { return rollbackDepth_; }
+  rollback::Histogram const& StallHistogram() const { return stallRuns_; }
+
+  rollback::TimeSync const& TimeSync() const { return timeSync_; }
+  // Milliseconds the current frame should be held past its nominal
+  // period to let the peer catch up. Set by every process() tick.
+  int FrameStretchMs() const { return frameStretchMs_; }
+
+  // Desync recovery (see NetSession::OnDesync).
+  //
+  // HashGameComponents of the state after `frame`, if its snapshot is
+  // still in the ring. Visits the slot and restores the newest one, so
+  // the live game is unchanged afterwards.
+  bool ComponentHashesAt(int32_t frame, ComponentHashes& out);
+  // Host: the state after the last confirmed frame, compressed for the
+  // wire (see serialization/resync_state.hpp). False outside the game
+  // phase.
+  bool ExportResyncState(std::vector<uint8_t>& out);
+  // Client: adopt a state from ExportResyncState. The sim continues from
+  // the frame after it, rewinding or skipping ahead as needed; inputs
+  // already exchanged for the frames in between are reused. Drops the
+  // shadow game, since its recording cannot reproduce an adopted state.
+  // False (and nothing changed) if the state doesn't fit this match.
+  bool ApplyResyncState(uint8_t const* data, std::size_t len);
+  uint32_t ResyncCount() const { return resyncCount_; }
 
   // Frames the resim loop replayed during the most recent process() tick.
   // Reset each tick. Used by the dev HUD overlay (`RB:n`).
@@ -149,13 +217,17 @@ struct RollbackController : CommonController {
   // last reported simFrame. 5 absorbs natural ±1-2 frame jitter between
   // two independent 70 fps processes (lower values caused a ~25% stall
   // rate on a quiet loopback link) while still leaving 2 frames of headroom
-  // before the kMaxRollback=7 stall fires.
+  // before the kMaxRollback=7 stall fires. Wider windows keep the same
+  // 2-frame headroom, so the one-way trip of a long link doesn't count
+  // against it.
   static constexpr int32_t kFrameAdvantage = 5;
+  static constexpr int32_t kFrameAdvantageHeadroom = 2;
 
   // Test hook: raises the threshold high enough that the stall never
   // fires, so tests exercising loss/reorder can freely run ahead.
   void SetFrameAdvantageEnabled(bool enabled) {
-    frameAdvantageThreshold_ = enabled ? kFrameAdvantage : INT32_MAX;
+    frameAdvantageThreshold_ =
+        enabled ? std::max(kFrameAdvantage, maxRollback_ - kFrameAdvantageHeadroom) : INT32_MAX;
   }
 
   Game game;
@@ -177,6 +249,17 @@ struct RollbackController : CommonController {
   // Idempotent via the state check.
   void FinishWeaponSelect();
   void SendInputWindow(uint32_t newest_frame, uint32_t local_frame);
+  // Packs the local control state into every frame from the last one
+  // written up to simFrame + inputDelay. Filling a gap (delay grew) or
+  // skipping (delay shrank) keeps each frame written exactly once.
+  void WriteLocalInput();
+  // Per-tick time sync: sends the periodic message, takes this tick's
+  // frame stretch and steps inputDelay toward the agreed value.
+  void UpdateTimeSync();
+  // Our sim frame minus the peer's estimated current one.
+  float LocalLead() const;
+  // Feeds the stall histogram; `stalled` is whether this tick held.
+  void NoteStall(bool stalled);
   // Full controller state reset for a phase transition. Clears the
   // input ring, snapshot ring, frame counters, and edge-detection state;
   // bumps generation_.
@@ -195,7 +278,10 @@ struct RollbackController : CommonController {
   bool goingToMenu_{false};
 
   uint32_t simFrame_{0};
+  // Rollback window; see SetMaxRollback.
+  int32_t maxRollback_{rollback::kMaxRollback};
   uint32_t inputDelay_{3};
+  uint32_t minInputDelay_{3};
   // simFrame + inputDelay of the most recent local input we packed into
   // localInputs[]. Empty (no input packed yet this phase) when false.
   uint32_t lastSentFrame_{0};
@@ -228,22 +314,25 @@ struct RollbackController : CommonController {
   // never resimmed). Hosts the player-facing NormalStatsRecorder (the
   // live game's is replaced with a no-op since its processFrame fires
   // speculatively) and feeds a ReplayWriter so multiplayer matches
-  // produce .lrp recordings. Owning a second Game would double sim
-  // cost in the worst case; we only advance it as confirmations land,
-  // so steady-state cost is one extra processFrame per real tick (no
-  // rollback amplification).
+  // produce .lrp recordings. It advances once per confirmed frame on
+  // shadowWorker_'s thread, so the game thread only pays for the live
+  // sim and its resims. Declared after shadowGame_ so the worker is
+  // joined before the Game it drives is destroyed.
   std::unique_ptr<Game> shadowGame_;
-  std::unique_ptr<ReplayWriter> shadowReplay_;
+  std::unique_ptr<ShadowWorker> shadowWorker_;
   std::unique_ptr<io::Writer> replayWriterOverride_;
+  // Last confirmed frame handed to the worker.
   int32_t shadowFrame_ = -1;
-  uint8_t shadowLocalPrevInput_ = 0;
-  uint8_t shadowRemotePrevInput_ = 0;
-  bool shadowMismatchLogged_ = false;
 
   void SetupShadowGame();
-  void StartReplayRecording();
+  std::unique_ptr<ReplayWriter> StartReplayRecording();
   void StopReplayRecording();
   void DriveShadow();
+  // Blocks until the worker has processed every queued frame. Needed
+  // before the game thread reads shadowGame_.
+  void SyncShadow();
+  // Joins the worker and drops the shadow Game (and its recording).
+  void DropShadow();
 
   // Prepare the rollback ring (idempotent), seed slot 0 with the
   // post-startGame state, then construct the shadow Game. Shared by
@@ -251,6 +340,11 @@ struct RollbackController : CommonController {
   // (focus's StateInitial branch).
   void SeedRollbackAndShadow();
 
+  // Moves the level's delta base up to the confirmed frame's slot once
+  // enough has been dug (Game::RebaseLevelDelta). Keeps delta slots and
+  // the per-save copy bounded by the rollback window, not the match.
+  void RebaseLevel();
+
   InputBatchSendCallback sendInputBatch_;
   ChecksumSendCallback sendChecksum_;
 
@@ -258,6 +352,7 @@ struct RollbackController : CommonController {
   std::function<void()> onLocalResume_;
   std::function<void()> onEndMatch_;
   std::function<void()> onPeerLeft_;
+  std::function<void()> inputPump_;
 
   std::unique_ptr<WeaponSelection> ws_;
 
@@ -266,6 +361,9 @@ struct RollbackController : CommonController {
   // generated.
   rollback::RollbackBuffer rollbackBuffer_;
   bool rollbackBufferPrepared_{false};
+  // Slots after the confirmed frame, gathered by RebaseLevel(). Reserved
+  // to the ring's capacity when it is prepared.
+  std::vector<GameSnapshot*> rebaseLater_;
 
   // Prediction state.
   // confirmedSimFrame_ — highest simFrame already advanced whose remote
@@ -277,10 +375,29 @@ struct RollbackController : CommonController {
   uint8_t lastRemoteInput_{0};
 
   uint64_t rollbackCount_ = 0;
+  uint32_t resyncCount_ = 0;
   uint32_t lastTickResimFrames_ = 0;
+  rollback::Histogram rollbackDepth_;
+  rollback::Histogram stallRuns_;
+  uint32_t stallRun_ = 0;
+
+  TimeSyncSendCallback sendTimeSync_;
+  rollback::TimeSync timeSync_;
+  int frameStretchMs_ = 0;
+  // Ticks between one-frame input-delay steps, so a change is felt
+  // before the next one is considered.
+  static constexpr uint32_t kDelayStepTicks = 70;
+  uint32_t lastDelayStepTick_ = 0;
+
+  // Peer's ack (see InjectInputAck); 0 until one arrives this phase,
+  // which keeps the window at the full K.
+  uint32_t peerNeededFrame_ = 0;
+  uint8_t peerLossQ8_ = 0;
 
   // Monotonic; stale packets carrying smaller frames are ignored.
   int32_t lastKnownRemoteFrame_ = -1;
+  // timeSync_ tick at which lastKnownRemoteFrame_ last moved.
+  uint32_t lastKnownRemoteTick_ = 0;
   uint64_t frameAdvantageStalls_ = 0;
   int32_t frameAdvantageThreshold_ = kFrameAdvantage;
 
@@ -290,19 +407,21 @@ struct RollbackController : CommonController {
 
   // Bounded queue for batches arriving from a peer that has already
   // crossed the next phase boundary while we haven't yet. Capacity
-  // matches the K-wide redundancy so one full peer-side resend fits.
+  // matches the K-wide redundancy so one full peer-side resend fits:
+  // K entries are used of the kMaxPendingFutureBatches reserved for the
+  // widest window.
   //
-  // Stall budget: at 70 Hz the peer emits one batch per tick, so 8 slots
-  // buffers ~115 ms of "peer ahead" before we start dropping. The local
-  // phase transition is driven by the same confirmed-frame stream and
-  // typically fires within 1–2 ticks of the peer's, so this is well
-  // above the observed worst case.
+  // Stall budget: at 70 Hz the peer emits one batch per tick, so the
+  // default 8 slots buffer ~115 ms of "peer ahead" before we start
+  // dropping. The local phase transition is driven by the same
+  // confirmed-frame stream and typically fires within 1–2 ticks of the
+  // peer's, so this is well above the observed worst case.
   static constexpr uint8_t kMaxPendingFutureBatches =
-      static_cast<uint8_t>(rollback::kMaxRollback + 1);
+      static_cast<uint8_t>(rollback::kMaxRollbackLimit + 1);
   struct PendingFutureBatch {
     uint32_t base_frame;
     uint8_t count;
-    std::array<uint8_t, rollback::kMaxRollback + 1> inputs;
+    std::array<uint8_t, rollback::kMaxRollbackLimit + 1> inputs;
     uint32_t remote_local_frame;
   };
   std::array<PendingFutureBatch, kMaxPendingFutureBatches> pendingFutureBatches_{};
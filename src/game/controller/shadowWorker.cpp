@@ -0,0 +1,129 @@
+#include "shadowWorker.hpp"
+
+#include "../game.hpp"
+#include "../profiling.hpp"
+#include "../replay.hpp"
+#include "../serialization/snapshot_checksum.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+ShadowWorker::ShadowWorker(Game& shadow, std::unique_ptr<ReplayWriter> replay)
+    : shadow_(shadow), replay_(std::move(replay)), scratch_(std::make_unique<GameSnapshot>()) {
+  // Only used to checksum, so hold just the dug cells.
+  scratch_->Prepare(shadow_, GameSnapshot::LevelStorage::kDelta);
+  try {
+    thread_ = std::thread(&ShadowWorker::Run, this);
+  } catch (std::system_error const&) {
+    // No threads: Push() steps the shadow inline.
+  }
+}
+
+ShadowWorker::~ShadowWorker() {
+  if (thread_.joinable()) {
+    {
+      std::scoped_lock const kLock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+}
+
+void ShadowWorker::Push(Frame const& frame) {
+  if (!thread_.joinable()) {
+    Step(frame);
+    return;
+  }
+  {
+    std::scoped_lock const kLock(mutex_);
+    queue_.push_back(frame);
+  }
+  wake_.notify_one();
+}
+
+void ShadowWorker::Wait() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+void ShadowWorker::StopRecording() {
+  Wait();
+  // ReplayWriter's destructor writes the 0x83 terminator and finishes the
+  // stream.
+  replay_.reset();
+}
+
+void ShadowWorker::Run() {
+  trace::SetThreadName("rollback shadow");
+  std::vector<Frame> batch;
+  for (;;) {
+    {
+      std::unique_lock lock(mutex_);
+      busy_ = false;
+      if (queue_.empty()) {
+        idle_.notify_all();
+      }
+      wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      batch.swap(queue_);
+      busy_ = true;
+    }
+    for (Frame const& frame : batch) {
+      Step(frame);
+    }
+    batch.clear();
+  }
+}
+
+void ShadowWorker::Step(Frame const& frame) {
+  ZoneScopedN("Rollback::Shadow");
+  for (int idx = 0; idx < 2; ++idx) {
+    uint8_t const kCur = frame.inputs[idx];
+    uint8_t const kRising = kCur & ~prev_inputs_[idx];
+    uint8_t const kReleased = prev_inputs_[idx] & ~kCur;
+    shadow_.worms[idx]->control_states.istate |= kRising;
+    shadow_.worms[idx]->control_states.istate &= ~kReleased;
+    prev_inputs_[idx] = kCur;
+  }
+
+  // recordFrame() reads worm.controlStates ^ prevControlStates, so it
+  // must run after edge detection but before processFrame() (which
+  // sets prev = current at end of tick, wiping the delta).
+  if (replay_) {
+    try {
+      replay_->RecordFrame();
+    } catch (std::runtime_error& e) {
+      std::fprintf(stderr, "[replay] aborting recording at frame %d: %s\n", frame.frame,
+                   e.what());
+      replay_.reset();
+    }
+  }
+
+  shadow_.ProcessFrame();
+
+  // Sanity check: the shadow must match the live game's confirmed
+  // state for the same frame. Log once on divergence so the breakage
+  // surfaces without spamming stderr.
+  shadow_.SaveSnapshotFast(*scratch_);
+  uint32_t const kShadowChk = SnapshotChecksum(*scratch_, shadow_.level);
+  if (kShadowChk != frame.checksum &&
+      mismatches_.fetch_add(1, std::memory_order_relaxed) == 0) {
+    std::fprintf(stderr,
+                 "[replay shadow] mismatch at frame %d: shadow=%08x live=%08x input0=%02x "
+                 "input1=%02x shadowRand=%08x\n",
+                 frame.frame, kShadowChk, frame.checksum, frame.inputs[0], frame.inputs[1],
+                 shadow_.rand.last);
+  }
+  // Every shadow frame is confirmed, so the scratch slot is always a
+  // valid delta base and nothing later depends on the old one.
+  shadow_.RebaseLevelDelta(*scratch_, {});
+  processed_.store(frame.frame, std::memory_order_release);
+}
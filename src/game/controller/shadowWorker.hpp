@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Game;
+struct GameSnapshot;
+struct ReplayWriter;
+
+// Runs the rollback controller's shadow Game on its own thread.
+//
+// The shadow advances once per confirmed frame and never rolls back, so it
+// only needs the confirmed input pair for each frame plus the live game's
+// checksum to verify against. The controller pushes those as they land and
+// moves on; the worker applies the inputs with the same edge detection the
+// live path uses, records the frame to the replay, runs ProcessFrame and
+// compares checksums (SnapshotChecksum, via a scratch snapshot of its own).
+// Mismatches are logged from the worker and counted.
+//
+// The worker owns the replay writer. The shadow Game (and its stats
+// recorder) is owned by the controller but belongs to the worker while it
+// runs: call Wait() before touching it from the game thread.
+//
+// Without thread support (std::thread throws) frames run inline in Push().
+class ShadowWorker {
+ public:
+  struct Frame {
+    int32_t frame = 0;
+    // Confirmed input bytes, indexed by worm.
+    uint8_t inputs[2] = {};
+    // Live game's SnapshotChecksum after this frame.
+    uint32_t checksum = 0;
+  };
+
+  ShadowWorker(Game& shadow, std::unique_ptr<ReplayWriter> replay);
+  ~ShadowWorker();
+
+  ShadowWorker(ShadowWorker const&) = delete;
+  ShadowWorker& operator=(ShadowWorker const&) = delete;
+
+  // Queues a confirmed frame. Never waits for the worker.
+  void Push(Frame const& frame);
+  // Blocks until every pushed frame has been processed.
+  void Wait();
+  // Waits, then finishes and closes the replay (if any).
+  void StopRecording();
+
+  // Last frame the shadow has processed; -1 before the first.
+  int32_t ProcessedFrame() const { return processed_.load(std::memory_order_acquire); }
+  uint32_t Mismatches() const { return mismatches_.load(std::memory_order_relaxed); }
+
+ private:
+  void Run();
+  void Step(Frame const& frame);
+
+  Game& shadow_;
+  std::unique_ptr<ReplayWriter> replay_;
+  std::unique_ptr<GameSnapshot> scratch_;
+  uint8_t prev_inputs_[2] = {};
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::vector<Frame> queue_;
+  bool busy_ = false;
+  bool stop_ = false;
+
+  std::atomic<int32_t> processed_{-1};
+  std::atomic<uint32_t> mismatches_{0};
+
+  std::thread thread_;
+};
@@ -504,15 +504,7 @@ struct FsNodeZipFile : FsNodeImp {
     free(ptr);  // NOLINT(cppcoreguidelines-no-malloc, hicpp-no-malloc) — miniz hands ownership back
                 // via plain C `free`; we cannot use RAII at the API boundary.
 
-    struct OwnedMemReader : io::Reader {
-      std::vector<uint8_t> data;
-      io::MemReader inner;
-      explicit OwnedMemReader(std::vector<uint8_t>&& d)
-          : data(std::move(d)), inner(data.data(), data.size()) {}
-      uint8_t Get() override { return inner.Get(); }
-      std::size_t TryGet(uint8_t* dst, std::size_t n) override { return inner.TryGet(dst, n); }
-    };
-    return std::make_unique<OwnedMemReader>(std::move(data));
+    return std::make_unique<io::BufferReader>(std::move(data));
   }
 
   std::unique_ptr<io::Writer> TryToWriter() override {
@@ -566,7 +558,16 @@ struct FsNodeFilesystem : FsNodeImp {
       return nullptr;
     }
 
-    return std::make_unique<io::FileReader>(f, io::FileReader::OwnFile{});
+    // Everything read through FsNode (TC files, levels, replays, setups)
+    // is small, so read it whole: the parsers then work on a buffer
+    // instead of pulling bytes through fgetc. Anything huge streams.
+    static constexpr std::size_t kMaxBufferedFile = 64 * 1024 * 1024;
+    std::size_t const kLen = FileLength(f);
+    auto file = std::make_unique<io::FileReader>(f, io::FileReader::OwnFile{});
+    if (kLen > kMaxBufferedFile) {
+      return file;
+    }
+    return io::BufferReader::ReadFrom(*file, kLen);
   }
 
   std::unique_ptr<io::Writer> TryToWriter() override {
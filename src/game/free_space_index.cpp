@@ -0,0 +1,122 @@
+#include "free_space_index.hpp"
+
+#include <algorithm>
+#include "level.hpp"
+#include "parallel.hpp"
+#include "rand.hpp"
+
+static_assert(FreeSpaceIndex::kTileShift == Level::kRenderTileShift);
+
+namespace {
+constexpr int kTileCells = FreeSpaceIndex::kTileSize * FreeSpaceIndex::kTileSize;
+}  // namespace
+
+void FreeSpaceIndex::CountTile(Level const& level, std::size_t tile) {
+  int const kX0 = static_cast<int>(tile % tiles_w_) << kTileShift;
+  int const kY0 = static_cast<int>(tile / tiles_w_) << kTileShift;
+  int const kW = std::min(kTileSize, width_ - kX0);
+  int const kH = std::min(kTileSize, height_ - kY0);
+  uint16_t* sums = &sums_[tile * kTileCells];
+
+  // Cells past the level edge count as free; queries are clipped anyway.
+  for (int ly = 0; ly < kTileSize; ++ly) {
+    Material const* row = ly < kH ? &level.materials[((kY0 + ly) * width_) + kX0] : nullptr;
+    uint16_t const* above = ly > 0 ? sums - kTileSize : nullptr;
+    uint16_t run = 0;
+    for (int lx = 0; lx < kTileSize; ++lx) {
+      if (row && lx < kW && (row[lx].flags & block_flags_) != 0) {
+        ++run;
+      }
+      sums[lx] = static_cast<uint16_t>(run + (above ? above[lx] : 0));
+    }
+    sums += kTileSize;
+  }
+}
+
+void FreeSpaceIndex::Update(Level const& level) {
+  bool const kTrackingStarted = level.EnsureRenderTiles();
+  if (kTrackingStarted || level_ != &level || epoch_ != level.render_epoch ||
+      width_ != level.width || height_ != level.height) {
+    level_ = &level;
+    epoch_ = level.render_epoch;
+    width_ = level.width;
+    height_ = level.height;
+    tiles_w_ = level.RenderTilesW();
+    std::size_t const kTiles = level.render_tile_revision.size();
+    sums_.resize(kTiles * kTileCells);
+    ParallelFor(kTiles, [&](std::size_t t) { CountTile(level, t); });
+    revision_ = level.render_revision;
+    return;
+  }
+
+  if (revision_ != level.render_revision) {
+    auto const& revisions = level.render_tile_revision;
+    for (std::size_t t = 0; t < revisions.size(); ++t) {
+      if (revisions[t] > revision_) {
+        CountTile(level, t);
+      }
+    }
+    revision_ = level.render_revision;
+  }
+}
+
+int FreeSpaceIndex::Count(Rect rect) const {
+  rect.Intersect(Rect(0, 0, width_, height_));
+  if (rect.x1 >= rect.x2 || rect.y1 >= rect.y2) {
+    return 0;
+  }
+
+  // Sum over the tiles the rect touches; spawn-sized rects touch at most 4.
+  int count = 0;
+  for (int ty = rect.y1 >> kTileShift; ty <= (rect.y2 - 1) >> kTileShift; ++ty) {
+    int const kY0 = ty << kTileShift;
+    int const kLy1 = std::max(rect.y1 - kY0, 0) - 1;
+    int const kLy2 = std::min(rect.y2 - kY0, kTileSize) - 1;
+    for (int tx = rect.x1 >> kTileShift; tx <= (rect.x2 - 1) >> kTileShift; ++tx) {
+      int const kX0 = tx << kTileShift;
+      int const kLx1 = std::max(rect.x1 - kX0, 0) - 1;
+      int const kLx2 = std::min(rect.x2 - kX0, kTileSize) - 1;
+      uint16_t const* sums = &sums_[((static_cast<std::size_t>(ty) * tiles_w_) + tx) * kTileCells];
+      auto at = [sums](int lx, int ly) {
+        return lx < 0 || ly < 0 ? 0 : static_cast<int>(sums[(ly * kTileSize) + lx]);
+      };
+      count += at(kLx2, kLy2) - at(kLx1, kLy2) - at(kLx2, kLy1) + at(kLx1, kLy1);
+    }
+  }
+  return count;
+}
+
+int FreeSpaceIndex::Blocked(Level const& level, Rect rect) {
+  Update(level);
+  return Count(rect);
+}
+
+bool FreeSpaceIndex::Sample(Level const& level, Rand& rand, int w, int h, Rect area,
+                            IVec2& pos) {
+  Update(level);
+  area.Intersect(Rect(0, 0, width_ - w + 1, height_ - h + 1));
+  if (w <= 0 || h <= 0 || area.x1 >= area.x2 || area.y1 >= area.y2) {
+    return false;
+  }
+
+  uint32_t free_count = 0;
+  for (int y = area.y1; y < area.y2; ++y) {
+    for (int x = area.x1; x < area.x2; ++x) {
+      free_count += Count(Rect(x, y, x + w, y + h)) == 0 ? 1 : 0;
+    }
+  }
+  if (free_count == 0) {
+    return false;
+  }
+
+  uint32_t pick = rand(free_count);
+  for (int y = area.y1; y < area.y2; ++y) {
+    for (int x = area.x1; x < area.x2; ++x) {
+      if (Count(Rect(x, y, x + w, y + h)) == 0 && pick-- == 0) {
+        pos = IVec2(x, y);
+        return true;
+      }
+    }
+  }
+  return false;
+}
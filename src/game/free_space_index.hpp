@@ -0,0 +1,68 @@
+#pragma once
+
+// Constant-time "is this rectangle free" queries over a Level, for spawn and
+// bonus placement that would otherwise test every cell of every candidate.
+//
+// A cell is blocked when its material has any of the index's flags. The
+// index keeps a summed-area table per level render tile and follows
+// Level::MarkDirty through the render tile revisions (EnsureRenderTiles), so
+// a query only recounts the tiles changed since the previous one. Answers
+// are exact: callers keep their candidate order and RNG use.
+//
+// A cache, like the render tile state it follows: never snapshotted or
+// hashed, and a copied index starts empty (Game copies made for AI
+// look-ahead rarely query it).
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "math/rect.hpp"
+
+struct Level;
+struct Rand;
+
+class FreeSpaceIndex {
+ public:
+  // Must match Level::kRenderTileShift; a tile's sums fit in uint16_t.
+  static constexpr int kTileShift = 5;
+  static constexpr int kTileSize = 1 << kTileShift;
+
+  explicit FreeSpaceIndex(uint8_t block_flags) : block_flags_(block_flags) {}
+  FreeSpaceIndex(FreeSpaceIndex const& other) : block_flags_(other.block_flags_) {}
+  FreeSpaceIndex& operator=(FreeSpaceIndex const& other) {
+    block_flags_ = other.block_flags_;
+    level_ = nullptr;
+    return *this;
+  }
+
+  // Blocked cells in `rect`, clipped to the level.
+  int Blocked(Level const& level, Rect rect);
+  // No blocked cell in `rect`, clipped to the level. Empty rects are free.
+  bool Free(Level const& level, Rect rect) { return Blocked(level, rect) == 0; }
+
+  // Picks uniformly among the free w x h rectangles inside the level whose
+  // top-left corner lies in `area`, using a single draw from `rand`. Returns
+  // false, without drawing, when there is none.
+  bool Sample(Level const& level, Rand& rand, int w, int h, Rect area, IVec2& pos);
+
+  // Brings the index up to date with `level` now, so that the first query
+  // doesn't pay for building it (Game::StartGame does this).
+  void Prepare(Level const& level) { Update(level); }
+
+ private:
+  void Update(Level const& level);
+  void CountTile(Level const& level, std::size_t tile);
+  // Blocked() against the index as it stands.
+  int Count(Rect rect) const;
+
+  uint8_t block_flags_;
+  Level const* level_ = nullptr;
+  uint32_t epoch_ = 0;
+  uint64_t revision_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  int tiles_w_ = 0;
+  // Per tile, kTileSize x kTileSize inclusive prefix sums: the entry for
+  // (lx, ly) counts the blocked cells in [0, lx] x [0, ly] of the tile.
+  std::vector<uint16_t> sums_;
+};
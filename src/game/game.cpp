@@ -1,5 +1,6 @@
 #include <SDL3/SDL.h>
 #include <algorithm>
+#include <cassert>
 #include <cstdlib>
 #include <ctime>
 
@@ -198,19 +199,7 @@ void Game::Draw(Renderer& renderer, GameState state, bool use_spectator_viewport
 }
 
 bool CheckBonusSpawnPosition(Game& game, int x, int y) {
-  Rect rect(x - 2, y - 2, x + 3, y + 3);
-
-  rect.Intersect(game.level.Bounds());
-
-  for (int cx = rect.x1; cx < rect.x2; ++cx) {
-    for (int cy = rect.y1; cy < rect.y2; ++cy) {
-      if (game.level.Mat(cx, cy).DirtRock()) {
-        return false;
-      }
-    }
-  }
-
-  return true;
+  return game.level.dirt_rock_space.Free(game.level, Rect(x - 2, y - 2, x + 3, y + 3));
 }
 
 void Game::CreateBonus() {
@@ -264,23 +253,31 @@ void Game::CreateBonus() {
   }  // 234F
 }
 
+template <Game::FrameMode kMode>
 void Game::ProcessFrame() {
   ZoneScopedN("Game::ProcessFrame");
-  stats_recorder->PreTick(*this);
+  // Viewports and the stats recorder only read sim state, never write it,
+  // so leaving them out can't change what the sim computes.
+  constexpr bool kPresent = kMode == FrameMode::kFull;
+  if constexpr (kPresent) {
+    stats_recorder->PreTick(*this);
+  }
 
   if (screen_flash > 0) {
     --screen_flash;
   }
 
-  for (auto& viewport : viewports) {
-    if (viewport->shake > 0) {
-      viewport->shake -= 4000;  // TODO: Read 4000 from exe?
+  if constexpr (kPresent) {
+    for (auto& viewport : viewports) {
+      if (viewport->shake > 0) {
+        viewport->shake -= 4000;  // TODO: Read 4000 from exe?
+      }
     }
-  }
 
-  for (auto& spectator_viewport : spectator_viewports) {
-    if (spectator_viewport->shake > 0) {
-      spectator_viewport->shake -= 4000;  // TODO: Read 4000 from exe?
+    for (auto& spectator_viewport : spectator_viewports) {
+      if (spectator_viewport->shake > 0) {
+        spectator_viewport->shake -= 4000;  // TODO: Read 4000 from exe?
+      }
     }
   }
 
@@ -289,7 +286,7 @@ void Game::ProcessFrame() {
     i->Process(*this);
   }
 
-  if ((cycles & 1) == 0) {
+  if (kPresent && (cycles & 1) == 0) {
     for (auto& viewport : viewports) {
       Viewport& v = *viewport;
 
@@ -331,26 +328,29 @@ void Game::ProcessFrame() {
     }
   }
 
-  auto sr = sobjects.All();
-  for (SObject* i = nullptr; (i = sr.Next());) {
-    i->Process(*this);
-  }
+  {
+    ZoneScopedN("Game::Objects");
+    auto sr = sobjects.All();
+    for (SObject* i = nullptr; (i = sr.Next());) {
+      i->Process(*this);
+    }
 
-  auto wr = wobjects.All();
-  for (WObject* i = nullptr; (i = wr.Next());) {
-    i->Process(*this);
-  }
+    auto wr = wobjects.All();
+    for (WObject* i = nullptr; (i = wr.Next());) {
+      i->Process(*this);
+    }
 
-  auto nr = nobjects.All();
-  for (NObject* i = nullptr; (i = nr.Next());) {
-    i->Process(*this);
-  }
+    auto nr = nobjects.All();
+    for (NObject* i = nullptr; (i = nr.Next());) {
+      i->Process(*this);
+    }
 
-  for (BObjectList::Iterator i = bobjects.Begin(); i != bobjects.End();) {
-    if (i->Process(*this)) {
-      ++i;
-    } else {
-      bobjects.Free(i);
+    for (BObjectList::Iterator i = bobjects.Begin(); i != bobjects.End();) {
+      if (i->Process(*this)) {
+        ++i;
+      } else {
+        bobjects.Free(i);
+      }
     }
   }
 
@@ -361,12 +361,15 @@ void Game::ProcessFrame() {
     CreateBonus();
   }
 
-  for (auto& worm : worms) {
-    worm->Process(*this);
-  }
+  {
+    ZoneScopedN("Game::Worms");
+    for (auto& worm : worms) {
+      worm->Process(*this);
+    }
 
-  for (auto& worm : worms) {
-    worm->ninjarope.Process(*worm, *this);
+    for (auto& worm : worms) {
+      worm->ninjarope.Process(*worm, *this);
+    }
   }
 
   switch (settings->game_mode) {
@@ -460,16 +463,23 @@ void Game::ProcessFrame() {
       break;
   }
 
-  ProcessViewports();
+  if constexpr (kPresent) {
+    ProcessViewports();
+  }
 
   // Store old control states so we can see what changes (mainly for replays)
   for (auto& worm : worms) {
     worm->prev_control_states = worm->control_states;
   }
 
-  stats_recorder->Tick(*this);
+  if constexpr (kPresent) {
+    stats_recorder->Tick(*this);
+  }
 }
 
+template void Game::ProcessFrame<Game::FrameMode::kFull>();
+template void Game::ProcessFrame<Game::FrameMode::kSimOnly>();
+
 void Game::Focus(Renderer& renderer) { UpdateSettings(renderer); }
 
 void Game::UpdateSettings(Renderer& renderer) {
@@ -512,6 +522,9 @@ void Game::StartGame() {
   sound_player->Play(common->sound_hook[SoundBegin]);
   bobjects.Resize(settings->blood_particle_max);
   stats_recorder->Reset(level.width, level.height);
+  // Built here rather than on the first spawn or bonus drop mid-match.
+  level.rock_space.Prepare(level);
+  level.dirt_rock_space.Prepare(level);
 
   if (settings->game_mode == Settings::kGmHoldazone) {
     SpawnZone();
@@ -637,6 +650,12 @@ bool CheckRespawnPosition(Game& game, int x2, int y2, int old_x, int old_y, int
   min_x = std::max(min_x, 0);
   min_y = std::max(min_y, 0);
 
+  // Same cells as the walk below, in constant time. The walk is kept for
+  // candidates past the level edge, where it runs on until it meets rock.
+  if (min_x <= max_x && min_y <= max_y) {
+    return game.level.rock_space.Free(game.level, Rect(min_x, min_y, max_x, max_y));
+  }
+
   for (int i = min_x; i != max_x; ++i) {
     for (int j = min_y; j != max_y; ++j) {
       if (game.level.Mat(i, j).Rock()) {  // TODO: The special rock respawn bug is here, consider an
@@ -688,6 +707,7 @@ void Game::LoadSnapshot(std::vector<uint8_t> const& in) {
 }
 
 void Game::SaveSnapshotFast(GameSnapshot& snap) {
+  ZoneScopedN("Game::SaveSnapshotFast");
   snap.rand = rand;
   snap.cycles = cycles;
   snap.screen_flash = screen_flash;
@@ -715,6 +735,30 @@ void Game::SaveSnapshotFast(GameSnapshot& snap) {
     std::memcpy(snap.bobjects_arr.data(), bobjects.arr.data(), bobjects.count * sizeof(BObject));
   }
 
+  if (snap.level_storage == GameSnapshot::LevelStorage::kDelta) {
+    // Delta slot: the current value of every cell dirtied since the delta
+    // base, in delta_list order. Cells outside that prefix still hold their
+    // delta base value, so nothing else needs storing. The list stays
+    // within what Prepare reserved unless one rollback window digs more.
+    if (level.delta_bits.empty()) {
+      level.InitDeltaTracking();
+    }
+    std::size_t const kCount = level.delta_list.size();
+    bool const kHasDv = !level.display_valid.empty();
+    snap.level_data.resize(kCount);
+    snap.level_display_valid.resize(kHasDv ? kCount : 0);
+    for (std::size_t i = 0; i < kCount; ++i) {
+      auto const kI = static_cast<std::size_t>(level.delta_list[i]);
+      snap.level_data[i] = level.material_id[kI];
+      if (kHasDv) {
+        snap.level_display_valid[i] = level.display_valid[kI];
+      }
+    }
+    snap.delta_epoch = level.delta_epoch;
+    snap.initialized = true;
+    return;
+  }
+
   std::size_t const kCells =
       static_cast<std::size_t>(level.width) * static_cast<std::size_t>(level.height);
   if (snap.level_data.size() != kCells) {
@@ -757,6 +801,7 @@ void Game::SaveSnapshotFast(GameSnapshot& snap) {
 }
 
 void Game::LoadSnapshotFast(GameSnapshot const& snap) {
+  ZoneScopedN("Game::LoadSnapshotFast");
   rand = snap.rand;
   cycles = snap.cycles;
   screen_flash = snap.screen_flash;
@@ -779,9 +824,31 @@ void Game::LoadSnapshotFast(GameSnapshot const& snap) {
                 snap.bobjects_count * sizeof(BObject));
   }
 
+  if (snap.level_storage == GameSnapshot::LevelStorage::kDelta) {
+    LoadLevelDelta(snap);
+    return;
+  }
+
   std::size_t const kCells =
       static_cast<std::size_t>(level.width) * static_cast<std::size_t>(level.height);
   if (kCells > 0) {
+    // Cells the restore actually changes must reach render-side caches too;
+    // only ever-dirtied cells can differ from the snapshot.
+    if (!level.render_tile_revision.empty()) {
+      if (level.dirty_bits.empty()) {
+        level.InvalidateRender();
+      } else {
+        bool const kHasDisplay = !snap.level_display_valid.empty() && !level.display_valid.empty();
+        for (int32_t const kDirtyIdx : level.dirty_list) {
+          auto const kI = static_cast<std::size_t>(kDirtyIdx);
+          if (level.material_id[kI] != snap.level_data[kI] ||
+              (kHasDisplay && level.display_valid[kI] != snap.level_display_valid[kI])) {
+            level.MarkDirty(kDirtyIdx);
+          }
+        }
+      }
+    }
+
     // Restore material_id (full memcpy; the slot is pre-filled at Prepare() and
     // dirty cells are overwritten on each save, so the slot is always complete).
     std::memcpy(level.material_id.data(), snap.level_data.data(), kCells);
@@ -792,9 +859,7 @@ void Game::LoadSnapshotFast(GameSnapshot const& snap) {
     // full O(W×H) pass when dirty tracking hasn't been initialised yet (e.g.
     // on the shadow-game bootstrap LoadSnapshotFast).
     if (level.dirty_bits.empty()) {
-      for (std::size_t i = 0; i < kCells; ++i) {
-        level.materials[i] = common->materials[level.material_id[i]];
-      }
+      level.RebuildMaterials(*common);
     } else {
       for (int32_t const kDirtyIdx : level.dirty_list) {
         auto const kI = static_cast<std::size_t>(kDirtyIdx);
@@ -807,3 +872,141 @@ void Game::LoadSnapshotFast(GameSnapshot const& snap) {
     std::memcpy(level.display_valid.data(), snap.level_display_valid.data(), kCells);
   }
 }
+
+void Game::LoadLevelDelta(GameSnapshot const& snap) {
+  if (!snap.initialized) {
+    // Never saved: the slot only carries sim fields (ApplyResyncState
+    // fills one from the wire), so the level stays as it is.
+    return;
+  }
+  if (level.delta_bits.empty()) {
+    // No tracking yet (the shadow-game bootstrap copies the level itself):
+    // the cells already hold the saved state, only materials are missing.
+    level.RebuildMaterials(*common);
+    return;
+  }
+  assert(snap.delta_epoch == level.delta_epoch);
+
+  // Only cells in delta_list can differ from the slot. The first
+  // level_data.size() of them were saved; the rest were first dirtied
+  // after the save and still held their delta base value then.
+  std::size_t const kSaved = snap.level_data.size();
+  bool const kHasDv = !level.display_valid.empty() &&
+                      !level.delta_base_display_valid.empty() &&
+                      snap.level_display_valid.size() == kSaved;
+  bool const kTrackRender = !level.render_tile_revision.empty();
+  for (std::size_t i = 0; i < level.delta_list.size(); ++i) {
+    int32_t const kDirtyIdx = level.delta_list[i];
+    auto const kI = static_cast<std::size_t>(kDirtyIdx);
+    bool const kWasSaved = i < kSaved;
+    uint8_t const kMat = kWasSaved ? snap.level_data[i] : level.delta_base_material_id[kI];
+    bool changed = level.material_id[kI] != kMat;
+    if (kHasDv) {
+      uint8_t const kDv =
+          kWasSaved ? snap.level_display_valid[i] : level.delta_base_display_valid[kI];
+      changed = changed || level.display_valid[kI] != kDv;
+      level.display_valid[kI] = kDv;
+    }
+    // Already in delta_list, so this only stamps the render tile (and
+    // dirty_list, if whole-level slots are tracked as well).
+    if (changed && kTrackRender) {
+      level.MarkDirty(kDirtyIdx);
+    }
+    level.material_id[kI] = kMat;
+    level.materials[kI] = common->materials[kMat];
+  }
+}
+
+bool Game::CanLoadSnapshotFast(GameSnapshot const& snap) const {
+  return snap.level_storage != GameSnapshot::LevelStorage::kDelta || !snap.initialized ||
+         level.delta_bits.empty() || snap.delta_epoch == level.delta_epoch;
+}
+
+void Game::RebaseLevelDelta(GameSnapshot& base, std::span<GameSnapshot* const> later,
+                            std::size_t min_cells) {
+  if (base.level_storage != GameSnapshot::LevelStorage::kDelta || !base.initialized ||
+      base.level_data.empty() || level.delta_bits.empty() || level.delta_list.size() < min_cells ||
+      base.delta_epoch != level.delta_epoch) {
+    return;
+  }
+  for (GameSnapshot const* s : later) {
+    if (s->delta_epoch != level.delta_epoch) {
+      return;
+    }
+  }
+  ZoneScopedN("Game::RebaseLevelDelta");
+
+  // One pass over the list. Each cell `base` saved moves the delta base
+  // (and its digest) to that value. It stays listed if the live level or
+  // a later slot holds something else for it; cells first dirtied after
+  // `base` was saved always stay. The kept entries are compacted to the
+  // front of the list and of every later slot, in order, so each slot
+  // still holds a prefix of the list.
+  std::vector<int32_t>& list = level.delta_list;
+  std::size_t const kBaseSaved = base.level_data.size();
+  bool const kHasDv = !level.display_valid.empty() && !level.delta_base_display_valid.empty() &&
+                      base.level_display_valid.size() == kBaseSaved;
+  std::size_t kept = 0;
+  for (std::size_t k = 0; k < list.size(); ++k) {
+    auto const kI = static_cast<std::size_t>(list[k]);
+    for (GameSnapshot* s : later) {
+      // A slot whose entries end here keeps the ones compacted so far.
+      if (s->level_data.size() == k) {
+        s->level_data.resize(kept);
+        s->level_display_valid.resize(kHasDv ? kept : 0);
+      }
+    }
+
+    bool keep = k >= kBaseSaved;
+    if (!keep) {
+      uint8_t const kMat = base.level_data[k];
+      uint8_t const kDv = kHasDv ? base.level_display_valid[k] : 0;
+      uint8_t const kOldMat = level.delta_base_material_id[kI];
+      uint8_t const kOldDv = kHasDv ? level.delta_base_display_valid[kI] : 0;
+      level.delta_base_digest +=
+          Level::CellDigest(kI, kMat, kDv) - Level::CellDigest(kI, kOldMat, kOldDv);
+      level.delta_base_material_id[kI] = kMat;
+      if (kHasDv) {
+        level.delta_base_display_valid[kI] = kDv;
+      }
+      keep = level.material_id[kI] != kMat || (kHasDv && level.display_valid[kI] != kDv);
+      for (GameSnapshot const* s : later) {
+        if (keep) {
+          break;
+        }
+        keep = k < s->level_data.size() &&
+               (s->level_data[k] != kMat || (kHasDv && s->level_display_valid[k] != kDv));
+      }
+    }
+    if (!keep) {
+      level.delta_bits[kI] = false;
+      continue;
+    }
+    list[kept] = list[k];
+    for (GameSnapshot* s : later) {
+      if (k < s->level_data.size()) {
+        s->level_data[kept] = s->level_data[k];
+        if (kHasDv) {
+          s->level_display_valid[kept] = s->level_display_valid[k];
+        }
+      }
+    }
+    ++kept;
+  }
+  for (GameSnapshot* s : later) {
+    if (s->level_data.size() == list.size()) {
+      s->level_data.resize(kept);
+      s->level_display_valid.resize(kHasDv ? kept : 0);
+    }
+  }
+  list.resize(kept);
+
+  // `base` is now the delta base itself.
+  ++level.delta_epoch;
+  base.level_data.clear();
+  base.level_display_valid.clear();
+  base.delta_epoch = level.delta_epoch;
+  for (GameSnapshot* s : later) {
+    s->delta_epoch = level.delta_epoch;
+  }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <string>
 #include <vector>
 #include "bobject.hpp"
@@ -53,6 +54,15 @@ struct Game {
   void OnKey(uint32_t key, bool state);
   Worm* FindControlForKey(uint32_t key, Worm::Control& control);
   void ReleaseControls();
+  // What ProcessFrame runs besides the simulation itself.
+  //   kFull: also viewport shake/banners/camera (ProcessViewports) and the
+  //     stats recorder's per-frame PreTick/Tick.
+  //   kSimOnly: sim state only, for frames that are never shown on their
+  //     own (rollback resim, AI lookahead). Sim state and checksums are
+  //     bit-identical to kFull; sim-driven sounds and stats hooks are
+  //     still gated by SetSpeculative.
+  enum class FrameMode : uint8_t { kFull, kSimOnly };
+  template <FrameMode kMode = FrameMode::kFull>
   void ProcessFrame();
   void Focus(Renderer& renderer);
   void UpdateSettings(Renderer& renderer);
@@ -88,9 +98,21 @@ struct Game {
   // Writes/reads directly into a pre-allocated GameSnapshot — no
   // serialisation, no allocation in the steady state.
   // SaveSnapshotFast is non-const: on the first call it initialises dirty
-  // tracking on the level (Level::InitDirtyTracking).
+  // tracking on the level (Level::InitDirtyTracking, or InitDeltaTracking
+  // for delta slots).
   void SaveSnapshotFast(struct GameSnapshot& snap);
   void LoadSnapshotFast(struct GameSnapshot const& snap);
+  // LoadSnapshotFast's level restore for GameSnapshot::LevelStorage::kDelta.
+  void LoadLevelDelta(struct GameSnapshot const& snap);
+  // False for a kDelta slot saved before the delta base last moved: it
+  // describes a frame older than the confirmed one the base moved to.
+  bool CanLoadSnapshotFast(struct GameSnapshot const& snap) const;
+  // Moves the level's delta base up to `base`, a confirmed kDelta slot,
+  // once Level::delta_list has reached `min_cells`. `later` are the slots
+  // saved after it, which are re-expressed against the new base; every
+  // older slot can no longer be loaded. Allocation-free.
+  void RebaseLevelDelta(struct GameSnapshot& base, std::span<struct GameSnapshot* const> later,
+                        std::size_t min_cells = Level::kDeltaRebaseCells);
 
   void SpawnZone();
 
@@ -1,5 +1,6 @@
 #include <SDL3/SDL.h>
 
+#include "alloc_tracker.hpp"
 #include "console.hpp"
 #include "constants.hpp"
 #include "filesystem.hpp"
@@ -9,10 +10,13 @@
 #include "math.hpp"
 #include "mixer/player.hpp"
 #include "reader.hpp"
+#include "tc_cache.hpp"
 #include "text.hpp"
+#include "trace.hpp"
 #include "viewport.hpp"
 #include "worm.hpp"
 
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <exception>
@@ -63,8 +67,8 @@ int GameEntry(int argc, char* argv[]) try {
 
   // TC loading
   FsNode const kLieroRoot(kConfigNode / "TC" / gfx.settings->tc);
-  std::shared_ptr<Common> const kCommon = std::make_shared<Common>();
-  kCommon->load(kLieroRoot);
+  std::shared_ptr<Common> const kCommon =
+      LoadCommonCached(kLieroRoot, TcCacheNode(gfx.settings->tc));
   gfx.common = kCommon;
   gfx.play_renderer.LoadPalette(*kCommon);
   gfx.SetColorMode(gfx.settings->modern_colors ? ColorMode::kModern : ColorMode::kClassic);
@@ -73,8 +77,14 @@ int GameEntry(int argc, char* argv[]) try {
   gfx.sound_player = std::make_shared<DefaultSoundPlayer>(*kCommon);
   g_sound_player = gfx.sound_player.get();
 
+  trace::SetThreadName("main");
   gfx.MainLoop();
 
+#ifdef OPENLIERO_ENABLE_ALLOC_TRACKING
+  // The main thread's allocations over the session, by profiler zone.
+  alloc_tracker::PrintThreadReport(stderr);
+#endif
+
   gfx.settings->save(kUserConfigNode / "Setups" / "liero.cfg", gfx.rand);
 
   g_sound_player = nullptr;
@@ -93,6 +93,12 @@ bool GamePlayState::Update() {
     return false;
   }
 
+  // Online play slows the leading peer by stretching frames rather than
+  // stalling the sim (see RollbackController::FrameStretchMs).
+  if (auto* rollback = dynamic_cast<RollbackController*>(gfx->controller.get())) {
+    gfx->frame_stretch_ms = rollback->FrameStretchMs();
+  }
+
   return true;
 }
 
@@ -3,11 +3,16 @@
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <memory>
 #include <random>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -16,6 +21,7 @@
 #include <emscripten.h>
 #endif
 
+#include "console.hpp"
 #include "filesystem.hpp"
 #include "game.hpp"
 #include "gfx.hpp"
@@ -43,6 +49,11 @@
 // NOLINTNEXTLINE(bugprone-throwing-static-initialization, cert-err58-cpp) — global Gfx is the platform singleton; an exception here means program startup itself has failed.
 Gfx gfx;
 
+// Automatic dumps of over-budget frames: at most one per cooldown, so a
+// slow stretch is dumped once, and a handful per session.
+constexpr int64_t kSlowFrameDumpCooldownNs = int64_t{10} * 1'000'000'000;
+constexpr int kMaxSlowFrameDumps = 16;
+
 struct KeyBehavior : ItemBehavior {
   KeyBehavior(Common& common, uint32_t& key, uint32_t& key_ex, uint32_t& gamepad_key,
               uint32_t& input_device, bool extended = false)
@@ -302,6 +313,10 @@ void Gfx::SetVideoMode() {
     sdl_spectator_world_texture = nullptr;
     sdl_spectator_world_texture_w = 0;
     sdl_spectator_world_texture_h = 0;
+    sdl_spectator_level_texture = nullptr;
+    sdl_spectator_level_texture_w = 0;
+    sdl_spectator_level_texture_h = 0;
+    spectator_level_texture_failed = false;
   }
   if (settings->spectator_window) {
     if (!sdl_spectator_window) {
@@ -455,6 +470,14 @@ void Gfx::LoadMenus() {
   hidden_menu.AddItem(MenuItem(48, 7, "SPECTATOR WINDOW", HiddenMenu::kSpectatorWindow));
   hidden_menu.AddItem(
       MenuItem(48, 7, "MAX SPECTATOR RES (H)", HiddenMenu::kMaxSpectatorRenderHeight));
+  hidden_menu.AddItem(
+      MenuItem(48, 7, "RESIDENT SPECTATOR MAP", HiddenMenu::kSpectatorResidentLevel));
+  hidden_menu.AddItem(MenuItem(48, 7, "NETWORK THREAD", HiddenMenu::kNetIoThread));
+  hidden_menu.AddItem(MenuItem(48, 7, "ROLLBACK WINDOW", HiddenMenu::kRollbackWindow));
+  hidden_menu.AddItem(MenuItem(48, 7, "EXPORT MATCH STATS", HiddenMenu::kExportMatchStats));
+  hidden_menu.AddItem(MenuItem(48, 7, "MAP GENERATOR", HiddenMenu::kLevelGenerator));
+  hidden_menu.AddItem(MenuItem(48, 7, "TRACE ZONES", HiddenMenu::kTraceZones));
+  hidden_menu.AddItem(MenuItem(48, 7, "TRACE BUDGET (MS)", HiddenMenu::kTraceFrameBudget));
 
   player_menu.AddItem(MenuItem(3, 7, "PROFILE LOADED", PlayerMenu::kPlLoadedProfile));
   player_menu.AddItem(MenuItem(3, 7, "SAVE PROFILE", PlayerMenu::kPlSaveProfile));
@@ -1054,6 +1077,42 @@ bool Gfx::SpectatorGpuComposite() const {
          sdl_spectator_texture != nullptr && primary_renderer != &single_screen_renderer;
 }
 
+int Gfx::SpectatorResidentLevelMax() const {
+  if (!settings->spectator_resident_level || !sdl_spectator_renderer ||
+      spectator_level_texture_failed) {
+    return 0;
+  }
+  // The software renderer reports no limit.
+  Sint64 const kMax =
+      SDL_GetNumberProperty(SDL_GetRendererProperties(sdl_spectator_renderer),
+                            SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0);
+  return kMax > 0 ? static_cast<int>(std::min<Sint64>(kMax, INT_MAX)) : INT_MAX;
+}
+
+bool Gfx::EnsureSpectatorLevelTexture(int need_w, int need_h) {
+  if (!sdl_spectator_renderer || need_w <= 0 || need_h <= 0) {
+    return false;
+  }
+  if (sdl_spectator_level_texture && sdl_spectator_level_texture_w >= need_w &&
+      sdl_spectator_level_texture_h >= need_h) {
+    return false;
+  }
+  if (sdl_spectator_level_texture) {
+    SDL_DestroyTexture(sdl_spectator_level_texture);
+  }
+  sdl_spectator_level_texture = SDL_CreateTexture(sdl_spectator_renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                  SDL_TEXTUREACCESS_STREAMING, need_w, need_h);
+  sdl_spectator_level_texture_w = need_w;
+  sdl_spectator_level_texture_h = need_h;
+  if (!sdl_spectator_level_texture) {
+    spectator_level_texture_failed = true;
+    return false;
+  }
+  SDL_SetTextureScaleMode(sdl_spectator_level_texture, SDL_SCALEMODE_LINEAR);
+  SDL_SetTextureBlendMode(sdl_spectator_level_texture, SDL_BLENDMODE_NONE);
+  return true;
+}
+
 void Gfx::EnsureSpectatorWorldTexture(int need_w, int need_h) {
   if (!sdl_spectator_renderer || need_w <= 0 || need_h <= 0) {
     return;
@@ -1080,6 +1139,7 @@ void Gfx::EnsureSpectatorWorldTexture(int need_w, int need_h) {
 
 void Gfx::DrawSpectatorGpu(Renderer& renderer) {
   ZoneScopedN("Gfx::DrawSpectatorGpu");
+  SDL_Texture* const kPrevWorldTexture = sdl_spectator_world_texture;
   EnsureSpectatorWorldTexture(renderer.gpu_world_max_w, renderer.gpu_world_max_h);
   if (!sdl_spectator_world_texture) {
     // Allocation failed; present via the CPU path so the window isn't black.
@@ -1089,11 +1149,48 @@ void Gfx::DrawSpectatorGpu(Renderer& renderer) {
   }
 
   Bitmap const& world = *renderer.gpu_world_src;
-  // Upload only the used sub-rect; the scratch content is anchored at (0,0).
-  SDL_Rect const kUsed{
-      .x = 0, .y = 0, .w = renderer.gpu_world_used_w, .h = renderer.gpu_world_used_h};
-  SDL_UpdateTexture(sdl_spectator_world_texture, &kUsed, world.pixels,
-                    static_cast<int>(world.pitch * sizeof(uint32_t)));
+  int const kWorldPitchBytes = static_cast<int>(world.pitch * sizeof(uint32_t));
+  Level const* const kLevel = renderer.gpu_level;
+  if (kLevel && EnsureSpectatorLevelTexture(kLevel->width, kLevel->height)) {
+    renderer.resident_level.Invalidate();
+  }
+  // Without the level texture (allocation failed) this one frame shows the
+  // objects over black; SpectatorResidentLevelMax turns the mode off after.
+  bool const kResident = kLevel && sdl_spectator_level_texture;
+  if (kResident) {
+    // Upload only the level tiles that changed since the last present, then
+    // only the overlay tiles holding objects now or last frame.
+    ZoneScopedN("Gfx::DrawSpectatorGpu::ResidentUpload");
+    ResidentLevel& resident = renderer.resident_level;
+    resident.Update(*kLevel, renderer.pal32, world.mode, world.cycles);
+    for (std::size_t i = 0; i < resident.Uploads().size(); ++i) {
+      UploadRect const& r = resident.Uploads()[i];
+      SDL_Rect const kRect{.x = r.x, .y = r.y, .w = r.w, .h = r.h};
+      SDL_UpdateTexture(sdl_spectator_level_texture, &kRect, resident.Pixels(i),
+                        static_cast<int>(r.w * sizeof(uint32_t)));
+    }
+
+    if (!spectator_prev_world_resident || sdl_spectator_world_texture != kPrevWorldTexture) {
+      spectator_world_overlay.Invalidate();
+    }
+    for (UploadRect const& r : spectator_world_overlay.Collect(world, renderer.gpu_world_used_w,
+                                                               renderer.gpu_world_used_h)) {
+      SDL_Rect const kRect{.x = r.x, .y = r.y, .w = r.w, .h = r.h};
+      SDL_UpdateTexture(sdl_spectator_world_texture, &kRect,
+                        world.pixels + (static_cast<std::size_t>(r.y) * world.pitch) + r.x,
+                        kWorldPitchBytes);
+    }
+  } else {
+    // Upload only the used sub-rect; the scratch content is anchored at (0,0).
+    SDL_Rect const kUsed{
+        .x = 0, .y = 0, .w = renderer.gpu_world_used_w, .h = renderer.gpu_world_used_h};
+    SDL_UpdateTexture(sdl_spectator_world_texture, &kUsed, world.pixels, kWorldPitchBytes);
+  }
+  // The world texture is the opaque base layer, or the object overlay
+  // blended over the resident level.
+  SDL_SetTextureBlendMode(sdl_spectator_world_texture,
+                          kResident ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+  spectator_prev_world_resident = kResident;
   // HUD overlay: transparent background, opaque HUD pixels. Upload only the
   // dirty bands — except the first GPU frame after a resolution change or a
   // CPU present, which must refresh the whole overlay since the texture's
@@ -1120,6 +1217,9 @@ void Gfx::DrawSpectatorGpu(Renderer& renderer) {
       renderer.fade_value >= 32 ? 255 : static_cast<Uint8>((renderer.fade_value * 255) >> 5);
   SDL_SetTextureColorMod(sdl_spectator_world_texture, kMod, kMod, kMod);
   SDL_SetTextureColorMod(sdl_spectator_texture, kMod, kMod, kMod);
+  if (kResident) {
+    SDL_SetTextureColorMod(sdl_spectator_level_texture, kMod, kMod, kMod);
+  }
 
   SDL_SetRenderDrawColor(sdl_spectator_renderer, 0, 0, 0, 255);
   SDL_RenderClear(sdl_spectator_renderer);  // opaque-black letterbox bars
@@ -1131,6 +1231,13 @@ void Gfx::DrawSpectatorGpu(Renderer& renderer) {
                        .y = static_cast<float>(renderer.gpu_world_dst_y),
                        .w = static_cast<float>(renderer.gpu_world_dst_w),
                        .h = static_cast<float>(renderer.gpu_world_dst_h)};
+  if (kResident) {
+    SDL_FRect const kLevelSrc{.x = static_cast<float>(renderer.gpu_level_src_x),
+                              .y = static_cast<float>(renderer.gpu_level_src_y),
+                              .w = static_cast<float>(renderer.gpu_level_src_w),
+                              .h = static_cast<float>(renderer.gpu_level_src_h)};
+    SDL_RenderTexture(sdl_spectator_renderer, sdl_spectator_level_texture, &kLevelSrc, &kDst);
+  }
   SDL_RenderTexture(sdl_spectator_renderer, sdl_spectator_world_texture, &kSrc, &kDst);
   SDL_RenderTexture(sdl_spectator_renderer, sdl_spectator_texture, nullptr, nullptr);
   SDL_RenderPresent(sdl_spectator_renderer);
@@ -1171,11 +1278,13 @@ void Gfx::Flip() {
       spectator_prev_present_gpu = false;
     }
     single_screen_renderer.gpu_world_src = nullptr;
+    single_screen_renderer.gpu_level = nullptr;
   }
 
   static unsigned int const kDelay = 14U;
 
-  auto wanted_time = last_frame + kDelay;
+  auto wanted_time = last_frame + kDelay + static_cast<unsigned int>(frame_stretch_ms);
+  frame_stretch_ms = 0;
 
   while (true) {
     auto now = SDL_GetTicks();
@@ -1455,6 +1564,7 @@ void Gfx::InitFrameStepping() {
   controller->Draw(this->play_renderer, /*use_spectator_viewports=*/false);
   single_screen_renderer.Clear();
   single_screen_renderer.gpu_world_composite = SpectatorGpuComposite();
+  single_screen_renderer.gpu_resident_level_max = SpectatorResidentLevelMax();
   single_screen_renderer.gpu_world_src = nullptr;
   controller->Draw(this->single_screen_renderer, /*use_spectator_viewports=*/true);
 
@@ -1481,6 +1591,10 @@ bool Gfx::RunOneFrame() {
         (ev.key.mod & SDL_KMOD_ALT)) {
       return false;
     }
+    if (ev.type == SDL_EVENT_KEY_DOWN && ev.key.scancode == SDL_SCANCODE_F12 &&
+        (ev.key.mod & SDL_KMOD_CTRL) && !ev.key.repeat && trace::Enabled()) {
+      DumpTrace();
+    }
     state_stack.HandleEvent(ev);
   }
 
@@ -1513,7 +1627,8 @@ bool Gfx::RunOneFrame() {
             settings->random_level == old_level->old_random_level &&
             settings->level_file == old_level->old_level_file &&
             settings->random_map_width == old_level->old_random_map_width &&
-            settings->random_map_height == old_level->old_random_map_height) {
+            settings->random_map_height == old_level->old_random_map_height &&
+            settings->random_level_generator == old_level->old_random_level_generator) {
           new_controller->SwapLevel(*old_level);
         } else {
           Level new_level(*common);
@@ -1616,6 +1731,7 @@ bool Gfx::RunOneFrame() {
       controller->Draw(this->play_renderer, /*use_spectator_viewports=*/false);
       single_screen_renderer.Clear();
       single_screen_renderer.gpu_world_composite = SpectatorGpuComposite();
+      single_screen_renderer.gpu_resident_level_max = SpectatorResidentLevelMax();
       single_screen_renderer.gpu_world_src = nullptr;
       controller->Draw(this->single_screen_renderer, /*use_spectator_viewports=*/true);
 
@@ -1638,6 +1754,7 @@ bool Gfx::RunOneFrame() {
   // reset the handoff so a frame that doesn't redraw the viewport (e.g. a menu
   // over a frozen game) falls back to the CPU present path.
   single_screen_renderer.gpu_world_composite = SpectatorGpuComposite();
+  single_screen_renderer.gpu_resident_level_max = SpectatorResidentLevelMax();
   single_screen_renderer.gpu_world_src = nullptr;
 
   state_stack.Draw();
@@ -1648,6 +1765,15 @@ bool Gfx::RunOneFrame() {
   Flip();
   FrameMark;
 
+  // Frame-to-frame time, so a stall anywhere in the loop counts. Dumps are
+  // capped per session; each one is a few megabytes.
+  int64_t const kBudgetNs = int64_t{settings->trace_frame_budget_ms} * 1'000'000;
+  if (trace_budget_.Tick(trace::Now(), kBudgetNs, kSlowFrameDumpCooldownNs) && trace::Enabled() &&
+      slow_frame_dumps_ < kMaxSlowFrameDumps) {
+    ++slow_frame_dumps_;
+    DumpTrace("-slow");
+  }
+
   return true;
 }
 
@@ -1663,6 +1789,9 @@ void Gfx::MainLoop() {
             self->InitFrameStepping();
           } else {
             self->controller.reset();
+            if (self->trace_writer_.joinable()) {
+              self->trace_writer_.join();
+            }
             emscripten_cancel_main_loop();
           }
         }
@@ -1682,6 +1811,9 @@ void Gfx::MainLoop() {
   }
 
   controller.reset();
+  if (trace_writer_.joinable()) {
+    trace_writer_.join();
+  }
 #endif
 }
 
@@ -1690,10 +1822,51 @@ void Gfx::SaveSettings(const FsNode& node) {
   settings->save(node, rand);
 }
 
+void Gfx::DumpTrace(char const* suffix) {
+  if (trace_writing_.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (trace_writer_.joinable()) {
+    trace_writer_.join();
+  }
+
+  std::time_t const kTicks = std::time(nullptr);
+  std::tm* now = std::localtime(&kTicks);
+  char time_buf[64];
+  // NOLINTNEXTLINE(cert-err33-c) — buffer is generous; truncation only on a malformed locale and is non-fatal here.
+  std::strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H.%M.%S", now);
+  FsNode const kNode = GetUserConfigNode() / "Traces" / (std::string(time_buf) + suffix + ".json");
+
+  // Copying the rings is quick; formatting and writing them is not, so
+  // that happens off the game thread. Shared so the inline fallback still
+  // has the lanes if the thread can't be started.
+  auto const kLanes = std::make_shared<std::vector<trace::Lane> const>(trace::Capture());
+  auto write = [kNode, kLanes] {
+    try {
+      auto writer = kNode.ToWriter();
+      trace::WriteChromeTrace(*kLanes, *writer);
+    } catch (std::runtime_error& e) {
+      console::WriteWarning(std::string("Error writing trace: ") + e.what());
+    }
+  };
+  trace_writing_.store(true, std::memory_order_relaxed);
+  try {
+    trace_writer_ = std::thread([this, write] {
+      write();
+      trace_writing_.store(false, std::memory_order_release);
+    });
+  } catch (std::system_error const&) {
+    write();
+    trace_writing_.store(false, std::memory_order_relaxed);
+  }
+}
+
 bool Gfx::LoadSettings(const FsNode& node) {
   settings_node = node;
   settings = std::make_shared<Settings>();
-  return settings->load(node, rand);
+  bool const kLoaded = settings->load(node, rand);
+  trace::SetEnabled(settings->trace_zones);
+  return kLoaded;
 }
 
 void Gfx::DrawBasicMenu(/*int curSel*/) {
@@ -1740,6 +1913,7 @@ void Gfx::DrawSpectatorInfo() {
   Common& common = *this->common;
   int const kCenterX = single_screen_renderer.render_res_x / 2;
   int const kCenterY = single_screen_renderer.render_res_y / 4;
+  TextCache& text_cache = single_screen_renderer.text_cache;
 
   Fill(single_screen_renderer.bmp, 0);
   if (frozen_spectator_screen.pixels != nullptr) {
@@ -1747,20 +1921,21 @@ void Gfx::DrawSpectatorInfo() {
                frozen_spectator_screen.h);
   }
   if (settings->level_file.empty()) {
-    common.font.DrawCenteredText(single_screen_renderer.bmp, LS(LevelRandom), kCenterX,
-                                 kCenterY - 32, 7, 2);
+    text_cache.DrawCenteredText(single_screen_renderer.bmp, common.font, LS(LevelRandom), kCenterX,
+                                kCenterY - 32, 7, 2);
   } else {
     auto level_name = GetBasename(GetLeaf(gfx.settings->level_file));
-    common.font.DrawCenteredText(single_screen_renderer.bmp,
-                                 LS(LevelIs1) + level_name + LS(LevelIs2), kCenterX, kCenterY - 32,
-                                 7, 2);
+    text_cache.DrawCenteredText(single_screen_renderer.bmp, common.font,
+                                LS(LevelIs1) + level_name + LS(LevelIs2), kCenterX, kCenterY - 32,
+                                7, 2);
   }
 
   std::string const kVsText =
       settings->worm_settings[0]->name + " vs " + settings->worm_settings[1]->name;
   // put worm color boxes on a nice spot even if no player names have been entered
   int const kTextSize = std::max(common.font.GetDims(kVsText) * 2, 48);
-  common.font.DrawCenteredText(single_screen_renderer.bmp, kVsText, kCenterX, kCenterY, 7, 2);
+  text_cache.DrawCenteredText(single_screen_renderer.bmp, common.font, kVsText, kCenterX, kCenterY,
+                              7, 2);
   FillRect(single_screen_renderer.bmp, kCenterX - (kTextSize / 2) - 1, kCenterY + 23 - 1, 16, 16,
            7);
   FillRect(single_screen_renderer.bmp, kCenterX - kTextSize / 2, kCenterY + 23, 14, 14,
@@ -1771,11 +1946,11 @@ void Gfx::DrawSpectatorInfo() {
            settings->worm_settings[1]->color);
 
   if (controller->Running()) {
-    common.font.DrawCenteredText(single_screen_renderer.bmp, "PAUSED", kCenterX, kCenterY + 48, 7,
-                                 2);
+    text_cache.DrawCenteredText(single_screen_renderer.bmp, common.font, "PAUSED", kCenterX,
+                                kCenterY + 48, 7, 2);
   } else {
-    common.font.DrawCenteredText(single_screen_renderer.bmp, "SETUP", kCenterX, kCenterY + 48, 7,
-                                 2);
+    text_cache.DrawCenteredText(single_screen_renderer.bmp, common.font, "SETUP", kCenterX,
+                                kCenterY + 48, 7, 2);
   }
 }
 
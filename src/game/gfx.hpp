@@ -3,8 +3,10 @@
 #include <SDL3/SDL.h>
 #include "math/rect.hpp"
 
+#include <atomic>
 #include <cassert>
 #include <cstdio>
+#include <thread>
 #include <unordered_map>
 
 #include "common.hpp"
@@ -22,6 +24,7 @@
 #include "rand.hpp"
 #include "settings.hpp"
 #include "state.hpp"
+#include "trace.hpp"
 
 struct Key {
   Key(int sym, char ch) : sym(sym), ch(ch) {}
@@ -139,6 +142,12 @@ struct Gfx {
   // when there is no spectator window/renderer, or when the single-screen
   // renderer is currently the main window's primary renderer.
   bool SpectatorGpuComposite() const;
+  // Largest level side the spectator GPU composite can keep resident in a
+  // texture (Renderer::gpu_resident_level_max); 0 when the mode is off.
+  int SpectatorResidentLevelMax() const;
+  // (Re)allocates `sdl_spectator_level_texture` to at least need_w×need_h.
+  // Returns true when a new texture was created (its contents are undefined).
+  bool EnsureSpectatorLevelTexture(int need_w, int need_h);
   void Flip();
   // Per-frame menu palette rebuild (fade step, rotation, worm colours).
   // Runs before state drawing so blits resolve through fresh pal32.
@@ -256,6 +265,11 @@ struct Gfx {
   void SaveSettings(const FsNode& node);
   bool LoadSettings(const FsNode& node);
 
+  // Writes what the trace rings hold to Traces/<time><suffix>.json under the
+  // user config root, on a background thread. Skipped while the previous
+  // dump is still being written.
+  void DumpTrace(char const* suffix = "");
+
   void ProcessEvent(SDL_Event& ev, Controller* controller = nullptr);
 
   int FindGamepadIndex(SDL_JoystickID id);
@@ -350,6 +364,21 @@ struct Gfx {
   // last wrote; after a CPU present (menu/pause/fallback) the next GPU frame
   // must re-upload the whole overlay.
   bool spectator_prev_present_gpu = false;
+  // Resident level texture for the spectator GPU composite: the whole level,
+  // updated from Renderer::resident_level's dirty rects. Belongs to
+  // sdl_spectator_renderer.
+  SDL_Texture* sdl_spectator_level_texture = nullptr;
+  int sdl_spectator_level_texture_w = 0;
+  int sdl_spectator_level_texture_h = 0;
+  // Set when the resident level texture could not be created; the spectator
+  // then stays on the per-frame world upload until the renderer is rebuilt.
+  bool spectator_level_texture_failed = false;
+  // In resident mode the world texture holds only the object overlay, and
+  // only its changed tiles are uploaded (see SparseOverlay). Whether the
+  // previous GPU present was resident: if not, the world texture holds an
+  // opaque world pass and the overlay must be uploaded in full.
+  SparseOverlay spectator_world_overlay;
+  bool spectator_prev_world_resident = false;
   // a software surface to do the actual drawing into
   SDL_Surface* sdl_draw_surface = nullptr;
   // a software surface to do the actual drawing of the spectator view into
@@ -365,6 +394,9 @@ struct Gfx {
   bool spectator_fullscreen, double_res{true};
 
   uint64_t last_frame;
+  // Extra milliseconds to hold the next Flip(); set per frame by online
+  // play's time sync and cleared once used.
+  int frame_stretch_ms{0};
   unsigned menu_cycles{0};
   int window_w{320 * 2}, window_h{200 * 2};
   int prev_mag{0};        // Previous magnification used for drawing
@@ -393,6 +425,11 @@ struct Gfx {
  private:
   struct MainMenuState* menuStatePtr_ = nullptr;
   bool tcChangeRequested_ = false;
+
+  trace::FrameBudget trace_budget_;
+  int slow_frame_dumps_ = 0;
+  std::thread trace_writer_;
+  std::atomic<bool> trace_writing_{false};
 };
 
 extern Gfx gfx;
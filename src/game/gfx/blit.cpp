@@ -98,6 +98,35 @@ void BlitImageScaled(Bitmap& scr, Sprite spr, int x, int y, float scale) {
   }
 }
 
+void BlitImageScaled(Bitmap& scr, ResolvedSprite const& spr, int x, int y, float scale) {
+  int const kDw =
+      std::max(1, static_cast<int>(std::lroundf(static_cast<float>(spr.width) * scale)));
+  int const kDh =
+      std::max(1, static_cast<int>(std::lroundf(static_cast<float>(spr.height) * scale)));
+  float const kInv = 1.0F / scale;
+  for (int dy = 0; dy < kDh; ++dy) {
+    int const kPy = y + dy;
+    if (kPy < scr.clip_rect.y1 || kPy >= scr.clip_rect.y2) {
+      continue;
+    }
+    std::size_t const kRow = static_cast<std::size_t>(static_cast<float>(dy) * kInv) * spr.pitch;
+    uint32_t* dstrow = scr.pixels + static_cast<std::size_t>(kPy) * scr.pitch;
+    for (int dx = 0; dx < kDw; ++dx) {
+      int const kPx = x + dx;
+      if (kPx < scr.clip_rect.x1 || kPx >= scr.clip_rect.x2) {
+        continue;
+      }
+      std::size_t const kSrc = kRow + static_cast<std::size_t>(static_cast<float>(dx) * kInv);
+      if (spr.mask[kSrc]) {
+        dstrow[kPx] = spr.argb[kSrc];
+      } else if (PalIdx const kC = spr.mem[kSrc]) {
+        // Colour-animated pixel: not in the cached copy.
+        dstrow[kPx] = scr.pal32[kC];
+      }
+    }
+  }
+}
+
 void DrawBar(Bitmap& scr, int x, int y, int width, int color) {
   DrawBar(scr, x, y, width, 2, color);
 }
@@ -261,6 +290,42 @@ void BlitImage(Bitmap& scr, Sprite spr, int x, int y) {
   }
 }
 
+void BlitImage(Bitmap& scr, ResolvedSprite const& spr, int x, int y) {
+  int pitch = spr.pitch;
+  int width = spr.width;
+  int height = spr.height;
+  uint32_t const* mem = spr.argb;
+  int const kOrgX = x;
+  int const kOrgY = y;
+
+  CLIP_IMAGE(scr.clip_rect);
+
+  uint32_t const* mask = spr.mask + (mem - spr.argb);
+  uint32_t* scrptr = scr.pixels + y * scr.pitch + x;
+
+  for (int y = 0; y < height; ++y) {
+    // Branch-free: opaque source pixels carry an all-ones mask, everything
+    // else (transparent or colour-animated) keeps the destination.
+    for (int x = 0; x < width; ++x) {
+      scrptr[x] = mem[x] | (scrptr[x] & ~mask[x]);
+    }
+
+    scrptr += scr.pitch;
+    mem += pitch;
+    mask += pitch;
+  }
+
+  for (int i = 0; i < spr.patch_count; ++i) {
+    SpritePatch const& p = spr.patches[i];
+    int const kPx = kOrgX + p.x;
+    int const kPy = kOrgY + p.y;
+    if (kPx >= scr.clip_rect.x1 && kPx < scr.clip_rect.x2 && kPy >= scr.clip_rect.y1 &&
+        kPy < scr.clip_rect.y2) {
+      scr.GetPixel(kPx, kPy) = scr.pal32[p.idx];
+    }
+  }
+}
+
 void BlitImageTrans(Bitmap& scr, Sprite spr, int x, int y, int phase) {
   UNPACK_SPRITE(spr);
 
@@ -624,6 +689,25 @@ void DrawDirtEffect(Common& common, Rand& rand, Level& level, int dirt_effect, i
 void CorrectShadow(Common& common, Level& level, Rect rect) {
   rect.Intersect(Rect(0, 3, level.width - 3, level.height));
 
+  // Like MakeShadow, every cell only reads cells the x-major walk hasn't
+  // reached yet, so large areas can go through RewriteCells instead.
+  if (rect.Valid() &&
+      static_cast<int64_t>(rect.Width()) * rect.Height() >= Level::kBandCells) {
+    level.RewriteCells(common, rect, [&level](int x, int y) {
+      int const kIdx = x + (y * level.width);
+      PalIdx const kPix = level.material_id[kIdx];
+      bool const kCasts = level.materials[kIdx + 3 - (3 * level.width)].DirtRock();
+      if (level.materials[kIdx].SeeShadow() && kCasts) {
+        return static_cast<int>(static_cast<PalIdx>(kPix + 4));
+      }
+      if (kPix >= 164 && kPix <= 167 && !kCasts) {
+        return kPix - 4;
+      }
+      return Level::kKeepCell;
+    });
+    return;
+  }
+
   for (int x = rect.x1; x < rect.x2; ++x) {
     for (int y = rect.y1; y < rect.y2; ++y) {
       PalIdx const kPix = level.Pixel(x, y);
@@ -749,21 +833,44 @@ void DrawGraph(Bitmap& scr, std::vector<double> const& data, int height, int sta
   DrawRoundedLineBox(scr, start_x, start_y, 7, static_cast<int>(data.size()), height);
 }
 
-void DrawHeatmap(Bitmap& scr, int x, int y, Heatmap& hm) {
-  int width = hm.width;
-  int height = hm.height;
-  int const pitch = width;
-  int const* mem = hm.map.data();
+void Heatmap::Flush() {
+  if (pending_.empty()) {
+    return;
+  }
+  std::vector<int>& cells = Storage();
+  for (Splat const& s : pending_) {
+    for (int y1 = -2; y1 <= 2; ++y1) {
+      int const kCy = s.y + y1;
+      if (kCy < 0 || kCy >= height) {
+        continue;
+      }
+      for (int x1 = -2; x1 <= 2; ++x1) {
+        int const kCx = s.x + x1;
+        if (kCx >= 0 && kCx < width) {
+          int const kWeight = (2 * 2) * (2 * 2) - (x1 * y1) * (x1 * y1);
+          cells[kCy * width + kCx] += s.v * kWeight;
+        }
+      }
+    }
+  }
+  pending_.clear();
+}
 
+void DrawHeatmap(Bitmap& scr, int x, int y, Heatmap& hm, int dest_w, int dest_h) {
+  hm.Flush();
+  if (dest_w <= 0 || dest_h <= 0) {
+    return;
+  }
+
+  // Equalize: each non-zero value maps to the heat ramp by its rank, so
+  // the ramp is spread over the values actually present.
   std::map<int, int> counts;
-  int const* p = mem;
   int total_pixels = 0;
-  while (p != mem + width * height) {
-    if (*p != 0) {
-      ++counts[*p];
+  for (int const kV : hm.map) {
+    if (kV != 0) {
+      ++counts[kV];
       ++total_pixels;
     }
-    ++p;
   }
 
   std::map<int, int> mapping;
@@ -777,12 +884,24 @@ void DrawHeatmap(Bitmap& scr, int x, int y, Heatmap& hm) {
     cum += v.second;
   }
 
-  CLIP_IMAGE(scr.clip_rect);
+  std::vector<uint32_t> cell_color(static_cast<std::size_t>(hm.width) * hm.height,
+                                   scr.pal32[0]);
+  for (std::size_t i = 0; i < hm.map.size(); ++i) {
+    cell_color[i] = scr.pal32[mapping[hm.map[i]]];
+  }
 
-  BLIT3({
-    int v = mapping[*mem];
-    *rowdest = scr.pal32[v];
-  });
+  int const kX1 = std::max(x, scr.clip_rect.x1);
+  int const kY1 = std::max(y, scr.clip_rect.y1);
+  int const kX2 = std::min(x + dest_w, scr.clip_rect.x2);
+  int const kY2 = std::min(y + dest_h, scr.clip_rect.y2);
+  for (int py = kY1; py < kY2; ++py) {
+    int const kCy = (py - y) * hm.height / dest_h;
+    uint32_t const* row = cell_color.data() + (static_cast<std::size_t>(kCy) * hm.width);
+    uint32_t* dest = scr.pixels + (py * scr.pitch);
+    for (int px = kX1; px < kX2; ++px) {
+      dest[px] = row[(px - x) * hm.width / dest_w];
+    }
+  }
 }
 
 // Per-channel fade at composition time. Identical arithmetic to
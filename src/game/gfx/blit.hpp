@@ -1,10 +1,12 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
 #include <vector>
 #include "color.hpp"
 #include "math/rect.hpp"
 #include "sprite.hpp"
+#include "sprite_cache.hpp"
 
 struct Level;
 struct Common;
@@ -40,9 +42,13 @@ void DrawLevelScaled(Bitmap& scr, Level const& level, int view_x, int view_y, fl
 // for the downscaled spectator world pass. (x,y) is the already-scaled
 // top-left in `scr`; the sprite is drawn at `scale` of its native size.
 void BlitImageScaled(Bitmap& scr, Sprite spr, int x, int y, float scale);
+void BlitImageScaled(Bitmap& scr, ResolvedSprite const& spr, int x, int y, float scale);
 // ARGB rectangle copy at identical coordinates (frozen_screen restores).
 void BlitBitmap(Bitmap& scr, Bitmap const& src, int x, int y, int width, int height);
 void BlitImage(Bitmap& scr, Sprite spr, int x, int y);
+// Same result as the indexed BlitImage for a frame from SpriteCache: masked
+// ARGB row copy, then the colour-animated pixels through the live pal32.
+void BlitImage(Bitmap& scr, ResolvedSprite const& spr, int x, int y);
 void BlitImageR(ShadowQuery const& shadow, Bitmap& scr, const PalIdx* mem, int x, int y, int width,
                 int height);
 void BlitImageTrans(Bitmap& scr, Sprite spr, int x, int y, int phase);
@@ -77,45 +83,73 @@ void ScaleDrawArea(uint32_t const* src, int src_w, int src_h, std::size_t src_pi
 
 int FitScreen(int back_w, int back_h, int scr_w, int scr_h, int& offset_x, int& offset_y);
 
+// Stats heatmap over a level. The grid's resolution is capped rather
+// than tied to the level: the classic 504x350 level keeps its
+// half-resolution grid, bigger levels get coarser cells, so a map costs
+// at most kMaxSide² counters (256 KB) however large the level. Storage
+// is allocated on the first sample.
 struct Heatmap {
-  Heatmap(int width, int height, int org_width, int org_height)
-      : width(width),
-        height(height),
-        org_width(org_width),
-        org_height(org_height),
-        map(width * height) {}
-
-  void Inc(int x, int y, int v = 1) {
-    x = (x * width) / org_width;
-    y = (y * height) / org_height;
-    x = std::min(std::max(x, 0), width - 1);
-    y = std::min(std::max(y, 0), height - 1);
-
-    map[y * width + x] += v;
-  }
+  static constexpr int kMaxSide = 256;
+
+  Heatmap(int org_width, int org_height)
+      : org_width(std::max(org_width, 1)),
+        org_height(std::max(org_height, 1)),
+        cell_size(std::max(2, (std::max(this->org_width, this->org_height) + kMaxSide - 1) /
+                                  kMaxSide)),
+        width((this->org_width + cell_size - 1) / cell_size),
+        height((this->org_height + cell_size - 1) / cell_size) {}
 
+  void Inc(int x, int y, int v = 1) { Storage()[CellY(y) * width + CellX(x)] += v; }
+
+  // Adds a 5x5-cell splat centred on (x, y). Splats are queued and
+  // applied by Flush(), once per frame; repeated hits on one cell within
+  // a frame collapse into one splat.
   void IncArea(int x, int y, int v = 1) {
-    x = (x * width) / org_width;
-    y = (y * height) / org_height;
-    x = std::min(std::max(x, 0), width - 1);
-    y = std::min(std::max(y, 0), height - 1);
-
-    for (int y1 = -2; y1 <= 2; ++y1) {
-      for (int x1 = -2; x1 <= 2; ++x1) {
-        int const kCx = x + x1;
-        int const kCy = y + y1;
-        if (kCx >= 0 && kCy >= 0 && kCx < width && kCy < height) {
-          int const kWeight = (2 * 2) * (2 * 2) - (x1 * y1) * (x1 * y1);
-          map[kCy * width + kCx] += v * kWeight;
-        }
+    int const kCx = CellX(x);
+    int const kCy = CellY(y);
+    for (Splat& s : pending_) {
+      if (s.x == kCx && s.y == kCy) {
+        s.v += v;
+        return;
       }
     }
+    pending_.push_back({.x = kCx, .y = kCy, .v = v});
+  }
+
+  void Flush();
+
+  int At(int cx, int cy) const { return map.empty() ? 0 : map[cy * width + cx]; }
+
+  std::size_t MemoryBytes() const {
+    return (map.capacity() * sizeof(int)) + (pending_.capacity() * sizeof(Splat));
   }
 
-  int width, height;
   int org_width, org_height;
+  // Level pixels per cell side.
+  int cell_size;
+  int width, height;
 
+  // width * height counters, or empty until the first sample.
   std::vector<int> map;
+
+ private:
+  struct Splat {
+    int x, y, v;
+  };
+
+  int CellX(int x) const { return std::clamp(x / cell_size, 0, width - 1); }
+  int CellY(int y) const { return std::clamp(y / cell_size, 0, height - 1); }
+
+  std::vector<int>& Storage() {
+    if (map.empty()) {
+      map.resize(static_cast<std::size_t>(width) * height);
+    }
+    return map;
+  }
+
+  std::vector<Splat> pending_;
 };
 
-void DrawHeatmap(Bitmap& scr, int x, int y, Heatmap& hm);
+// Draws `hm` equalized to the heat palette, resampled (nearest cell) to
+// dest_w x dest_h. Flushes pending splats first.
+void DrawHeatmap(Bitmap& scr, int x, int y, Heatmap& hm, int dest_w, int dest_h);
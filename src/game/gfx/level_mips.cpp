@@ -0,0 +1,117 @@
+#include "level_mips.hpp"
+
+#include <cstddef>
+#include "../level.hpp"
+#include "blit.hpp"
+
+namespace {
+
+// Rounded per-channel average of four ARGB pixels, two channels per lane.
+uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  uint32_t const kRb =
+      (((a & 0x00FF00FFU) + (b & 0x00FF00FFU) + (c & 0x00FF00FFU) + (d & 0x00FF00FFU) +
+        0x00020002U) >>
+       2) &
+      0x00FF00FFU;
+  uint32_t const kAg = ((((a >> 8) & 0x00FF00FFU) + ((b >> 8) & 0x00FF00FFU) +
+                         ((c >> 8) & 0x00FF00FFU) + ((d >> 8) & 0x00FF00FFU) + 0x00020002U) >>
+                        2) &
+                       0x00FF00FFU;
+  return kRb | (kAg << 8);
+}
+
+// Averages the 2x2 blocks of the sw x sh region at `src` (row stride
+// `stride`, top-left at even coordinates (sx, sy) of its level) into `dst`.
+// Blocks cut by the region's right or bottom edge reuse their last column or
+// row, i.e. average the cells they have.
+void Reduce(uint32_t const* src, std::size_t stride, int sx, int sy, int sw, int sh,
+            LevelMips::Mip& dst) {
+  int const kDw = (sw + 1) / 2;
+  int const kDh = (sh + 1) / 2;
+  for (int y = 0; y < kDh; ++y) {
+    uint32_t const* r0 = src + (static_cast<std::size_t>(2 * y) * stride);
+    uint32_t const* r1 = (2 * y) + 1 < sh ? r0 + stride : r0;
+    uint32_t* out = &dst.argb[(static_cast<std::size_t>((sy / 2) + y) * dst.w) + (sx / 2)];
+    for (int x = 0; x < kDw; ++x) {
+      int const kX0 = 2 * x;
+      int const kX1 = kX0 + 1 < sw ? kX0 + 1 : kX0;
+      out[x] = Average4(r0[kX0], r0[kX1], r1[kX0], r1[kX1]);
+    }
+  }
+}
+
+}  // namespace
+
+void LevelMips::Update(Level const& level, uint32_t const* pal32, ColorMode mode, int cycles) {
+  if (tracker_.Update(level, pal32, mode, cycles)) {
+    int w = level.width;
+    int h = level.height;
+    for (auto& mip : mips_) {
+      w = (w + 1) / 2;
+      h = (h + 1) / 2;
+      mip.w = w;
+      mip.h = h;
+      mip.argb.assign(static_cast<std::size_t>(w) * h, 0);
+    }
+  }
+
+  // Render tiles are 32 cells, so every rect stays even-aligned down to 8x.
+  for (std::size_t i = 0; i < tracker_.Uploads().size(); ++i) {
+    UploadRect const& r = tracker_.Uploads()[i];
+    Reduce(tracker_.Pixels(i), r.w, r.x, r.y, r.w, r.h, mips_[0]);
+    int x = r.x / 2;
+    int y = r.y / 2;
+    int w = (r.w + 1) / 2;
+    int h = (r.h + 1) / 2;
+    for (int k = 1; k < kLevels; ++k) {
+      Mip const& src = mips_[k - 1];
+      Reduce(&src.argb[(static_cast<std::size_t>(y) * src.w) + x], src.w, x, y, w, h, mips_[k]);
+      x /= 2;
+      y /= 2;
+      w = (w + 1) / 2;
+      h = (h + 1) / 2;
+    }
+  }
+}
+
+void LevelMips::DrawScaled(Bitmap& scr, Level const& level, int view_x, int view_y,
+                           float scale) {
+  int k = 0;
+  while (k < kLevels && static_cast<float>(2 << k) * scale <= 1.0F) {
+    ++k;
+  }
+  if (k == 0) {
+    DrawLevelScaled(scr, level, view_x, view_y, scale);
+    return;
+  }
+
+  Update(level, scr.pal32, scr.mode, scr.cycles);
+  Mip const& mip = mips_[k - 1];
+  if (mip.argb.empty()) {
+    return;
+  }
+
+  // Same world positions as DrawLevelScaled, mapped into the mip once per
+  // column; -1 marks columns outside the level.
+  float const kInv = 1.0F / scale;
+  columns_.resize(scr.w);
+  for (int px = 0; px < scr.w; ++px) {
+    int const kWx = view_x + static_cast<int>(static_cast<float>(px) * kInv);
+    columns_[px] = (kWx < 0 || kWx >= level.width) ? -1 : kWx >> k;
+  }
+
+  for (int py = 0; py < scr.h; ++py) {
+    int const kWy = view_y + static_cast<int>(static_cast<float>(py) * kInv);
+    if (kWy < 0 || kWy >= level.height) {
+      continue;
+    }
+    uint32_t* row = scr.pixels + static_cast<std::size_t>(py) * scr.pitch;
+    uint32_t const* src = &mip.argb[static_cast<std::size_t>(kWy >> k) * mip.w];
+    for (int px = 0; px < scr.w; ++px) {
+      int const kCol = columns_[px];
+      if (kCol >= 0) {
+        row[px] = src[kCol];
+      }
+    }
+  }
+}
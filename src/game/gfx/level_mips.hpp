@@ -0,0 +1,57 @@
+#pragma once
+
+// Box-filtered mip pyramid of a level's appearance for the zoomed-out
+// spectator world pass.
+//
+// DrawLevelScaled nearest-samples one level cell per output pixel, which
+// aliases at overview zooms and reads the level at a large stride. LevelMips
+// keeps the ARGB appearance reduced 2x, 4x and 8x (each texel the average of
+// the 2x2 block below it) and DrawScaled samples the coarsest mip that is
+// still at least as fine as the output, so reads stay close together and
+// thin features average out instead of flickering.
+//
+// Kept up to date incrementally: a ResidentLevel reports the level render
+// tiles whose appearance changed (dirty cells, animated palette entries and
+// ramps, palette/mode changes) and only their footprint is re-reduced. Tiles
+// are 32 cells, so they stay aligned through all three levels.
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "bitmap.hpp"
+#include "color.hpp"
+#include "resident_level.hpp"
+
+struct Level;
+
+class LevelMips {
+ public:
+  static constexpr int kLevels = 3;
+
+  struct Mip {
+    int w = 0;
+    int h = 0;
+    std::vector<uint32_t> argb;
+  };
+
+  // Marks palette entries [from, to] as colour-animated.
+  void SetAnimated(int from, int to) { tracker_.SetAnimated(from, to); }
+  // Forgets the animated set; the next Update rebuilds everything.
+  void Reset() { tracker_.Reset(); }
+
+  // Brings the pyramid up to date with `level` as it appears through `pal32`.
+  void Update(Level const& level, uint32_t const* pal32, ColorMode mode, int cycles);
+
+  // Drop-in for DrawLevelScaled(scr, level, view_x, view_y, scale): same
+  // sample positions, read from the mip 2^k with 2^k <= 1 / scale (falls back
+  // to DrawLevelScaled above half scale).
+  void DrawScaled(Bitmap& scr, Level const& level, int view_x, int view_y, float scale);
+
+  // Mip `k` (0 = 2x, 1 = 4x, 2 = 8x).
+  Mip const& Get(int k) const { return mips_[k]; }
+
+ private:
+  ResidentLevel tracker_;
+  std::array<Mip, kLevels> mips_;
+  std::vector<int> columns_;
+};
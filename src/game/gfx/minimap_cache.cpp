@@ -0,0 +1,191 @@
+#include "minimap_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include "../level.hpp"
+
+void MinimapCache::SetAnimated(int from, int to) {
+  from = std::max(from, 0);
+  to = std::min(to, 255);
+  for (int i = from; i <= to; ++i) {
+    animated_[i] = true;
+  }
+  for (auto& img : images_) {
+    img.level = nullptr;
+  }
+}
+
+void MinimapCache::Reset() {
+  std::fill(std::begin(animated_), std::end(animated_), false);
+  for (auto& img : images_) {
+    img.level = nullptr;
+  }
+}
+
+MinimapCache::Image& MinimapCache::Find(Level const& level, int step_x, int step_y) {
+  Image* lru = &images_[0];
+  for (auto& img : images_) {
+    if (img.level == &level && img.step_x == step_x && img.step_y == step_y) {
+      return img;
+    }
+    if (img.last_used < lru->last_used) {
+      lru = &img;
+    }
+  }
+  lru->level = nullptr;
+  return *lru;
+}
+
+void MinimapCache::Resolve(Image& img, int sample, Bitmap const& dest, Level const& level) {
+  int32_t const kCell = img.cell[sample];
+  if (kCell < 0) {
+    return;
+  }
+  img.argb[sample] = level.AppearanceAt(kCell, dest.mode, dest.pal32, dest.cycles);
+
+  bool animated = false;
+  if (dest.mode == ColorMode::kModern && !level.display_valid.empty() &&
+      level.display_valid[kCell]) {
+    animated = !level.display_anim.empty() && level.display_anim[kCell] != 0;
+  } else {
+    animated = animated_[level.material_id[kCell]];
+  }
+  if (static_cast<uint8_t>(animated) != img.is_animated[sample]) {
+    img.is_animated[sample] = static_cast<uint8_t>(animated);
+    img.animated_stale = true;
+  }
+  ++last_resolved_;
+}
+
+void MinimapCache::ResolveAll(Image& img, Bitmap const& dest, Level const& level) {
+  for (int s = 0; s < img.cols * img.rows; ++s) {
+    Resolve(img, s, dest, level);
+  }
+  std::memcpy(img.pal, dest.pal32, sizeof(img.pal));
+  img.mode = dest.mode;
+}
+
+void MinimapCache::Rebuild(Image& img, Bitmap const& dest, Level const& level) {
+  img.level = &level;
+  img.epoch = level.render_epoch;
+  img.revision = level.render_revision;
+  img.level_w = level.width;
+  img.level_h = level.height;
+  // Same sample grid as DrawMiniature, including its row-wrapping index
+  // arithmetic and the bounds check against the cell count.
+  img.cols = std::max((level.width + img.step_x / 2) / img.step_x, 0);
+  img.rows = std::max((level.height + img.step_y / 2) / img.step_y, 0);
+  std::size_t const kSamples = static_cast<std::size_t>(img.cols) * img.rows;
+  img.argb.assign(kSamples, 0);
+  img.mask.assign(kSamples, 0);
+  img.cell.assign(kSamples, -1);
+  img.is_animated.assign(kSamples, 0);
+
+  int const kTiles = level.RenderTilesW() * level.RenderTilesH();
+  img.tile_begin.assign(static_cast<std::size_t>(kTiles) + 1, 0);
+  img.tile_samples.resize(kSamples);
+
+  auto tile_of = [&level](int32_t cell) {
+    return (((cell / level.width) >> Level::kRenderTileShift) * level.RenderTilesW()) +
+           ((cell % level.width) >> Level::kRenderTileShift);
+  };
+
+  int my = img.step_y / 2;
+  for (int y = 0; y < img.rows; ++y) {
+    int mx = img.step_x / 2;
+    for (int x = 0; x < img.cols; ++x) {
+      auto const kIdx = static_cast<unsigned int>(mx + my * level.width);
+      if (kIdx < level.material_id.size()) {
+        int const kSample = y * img.cols + x;
+        img.cell[kSample] = static_cast<int32_t>(kIdx);
+        img.mask[kSample] = 0xFFFFFFFFU;
+        ++img.tile_begin[tile_of(static_cast<int32_t>(kIdx)) + 1];
+      }
+      mx += img.step_x;
+    }
+    my += img.step_y;
+  }
+
+  for (int t = 0; t < kTiles; ++t) {
+    img.tile_begin[t + 1] += img.tile_begin[t];
+  }
+  std::vector<int32_t> fill(img.tile_begin.begin(), img.tile_begin.end() - 1);
+  for (int s = 0; s < static_cast<int>(kSamples); ++s) {
+    if (img.cell[s] >= 0) {
+      img.tile_samples[fill[tile_of(img.cell[s])]++] = s;
+    }
+  }
+
+  ResolveAll(img, dest, level);
+  img.animated_stale = true;
+}
+
+void MinimapCache::Draw(Bitmap& dest, Level const& level, int map_x, int map_y, int step_x,
+                        int step_y) {
+  last_resolved_ = 0;
+  if (level.width <= 0 || level.height <= 0 || step_x <= 0 || step_y <= 0) {
+    return;
+  }
+
+  Image& img = Find(level, step_x, step_y);
+  img.last_used = ++clock_;
+  img.step_x = step_x;
+  img.step_y = step_y;
+
+  bool const kTrackingStarted = level.EnsureRenderTiles();
+  if (kTrackingStarted || img.level != &level || img.epoch != level.render_epoch ||
+      img.level_w != level.width || img.level_h != level.height) {
+    Rebuild(img, dest, level);
+  } else {
+    bool pal_changed = img.mode != dest.mode;
+    for (int i = 0; i < 256 && !pal_changed; ++i) {
+      pal_changed = !animated_[i] && img.pal[i] != dest.pal32[i];
+    }
+
+    if (pal_changed) {
+      ResolveAll(img, dest, level);
+      img.revision = level.render_revision;
+    } else {
+      if (img.revision != level.render_revision) {
+        auto const& revisions = level.render_tile_revision;
+        for (std::size_t t = 0; t < revisions.size(); ++t) {
+          if (revisions[t] > img.revision) {
+            for (int32_t i = img.tile_begin[t]; i < img.tile_begin[t + 1]; ++i) {
+              Resolve(img, img.tile_samples[i], dest, level);
+            }
+          }
+        }
+        img.revision = level.render_revision;
+      }
+      for (int32_t const kSample : img.animated) {
+        Resolve(img, kSample, dest, level);
+      }
+    }
+  }
+
+  if (img.animated_stale) {
+    img.animated.clear();
+    for (int s = 0; s < img.cols * img.rows; ++s) {
+      if (img.is_animated[s]) {
+        img.animated.push_back(s);
+      }
+    }
+    img.animated_stale = false;
+  }
+
+  // Single masked blit, clipped like DrawMiniature's per-pixel Inside().
+  int const kX1 = std::max(map_x, dest.clip_rect.x1);
+  int const kY1 = std::max(map_y, dest.clip_rect.y1);
+  int const kX2 = std::min(map_x + img.cols, dest.clip_rect.x2);
+  int const kY2 = std::min(map_y + img.rows, dest.clip_rect.y2);
+  for (int y = kY1; y < kY2; ++y) {
+    std::size_t const kRow = (static_cast<std::size_t>(y - map_y) * img.cols) + (kX1 - map_x);
+    uint32_t const* src = &img.argb[kRow];
+    uint32_t const* mask = &img.mask[kRow];
+    uint32_t* dst = &dest.GetPixel(kX1, y);
+    for (int i = 0; i < kX2 - kX1; ++i) {
+      dst[i] = (src[i] & mask[i]) | (dst[i] & ~mask[i]);
+    }
+  }
+}
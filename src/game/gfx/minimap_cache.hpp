@@ -0,0 +1,79 @@
+#pragma once
+
+// Persistent minimap images.
+//
+// Level::DrawMiniature resamples the level on every call. The cache keeps one
+// ARGB image per level and step size and only re-resolves the samples that
+// can have changed since the last draw:
+//  - samples inside level tiles stamped by Level::MarkDirty since then,
+//  - samples showing a colour-animated palette entry or an animated ramp,
+//  - everything, when a non-animated palette entry or the colour mode changed.
+// The image then goes out in a single masked blit. Output is identical to
+// DrawMiniature with the same arguments.
+//
+// Owned by a Renderer and resolved against the destination bitmap's pal32,
+// mode and cycles, like DrawMiniature.
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "bitmap.hpp"
+#include "color.hpp"
+
+struct Level;
+
+class MinimapCache {
+ public:
+  static constexpr int kMaxImages = 4;
+
+  // Marks palette entries [from, to] as colour-animated: samples showing them
+  // are re-resolved on every draw instead of invalidating the image.
+  void SetAnimated(int from, int to);
+  // Forgets the animated set and every image.
+  void Reset();
+
+  // Same output as level.DrawMiniature(dest, map_x, map_y, step_x, step_y).
+  void Draw(Bitmap& dest, Level const& level, int map_x, int map_y, int step_x, int step_y);
+
+  // Samples re-resolved by the last Draw (for tests).
+  int LastResolved() const { return last_resolved_; }
+
+ private:
+  struct Image {
+    Level const* level = nullptr;
+    uint32_t epoch = 0;
+    uint64_t revision = 0;
+    int level_w = 0;
+    int level_h = 0;
+    int step_x = 0;
+    int step_y = 0;
+    int cols = 0;
+    int rows = 0;
+    ColorMode mode = ColorMode::kClassic;
+    uint64_t last_used = 0;
+    // pal32 the image was resolved against (animated entries excepted).
+    uint32_t pal[256] = {};
+    std::vector<uint32_t> argb;
+    // 0xFFFFFFFF where DrawMiniature writes the pixel, 0 where it skips it.
+    std::vector<uint32_t> mask;
+    // Level cell each sample reads, or -1 when out of range.
+    std::vector<int32_t> cell;
+    std::vector<uint8_t> is_animated;
+    std::vector<int32_t> animated;
+    bool animated_stale = false;
+    // Samples per level render tile: tile t owns
+    // tile_samples[tile_begin[t] .. tile_begin[t + 1]).
+    std::vector<int32_t> tile_begin;
+    std::vector<int32_t> tile_samples;
+  };
+
+  Image& Find(Level const& level, int step_x, int step_y);
+  void Rebuild(Image& img, Bitmap const& dest, Level const& level);
+  void Resolve(Image& img, int sample, Bitmap const& dest, Level const& level);
+  void ResolveAll(Image& img, Bitmap const& dest, Level const& level);
+
+  std::array<Image, kMaxImages> images_;
+  bool animated_[256] = {};
+  uint64_t clock_ = 0;
+  int last_resolved_ = 0;
+};
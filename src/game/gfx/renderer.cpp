@@ -15,16 +15,35 @@ void Renderer::LoadPalette(Common const& common) {
   origpal = common.exepal;
   origpal_modern = common.modernpal;
   pal = Origpal();
+  sprite_cache.Reset();
+  text_cache.Clear();
+  minimaps.Reset();
+  resident_level.Reset();
+  level_mips.Reset();
+  for (auto const& anim : common.color_anim) {
+    sprite_cache.SetAnimated(anim.from, anim.to);
+    minimaps.SetAnimated(anim.from, anim.to);
+    resident_level.SetAnimated(anim.from, anim.to);
+    level_mips.SetAnimated(anim.from, anim.to);
+  }
   UpdatePal32();
 }
 
 void Renderer::Clear() { Fill(bmp, 0); }
 
 void Renderer::UpdatePal32() {
+  bool changed = false;
   for (int i = 0; i < 256; ++i) {
     Color const& e = pal.entries[i];
-    pal32[i] =
+    uint32_t const kArgb =
         0xFF000000U | (static_cast<uint32_t>(e.r) << 16) | (static_cast<uint32_t>(e.g) << 8) | e.b;
+    if (kArgb != pal32[i] && !sprite_cache.IsAnimated(static_cast<PalIdx>(i))) {
+      changed = true;
+    }
+    pal32[i] = kArgb;
+  }
+  if (changed) {
+    sprite_cache.Invalidate();
   }
   bmp.mode = mode;
 }
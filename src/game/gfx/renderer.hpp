@@ -3,6 +3,11 @@
 #include "../common.hpp"
 #include "../rand.hpp"
 #include "bitmap.hpp"
+#include "level_mips.hpp"
+#include "minimap_cache.hpp"
+#include "resident_level.hpp"
+#include "sprite_cache.hpp"
+#include "text_cache.hpp"
 
 struct Renderer {
   Renderer() = default;
@@ -13,9 +18,16 @@ struct Renderer {
   void SetRenderResolution(int x, int y);
   // Repacks `pal` into `pal32`. Every palette-rebuild block must end with
   // this, and must run before anything draws into `bmp` for the frame —
-  // blits resolve palette indices through `pal32` at draw time.
+  // blits resolve palette indices through `pal32` at draw time. Invalidates
+  // `sprite_cache` when an entry outside the colour-animated ranges changed.
   void UpdatePal32();
 
+  // `frame` of `set` resolved against this renderer's `pal32`, for the
+  // ResolvedSprite blits.
+  ResolvedSprite Resolved(SpriteSet const& set, int frame) {
+    return sprite_cache.Get(set, frame, pal32);
+  }
+
   // The palette `pal` is rebuilt from every frame, picked by `mode`.
   Palette const& Origpal() const { return mode == ColorMode::kModern ? origpal_modern : origpal; }
 
@@ -24,6 +36,14 @@ struct Renderer {
   Palette pal;
   // ARGB8888 (0xFF000000 | r<<16 | g<<8 | b) image of `pal`, frame scope.
   uint32_t pal32[256] = {};
+  // Sprite frames resolved against `pal32`; see SpriteCache.
+  SpriteCache sprite_cache;
+  // Rendered HUD/stats text runs; see TextCache.
+  TextCache text_cache;
+  // Incrementally maintained level minimaps; see MinimapCache.
+  MinimapCache minimaps;
+  // Reduced level for the zoomed-out spectator world pass; see LevelMips.
+  LevelMips level_mips;
   // Classic palette origin: the EXE/TC palette, or a level's custom palette.
   Palette origpal;
   // Modern palette origin: the TC's modern.pal (or a full-range expansion of
@@ -62,6 +82,22 @@ struct Renderer {
   int gpu_world_dst_w = 0;
   int gpu_world_dst_h = 0;
 
+  // ── Spectator resident level ────────────────────────────────────────────────
+  // Largest level (per side) Gfx can keep resident in a texture for the GPU
+  // composite; 0 when the mode is off. Set by Gfx beside gpu_world_composite.
+  int gpu_resident_level_max = 0;
+  // When non-null, the level is drawn from Gfx's resident level texture and
+  // `gpu_world_src` holds only the dynamic objects over a transparent
+  // background. Set together with gpu_world_src; same one-shot lifetime.
+  Level const* gpu_level = nullptr;
+  // Visible level region (level pixels) mapped onto the gpu_world_dst rect.
+  int gpu_level_src_x = 0;
+  int gpu_level_src_y = 0;
+  int gpu_level_src_w = 0;
+  int gpu_level_src_h = 0;
+  // Which level regions the resident texture is missing; see ResidentLevel.
+  ResidentLevel resident_level;
+
   // ── Spectator HUD overlay partial present ───────────────────────────────────
   // The HUD overlay only touches a few full-width rows; the spectator viewport
   // clears and the GPU present uploads just these bands instead of the whole
@@ -0,0 +1,179 @@
+#include "resident_level.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include "../level.hpp"
+
+void ResidentLevel::SetAnimated(int from, int to) {
+  from = std::max(from, 0);
+  to = std::min(to, 255);
+  for (int i = from; i <= to; ++i) {
+    animated_[i] = true;
+  }
+  level_ = nullptr;
+}
+
+void ResidentLevel::Reset() {
+  std::fill(std::begin(animated_), std::end(animated_), false);
+  level_ = nullptr;
+}
+
+bool ResidentLevel::Update(Level const& level, uint32_t const* pal32, ColorMode mode,
+                           int cycles) {
+  uploads_.clear();
+  offsets_.clear();
+  staging_.clear();
+  if (level.width <= 0 || level.height <= 0) {
+    return false;
+  }
+
+  bool const kTrackingStarted = level.EnsureRenderTiles();
+  int const kTilesW = level.RenderTilesW();
+  int const kTilesH = level.RenderTilesH();
+  std::size_t const kTiles = static_cast<std::size_t>(kTilesW) * kTilesH;
+
+  bool full = kTrackingStarted || level_ != &level || epoch_ != level.render_epoch ||
+              width_ != level.width || height_ != level.height || mode_ != mode;
+  bool pal_anim_changed = false;
+  for (int i = 0; i < 256; ++i) {
+    if (pal_[i] != pal32[i]) {
+      if (animated_[i]) {
+        pal_anim_changed = true;
+      } else {
+        full = true;
+      }
+    }
+  }
+  bool const kCyclesChanged = cycles != cycles_;
+
+  if (full) {
+    tile_anim_.assign(kTiles, 0);
+  }
+  tile_dirty_.resize(kTiles);
+  auto const& revisions = level.render_tile_revision;
+  for (std::size_t t = 0; t < kTiles; ++t) {
+    tile_dirty_[t] = static_cast<uint8_t>(
+        full || revisions[t] > revision_ ||
+        (pal_anim_changed && (tile_anim_[t] & kPaletteAnim) != 0) ||
+        (kCyclesChanged && (tile_anim_[t] & kRampAnim) != 0));
+  }
+
+  for (int ty = 0; ty < kTilesH; ++ty) {
+    uint8_t const* row = &tile_dirty_[static_cast<std::size_t>(ty) * kTilesW];
+    int tx = 0;
+    while (tx < kTilesW) {
+      if (row[tx] == 0) {
+        ++tx;
+        continue;
+      }
+      int tx_end = tx + 1;
+      while (tx_end < kTilesW && row[tx_end] != 0) {
+        ++tx_end;
+      }
+      Resolve(level, tx, tx_end, ty, pal32, mode, cycles);
+      tx = tx_end;
+    }
+  }
+
+  level_ = &level;
+  epoch_ = level.render_epoch;
+  revision_ = level.render_revision;
+  width_ = level.width;
+  height_ = level.height;
+  mode_ = mode;
+  cycles_ = cycles;
+  std::memcpy(pal_, pal32, sizeof(pal_));
+  return full;
+}
+
+void ResidentLevel::Resolve(Level const& level, int tx0, int tx1, int ty, uint32_t const* pal32,
+                            ColorMode mode, int cycles) {
+  int const kX = tx0 << Level::kRenderTileShift;
+  int const kY = ty << Level::kRenderTileShift;
+  int const kW = std::min(tx1 << Level::kRenderTileShift, level.width) - kX;
+  int const kH = std::min((ty + 1) << Level::kRenderTileShift, level.height) - kY;
+
+  uploads_.push_back({.x = kX, .y = kY, .w = kW, .h = kH});
+  offsets_.push_back(staging_.size());
+  staging_.resize(staging_.size() + (static_cast<std::size_t>(kW) * kH));
+  uint32_t* out = &staging_[offsets_.back()];
+
+  uint8_t* anim = &tile_anim_[(static_cast<std::size_t>(ty) * level.RenderTilesW()) + tx0];
+  std::fill(anim, anim + (tx1 - tx0), uint8_t{0});
+
+  bool const kDisplay = mode == ColorMode::kModern && !level.display_valid.empty();
+  bool const kRamps = !level.display_anim.empty();
+  for (int y = kY; y < kY + kH; ++y) {
+    int idx = (y * level.width) + kX;
+    for (int x = 0; x < kW; ++x, ++idx) {
+      *out++ = level.AppearanceAt(idx, mode, pal32, cycles);
+      uint8_t flag = 0;
+      if (kDisplay && level.display_valid[idx]) {
+        flag = (kRamps && level.display_anim[idx] != 0) ? kRampAnim : 0;
+      } else {
+        flag = animated_[level.material_id[idx]] ? kPaletteAnim : 0;
+      }
+      anim[x >> Level::kRenderTileShift] |= flag;
+    }
+  }
+}
+
+std::vector<UploadRect> const& SparseOverlay::Collect(Bitmap const& bmp, int w, int h) {
+  uploads_.clear();
+  int const kTilesW = (w + kTileSize - 1) >> kTileShift;
+  int const kTilesH = (h + kTileSize - 1) >> kTileShift;
+  if (w != w_ || h != h_) {
+    w_ = w;
+    h_ = h;
+    full_ = true;
+    prev_drawn_.assign(static_cast<std::size_t>(kTilesW) * kTilesH, 0);
+  }
+  drawn_.assign(static_cast<std::size_t>(kTilesW) * kTilesH, 0);
+
+  // Drawn overlay pixels are opaque pal32 values; cleared ones are 0.
+  for (int y = 0; y < h; ++y) {
+    uint32_t const* src = bmp.pixels + (static_cast<std::size_t>(y) * bmp.pitch);
+    uint8_t* drawn = &drawn_[static_cast<std::size_t>(y >> kTileShift) * kTilesW];
+    for (int tx = 0; tx < kTilesW; ++tx) {
+      if (drawn[tx] != 0) {
+        continue;
+      }
+      int const kEnd = std::min((tx + 1) << kTileShift, w);
+      uint32_t alpha = 0;
+      for (int x = tx << kTileShift; x < kEnd; ++x) {
+        alpha |= src[x];
+      }
+      drawn[tx] = static_cast<uint8_t>((alpha & 0xFF000000U) != 0);
+    }
+  }
+
+  if (full_) {
+    uploads_.push_back({.x = 0, .y = 0, .w = w, .h = h});
+    full_ = false;
+  } else {
+    for (int ty = 0; ty < kTilesH; ++ty) {
+      std::size_t const kRow = static_cast<std::size_t>(ty) * kTilesW;
+      int tx = 0;
+      while (tx < kTilesW) {
+        if ((drawn_[kRow + tx] | prev_drawn_[kRow + tx]) == 0) {
+          ++tx;
+          continue;
+        }
+        int tx_end = tx + 1;
+        while (tx_end < kTilesW && (drawn_[kRow + tx_end] | prev_drawn_[kRow + tx_end]) != 0) {
+          ++tx_end;
+        }
+        int const kX = tx << kTileShift;
+        int const kY = ty << kTileShift;
+        uploads_.push_back({.x = kX,
+                            .y = kY,
+                            .w = std::min(tx_end << kTileShift, w) - kX,
+                            .h = std::min(kY + kTileSize, h) - kY});
+        tx = tx_end;
+      }
+    }
+  }
+  drawn_.swap(prev_drawn_);
+  return uploads_;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// CPU side of the spectator's resident level texture.
+//
+// Instead of re-rendering the visible terrain into the world scratch and
+// uploading it every frame, the spectator GPU composite can keep the whole
+// level in a texture and only re-upload what changed. ResidentLevel works out
+// which level regions those are, in Level render tiles (see
+// Level::EnsureRenderTiles):
+//  - tiles stamped by Level::MarkDirty since the previous Update,
+//  - tiles holding colour-animated palette entries, when one of them changed,
+//  - tiles holding animated ramp cells (modern mode), when `cycles` moved,
+//  - everything after a new level, colour mode or static palette change.
+// Dirty tiles next to each other in a tile row are merged into one rect and
+// resolved into a staging buffer for upload. SDL-free so it can be tested
+// without a renderer; Gfx owns the texture.
+//
+// SparseOverlay does the matching bookkeeping for the dynamic-object overlay
+// drawn on top: only tiles that hold drawn pixels this frame or held them last
+// frame (and so must be cleared) are uploaded.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitmap.hpp"
+#include "color.hpp"
+
+struct Level;
+
+struct UploadRect {
+  int x;
+  int y;
+  int w;
+  int h;
+};
+
+class ResidentLevel {
+ public:
+  // Marks palette entries [from, to] as colour-animated.
+  void SetAnimated(int from, int to);
+  // Forgets the animated set; the next Update uploads everything.
+  void Reset();
+  // The texture was (re)created: the next Update uploads everything.
+  void Invalidate() { level_ = nullptr; }
+
+  // Collects the regions of `level` whose appearance changed since the last
+  // Update into Uploads()/Pixels(). Returns true when that is the whole level.
+  bool Update(Level const& level, uint32_t const* pal32, ColorMode mode, int cycles);
+
+  std::vector<UploadRect> const& Uploads() const { return uploads_; }
+  // ARGB pixels of Uploads()[i], rows packed at a pitch of its width.
+  uint32_t const* Pixels(std::size_t i) const { return &staging_[offsets_[i]]; }
+
+ private:
+  enum : uint8_t { kPaletteAnim = 1, kRampAnim = 2 };
+
+  void Resolve(Level const& level, int tx0, int tx1, int ty, uint32_t const* pal32,
+               ColorMode mode, int cycles);
+
+  Level const* level_ = nullptr;
+  uint32_t epoch_ = 0;
+  uint64_t revision_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  ColorMode mode_ = ColorMode::kClassic;
+  int cycles_ = 0;
+  uint32_t pal_[256] = {};
+  bool animated_[256] = {};
+  // kPaletteAnim/kRampAnim per render tile.
+  std::vector<uint8_t> tile_anim_;
+  std::vector<uint8_t> tile_dirty_;
+  std::vector<UploadRect> uploads_;
+  std::vector<std::size_t> offsets_;
+  std::vector<uint32_t> staging_;
+};
+
+class SparseOverlay {
+ public:
+  static constexpr int kTileShift = 5;
+  static constexpr int kTileSize = 1 << kTileShift;
+
+  // The texture no longer matches (new texture, or another path wrote it):
+  // the next Collect uploads the whole used area.
+  void Invalidate() { full_ = true; }
+
+  // Scans [0, w) x [0, h) of `bmp`, an overlay cleared to transparent, and
+  // returns the rects to upload: tiles drawn into now or at the last Collect.
+  std::vector<UploadRect> const& Collect(Bitmap const& bmp, int w, int h);
+
+ private:
+  bool full_ = true;
+  int w_ = 0;
+  int h_ = 0;
+  std::vector<uint8_t> drawn_;
+  std::vector<uint8_t> prev_drawn_;
+  std::vector<UploadRect> uploads_;
+};
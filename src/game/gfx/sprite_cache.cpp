@@ -0,0 +1,99 @@
+#include "sprite_cache.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+void SpriteCache::SetAnimated(int from, int to) {
+  from = std::max(from, 0);
+  to = std::min(to, 255);
+  for (int i = from; i <= to; ++i) {
+    animated_[i] = true;
+  }
+  entries_.clear();
+}
+
+void SpriteCache::Reset() {
+  std::fill(std::begin(animated_), std::end(animated_), false);
+  entries_.clear();
+  ++generation_;
+}
+
+SpriteCache::Entry& SpriteCache::FindEntry(SpriteSet const& set) {
+  for (auto& e : entries_) {
+    if (e.set == &set) {
+      // A reloaded set (new TC) can land at the same address; rebuild when
+      // its storage no longer matches what was resolved.
+      if (e.base != set.data.data() || e.count != set.count || e.sprite_size != set.sprite_size) {
+        Build(e, set);
+      }
+      return e;
+    }
+  }
+  Entry& e = entries_.emplace_back();
+  Build(e, set);
+  return e;
+}
+
+void SpriteCache::Build(Entry& entry, SpriteSet const& set) const {
+  std::size_t const kTotal = set.data.size();
+  entry.set = &set;
+  entry.base = set.data.data();
+  entry.count = set.count;
+  entry.sprite_size = set.sprite_size;
+  entry.argb.assign(kTotal, 0);
+  entry.mask.assign(kTotal, 0);
+  entry.frame_generation.assign(static_cast<std::size_t>(set.count), 0);
+  entry.patch_begin.assign(static_cast<std::size_t>(set.count) + 1, 0);
+  entry.patches.clear();
+
+  // Masks and patch lists only depend on the indices and the animated set,
+  // so they are built once here; Get() fills `argb` per palette generation.
+  for (int f = 0; f < set.count; ++f) {
+    std::size_t const kBase = static_cast<std::size_t>(f) * set.sprite_size;
+    entry.patch_begin[f] = static_cast<uint32_t>(entry.patches.size());
+    for (int p = 0; p < set.sprite_size; ++p) {
+      PalIdx const kC = set.data[kBase + p];
+      if (!kC) {
+        continue;
+      }
+      if (animated_[kC]) {
+        entry.patches.push_back({.x = static_cast<uint16_t>(p % set.width),
+                                 .y = static_cast<uint16_t>(p / set.width),
+                                 .idx = kC});
+      } else {
+        entry.mask[kBase + p] = 0xFFFFFFFFU;
+      }
+    }
+  }
+  entry.patch_begin[set.count] = static_cast<uint32_t>(entry.patches.size());
+}
+
+ResolvedSprite SpriteCache::Get(SpriteSet const& set, int frame, uint32_t const* pal32) {
+  assert(frame >= 0 && frame < set.count);
+  Entry& e = FindEntry(set);
+  std::size_t const kBase = static_cast<std::size_t>(frame) * set.sprite_size;
+
+  if (e.frame_generation[frame] != generation_) {
+    PalIdx const* src = &set.data[kBase];
+    uint32_t* dst = &e.argb[kBase];
+    uint32_t const* mask = &e.mask[kBase];
+    for (int p = 0; p < set.sprite_size; ++p) {
+      dst[p] = pal32[src[p]] & mask[p];
+    }
+    e.frame_generation[frame] = generation_;
+  }
+
+  uint32_t const kPatchBegin = e.patch_begin[frame];
+  return ResolvedSprite{
+      .argb = &e.argb[kBase],
+      .mask = &e.mask[kBase],
+      .patches = e.patches.data() + kPatchBegin,
+      .patch_count = static_cast<int>(e.patch_begin[frame + 1] - kPatchBegin),
+      .mem = &set.data[kBase],
+      .width = set.width,
+      .height = set.height,
+      .pitch = set.width,
+  };
+}
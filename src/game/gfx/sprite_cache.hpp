@@ -0,0 +1,78 @@
+#pragma once
+
+// Palette-resolved ARGB copies of sprite frames.
+//
+// The sprite blits resolve every pixel through `Bitmap::pal32` on every
+// draw. Between palette rebuilds the result is the same for everything but
+// the colour-animated entries, so the cache keeps, per sprite frame, an ARGB
+// copy plus an opaque mask and draws with a branch-free masked copy. Pixels
+// whose index lies in a ColourAnim range are left out of the copy and
+// listed in a small per-frame patch list, which the blit resolves through
+// the live `pal32` — so rotating the animated ranges never invalidates.
+//
+// Owned by a Renderer: entries are resolved against that renderer's `pal32`
+// (and so its colour mode). Renderer::UpdatePal32 calls Invalidate() when a
+// non-animated entry actually changed; frames re-resolve lazily on next use.
+
+#include <cstdint>
+#include <vector>
+#include "color.hpp"
+#include "sprite.hpp"
+
+struct SpritePatch {
+  // Position within the frame.
+  uint16_t x, y;
+  PalIdx idx;
+};
+
+// A cached frame as handed to the blits. `mem` is the original indexed
+// frame, kept for paths that still want indices (scaled blits sample it).
+struct ResolvedSprite {
+  uint32_t const* argb;
+  uint32_t const* mask;
+  SpritePatch const* patches;
+  int patch_count;
+  PalIdx const* mem;
+  int width, height, pitch;
+};
+
+class SpriteCache {
+ public:
+  // Marks palette entries [from, to] as colour-animated. Drops every cached
+  // set, since masks and patch lists depend on the animated set.
+  void SetAnimated(int from, int to);
+  // Forgets the animated set and every cached set (new TC / palette load).
+  void Reset();
+  // Palette changed outside the animated ranges: every frame re-resolves on
+  // its next Get().
+  void Invalidate() { ++generation_; }
+
+  bool IsAnimated(PalIdx idx) const { return animated_[idx]; }
+  uint32_t Generation() const { return generation_; }
+
+  // Returns `frame` of `set` resolved against `pal32`, resolving it first if
+  // it is missing or older than the last Invalidate().
+  ResolvedSprite Get(SpriteSet const& set, int frame, uint32_t const* pal32);
+
+ private:
+  struct Entry {
+    SpriteSet const* set = nullptr;
+    PalIdx const* base = nullptr;
+    int count = 0;
+    int sprite_size = 0;
+    std::vector<uint32_t> argb;
+    std::vector<uint32_t> mask;
+    // Generation each frame's `argb` was resolved at; 0 = never.
+    std::vector<uint32_t> frame_generation;
+    // Per-frame [patch_begin[f], patch_begin[f + 1]) into `patches`.
+    std::vector<uint32_t> patch_begin;
+    std::vector<SpritePatch> patches;
+  };
+
+  Entry& FindEntry(SpriteSet const& set);
+  void Build(Entry& entry, SpriteSet const& set) const;
+
+  std::vector<Entry> entries_;
+  bool animated_[256] = {};
+  uint32_t generation_ = 1;
+};
@@ -0,0 +1,165 @@
+#include "text_cache.hpp"
+
+#include <xxhash.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include "blit.hpp"
+#include "font.hpp"
+#include "text_cell.hpp"
+
+namespace {
+
+uint64_t HashKey(std::string_view str, Font const* font, uint32_t argb, int size) {
+  struct {
+    Font const* font;
+    uint32_t argb;
+    int size;
+  } const kParams{font, argb, size};
+  uint64_t const kSeed = XXH3_64bits(&kParams, sizeof(kParams));
+  return XXH3_64bits_withSeed(str.data(), str.size(), kSeed);
+}
+
+}  // namespace
+
+void TextCache::Clear() {
+  for (auto& e : entries_) {
+    e.used = false;
+  }
+  index_.clear();
+}
+
+std::string_view TextCache::Format(std::string_view label, int value) {
+  char digits[16];
+  auto const kRes = std::to_chars(digits, digits + sizeof(digits), value);
+  format_.assign(label);
+  format_.append(digits, kRes.ptr);
+  return format_;
+}
+
+TextCache::Entry const& TextCache::Lookup(Bitmap const& scr, Font& font, std::string_view str,
+                                          int color, int size) {
+  uint32_t const kArgb = scr.pal32[color];
+  uint64_t const kHash = HashKey(str, &font, kArgb, size);
+  ++clock_;
+
+  if (auto it = index_.find(kHash); it != index_.end()) {
+    Entry& e = entries_[it->second];
+    if (e.font == &font && e.argb == kArgb && e.size == size && e.text == str) {
+      e.last_used = clock_;
+      return e;
+    }
+    // 64-bit collision: re-render over the colliding entry.
+    index_.erase(it);
+    e.used = false;
+  }
+
+  // Free slot, else the least recently used one.
+  int slot = 0;
+  for (int i = 0; i < kCapacity; ++i) {
+    if (!entries_[i].used) {
+      slot = i;
+      break;
+    }
+    if (entries_[i].last_used < entries_[slot].last_used) {
+      slot = i;
+    }
+  }
+
+  Entry& e = entries_[slot];
+  if (e.used) {
+    index_.erase(e.hash);
+  }
+  e.used = true;
+  e.hash = kHash;
+  e.last_used = clock_;
+  e.text.assign(str);
+  e.font = &font;
+  e.argb = kArgb;
+  e.size = size;
+  Render(e, scr, font, color);
+  index_[kHash] = slot;
+  ++misses_;
+  return e;
+}
+
+void TextCache::Render(Entry& e, Bitmap const& scr, Font& font, int color) {
+  int height = 0;
+  int const kWidth = font.GetDims(e.text.data(), e.text.size(), &height);
+  e.advance = kWidth * e.size;
+  // DrawChar always paints the full 7-pixel glyph cell, which can overhang
+  // the last glyph's advance width.
+  e.w = (kWidth + 7) * e.size;
+  e.h = height * e.size;
+
+  if (!strip_.pixels || strip_.w < e.w || strip_.h < e.h) {
+    strip_.Alloc(strip_.pixels ? std::max(strip_.w, e.w) : e.w,
+                 strip_.pixels ? std::max(strip_.h, e.h) : e.h);
+  }
+  strip_.clip_rect.x1 = 0;
+  strip_.clip_rect.y1 = 0;
+  strip_.clip_rect.x2 = e.w;
+  strip_.clip_rect.y2 = e.h;
+  strip_.pal32 = scr.pal32;
+  FillTransparent(strip_);
+  font.DrawString(strip_, e.text.data(), e.text.size(), 0, 0, color, e.size);
+
+  e.pixels.resize(static_cast<std::size_t>(e.w) * e.h);
+  for (int y = 0; y < e.h; ++y) {
+    std::memcpy(&e.pixels[static_cast<std::size_t>(y) * e.w], &strip_.GetPixel(0, y),
+                sizeof(uint32_t) * e.w);
+  }
+}
+
+void TextCache::Blit(Bitmap& scr, Entry const& e, int x, int y) {
+  int const kX1 = std::max(x, scr.clip_rect.x1);
+  int const kY1 = std::max(y, scr.clip_rect.y1);
+  int const kX2 = std::min(x + e.w, scr.clip_rect.x2);
+  int const kY2 = std::min(y + e.h, scr.clip_rect.y2);
+  if (kX1 >= kX2 || kY1 >= kY2) {
+    return;
+  }
+
+  for (int py = kY1; py < kY2; ++py) {
+    uint32_t const* src = &e.pixels[static_cast<std::size_t>(py - y) * e.w + (kX1 - x)];
+    uint32_t* dst = &scr.GetPixel(kX1, py);
+    for (int i = 0; i < kX2 - kX1; ++i) {
+      // Drawn pixels are opaque: the alpha's top bit selects the source.
+      uint32_t const kMask = static_cast<uint32_t>(static_cast<int32_t>(src[i]) >> 31);
+      dst[i] = src[i] | (dst[i] & ~kMask);
+    }
+  }
+}
+
+void TextCache::DrawString(Bitmap& scr, Font& font, std::string_view str, int x, int y,
+                           int color, int size) {
+  if (str.empty()) {
+    return;
+  }
+  Blit(scr, Lookup(scr, font, str, color, size), x, y);
+}
+
+void TextCache::DrawString(Bitmap& scr, Font& font, TextCell const& cell, int x, int y,
+                           int color) {
+  if (cell.buffer.empty()) {
+    return;
+  }
+  std::string_view const kStr(reinterpret_cast<char const*>(cell.buffer.data()),
+                              cell.buffer.size());
+  Entry const& e = Lookup(scr, font, kStr, color, 1);
+  if (cell.placement == TextCell::kCenter) {
+    x -= e.advance / 2;
+  } else if (cell.placement == TextCell::kRight) {
+    x -= e.advance;
+  }
+  Blit(scr, e, x, y);
+}
+
+void TextCache::DrawCenteredText(Bitmap& scr, Font& font, std::string_view str, int x, int y,
+                                 int color, int size) {
+  if (str.empty()) {
+    return;
+  }
+  Entry const& e = Lookup(scr, font, str, color, size);
+  Blit(scr, e, x - (e.advance / 2), y);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// Cache of rendered text runs.
+//
+// HUD and stats text is mostly the same strings frame after frame (names,
+// "Kills: N", timers, "Reloading"), yet Font::DrawString decodes UTF-8 and
+// blits glyph by glyph on every call. The cache keeps each run rendered once
+// as an ARGB strip, keyed by text + font + resolved colour + size, so an
+// unchanged string costs one clipped rectangle copy. Strips hold 0 where no
+// glyph pixel was drawn (pal32 values are always opaque), which doubles as
+// the transparency mask.
+//
+// Keyed on the ARGB the colour index resolves to, not the index, so palette
+// changes never serve stale colours; a blinking colour just cycles through a
+// couple of entries. Hits never allocate; once the cache is full a miss
+// recycles the least-recently-used entry and its buffers in place.
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "bitmap.hpp"
+
+struct Font;
+struct TextCell;
+
+class TextCache {
+ public:
+  static constexpr int kCapacity = 128;
+
+  TextCache() { index_.reserve(kCapacity * 2); }
+
+  // Draws like font.DrawString(scr, str, x, y, color, size).
+  void DrawString(Bitmap& scr, Font& font, std::string_view str, int x, int y, int color,
+                  int size = 1);
+  // Draws like font.DrawString(scr, cell, x, y, color), honouring placement.
+  void DrawString(Bitmap& scr, Font& font, TextCell const& cell, int x, int y, int color);
+  // Draws like font.DrawCenteredText(scr, str, x, y, color, size).
+  void DrawCenteredText(Bitmap& scr, Font& font, std::string_view str, int x, int y, int color,
+                        int size = 1);
+
+  // `label` followed by `value` in decimal, in a buffer reused across calls
+  // (valid until the next Format). Replaces `label + ToString(value)` on
+  // per-frame HUD paths.
+  std::string_view Format(std::string_view label, int value);
+
+  // Drops every run (e.g. a new TC font).
+  void Clear();
+
+  std::size_t Size() const { return index_.size(); }
+  uint64_t Misses() const { return misses_; }
+
+ private:
+  struct Entry {
+    uint64_t hash = 0;
+    uint64_t last_used = 0;
+    bool used = false;
+    std::string text;
+    Font const* font = nullptr;
+    uint32_t argb = 0;
+    int size = 1;
+    // Advance width as returned by Font::GetDims (times size).
+    int advance = 0;
+    int w = 0;
+    int h = 0;
+    std::vector<uint32_t> pixels;
+  };
+
+  Entry const& Lookup(Bitmap const& scr, Font& font, std::string_view str, int color, int size);
+  void Render(Entry& e, Bitmap const& scr, Font& font, int color);
+  static void Blit(Bitmap& scr, Entry const& e, int x, int y);
+
+  std::array<Entry, kCapacity> entries_;
+  std::unordered_map<uint64_t, int> index_;
+  Bitmap strip_;
+  std::string format_;
+  uint64_t clock_ = 0;
+  uint64_t misses_ = 0;
+};
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "io/stream.hpp"
+#include "trace.hpp"
+
+// Writer that hands its bytes to a background thread which feeds the real
+// sink (typically a DeflateWriter over a file), so compression and disk I/O
+// stay off the calling thread.
+//
+// One thread produces: Put() appends into a lock-free single-producer /
+// single-consumer byte ring and Commit() publishes everything written so far
+// to the worker in one release store. If the worker falls behind and the ring
+// is full, Put() spills into a private overflow buffer instead of waiting;
+// later Commit()s move the spill into the ring as space frees up, keeping
+// byte order. Only Flush() and Close() wait on the worker.
+//
+// The overflow is capped. A sink that falls further behind than that is not
+// going to catch up, so Put() drops the spill and throws StreamError, and
+// every later Put() and Commit() throws too; the caller abandons the stream
+// (a replay recording logs and stops). Close() still finishes the sink with
+// whatever reached the ring.
+//
+// Sink errors are captured on the worker (which then drops further input)
+// and rethrown from every later Commit(), Flush() and Close().
+
+namespace io {
+
+struct AsyncWriter : Writer {
+  static constexpr std::size_t kDefaultCapacity = std::size_t{1} << 16;
+  static constexpr std::size_t kDefaultOverflowLimit = std::size_t{16} << 20;
+
+  // `capacity` is rounded up to a power of two.
+  explicit AsyncWriter(std::unique_ptr<Writer> sink, std::size_t capacity = kDefaultCapacity,
+                       std::size_t overflow_limit = kDefaultOverflowLimit)
+      : sink_(std::move(sink)), overflow_limit_(overflow_limit) {
+    std::size_t cap = 64;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    ring_.resize(cap);
+    mask_ = cap - 1;
+    try {
+      thread_ = std::thread(&AsyncWriter::Run, this);
+    } catch (std::system_error const&) {
+      // No threads (e.g. a non-pthread Emscripten build): every Commit()
+      // writes through to the sink on the calling thread instead.
+    }
+  }
+
+  ~AsyncWriter() override {
+    try {
+      Close();
+    } catch (...) {  // NOLINT(bugprone-empty-catch) — destructor must not throw; Close() has
+                     // already drained and joined the worker before rethrowing.
+    }
+  }
+
+  AsyncWriter(AsyncWriter const&) = delete;
+  AsyncWriter& operator=(AsyncWriter const&) = delete;
+
+  void Put(uint8_t b) override {
+    if (!closed_ && !overflowed_ && overflow_.empty() && write_pos_ - head_cache_ < ring_.size()) {
+      ring_[write_pos_++ & mask_] = b;
+      return;
+    }
+    Put(&b, 1);
+  }
+
+  void Put(uint8_t const* src, std::size_t n) override {
+    if (closed_) {
+      throw StreamError("write after close");
+    }
+    ThrowIfOverflowed();
+    if (overflow_.empty()) {
+      std::size_t const kCopied = PushRing(src, n);
+      src += kCopied;
+      n -= kCopied;
+    }
+    if (n == 0) {
+      return;
+    }
+    if (Overflow() + n > overflow_limit_) {
+      overflowed_ = true;
+      overflow_.clear();
+      overflow_.shrink_to_fit();
+      overflow_pos_ = 0;
+      ThrowIfOverflowed();
+    }
+    // Drop what Publish() has already moved once it is half the buffer, so
+    // the spill is compacted at most once per its own length.
+    if (overflow_pos_ > 0 && overflow_pos_ >= overflow_.size() / 2) {
+      overflow_.erase(overflow_.begin(),
+                      overflow_.begin() + static_cast<std::ptrdiff_t>(overflow_pos_));
+      overflow_pos_ = 0;
+    }
+    overflow_.insert(overflow_.end(), src, src + n);
+  }
+
+  // Publishes everything written so far to the worker. Never blocks.
+  void Commit() {
+    Publish();
+    if (failed_.load(std::memory_order_acquire)) {
+      RethrowError();
+    }
+    ThrowIfOverflowed();
+  }
+
+  // Waits until the sink has received everything written so far, then
+  // flushes it.
+  void Flush() override {
+    if (closed_) {
+      return;
+    }
+    Drain();
+    if (!thread_.joinable()) {
+      FlushSink();
+      RethrowError();
+      return;
+    }
+    uint32_t const kSeq = flush_request_.load(std::memory_order_relaxed) + 1;
+    flush_request_.store(kSeq, std::memory_order_release);
+    Signal();
+    for (uint32_t done = flush_done_.load(std::memory_order_acquire); done != kSeq;
+         done = flush_done_.load(std::memory_order_acquire)) {
+      flush_done_.wait(done, std::memory_order_acquire);
+    }
+    RethrowError();
+  }
+
+  // Drains everything, lets the worker destroy the sink (so a DeflateWriter
+  // finishes its stream) and joins it. Idempotent.
+  void Close() {
+    if (closed_) {
+      return;
+    }
+    Drain();
+    if (thread_.joinable()) {
+      closing_.store(true, std::memory_order_release);
+      Signal();
+      thread_.join();
+    } else {
+      CloseSink();
+    }
+    closed_ = true;
+    RethrowError();
+  }
+
+  // Bytes written but still waiting for ring space (for tests and stats).
+  std::size_t Overflow() const { return overflow_.size() - overflow_pos_; }
+
+ private:
+  // Copies as much of [src, src + n) as fits into the ring without
+  // publishing it; returns the number of bytes copied.
+  std::size_t PushRing(uint8_t const* src, std::size_t n) {
+    if (write_pos_ - head_cache_ + n > ring_.size()) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+    }
+    std::size_t const kTake = std::min(n, ring_.size() - (write_pos_ - head_cache_));
+    std::size_t const kAt = write_pos_ & mask_;
+    std::size_t const kFirst = std::min(kTake, ring_.size() - kAt);
+    std::memcpy(&ring_[kAt], src, kFirst);
+    std::memcpy(ring_.data(), src + kFirst, kTake - kFirst);
+    write_pos_ += kTake;
+    return kTake;
+  }
+
+  void ThrowIfOverflowed() const {
+    if (overflowed_) {
+      throw StreamError("async writer: sink fell more than the overflow limit behind");
+    }
+  }
+
+  // Moves what fits of the overflow into the ring and publishes the ring.
+  // The moved bytes are only skipped here; Put() compacts them away.
+  void Publish() {
+    if (!overflow_.empty()) {
+      overflow_pos_ += PushRing(overflow_.data() + overflow_pos_, Overflow());
+      if (overflow_pos_ == overflow_.size()) {
+        overflow_.clear();
+        overflow_pos_ = 0;
+      }
+    }
+    if (write_pos_ != tail_.load(std::memory_order_relaxed)) {
+      tail_.store(write_pos_, std::memory_order_release);
+      Signal();
+    }
+  }
+
+  // Publishes until the overflow is empty, waiting on the worker for space.
+  void Drain() {
+    Publish();
+    while (!overflow_.empty()) {
+      std::size_t const kSeen = head_.load(std::memory_order_acquire);
+      if (write_pos_ - kSeen >= ring_.size()) {
+        head_.wait(kSeen, std::memory_order_acquire);
+      }
+      Publish();
+    }
+  }
+
+  void Signal() {
+    if (!thread_.joinable()) {
+      Consume(tail_.load(std::memory_order_relaxed));
+      return;
+    }
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+  }
+
+  void RethrowError() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  void Run() {
+    trace::SetThreadName("async writer");
+    uint32_t flushed = 0;
+    for (;;) {
+      uint32_t const kSignal = signal_.load(std::memory_order_acquire);
+      std::size_t const kTail = tail_.load(std::memory_order_acquire);
+      if (read_pos_ != kTail) {
+        // A plain scope: this header stays free of the Tracy include.
+        trace::Scope const kScope("AsyncWriter::Write");
+        Consume(kTail);
+        continue;
+      }
+
+      uint32_t const kFlush = flush_request_.load(std::memory_order_acquire);
+      if (kFlush != flushed) {
+        FlushSink();
+        flushed = kFlush;
+        flush_done_.store(flushed, std::memory_order_release);
+        flush_done_.notify_one();
+        continue;
+      }
+
+      if (closing_.load(std::memory_order_acquire)) {
+        break;
+      }
+      signal_.wait(kSignal, std::memory_order_acquire);
+    }
+    CloseSink();
+  }
+
+  // Consumer side: writes the ring up to `tail` to the sink and frees it.
+  void Consume(std::size_t tail) {
+    std::size_t const kAt = read_pos_ & mask_;
+    std::size_t const kFirst = std::min(tail - read_pos_, ring_.size() - kAt);
+    Write(&ring_[kAt], kFirst);
+    Write(ring_.data(), tail - read_pos_ - kFirst);
+    read_pos_ = tail;
+    head_.store(read_pos_, std::memory_order_release);
+    head_.notify_one();
+  }
+
+  void FlushSink() {
+    if (error_) {
+      return;
+    }
+    try {
+      sink_->Flush();
+    } catch (...) {
+      Fail();
+    }
+  }
+
+  // Destroying the sink finishes it (e.g. DeflateWriter's final block).
+  void CloseSink() {
+    try {
+      sink_.reset();
+    } catch (...) {
+      if (!error_) {
+        Fail();
+      }
+    }
+  }
+
+  void Write(uint8_t const* src, std::size_t n) {
+    if (n == 0 || error_) {
+      return;
+    }
+    try {
+      sink_->Put(src, n);
+    } catch (...) {
+      Fail();
+    }
+  }
+
+  void Fail() {
+    error_ = std::current_exception();
+    failed_.store(true, std::memory_order_release);
+  }
+
+  std::unique_ptr<Writer> sink_;
+  std::vector<uint8_t> ring_;
+  std::size_t mask_ = 0;
+
+  // Producer side.
+  std::size_t write_pos_ = 0;
+  std::size_t head_cache_ = 0;
+  // Spilled bytes; the first overflow_pos_ of them are already in the ring.
+  std::vector<uint8_t> overflow_;
+  std::size_t overflow_pos_ = 0;
+  std::size_t overflow_limit_;
+  bool overflowed_ = false;
+  bool closed_ = false;
+
+  // Consumer side.
+  std::size_t read_pos_ = 0;
+
+  // Shared. head_ / tail_ are running byte counts; signal_ bumps on every
+  // commit, flush request and close so the worker can sleep on it.
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<uint32_t> signal_{0};
+  std::atomic<uint32_t> flush_request_{0};
+  std::atomic<uint32_t> flush_done_{0};
+  std::atomic<bool> closing_{false};
+  // Set once by the worker; read by the producer only after a failed_,
+  // flush_done_ acquire or join.
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+
+  std::thread thread_;
+};
+
+}  // namespace io
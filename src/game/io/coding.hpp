@@ -14,11 +14,17 @@ namespace io {
 
 namespace detail {
 
+// io::Reader / io::Writer move the whole value in one call; types with
+// only the byte interface go a byte at a time.
 template <typename T, typename Reader>
 inline T ReadN(Reader& r) {
   uint8_t buf[sizeof(T)];
-  for (auto& b : buf) {
-    b = r.Get();
+  if constexpr (requires { r.Get(buf, sizeof(T)); }) {
+    r.Get(buf, sizeof(T));
+  } else {
+    for (auto& b : buf) {
+      b = r.Get();
+    }
   }
   T v;
   std::memcpy(&v, buf, sizeof(T));
@@ -29,8 +35,12 @@ template <typename T, typename Writer>
 inline void WriteN(Writer& w, T v) {
   uint8_t buf[sizeof(T)];
   std::memcpy(buf, &v, sizeof(T));
-  for (auto b : buf) {
-    w.Put(b);
+  if constexpr (requires { w.Put(buf, sizeof(T)); }) {
+    w.Put(buf, sizeof(T));
+  } else {
+    for (auto b : buf) {
+      w.Put(b);
+    }
   }
 }
 
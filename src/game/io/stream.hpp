@@ -4,14 +4,23 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <istream>
 #include <memory>
+#include <span>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Minimal stream layer: polymorphic Reader / Writer base classes with
 // concrete implementations for files, memory buffers, and (in deflate.hpp)
 // zlib-via-miniz streams.
+//
+// Readers backed by one contiguous buffer (MemReader, BufferReader) also
+// expose their unread bytes through Buffered(), so callers can parse or
+// deserialise in place with Borrow() instead of pulling bytes one virtual
+// Get() at a time.
 
 namespace io {
 
@@ -59,8 +68,58 @@ struct Reader {
     }
     return total;
   }
+
+  // The unread bytes, if the reader holds them in one contiguous buffer;
+  // empty for streaming readers. Valid until the next read or skip.
+  virtual std::span<uint8_t const> Buffered() { return {}; }
+
+  // The next `n` bytes, consumed. Points into the reader's own buffer
+  // when it has one, otherwise they're copied into `scratch`. Valid until
+  // the next read or until `scratch` changes. Throws EndOfStream if fewer
+  // than `n` bytes are left.
+  //
+  // `n` often comes from the stream itself, so a corrupt length must not
+  // cost more memory than the data that is actually there: a buffered
+  // reader holds everything left, and the copy grows only as bytes arrive.
+  std::span<uint8_t const> Borrow(std::size_t n, std::vector<uint8_t>& scratch) {
+    std::span<uint8_t const> const kBuf = Buffered();
+    if (kBuf.size() >= n) {
+      TrySkip(n);
+      return kBuf.first(n);
+    }
+    if (!kBuf.empty()) {
+      throw EndOfStream{};
+    }
+    constexpr std::size_t kChunk = std::size_t{1} << 16;
+    scratch.clear();
+    while (scratch.size() < n) {
+      std::size_t const kHave = scratch.size();
+      std::size_t const kTake = std::min(kChunk, n - kHave);
+      scratch.resize(kHave + kTake);
+      if (TryGet(scratch.data() + kHave, kTake) != kTake) {
+        throw EndOfStream{};
+      }
+    }
+    return scratch;
+  }
 };
 
+// Everything left in `r`, as text for the parsers that want a string.
+inline std::string ReadAll(Reader& r) {
+  std::span<uint8_t const> const kBuf = r.Buffered();
+  std::string out(reinterpret_cast<char const*>(kBuf.data()), kBuf.size());
+  r.TrySkip(kBuf.size());
+  char buf[4096];
+  for (;;) {
+    std::size_t const kGot = r.TryGet(reinterpret_cast<uint8_t*>(buf), sizeof(buf));
+    if (kGot == 0) {
+      break;
+    }
+    out.append(buf, kGot);
+  }
+  return out;
+}
+
 struct Writer {
   virtual ~Writer() = default;
 
@@ -151,7 +210,7 @@ struct FileWriter : Writer {
 
 // ---- Memory-backed ----
 
-struct MemReader : Reader {
+struct MemReader final : Reader {
   MemReader() = default;
   MemReader(uint8_t const* data, std::size_t size) : data_(data), size_(size) {}
   explicit MemReader(std::string const& s)
@@ -189,12 +248,67 @@ struct MemReader : Reader {
     return kTake;
   }
 
+  std::size_t TrySkip(std::size_t n) override {
+    std::size_t const kTake = std::min(n, size_ - pos_);
+    pos_ += kTake;
+    return kTake;
+  }
+
+  std::span<uint8_t const> Buffered() override { return {data_ + pos_, size_ - pos_}; }
+
  private:
   uint8_t const* data_ = nullptr;
   std::size_t size_ = 0;
   std::size_t pos_ = 0;
 };
 
+struct SpanStreamBuf : std::streambuf {
+  explicit SpanStreamBuf(std::span<uint8_t const> data) {
+    // The get area is never written through.
+    char* const kBegin = const_cast<char*>(reinterpret_cast<char const*>(data.data()));
+    setg(kBegin, kBegin, kBegin + data.size());
+  }
+};
+
+// std::istream over a borrowed buffer, so cereal archives can read a
+// Borrow()ed region in place. (std::ispanstream isn't in every standard
+// library we build with.)
+class SpanIStream : private SpanStreamBuf, public std::istream {
+ public:
+  explicit SpanIStream(std::span<uint8_t const> data)
+      : SpanStreamBuf(data), std::istream(static_cast<SpanStreamBuf*>(this)) {}
+};
+
+// A MemReader over a buffer it owns: whole files read up front, entries
+// extracted from a zip.
+struct BufferReader final : Reader {
+  explicit BufferReader(std::vector<uint8_t>&& data)
+      : data_(std::move(data)), inner_(data_.data(), data_.size()) {}
+  BufferReader(BufferReader const&) = delete;
+  BufferReader& operator=(BufferReader const&) = delete;
+
+  // The rest of `r`, read in one go. `size_hint` is what to reserve.
+  static std::unique_ptr<BufferReader> ReadFrom(Reader& r, std::size_t size_hint = 0) {
+    std::vector<uint8_t> data(size_hint);
+    std::size_t got = r.TryGet(data.data(), size_hint);
+    data.resize(got);
+    uint8_t buf[4096];
+    while ((got = r.TryGet(buf, sizeof(buf))) > 0) {
+      data.insert(data.end(), buf, buf + got);
+    }
+    return std::make_unique<BufferReader>(std::move(data));
+  }
+
+  uint8_t Get() override { return inner_.Get(); }
+  std::size_t TryGet(uint8_t* dst, std::size_t n) override { return inner_.TryGet(dst, n); }
+  std::size_t TrySkip(std::size_t n) override { return inner_.TrySkip(n); }
+  std::span<uint8_t const> Buffered() override { return inner_.Buffered(); }
+
+ private:
+  std::vector<uint8_t> data_;
+  MemReader inner_;
+};
+
 struct VectorWriter : Writer {
   std::vector<uint8_t>& buf;
   explicit VectorWriter(std::vector<uint8_t>& b) : buf(b) {}
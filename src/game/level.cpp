@@ -5,7 +5,9 @@
 #include "gfx.hpp"
 #include "gfx/color.hpp"
 #include "io/stream.hpp"
+#include "tiled_level.hpp"
 
+#include <atomic>
 #include <cstring>
 
 void Level::GenerateDirtPattern(Common& common, Rand& rand) {
@@ -103,6 +105,11 @@ void Level::GenerateRandom(Common& common, Settings const& settings, Rand& rand)
   has_custom_palette = false;
 
   Resize(settings.random_map_width, settings.random_map_height);
+  if (settings.random_level_generator == Settings::kLevelGenTiled) {
+    GenerateTiled(common, rand);
+    return;
+  }
+
   GenerateDirtPattern(common, rand);
 
   int count = rand(50) + 5;
@@ -192,21 +199,203 @@ void Level::GenerateRandom(Common& common, Settings const& settings, Rand& rand)
   }
 }
 
-void Level::MakeShadow(Common& common) {
-  for (int x = 0; x < width - 3; ++x) {
-    for (int y = 3; y < height; ++y) {
-      if (Mat(x, y).SeeShadow() && Mat(x + 3, y - 3).DirtRock()) {
-        SetPixel(x, y, Pixel(x, y) + 4, common);
-      }
+// Classic feature counts are for the whole 504x350 map; the tiled
+// generator scales them to each tile's area.
+static uint32_t ScaledCount(uint32_t classic, int area) {
+  int const kClassicArea = 504 * 350;
+  return static_cast<uint32_t>(((static_cast<int64_t>(classic) * area) + (kClassicArea / 2)) /
+                               kClassicArea);
+}
 
-      if (Pixel(x, y) >= 12 && Pixel(x, y) <= 18 && Mat(x + 3, y - 3).Rock()) {
-        SetPixel(x, y, Pixel(x, y) - 2, common);
-        if (Pixel(x, y) < 12) {
-          SetPixel(x, y, 12, common);
+// An independent RNG stream for one tile and pass (splitmix64 finalizer).
+static uint32_t TileSeed(uint32_t seed, int tx, int ty, uint32_t stream) {
+  uint64_t z = ((static_cast<uint64_t>(seed) << 32) | stream) +
+               (0x9E3779B97F4A7C15ULL *
+                (1 + static_cast<uint64_t>(tx) + (static_cast<uint64_t>(ty) << 16)));
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return static_cast<uint32_t>(z ^ (z >> 31));
+}
+
+void Level::GenerateTiled(Common& common, Rand& rand, unsigned max_threads) {
+  // Features anchored in a tile stay within kReach of it. Tiles in the same
+  // phase are a whole tile apart, so with 2 * kReach <= kGenTileSize their
+  // reads and writes never meet and the phase can run in any order.
+  int const kReach = 64;
+  static_assert(2 * kReach <= kGenTileSize);
+  // The level was just resized, so dirty and render tracking are off and
+  // SetPixel/MarkDirty only touch the cell itself.
+
+  uint32_t const kSeed = rand();
+  int const kTilesW = (width + kGenTileSize - 1) / kGenTileSize;
+  int const kTilesH = (height + kGenTileSize - 1) / kGenTileSize;
+
+  auto tile_rect = [&](int tx, int ty) {
+    return Rect(tx * kGenTileSize, ty * kGenTileSize, std::min((tx + 1) * kGenTileSize, width),
+                std::min((ty + 1) * kGenTileSize, height));
+  };
+
+  // The classic dirt recurrence, restarted at every tile.
+  ParallelFor(
+      static_cast<std::size_t>(kTilesW) * kTilesH,
+      [&](std::size_t i) {
+        int const kTx = static_cast<int>(i % kTilesW);
+        int const kTy = static_cast<int>(i / kTilesW);
+        Rect const kR = tile_rect(kTx, kTy);
+        Rand tile_rand(TileSeed(kSeed, kTx, kTy, 0));
+
+        SetPixel(kR.x1, kR.y1, tile_rand(7) + 12, common);
+        for (int y = kR.y1 + 1; y < kR.y2; ++y) {
+          SetPixel(kR.x1, y, ((tile_rand(7) + 12) + Pixel(kR.x1, y - 1)) >> 1, common);
         }
-      }
-    }
+        for (int x = kR.x1 + 1; x < kR.x2; ++x) {
+          SetPixel(x, kR.y1, ((tile_rand(7) + 12) + Pixel(x - 1, kR.y1)) >> 1, common);
+        }
+        for (int y = kR.y1 + 1; y < kR.y2; ++y) {
+          for (int x = kR.x1 + 1; x < kR.x2; ++x) {
+            SetPixel(x, y, (Pixel(x - 1, y) + Pixel(x, y - 1) + tile_rand(8) + 12) / 3, common);
+          }
+        }
+      },
+      max_threads);
+
+  // Decorations, stones, dirt and rock formations, in the classic order
+  // within each tile. Later phases see earlier phases' rocks.
+  int const kMaxTries = 1024;
+  for (int phase = 0; phase < 4; ++phase) {
+    int const kPx = phase & 1;
+    int const kPy = phase >> 1;
+    int const kPhaseW = (kTilesW - kPx + 1) / 2;
+    int const kPhaseH = (kTilesH - kPy + 1) / 2;
+    ParallelFor(
+        static_cast<std::size_t>(std::max(kPhaseW, 0)) * std::max(kPhaseH, 0),
+        [&](std::size_t i) {
+          int const kTx = kPx + (2 * static_cast<int>(i % kPhaseW));
+          int const kTy = kPy + (2 * static_cast<int>(i / kPhaseW));
+          Rect const kR = tile_rect(kTx, kTy);
+          int const kArea = kR.Width() * kR.Height();
+          Rand tile_rand(TileSeed(kSeed, kTx, kTy, 1));
+          auto rand_x = [&](int margin) {
+            return kR.x1 + static_cast<int>(tile_rand(kR.Width())) - margin;
+          };
+          auto rand_y = [&](int margin) {
+            return kR.y1 + static_cast<int>(tile_rand(kR.Height())) - margin;
+          };
+
+          uint32_t count = tile_rand(ScaledCount(100, kArea));
+          for (uint32_t j = 0; j < count; ++j) {
+            int const kX = rand_x(8);
+            int const kY = rand_y(8);
+            PalIdx const* image = common.large_sprites.SpritePtr(tile_rand(4) + 69);
+            for (int cy = std::max(0, -kY); cy < 16 && kY + cy < height; ++cy) {
+              for (int cx = std::max(0, -kX); cx < 16 && kX + cx < width; ++cx) {
+                PalIdx const kSrcPix = image[(cy << 4) + cx];
+                if (kSrcPix > 0) {
+                  PalIdx const kPix = Pixel(kX + cx, kY + cy);
+                  SetPixel(kX + cx, kY + cy,
+                           kPix > 176 && kPix < 180 ? (kSrcPix + kPix) / 2 : kSrcPix, common);
+                }
+              }
+            }
+          }
+
+          count = tile_rand(ScaledCount(15, kArea));
+          for (uint32_t j = 0; j < count; ++j) {
+            int const kX = rand_x(8);
+            int const kY = rand_y(8);
+            BlitStone(common, *this, /*p1=*/false,
+                      common.large_sprites.SpritePtr(tile_rand(4) + 56), kX, kY);
+          }
+
+          // The classic walk can wander far from where it starts; steps
+          // that leave the tile's reach are dropped.
+          Rect const kDirtReach(kR.x1 - kReach, kR.y1 - kReach, kR.x2 + kReach - 16,
+                                kR.y2 + kReach - 16);
+          count = tile_rand(ScaledCount(50, kArea)) + ScaledCount(5, kArea);
+          for (uint32_t j = 0; j < count; ++j) {
+            int cx = rand_x(8);
+            int cy = rand_y(8);
+            int const kDx = tile_rand(11) - 5;
+            int const kDy = tile_rand(5) - 2;
+            int const kCount2 = tile_rand(12);
+            for (int k = 0; k < kCount2; ++k) {
+              int const kCount3 = tile_rand(5);
+              for (int l = 0; l < kCount3; ++l) {
+                cx += kDx;
+                cy += kDy;
+                if (kDirtReach.Inside(cx, cy)) {
+                  DrawDirtEffect(common, tile_rand, *this, 1, cx, cy);
+                }
+              }
+              cx -= (kCount3 + 1) * kDx;
+              cy -= (kCount3 + 1) * kDy;
+              cx += tile_rand(7) - 3;
+              cy += tile_rand(15) - 7;
+            }
+          }
+
+          bool const kBottom = kR.y2 == height;
+          count = tile_rand(ScaledCount(15, kArea)) + ScaledCount(5, kArea);
+          for (uint32_t j = 0; j < count; ++j) {
+            int cx = 0;
+            int cy = 0;
+            int tries = 0;
+            do {
+              cx = rand_x(16);
+              cy = kBottom && tile_rand(4) == 0 ? height - 1 - tile_rand(20) : rand_y(16);
+            } while (!IsNoRock(common, *this, 32, cx, cy) && ++tries < kMaxTries);
+            if (tries >= kMaxTries) {
+              continue;
+            }
+            int const kRock = tile_rand(3);
+            for (int part = 0; part < 4; ++part) {
+              BlitStone(common, *this, /*p1=*/false,
+                        common.large_sprites.SpritePtr(stone_tab[kRock][part]),
+                        cx + ((part & 1) * 16), cy + ((part >> 1) * 16));
+            }
+          }
+
+          count = tile_rand(ScaledCount(25, kArea)) + ScaledCount(5, kArea);
+          for (uint32_t j = 0; j < count; ++j) {
+            int cx = 0;
+            int cy = 0;
+            int tries = 0;
+            do {
+              cx = rand_x(8);
+              cy = kBottom && tile_rand(5) == 0 ? height - 1 - tile_rand(13) : rand_y(8);
+            } while (!IsNoRock(common, *this, 15, cx, cy) && ++tries < kMaxTries);
+            if (tries >= kMaxTries) {
+              continue;
+            }
+            BlitStone(common, *this, /*p1=*/false,
+                      common.large_sprites.SpritePtr(tile_rand(6) + 3), cx, cy);
+          }
+        },
+        max_threads);
   }
+}
+
+void Level::MakeShadow(Common& common) {
+  // The original pass walks x-major, so the (x + 3, y - 3) cell it reads
+  // is always still unshadowed: each cell only depends on the level as it
+  // was, which lets RewriteCells do it in row bands.
+  RewriteCells(common, Rect(0, 3, width - 3, height), [this](int x, int y) {
+    int const kIdx = x + (y * width);
+    Material const kCaster = materials[kIdx + 3 - (3 * width)];
+    int pix = material_id[kIdx];
+    bool touched = false;
+
+    if (materials[kIdx].SeeShadow() && kCaster.DirtRock()) {
+      pix = static_cast<PalIdx>(pix + 4);
+      touched = true;
+    }
+
+    if (pix >= 12 && pix <= 18 && kCaster.Rock()) {
+      pix = std::max(pix - 2, 12);
+      touched = true;
+    }
+    return touched ? pix : kKeepCell;
+  });
 
   for (int x = 0; x < width; ++x) {
     if (Mat(x, height - 1).Background()) {
@@ -215,6 +404,84 @@ void Level::MakeShadow(Common& common) {
   }
 }
 
+void Level::RebuildMaterials(Common const& common) {
+  int const kRows = BandRows(width);
+  ParallelFor(BandCount(height, kRows), [&](std::size_t band) {
+    std::size_t const kBegin = band * kRows * static_cast<std::size_t>(width);
+    std::size_t const kEnd = std::min(kBegin + (static_cast<std::size_t>(kRows) * width),
+                                      material_id.size());
+    for (std::size_t i = kBegin; i < kEnd; ++i) {
+      materials[i] = common.materials[material_id[i]];
+    }
+  });
+  InvalidateRender();
+}
+
+void Level::RevertToDirtyBase(Common const& common) {
+  bool const kHasDv = !display_valid.empty() && !dirty_base_display_valid.empty();
+  auto revert = [&](std::size_t i) {
+    if (!CellDiffersFromBase(i)) {
+      return;
+    }
+    material_id[i] = dirty_base_material_id[i];
+    materials[i] = common.materials[material_id[i]];
+    if (kHasDv) {
+      display_valid[i] = dirty_base_display_valid[i];
+    }
+    MarkDirty(static_cast<int>(i));
+  };
+  if (!dirty_bits.empty()) {
+    // MarkDirty only appends cells not yet listed, so the walk is stable.
+    for (int32_t const kIdx : dirty_list) {
+      revert(static_cast<std::size_t>(kIdx));
+    }
+  } else if (!delta_bits.empty()) {
+    for (std::size_t i = 0; i < material_id.size(); ++i) {
+      revert(i);
+    }
+  }
+}
+
+void Level::StoreCells(Common& common, Rect rect, std::vector<int16_t> const& pix) {
+  int const kW = rect.Width();
+  int const kRows = BandRows(kW);
+  std::size_t const kBands = BandCount(rect.Height(), kRows);
+  bool const kTrack = DirtyTracking() || !render_tile_revision.empty();
+  bool const kHasDv = !display_valid.empty();
+  // Stored cells per band, marked dirty once the bands are done: MarkDirty
+  // appends to shared lists.
+  std::vector<std::vector<int32_t>> stored(kTrack ? kBands : 0);
+
+  ParallelFor(kBands, [&](std::size_t band) {
+    int const kY1 = rect.y1 + (static_cast<int>(band) * kRows);
+    int const kY2 = std::min(rect.y2, kY1 + kRows);
+    for (int y = kY1; y < kY2; ++y) {
+      int16_t const* in = &pix[static_cast<std::size_t>(y - rect.y1) * kW];
+      for (int x = rect.x1; x < rect.x2; ++x) {
+        int const kPix = in[x - rect.x1];
+        if (kPix == kKeepCell) {
+          continue;
+        }
+        int const kIdx = x + (y * width);
+        material_id[kIdx] = static_cast<PalIdx>(kPix);
+        materials[kIdx] = common.materials[kPix];
+        if (kHasDv) {
+          display_valid[kIdx] = 0;
+        }
+        if (kTrack) {
+          stored[band].push_back(kIdx);
+        }
+      }
+    }
+  });
+
+  for (std::vector<int32_t> const& cells : stored) {
+    for (int32_t const kIdx : cells) {
+      MarkDirty(kIdx);
+    }
+  }
+}
+
 void Level::Resize(int width_new, int height_new) {
   width = width_new;
   height = height_new;
@@ -224,10 +491,37 @@ void Level::Resize(int width_new, int height_new) {
   // re-initialises for the new dimensions.
   dirty_bits.clear();
   dirty_list.clear();
+  dirty_base_material_id.clear();
+  dirty_base_display_valid.clear();
+  dirty_base_digest = 0;
+  delta_bits.clear();
+  delta_list.clear();
+  delta_base_material_id.clear();
+  delta_base_display_valid.clear();
+  delta_base_digest = 0;
+  // Everything resizing is followed by a full rewrite of the cells.
+  InvalidateRender();
+}
+
+uint32_t Level::NextRenderEpoch() {
+  static std::atomic<uint32_t> next{1};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool Level::EnsureRenderTiles() const {
+  int const kTilesW = (width + kRenderTileSize - 1) >> kRenderTileShift;
+  std::size_t const kTiles = static_cast<std::size_t>(kTilesW) * RenderTilesH();
+  if (kTiles == 0 || (render_tiles_w == kTilesW && render_tile_revision.size() == kTiles)) {
+    return false;
+  }
+  render_tiles_w = kTilesW;
+  render_tile_revision.assign(kTiles, 0);
+  return true;
 }
 
 bool Level::load(Common& common, Settings const& settings, io::Reader& r) {
-  // Probe for OLLEVEL2 sized-format header: magic(8) + version(1) + w(2LE) + h(2LE).
+  // Probe for OLLEVEL2 sized-format header: magic(8) + version(1) + w(2LE) + h(2LE),
+  // or for the OLLEVEL3 tiled format.
   static constexpr uint8_t kSizedMagic[8] = {'O', 'L', 'L', 'E', 'V', 'E', 'L', '2'};
   static constexpr int kMaxDim = 4096;
 
@@ -239,6 +533,10 @@ bool Level::load(Common& common, Settings const& settings, io::Reader& r) {
   uint8_t leftover[8] = {};
   std::size_t leftover_count = 0;
 
+  if (kProbeRead == 8 && std::memcmp(kTiledLevelMagic, probe, 8) == 0) {
+    return ReadTiledLevel(*this, common, settings, r);
+  }
+
   if (kProbeRead == 8 && std::memcmp(kSizedMagic, probe, 8) == 0) {
     uint8_t hdr[5] = {};
     if (r.TryGet(hdr, 5) != 5) {
@@ -382,9 +680,7 @@ bool Level::load(Common& common, Settings const& settings, io::Reader& r) {
     }
   }
 
-  for (std::size_t i = 0; i < material_id.size(); ++i) {
-    materials[i] = common.materials[material_id[i]];
-  }
+  RebuildMaterials(common);
 
   if (reset_palette) {
     origpal.ResetPalette(common.exepal, settings);
@@ -422,6 +718,7 @@ void Level::GenerateFromSettings(Common& common, Settings const& settings, Rand&
   old_level_file = settings.level_file;
   old_random_map_width = settings.random_map_width;
   old_random_map_height = settings.random_map_height;
+  old_random_level_generator = settings.random_level_generator;
 
   if (settings.shadow) {
     MakeShadow(common);
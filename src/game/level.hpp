@@ -1,14 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <string>
 #include <utility>
 #include <vector>
 #include "common.hpp"
+#include "free_space_index.hpp"
 #include "gfx/palette.hpp"
 #include "material.hpp"
 #include "math/rect.hpp"
+#include "parallel.hpp"
 
 namespace io {
 struct Reader;
@@ -21,7 +25,7 @@ struct Common;
 struct ShadowQuery;
 
 struct Level {
-  Level(Common& common) : zero_material(common.materials[0]) {}
+  Level(Common& common) : render_epoch(NextRenderEpoch()), zero_material(common.materials[0]) {}
 
   // Minimap bounding-box targets used by all call sites.
   // For a 504×350 level these produce the original Liero 1.36 step values:
@@ -36,6 +40,12 @@ struct Level {
 
   void GenerateDirtPattern(Common& common, Rand& rand);
   void GenerateRandom(Common& common, Settings const& settings, Rand& rand);
+  // Settings::kLevelGenTiled: fills the current size from one draw of
+  // `rand`. Each tile gets its own RNG streams derived from that seed, and
+  // tiles run in parallel phases whose writes never overlap, so the level
+  // is the same whatever `max_threads` (0 = all cores) is.
+  static constexpr int kGenTileSize = 256;
+  void GenerateTiled(Common& common, Rand& rand, unsigned max_threads = 0);
   void MakeShadow(Common& common);
   void GenerateFromSettings(Common& common, Settings const& settings, Rand& rand);
   bool SelectSpawn(Rand& rand, int w, int h, IVec2& selected);
@@ -90,10 +100,77 @@ struct Level {
   }
 
   // Initialise dirty tracking for rollback snapshot optimisation.
-  // Called once by SaveSnapshotFast before the first rollback save.
+  // Called once by SaveSnapshotFast before the first whole-level rollback
+  // save. Also captures the level as it stands as the match's base, unless
+  // delta tracking took it first; then the cells dug since are listed.
   void InitDirtyTracking() {
-    dirty_bits.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(height), false);
+    std::size_t const kCells = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    dirty_bits.assign(kCells, false);
     dirty_list.clear();
+    if (!delta_bits.empty()) {
+      for (std::size_t i = 0; i < kCells; ++i) {
+        if (CellDiffersFromBase(i)) {
+          MarkDirty(static_cast<int>(i));
+        }
+      }
+      return;
+    }
+    TakeDirtyBase();
+  }
+
+  // Cells the delta list is pre-sized for, and the length past which
+  // Game::RebaseLevelDelta moves the delta base up to a confirmed frame.
+  static constexpr std::size_t kDeltaReserveCells = std::size_t{1} << 16;
+  static constexpr std::size_t kDeltaRebaseCells = std::size_t{1} << 14;
+
+  // Initialise delta tracking for GameSnapshot::LevelStorage::kDelta slots.
+  // Called by SaveSnapshotFast before the first delta save, and again to
+  // restart from the level as it stands (ApplyResyncState). Takes the
+  // match's base as well if nothing has yet.
+  void InitDeltaTracking() {
+    if (dirty_bits.empty() && delta_bits.empty()) {
+      TakeDirtyBase();
+    }
+    bool const kAtBase = dirty_bits.empty() ? delta_bits.empty() : dirty_list.empty();
+    delta_bits.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(height), false);
+    delta_list.clear();
+    delta_list.reserve(kDeltaReserveCells);
+    delta_base_material_id = material_id;
+    delta_base_display_valid = display_valid;
+    delta_base_digest = kAtBase ? dirty_base_digest : ContentDigest();
+    ++delta_epoch;
+  }
+
+  // Either kind of rollback dirty tracking is running.
+  bool DirtyTracking() const { return !dirty_bits.empty() || !delta_bits.empty(); }
+
+  // Puts every cell back to its value in the match's base, marking the
+  // ones that change. Walks dirty_list when it is kept, the whole map
+  // otherwise.
+  void RevertToDirtyBase(Common const& common);
+
+  // Order-independent hash of one cell's sim-visible layers. The digest of
+  // a level is the wrapping sum over all cells, so replacing one cell's
+  // term updates it in O(1) (see SnapshotChecksum).
+  static uint64_t CellDigest(std::size_t idx, uint8_t material, uint8_t valid) {
+    uint64_t z = (static_cast<uint64_t>(idx) << 16) | (static_cast<uint64_t>(material) << 8) |
+                 valid;
+    // splitmix64 finaliser
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Sum of CellDigest over the whole map. O(cells); the checksum only pays
+  // for it once, when dirty tracking starts.
+  uint64_t ContentDigest() const {
+    uint64_t digest = 0;
+    bool const kHasDv = !display_valid.empty();
+    for (std::size_t i = 0; i < material_id.size(); ++i) {
+      digest += CellDigest(i, material_id[i], kHasDv ? display_valid[i] : 0);
+    }
+    return digest;
   }
 
   // Mark a flat cell index as dirty for rollback snapshot optimisation.
@@ -105,6 +182,30 @@ struct Level {
       dirty_bits[static_cast<std::size_t>(idx)] = true;
       dirty_list.push_back(idx);
     }
+    if (!delta_bits.empty() && !delta_bits[static_cast<std::size_t>(idx)]) {
+      delta_bits[static_cast<std::size_t>(idx)] = true;
+      delta_list.push_back(idx);
+    }
+    if (!render_tile_revision.empty()) {
+      int const kTx = (idx % width) >> kRenderTileShift;
+      int const kTy = (idx / width) >> kRenderTileShift;
+      render_tile_revision[(static_cast<std::size_t>(kTy) * render_tiles_w) + kTx] =
+          ++render_revision;
+    }
+  }
+
+  // Render-side change tracking for persistent images of the level (see
+  // MinimapCache). Off until a consumer calls EnsureRenderTiles; from then on
+  // MarkDirty stamps the cell's tile with a fresh render_revision, and the
+  // consumer redoes the tiles stamped after the revision it last saw.
+  // Returns true when tracking was (re)started, i.e. nothing is tracked yet.
+  bool EnsureRenderTiles() const;
+  int RenderTilesW() const { return render_tiles_w; }
+  int RenderTilesH() const { return (height + kRenderTileSize - 1) >> kRenderTileShift; }
+  // The whole level was replaced: consumers must rebuild from scratch.
+  void InvalidateRender() {
+    render_epoch = NextRenderEpoch();
+    render_tile_revision.clear();
   }
 
   Material& Mat(int x, int y) { return materials[x + y * width]; }
@@ -148,6 +249,17 @@ struct Level {
     display_anim.swap(other.display_anim);
     dirty_bits.swap(other.dirty_bits);
     dirty_list.swap(other.dirty_list);
+    dirty_base_material_id.swap(other.dirty_base_material_id);
+    dirty_base_display_valid.swap(other.dirty_base_display_valid);
+    std::swap(dirty_base_digest, other.dirty_base_digest);
+    delta_bits.swap(other.delta_bits);
+    delta_list.swap(other.delta_list);
+    delta_base_material_id.swap(other.delta_base_material_id);
+    delta_base_display_valid.swap(other.delta_base_display_valid);
+    std::swap(delta_base_digest, other.delta_base_digest);
+    std::swap(delta_epoch, other.delta_epoch);
+    InvalidateRender();
+    other.InvalidateRender();
     std::swap(width, other.width);
     std::swap(height, other.height);
     std::swap(origpal, other.origpal);
@@ -156,6 +268,7 @@ struct Level {
     std::swap(old_level_file, other.old_level_file);
     std::swap(old_random_map_width, other.old_random_map_width);
     std::swap(old_random_map_height, other.old_random_map_height);
+    std::swap(old_random_level_generator, other.old_random_level_generator);
     std::swap(zero_material, other.zero_material);
   }
 
@@ -179,6 +292,45 @@ struct Level {
 
   void Resize(int width_new, int height_new);
 
+  // Cells per row band of the whole-level passes below. A classic 504x350
+  // level fits in one band, so those passes stay on the calling thread.
+  static constexpr int kBandCells = 1 << 18;
+
+  // materials[i] = common.materials[material_id[i]] for every cell. Callers
+  // have replaced the cells wholesale, so this also invalidates the caches
+  // that follow MarkDirty.
+  void RebuildMaterials(Common const& common);
+
+  // Returned by a RewriteCells callback to leave the cell alone.
+  static constexpr int kKeepCell = -1;
+
+  // Applies new_pix(x, y) to every cell of `rect` (clipped to the level)
+  // in parallel row bands. A result other than kKeepCell is stored as by
+  // SetPixel, except that the cells are marked dirty afterwards, in row
+  // order. new_pix always sees the level as it was before the call, so it
+  // gives the same result as a serial pass only when no cell reads a cell
+  // that the pass visits before it.
+  template <typename F>
+  void RewriteCells(Common& common, Rect rect, F const& new_pix) {
+    if (!rect.Intersect(Bounds()) || rect.Width() == 0 || rect.Height() == 0) {
+      return;
+    }
+    int const kW = rect.Width();
+    int const kRows = BandRows(kW);
+    std::vector<int16_t> pix(static_cast<std::size_t>(kW) * rect.Height());
+    ParallelFor(BandCount(rect.Height(), kRows), [&](std::size_t band) {
+      int const kY1 = rect.y1 + (static_cast<int>(band) * kRows);
+      int const kY2 = std::min(rect.y2, kY1 + kRows);
+      for (int y = kY1; y < kY2; ++y) {
+        int16_t* out = &pix[static_cast<std::size_t>(y - rect.y1) * kW];
+        for (int x = rect.x1; x < rect.x2; ++x) {
+          out[x - rect.x1] = static_cast<int16_t>(new_pix(x, y));
+        }
+      }
+    });
+    StoreCells(common, rect, pix);
+  }
+
   std::vector<unsigned char> material_id;
   std::vector<Material> materials;
   // Optional true-colour display layer (modern levels only). Both stay empty
@@ -192,17 +344,61 @@ struct Level {
   std::vector<ArgbRamp> argb_ramps;
   std::vector<uint8_t> display_anim;
 
-  // Rollback snapshot optimisation: dirty tracking for SaveSnapshotFast.
-  // Both are empty until InitDirtyTracking() is called (first rollback save).
-  // dirty_list accumulates indices of every cell ever modified via SetPixel;
-  // dirty_bits prevents duplicates. Neither is ever cleared during a game.
+  // Rollback snapshot optimisation: dirty tracking for SaveSnapshotFast's
+  // whole-level slots. Both are empty until InitDirtyTracking() is called
+  // (first such save). dirty_list accumulates indices of every cell ever
+  // modified via SetPixel; dirty_bits prevents duplicates. Neither is ever
+  // cleared during a game.
   std::vector<bool> dirty_bits;
   std::vector<int32_t> dirty_list;
+  // material_id / display_valid as they were when either kind of tracking
+  // started: the match's base, which resync states are expressed against.
+  // While dirty_list is kept, a cell not in it still holds its base value.
+  std::vector<uint8_t> dirty_base_material_id;
+  std::vector<uint8_t> dirty_base_display_valid;
+  // ContentDigest() of the base layers above.
+  uint64_t dirty_base_digest = 0;
+
+  // Delta tracking for GameSnapshot::LevelStorage::kDelta slots, empty
+  // until InitDeltaTracking(). delta_base_* is the level as of a confirmed
+  // frame (see Game::RebaseLevelDelta); delta_list holds the cells that
+  // may differ from it, in the order they were first dirtied since, and
+  // delta_bits marks them. A cell not in delta_list holds its delta base
+  // value. Each rebase drops the cells that settled, so the list follows
+  // what the rollback window digs rather than the whole match.
+  std::vector<bool> delta_bits;
+  std::vector<int32_t> delta_list;
+  std::vector<uint8_t> delta_base_material_id;
+  std::vector<uint8_t> delta_base_display_valid;
+  // ContentDigest() of the delta base.
+  uint64_t delta_base_digest = 0;
+  // Bumped whenever the delta base moves. A kDelta slot saved under an
+  // older epoch no longer describes a restorable state.
+  uint32_t delta_epoch = 0;
+
+  // Render-side tracking state (EnsureRenderTiles). Display-only: never
+  // snapshotted or hashed, mutable so const drawing code can switch it on.
+  static constexpr int kRenderTileShift = 5;
+  static constexpr int kRenderTileSize = 1 << kRenderTileShift;
+  mutable std::vector<uint64_t> render_tile_revision;
+  mutable int render_tiles_w = 0;
+  uint64_t render_revision = 0;
+  // Changes whenever the level content is replaced wholesale (Resize, Swap,
+  // InvalidateRender); unique across all levels, so a cache keyed on it
+  // never mistakes a new level at a reused address for the old one.
+  uint32_t render_epoch;
+
+  // Spawn and bonus placement queries (CheckRespawnPosition,
+  // CheckBonusSpawnPosition). Caches over `materials`, like the render
+  // state above.
+  mutable FreeSpaceIndex rock_space{Material::kRock};
+  mutable FreeSpaceIndex dirt_rock_space{Material::kDirt | Material::kDirt2 | Material::kRock};
 
   bool old_random_level;
   std::string old_level_file;
   int32_t old_random_map_width{504};
   int32_t old_random_map_height{350};
+  uint32_t old_random_level_generator{0};
   int width{0}, height{0};
   Palette origpal;
   // True when the level shipped its own palette (e.g. POWERLEVEL); such a
@@ -214,6 +410,29 @@ struct Level {
  private:
   friend struct ShadowQuery;
 
+  static uint32_t NextRenderEpoch();
+
+  static int BandRows(int row_width) { return std::max(1, kBandCells / std::max(1, row_width)); }
+  static std::size_t BandCount(int rows, int band_rows) {
+    return static_cast<std::size_t>((rows + band_rows - 1) / band_rows);
+  }
+
+  // The write half of RewriteCells.
+  void StoreCells(Common& common, Rect rect, std::vector<int16_t> const& pix);
+
+  // Captures the level as the match's base (dirty_base_*).
+  void TakeDirtyBase() {
+    dirty_base_material_id = material_id;
+    dirty_base_display_valid = display_valid;
+    dirty_base_digest = ContentDigest();
+  }
+
+  bool CellDiffersFromBase(std::size_t idx) const {
+    return material_id[idx] != dirty_base_material_id[idx] ||
+           (!display_valid.empty() && !dirty_base_display_valid.empty() &&
+            display_valid[idx] != dirty_base_display_valid[idx]);
+  }
+
   // Resolves the modern-authored colour at `idx` (caller must ensure
   // display_valid[idx] is true). Returns the animated colour when ramps are
   // active, otherwise the static display_data value.
@@ -5,9 +5,12 @@
 #include "../filesystem.hpp"
 #include "../gfx.hpp"
 #include "../mixer/player.hpp"
+#include "../trace.hpp"
 
 // NOLINTNEXTLINE(bugprone-throwing-static-initialization, cert-err58-cpp) — string-literal constructor can theoretically throw bad_alloc, but the allocations are tiny and any failure here is unrecoverable anyway.
 static std::string const kBotWeaponSel[3] = {"RANDOM", "PICK", "KEEP"};
+// NOLINTNEXTLINE(bugprone-throwing-static-initialization, cert-err58-cpp) — as above.
+static std::string const kLevelGeneratorSel[Settings::kMaxLevelGens] = {"CLASSIC", "TILED"};
 
 ItemBehavior* HiddenMenu::GetItemBehavior(Common& common, MenuItem& item) {
   switch (item.id) {
@@ -54,6 +57,31 @@ ItemBehavior* HiddenMenu::GetItemBehavior(Common& common, MenuItem& item) {
     // window resize / video-mode change (see Gfx::OnWindowResize).
     case kMaxSpectatorRenderHeight:
       return new IntegerBehavior(common, gfx.settings->max_spectator_render_height, 0, 4320, 120);
+    // Picked up by the next spectator frame (see Gfx::SpectatorResidentLevelMax).
+    case kSpectatorResidentLevel:
+      return new BooleanSwitchBehavior(common, gfx.settings->spectator_resident_level);
+    // Picked up when the next online match starts (see NetSession::BeginPlaying).
+    case kNetIoThread:
+      return new BooleanSwitchBehavior(common, gfx.settings->net_io_thread);
+    // Offered in the next online handshake (see NetSession::CreateController).
+    case kRollbackWindow:
+      return new IntegerBehavior(common, gfx.settings->rollback_window, 1, 30);
+    // Picked up when the next match starts.
+    case kExportMatchStats:
+      return new BooleanSwitchBehavior(common, gfx.settings->export_match_stats);
+    // Used by the next random level (see Level::GenerateRandom).
+    case kLevelGenerator:
+      return new ArrayEnumBehavior(common, gfx.settings->random_level_generator,
+                                   kLevelGeneratorSel);
+    // Takes effect at once; Ctrl+F12 dumps what has been recorded.
+    case kTraceZones:
+      return new BooleanSwitchBehavior(common, gfx.settings->trace_zones, [](bool v) {
+        gfx.settings->trace_zones = v;
+        trace::SetEnabled(v);
+      });
+    // Checked after every frame while TRACE ZONES is on (see Gfx::RunOneFrame).
+    case kTraceFrameBudget:
+      return new IntegerBehavior(common, gfx.settings->trace_frame_budget_ms, 0, 1000);
 
     default:
       return Menu::GetItemBehavior(common, item);
@@ -25,6 +25,13 @@ struct HiddenMenu : Menu {
     kSpectatorWindow,
     kColorMode,
     kMaxSpectatorRenderHeight,
+    kSpectatorResidentLevel,
+    kNetIoThread,
+    kRollbackWindow,
+    kExportMatchStats,
+    kLevelGenerator,
+    kTraceZones,
+    kTraceFrameBudget,
   };
 
   HiddenMenu(int x, int y) : Menu(x, y) {}
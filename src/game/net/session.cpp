@@ -1,12 +1,14 @@
 #include "session.hpp"
 
 #include <miniz.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 
 #include "../profiling.hpp"
+#include "../stateHash.hpp"
 #include "memoryFs.hpp"
 #include "tcArchive.hpp"
 
@@ -29,21 +31,29 @@ NetSession::NetSession(std::shared_ptr<Common> common, std::shared_ptr<Settings>
 NetSession::~NetSession() { Disconnect(); }
 
 void NetSession::CreateController(int local_idx) {
-  // Wire protocol caps inputDelay at kMaxRollback (see setInputDelay).
-  // Clamp the settings value too so pre-fill loops below stay in sync
-  // with the controller.
+  int const kWindow = std::min(LocalRollbackWindow(), remoteRollbackWindow_);
+  // Wire protocol caps inputDelay at the rollback window (see
+  // setInputDelay). Clamp the settings value too so pre-fill loops below
+  // stay in sync with the controller. Both peers clamp the host's value
+  // against the same negotiated window.
   if (settings_->input_delay < 0) {
     settings_->input_delay = 0;
-  } else if (settings_->input_delay > rollback::kMaxRollback) {
-    settings_->input_delay = rollback::kMaxRollback;
+  } else if (settings_->input_delay > kWindow) {
+    settings_->input_delay = kWindow;
   }
   rollback_ = std::make_unique<RollbackController>(common_, settings_, local_idx);
+  rollback_->SetMaxRollback(kWindow);
   rollback_->SetInputDelay(static_cast<uint32_t>(settings_->input_delay));
 }
 
+uint8_t NetSession::LocalRollbackWindow() const {
+  return static_cast<uint8_t>(
+      std::clamp(settings_->rollback_window, 1, rollback::kMaxRollbackLimit));
+}
+
 void NetSession::WireActiveController() {
   auto checksum_cb = [this](uint8_t generation, uint32_t frame, uint32_t checksum) {
-    transport_.SendChecksum(generation, frame, checksum);
+    transport_.SendChecksum(generation, resyncEpoch_, frame, checksum);
     OnLocalChecksum(frame, checksum);
   };
   auto pause_cb = [this]() { transport_.SendPause(); };
@@ -51,17 +61,23 @@ void NetSession::WireActiveController() {
   auto end_match_cb = [this]() { transport_.SendEndMatch(); };
   auto peer_left_cb = [this]() { transport_.SendPeerLeft(); };
 
-  rollback_->SetInputCallbacks([this](uint8_t generation, uint32_t base_frame, uint8_t count,
-                                      uint8_t const* inputs, uint32_t local_frame) {
-    // localDelta = simFrame - baseFrame at send time. Encoded as
-    // uint8_t; range guaranteed by the controller's K-wide window.
-    auto const kLocalDelta = static_cast<uint8_t>(local_frame - base_frame);
-    transport_.SendInputBatch(generation, base_frame, count, kLocalDelta, inputs);
+  // The controller owns the callback, so the raw pointer outlives it;
+  // rollback_ itself is handed to Gfx once play starts.
+  RollbackController* const kController = rollback_.get();
+  rollback_->SetInputCallbacks([this, kController](uint8_t generation, uint32_t base_frame,
+                                                   uint8_t count, uint8_t const* inputs,
+                                                   uint32_t local_frame) {
+    transport_.SendInputBatch(generation, base_frame, count, local_frame, inputs,
+                              kController->RemoteInputNeeded());
   });
   rollback_->SetChecksumCallback(checksum_cb);
+  rollback_->SetTimeSyncCallback([this](rollback::TimeSyncMessage const& msg) {
+    transport_.SendTimeSync(msg.seq, msg.echo_seq, msg.echo_hold, msg.lead_q4, msg.input_delay);
+  });
   rollback_->SetPauseCallbacks(pause_cb, resume_cb);
   rollback_->SetEndMatchCallback(end_match_cb);
   rollback_->SetPeerLeftCallback(peer_left_cb);
+  rollback_->SetInputPump([this]() { transport_.PumpInput(); });
 }
 
 Game& NetSession::ActiveGame() { return rollback_->game; }
@@ -145,6 +161,10 @@ void NetSession::Update() {
 
   transport_.Poll();
 
+  if (pendingDesync_.valid) {
+    HandleDesync();
+  }
+
   if (transport_.CurrentState() == NetTransport::kFailed) {
     sessionState_ = kFailed;
     return;
@@ -198,7 +218,7 @@ void NetSession::OnConnected() {
   // Both sides send their handshake.
   // Host includes the seed; client sends 0 (host's seed is authoritative).
   uint32_t const kSeedToSend = (role_ == kHost) ? gameSeed_ : 0;
-  transport_.SendHandshake(kSeedToSend, localSettingsHash_);
+  transport_.SendHandshake(kSeedToSend, localSettingsHash_, LocalRollbackWindow());
   handshakeSent_ = true;
 
   SendLocalPlayerInfo();
@@ -237,11 +257,12 @@ void NetSession::OnConnected() {
 
 void NetSession::OnDisconnected() { sessionState_ = kDisconnected; }
 
-void NetSession::OnHandshake(uint32_t seed, uint32_t /*settings_hash*/) {
+void NetSession::OnHandshake(uint32_t seed, uint32_t /*settings_hash*/, uint8_t rollback_window) {
   // Client uses the host's seed
   if (role_ == kClient) {
     gameSeed_ = seed;
   }
+  remoteRollbackWindow_ = std::clamp<uint8_t>(rollback_window, 1, rollback::kMaxRollbackLimit);
 
   if (sessionState_ == kRematch) {
     // During rematch, handshake signals the host is starting the game.
@@ -268,7 +289,7 @@ void NetSession::OnRemoteInputBatch(uint8_t generation, uint32_t base_frame, uin
   if (prePlayingInputBatches_.size() >= kMaxPrePlayingBatches) {
     return;
   }
-  if (count > rollback::kMaxRollback + 1) {
+  if (count > rollback::kMaxRollbackLimit + 1) {
     return;
   }
   PendingInputBatch b{};
@@ -392,7 +413,9 @@ void NetSession::SendResume() { transport_.SendResume(); }
 void NetSession::WireCallbacks() {
   transport_.on_connected = [this]() { OnConnected(); };
   transport_.on_disconnected = [this]() { OnDisconnected(); };
-  transport_.on_handshake = [this](uint32_t seed, uint32_t hash) { OnHandshake(seed, hash); };
+  transport_.on_handshake = [this](uint32_t seed, uint32_t hash, uint8_t rollback_window) {
+    OnHandshake(seed, hash, rollback_window);
+  };
   transport_.on_remote_input_batch = [this](uint8_t generation, uint32_t base_frame, uint8_t count,
                                             uint8_t const* inputs, uint32_t remote_local_frame) {
     OnRemoteInputBatch(generation, base_frame, count, inputs, remote_local_frame);
@@ -406,8 +429,30 @@ void NetSession::WireCallbacks() {
   transport_.on_resume = [this]() { OnResume(); };
   transport_.on_end_match = [this]() { OnRemoteEndMatch(); };
   transport_.on_peer_left = [this]() { OnRemotePeerLeft(); };
-  transport_.on_checksum = [this](uint8_t generation, uint32_t frame, uint32_t checksum) {
-    OnChecksum(generation, frame, checksum);
+  transport_.on_input_ack = [this](uint8_t generation, uint32_t next_frame, uint8_t loss_q8) {
+    if (rollbackPtr_) {
+      rollbackPtr_->InjectInputAck(generation, next_frame, loss_q8);
+    }
+  };
+  transport_.on_checksum = [this](uint8_t generation, uint8_t epoch, uint32_t frame,
+                                  uint32_t checksum) {
+    OnChecksum(generation, epoch, frame, checksum);
+  };
+  transport_.on_resync_request = [this](uint8_t epoch, uint32_t frame) {
+    OnResyncRequest(epoch, frame);
+  };
+  transport_.on_resync_state = [this](uint8_t epoch, uint32_t frame, const void* data,
+                                      size_t len) { OnResyncState(epoch, frame, data, len); };
+  transport_.on_resync_ack = [this](uint8_t epoch, bool ok) { OnResyncAck(epoch, ok); };
+  transport_.on_time_sync = [this](uint16_t seq, uint16_t echo_seq, uint8_t echo_hold,
+                                   int16_t lead_q4, uint8_t input_delay) {
+    if (rollbackPtr_ && sessionState_ == kPlaying) {
+      rollbackPtr_->InjectTimeSync({.seq = seq,
+                                    .echo_seq = echo_seq,
+                                    .echo_hold = echo_hold,
+                                    .lead_q4 = lead_q4,
+                                    .input_delay = input_delay});
+    }
   };
   transport_.on_rematch_ready = [this](bool ready) { OnRematchReady(ready); };
   transport_.on_rematch_level = [this](bool random, std::string file) {
@@ -544,6 +589,10 @@ void NetSession::BeginPlaying(int local_idx, bool is_rematch) {
   WireActiveController();
   PrefillRemoteInput();
   rollbackPtr_ = rollback_.get();
+  resyncEpoch_ = 0;
+  resyncCount_ = 0;
+  awaitingResync_ = false;
+  pendingDesync_.valid = false;
 
   for (auto const& b : prePlayingInputBatches_) {
     rollbackPtr_->InjectRemoteBatch(b.generation, b.base_frame, b.count, b.inputs.data(),
@@ -560,6 +609,10 @@ void NetSession::BeginPlaying(int local_idx, bool is_rematch) {
     }
   }
 
+  if (settings_->net_io_thread) {
+    transport_.StartIoThread();
+  }
+
   sessionState_ = kPlaying;
 }
 
@@ -676,7 +729,7 @@ void NetSession::StartRematch() {
 
   // Generate a new seed and send it before beginPlaying generates the map
   gameSeed_ = static_cast<uint32_t>(std::time(nullptr));
-  transport_.SendHandshake(gameSeed_, 0);
+  transport_.SendHandshake(gameSeed_, 0, LocalRollbackWindow());
 
   BeginPlaying(/*local_idx=*/0, /*is_rematch=*/true);
 }
@@ -847,7 +900,8 @@ void MaybeLog(char const* who, uint64_t& counter, uint32_t frame, uint32_t check
 }
 }  // namespace
 
-void NetSession::OnChecksum(uint8_t generation, uint32_t frame, uint32_t remote_checksum) {
+void NetSession::OnChecksum(uint8_t generation, uint8_t epoch, uint32_t frame,
+                            uint32_t remote_checksum) {
   if (desyncDetected_ || sessionState_ != kPlaying || !rollbackPtr_) {
     return;
   }
@@ -858,6 +912,11 @@ void NetSession::OnChecksum(uint8_t generation, uint32_t frame, uint32_t remote_
   if (generation != rollbackPtr_->Generation()) {
     return;
   }
+  // Likewise across a resync: the peer was simulating a state one of us
+  // has since abandoned.
+  if (epoch != resyncEpoch_) {
+    return;
+  }
 
   static uint64_t remote_count = 0;
   MaybeLog("remote", remote_count, frame, remote_checksum);
@@ -866,10 +925,7 @@ void NetSession::OnChecksum(uint8_t generation, uint32_t frame, uint32_t remote_
   size_t const kSlot = frame % kChecksumBufferSize;
   if (checksumBuffer_[kSlot].valid && checksumBuffer_[kSlot].frame == frame) {
     if (checksumBuffer_[kSlot].checksum != remote_checksum) {
-      desyncDetected_ = true;
-      desyncFrame_ = frame;
-      std::fprintf(stderr, "DESYNC DETECTED at frame %u! local=%08x remote=%08x\n", frame,
-                   checksumBuffer_[kSlot].checksum, remote_checksum);
+      OnDesync(frame, checksumBuffer_[kSlot].checksum, remote_checksum);
     }
   } else {
     // We haven't processed this frame yet — store for later comparison
@@ -891,16 +947,129 @@ void NetSession::OnLocalChecksum(uint32_t frame, uint32_t checksum) {
   // Check pending remote checksums
   for (size_t i = 0; i < pendingRemoteCount_;) {
     if (pendingRemoteChecksums_[i].frame == frame) {
-      if (pendingRemoteChecksums_[i].checksum != checksum) {
-        desyncDetected_ = true;
-        desyncFrame_ = frame;
-        std::fprintf(stderr, "DESYNC DETECTED at frame %u! local=%08x remote=%08x\n", frame,
-                     checksum, pendingRemoteChecksums_[i].checksum);
-      }
+      uint32_t const kRemote = pendingRemoteChecksums_[i].checksum;
       // Remove by swapping with last
       pendingRemoteChecksums_[i] = pendingRemoteChecksums_[--pendingRemoteCount_];
+      if (kRemote != checksum) {
+        OnDesync(frame, checksum, kRemote);
+        return;
+      }
     } else {
       ++i;
     }
   }
 }
+
+void NetSession::OnDesync(uint32_t frame, uint32_t local_checksum, uint32_t remote_checksum) {
+  if (awaitingResync_ || pendingDesync_.valid) {
+    return;
+  }
+  pendingDesync_ = {.frame = frame,
+                    .local_checksum = local_checksum,
+                    .remote_checksum = remote_checksum,
+                    .valid = true};
+}
+
+void NetSession::HandleDesync() {
+  PendingDesync const kDesync = pendingDesync_;
+  pendingDesync_.valid = false;
+  if (desyncDetected_ || sessionState_ != kPlaying || !rollbackPtr_) {
+    return;
+  }
+
+  desyncFrame_ = kDesync.frame;
+  std::fprintf(stderr, "DESYNC DETECTED at frame %u! local=%08x remote=%08x\n", kDesync.frame,
+               kDesync.local_checksum, kDesync.remote_checksum);
+  ComponentHashes hashes{};
+  if (rollbackPtr_->ComponentHashesAt(static_cast<int32_t>(kDesync.frame), hashes)) {
+    PrintComponentHashes("local", kDesync.frame, hashes);
+  }
+
+  if (resyncCount_ >= kMaxResyncs) {
+    std::fprintf(stderr, "[resync] giving up after %u resyncs\n", resyncCount_);
+    desyncDetected_ = true;
+    return;
+  }
+  if (role_ == kHost) {
+    StartResync(kDesync.frame);
+  } else {
+    awaitingResync_ = true;
+    transport_.SendResyncRequest(resyncEpoch_, kDesync.frame);
+  }
+}
+
+void NetSession::StartResync(uint32_t frame) {
+  std::vector<uint8_t> state;
+  if (!rollbackPtr_->ExportResyncState(state)) {
+    desyncFrame_ = frame;
+    desyncDetected_ = true;
+    return;
+  }
+  auto const kFrame = static_cast<uint32_t>(rollbackPtr_->ConfirmedFrame());
+  // Our state stands, so our checksums stay valid; only what the peer
+  // sent from the state it is about to abandon goes.
+  ++resyncEpoch_;
+  ++resyncCount_;
+  pendingRemoteCount_ = 0;
+  std::fprintf(stderr, "[resync] sending state at frame %u (%zu bytes, epoch %u)\n", kFrame,
+               state.size(), static_cast<unsigned>(resyncEpoch_));
+  transport_.SendResyncState(resyncEpoch_, kFrame, state.data(), state.size());
+}
+
+void NetSession::OnResyncRequest(uint8_t epoch, uint32_t frame) {
+  if (role_ != kHost || desyncDetected_ || sessionState_ != kPlaying || !rollbackPtr_) {
+    return;
+  }
+  // A request from an older epoch is already answered by the state in
+  // flight.
+  if (epoch != resyncEpoch_) {
+    return;
+  }
+  std::fprintf(stderr, "[resync] peer reports desync at frame %u\n", frame);
+  if (resyncCount_ >= kMaxResyncs) {
+    desyncFrame_ = frame;
+    desyncDetected_ = true;
+    return;
+  }
+  StartResync(frame);
+}
+
+void NetSession::OnResyncState(uint8_t epoch, uint32_t frame, const void* data, size_t len) {
+  if (role_ != kClient || desyncDetected_ || sessionState_ != kPlaying || !rollbackPtr_) {
+    return;
+  }
+  if (epoch != static_cast<uint8_t>(resyncEpoch_ + 1)) {
+    return;
+  }
+  bool const kOk = rollbackPtr_->ApplyResyncState(static_cast<uint8_t const*>(data), len);
+  transport_.SendResyncAck(epoch, kOk);
+  if (!kOk) {
+    desyncFrame_ = frame;
+    desyncDetected_ = true;
+    return;
+  }
+  resyncEpoch_ = epoch;
+  ++resyncCount_;
+  awaitingResync_ = false;
+  pendingDesync_.valid = false;
+  ClearChecksums();
+}
+
+void NetSession::OnResyncAck(uint8_t epoch, bool ok) {
+  if (role_ != kHost || epoch != resyncEpoch_) {
+    return;
+  }
+  if (!ok) {
+    std::fprintf(stderr, "[resync] peer could not adopt the state for epoch %u\n",
+                 static_cast<unsigned>(epoch));
+    desyncDetected_ = true;
+  }
+}
+
+void NetSession::ClearChecksums() {
+  for (FrameChecksum& c : checksumBuffer_) {
+    c.valid = false;
+  }
+  pendingRemoteCount_ = 0;
+}
+
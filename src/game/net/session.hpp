@@ -81,9 +81,13 @@ struct NetSession {
   bool RemoteReady() const { return remoteReady_; }
   bool IsHost() const { return role_ == kHost; }
 
-  // Desync detection
+  // Desync detection. A mismatch first triggers a resync (the client
+  // adopts the host's state); DesyncDetected only turns true once that
+  // fails or the match has used up kMaxResyncs. DesyncFrame is the frame
+  // of the most recent mismatch either way.
   bool DesyncDetected() const { return desyncDetected_; }
   uint32_t DesyncFrame() const { return desyncFrame_; }
+  uint32_t ResyncCount() const { return resyncCount_; }
 
   // TC sync: called when client needs to reload Common with new TC data.
   // The callback receives the new Common. Caller must update gfx.common.
@@ -95,7 +99,7 @@ struct NetSession {
  private:
   void OnConnected();
   void OnDisconnected();
-  void OnHandshake(uint32_t seed, uint32_t settings_hash);
+  void OnHandshake(uint32_t seed, uint32_t settings_hash, uint8_t rollback_window);
   void OnPlayerInfo(const NetTransport::PlayerInfo& info);
   void OnMatchSettings(const NetTransport::MatchSettingsData& data);
   void OnMapData(const void* data, size_t len);
@@ -123,6 +127,9 @@ struct NetSession {
   void PrefillRemoteInput();
   void GenerateAndSendMap();
   uint32_t ComputeSettingsHash() const;
+  // Rollback window we offer in the handshake: settings.rollbackWindow
+  // clamped to [1, kMaxRollbackLimit].
+  uint8_t LocalRollbackWindow() const;
 
   // Build the rollback controller and wire its transport callbacks.
   // Shared by all game-start paths.
@@ -153,6 +160,9 @@ struct NetSession {
   bool playerInfoReceived_{false};
   bool matchSettingsReceived_{false};  // client only; host always has settings
   bool mapDataReceived_{false};        // client only; host generates locally
+  // Peer's handshake offer. The match runs with the smaller of this and
+  // ours, so both controllers agree on the window (and batch width).
+  uint8_t remoteRollbackWindow_{rollback::kMaxRollback};
   NetTransport::PlayerInfo remotePlayerInfo_;
 
   // Rematch state
@@ -173,8 +183,37 @@ struct NetSession {
   // Desync detection
   bool desyncDetected_{false};
   uint32_t desyncFrame_{0};
-  void OnChecksum(uint8_t generation, uint32_t frame, uint32_t remote_checksum);
+  void OnChecksum(uint8_t generation, uint8_t epoch, uint32_t frame, uint32_t remote_checksum);
   void OnLocalChecksum(uint32_t frame, uint32_t checksum);
+  // Checksums are compared mid-tick (the controller emits them from its
+  // resim loop), so a mismatch is only noted here and handled by
+  // HandleDesync from Update(), between ticks.
+  void OnDesync(uint32_t frame, uint32_t local_checksum, uint32_t remote_checksum);
+  // Logs the mismatch with the local component hashes, then starts a
+  // resync (host) or asks the host for one (client).
+  void HandleDesync();
+  void StartResync(uint32_t frame);
+  void OnResyncRequest(uint8_t epoch, uint32_t frame);
+  void OnResyncState(uint8_t epoch, uint32_t frame, const void* data, size_t len);
+  void OnResyncAck(uint8_t epoch, bool ok);
+  void ClearChecksums();
+
+  // Resyncs a match may go through before it is given up as desynced.
+  static constexpr uint32_t kMaxResyncs = 5;
+  // Resyncs completed this match. Checksums carry it, so peers only
+  // compare frames simulated from the same adopted state.
+  uint8_t resyncEpoch_{0};
+  uint32_t resyncCount_{0};
+  // Client: request sent, host state not adopted yet. Further mismatches
+  // are expected until then.
+  bool awaitingResync_{false};
+  struct PendingDesync {
+    uint32_t frame;
+    uint32_t local_checksum;
+    uint32_t remote_checksum;
+    bool valid;
+  };
+  PendingDesync pendingDesync_{};
 
   // Ring buffer of local checksums for frame-accurate comparison
   static constexpr size_t kChecksumBufferSize = 128;
@@ -200,7 +239,7 @@ struct NetSession {
     uint8_t generation;
     uint32_t base_frame;
     uint8_t count;
-    std::array<uint8_t, rollback::kMaxRollback + 1> inputs;
+    std::array<uint8_t, rollback::kMaxRollbackLimit + 1> inputs;
     uint32_t remote_local_frame;
   };
   static constexpr size_t kMaxPrePlayingBatches = 256;
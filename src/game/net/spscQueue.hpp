@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed-capacity lock-free single-producer / single-consumer queue.
+//
+// One thread pushes, one thread pops; neither ever waits. TryPush fails
+// when the queue is full and TryPop when it is empty, so callers decide
+// what to drop. Capacity must be a power of two.
+template <typename T, std::size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+ public:
+  bool TryPush(T const& item) {
+    std::size_t const kTail = tail_.load(std::memory_order_relaxed);
+    if (kTail - head_cache_ == N) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (kTail - head_cache_ == N) {
+        return false;
+      }
+    }
+    items_[kTail & (N - 1)] = item;
+    tail_.store(kTail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T& out) {
+    std::size_t const kHead = head_.load(std::memory_order_relaxed);
+    if (kHead == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (kHead == tail_cache_) {
+        return false;
+      }
+    }
+    out = items_[kHead & (N - 1)];
+    head_.store(kHead + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  std::array<T, N> items_{};
+  // Running counts; producer owns tail_ and head_cache_, consumer owns
+  // head_ and tail_cache_. Kept on separate lines so the two sides don't
+  // false-share.
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t head_cache_ = 0;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t tail_cache_ = 0;
+};
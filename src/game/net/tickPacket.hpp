@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Per-tick rollback datagram (NetTransport::kPacketTick): the sender's
+// input window, an ack for the peer's input, and the checksums of the
+// frames confirmed since the last one, in one unreliable packet.
+//
+// Payload after the type byte:
+//   [gen:1][seq:u16 LE][ackNext:u32 LE][loss:u8]
+//   [baseFrame:u32 LE][count:u8][lag:u8][inputs: RLE]
+//   [checksums:u8] then per checksum [epoch:1][back:u16 LE][checksum:u32 LE]
+//
+// `ackNext` is the first of the peer's frames the sender is still
+// missing; every earlier one has arrived, so the peer can start its
+// next window there. `loss` is the share of the peer's packets the
+// sender has seen go missing, in 1/256. `lag` puts the sender's sim
+// frame at baseFrame + count - 1 - lag, and each checksum's frame is
+// `back` frames before baseFrame + count - 1.
+//
+// Inputs are 7-bit, so the RLE uses the top bit: a byte below 0x80 is
+// the next input, a byte 0x80 | n repeats the previous input n + 1 more
+// times. A held or idle control state costs two bytes for the whole
+// window.
+
+struct TickChecksum {
+  uint8_t epoch;
+  uint32_t frame;
+  uint32_t checksum;
+};
+
+struct TickPacket {
+  // Same cap as the rollback window allows, with headroom.
+  static constexpr std::size_t kMaxInputs = 64;
+  static constexpr std::size_t kMaxChecksums = 32;
+  static constexpr std::size_t kHeaderSize = 14;
+  static constexpr std::size_t kChecksumSize = 7;
+  static constexpr std::size_t kMaxSize =
+      kHeaderSize + kMaxInputs + 1 + (kMaxChecksums * kChecksumSize);
+
+  uint8_t generation = 0;
+  uint16_t seq = 0;
+  uint32_t ack_next = 0;
+  uint8_t loss_q8 = 0;
+  uint32_t base_frame = 0;
+  uint8_t count = 0;
+  uint8_t lag = 0;
+  std::array<uint8_t, kMaxInputs> inputs{};
+  uint8_t checksum_count = 0;
+  std::array<TickChecksum, kMaxChecksums> checksums{};
+
+  uint32_t NewestFrame() const { return base_frame + count - 1U; }
+  uint32_t LocalFrame() const { return NewestFrame() - lag; }
+  // Whether a checksum for `frame` can ride in this packet.
+  bool CanCarry(uint32_t frame) const {
+    return frame <= NewestFrame() && NewestFrame() - frame <= 0xffffU;
+  }
+};
+
+namespace tick_packet_detail {
+
+inline void Put16(uint8_t*& p, uint16_t v) {
+  std::memcpy(p, &v, 2);
+  p += 2;
+}
+
+inline void Put32(uint8_t*& p, uint32_t v) {
+  std::memcpy(p, &v, 4);
+  p += 4;
+}
+
+inline uint16_t Get16(uint8_t const*& p) {
+  uint16_t v = 0;
+  std::memcpy(&v, p, 2);
+  p += 2;
+  return v;
+}
+
+inline uint32_t Get32(uint8_t const*& p) {
+  uint32_t v = 0;
+  std::memcpy(&v, p, 4);
+  p += 4;
+  return v;
+}
+
+}  // namespace tick_packet_detail
+
+// Writes the payload (without the type byte) to `out`, which must hold
+// TickPacket::kMaxSize bytes. Returns the length, or 0 if `p` breaks the
+// format's limits. Input bytes are masked to 7 bits.
+inline std::size_t EncodeTickPacket(TickPacket const& p, uint8_t* out) {
+  using namespace tick_packet_detail;
+  if (p.count == 0 || p.count > TickPacket::kMaxInputs || p.lag >= p.count ||
+      p.checksum_count > TickPacket::kMaxChecksums) {
+    return 0;
+  }
+  uint8_t* w = out;
+  *w++ = p.generation;
+  Put16(w, p.seq);
+  Put32(w, p.ack_next);
+  *w++ = p.loss_q8;
+  Put32(w, p.base_frame);
+  *w++ = p.count;
+  *w++ = p.lag;
+
+  std::size_t i = 0;
+  while (i < p.count) {
+    uint8_t const kIn = p.inputs[i] & 0x7f;
+    *w++ = kIn;
+    std::size_t run = 0;
+    while (i + 1 + run < p.count && (p.inputs[i + 1 + run] & 0x7f) == kIn && run < 0x80) {
+      ++run;
+    }
+    if (run > 0) {
+      *w++ = static_cast<uint8_t>(0x80 | (run - 1));
+    }
+    i += 1 + run;
+  }
+
+  *w++ = p.checksum_count;
+  for (uint8_t k = 0; k < p.checksum_count; ++k) {
+    TickChecksum const& c = p.checksums[k];
+    if (!p.CanCarry(c.frame)) {
+      return 0;
+    }
+    *w++ = c.epoch;
+    Put16(w, static_cast<uint16_t>(p.NewestFrame() - c.frame));
+    Put32(w, c.checksum);
+  }
+  return static_cast<std::size_t>(w - out);
+}
+
+// Parses a payload written by EncodeTickPacket. Anything truncated,
+// overlong or with trailing bytes is rejected.
+inline bool DecodeTickPacket(uint8_t const* data, std::size_t len, TickPacket& out) {
+  using namespace tick_packet_detail;
+  if (len < TickPacket::kHeaderSize + 2) {
+    return false;
+  }
+  uint8_t const* r = data;
+  uint8_t const* const kEnd = data + len;
+  out.generation = *r++;
+  out.seq = Get16(r);
+  out.ack_next = Get32(r);
+  out.loss_q8 = *r++;
+  out.base_frame = Get32(r);
+  out.count = *r++;
+  out.lag = *r++;
+  if (out.count == 0 || out.count > TickPacket::kMaxInputs || out.lag >= out.count) {
+    return false;
+  }
+
+  std::size_t n = 0;
+  while (n < out.count) {
+    if (r == kEnd) {
+      return false;
+    }
+    uint8_t const kB = *r++;
+    if ((kB & 0x80) == 0) {
+      out.inputs[n++] = kB;
+      continue;
+    }
+    std::size_t const kRun = (kB & 0x7fU) + 1U;
+    if (n == 0 || n + kRun > out.count) {
+      return false;
+    }
+    std::fill_n(out.inputs.begin() + static_cast<std::ptrdiff_t>(n), kRun, out.inputs[n - 1]);
+    n += kRun;
+  }
+
+  if (r == kEnd) {
+    return false;
+  }
+  out.checksum_count = *r++;
+  if (out.checksum_count > TickPacket::kMaxChecksums ||
+      static_cast<std::size_t>(kEnd - r) != out.checksum_count * TickPacket::kChecksumSize) {
+    return false;
+  }
+  for (uint8_t k = 0; k < out.checksum_count; ++k) {
+    TickChecksum& c = out.checksums[k];
+    c.epoch = *r++;
+    uint16_t const kBack = Get16(r);
+    if (kBack > out.NewestFrame()) {
+      return false;
+    }
+    c.frame = out.NewestFrame() - kBack;
+    c.checksum = Get32(r);
+  }
+  return true;
+}
+
+// Receiver-side loss estimate from kPacketTick sequence numbers. Gaps
+// count as lost; a late packet arriving behind a newer one was already
+// counted and is ignored, so reordering reads as loss. That errs toward
+// more redundancy, which is the cheap direction.
+class LossMeter {
+ public:
+  void OnSeq(uint16_t seq) {
+    if (!started_) {
+      started_ = true;
+      highest_ = seq;
+      return;
+    }
+    auto const kAhead = static_cast<int16_t>(seq - highest_);
+    if (kAhead <= 0) {
+      return;
+    }
+    int const kLost = std::min<int>(kAhead - 1, kMaxGap);
+    for (int i = 0; i < kLost; ++i) {
+      Sample(/*lost=*/true);
+    }
+    Sample(/*lost=*/false);
+    highest_ = seq;
+  }
+
+  uint8_t LossQ8() const { return static_cast<uint8_t>(loss_q16_ >> 8); }
+
+ private:
+  // Longer gaps are an outage, not loss; they'd pin the estimate at 100%.
+  static constexpr int kMaxGap = 16;
+
+  // Moving average over roughly the last 16 packets.
+  void Sample(bool lost) { loss_q16_ += ((lost ? 0xffff : 0) - loss_q16_) / 16; }
+
+  bool started_ = false;
+  uint16_t highest_ = 0;
+  int32_t loss_q16_ = 0;
+};
@@ -1,10 +1,17 @@
 #include "transport.hpp"
 #include "iceAgent.hpp"
 
+#include "spscQueue.hpp"
+
 #include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "../profiling.hpp"
 
@@ -33,7 +40,87 @@ static int32_t ReadI32(const uint8_t* p) {
 static constexpr int kNumChannels = 3;
 static constexpr int kChannelReliable = 0;
 static constexpr int kChannelUnreliable = 1;
-static constexpr int kChannelInputBatch = 2;
+static constexpr int kChannelTick = 2;
+
+static constexpr size_t kMaxPacketSize = 10 * 1024 * 1024;
+// Checksums waiting for the next tick packet. A stalled sender can pile
+// up a few windows' worth; past this the oldest are dropped, which only
+// skips those comparisons.
+static constexpr size_t kMaxPendingChecksums = 4 * TickPacket::kMaxChecksums;
+
+namespace {
+
+// Encoded kPacketTick, type byte included, on its way to the I/O thread.
+struct TickBytes {
+  uint16_t len;
+  uint8_t data[1 + TickPacket::kMaxSize];
+};
+
+// Behind OPENLIERO_CHECKSUM_LOG=1: count received packet types so we can
+// tell whether tick packets (and the checksums in them) are reaching the
+// wire at all (vs being lost in the ICE bridge or never sent). Called from whichever thread
+// services ENet.
+void LogRxPacket(uint8_t type) {
+  static const bool kLogEnabled = []() {
+    char const* e = std::getenv("OPENLIERO_CHECKSUM_LOG");
+    return e && *e && *e != '0';
+  }();
+  if (!kLogEnabled) {
+    return;
+  }
+  // Tick packets are counted on the I/O thread when it runs, the rest on
+  // the game thread.
+  static std::atomic<uint64_t> cnt_input{0};
+  static std::atomic<uint64_t> cnt_tick{0};
+  static std::atomic<uint64_t> cnt_other{0};
+  switch (type) {
+    case NetTransport::kPacketInput:
+      ++cnt_input;
+      break;
+    case NetTransport::kPacketTick:
+      ++cnt_tick;
+      break;
+    default:
+      ++cnt_other;
+      break;
+  }
+  uint64_t const kTotal = cnt_input + cnt_tick + cnt_other;
+  if (kTotal > 0 && kTotal % 140 == 0) {
+    std::fprintf(stderr, "[transport rx] input=%llu tick=%llu other=%llu\n",
+                 static_cast<unsigned long long>(cnt_input.load()),
+                 static_cast<unsigned long long>(cnt_tick.load()),
+                 static_cast<unsigned long long>(cnt_other.load()));
+  }
+}
+
+// Connect / disconnect / non-input packet seen by the I/O thread, replayed
+// on the game thread by Poll().
+struct DeferredEvent {
+  ENetEventType type;
+  std::vector<uint8_t> data;
+};
+
+}  // namespace
+
+struct NetTransport::IoThread {
+  static constexpr size_t kQueueSize = 64;
+  // Socket wait per loop iteration; bounds how long a queued send or an
+  // ICE bridge packet waits for the thread.
+  static constexpr int kWaitMs = 1;
+
+  std::thread thread;
+  std::atomic<bool> stop{false};
+  // Guards every ENet call (and peer_) and the ICE agent and bridge while
+  // the thread runs.
+  std::mutex enet_mutex;
+  std::mutex deferred_mutex;
+  std::vector<DeferredEvent> deferred;
+  // Game thread -> I/O thread.
+  SpscQueue<TickBytes, kQueueSize> out_ticks;
+  // I/O thread -> game thread. A full queue drops: unacked input is
+  // resent every tick and a missing checksum only skips one comparison.
+  SpscQueue<TickPacket, kQueueSize> in_ticks;
+};
 
 // Single active transport pointer. Only one ENet host exists per process.
 static std::atomic<NetTransport*> s_active_transport{nullptr};
@@ -52,12 +139,18 @@ static NetTransport* GetTransportFromHost(_ENetHost* /*unused*/) {
 
 NetTransport::NetTransport() { enet_initialize(); }
 
-NetTransport::NetTransport(NetTransport&& other) noexcept
-    : enetHost_(other.enetHost_),
-      peer_(other.peer_),
-      state_(other.state_),
-      iceBridge_(std::move(other.iceBridge_)),
-      iceAgent_(std::move(other.iceAgent_)) {
+NetTransport::NetTransport(NetTransport&& other) noexcept {
+  // The thread services `other`'s members; stop it before taking them.
+  other.StopIoThread();
+  enetHost_ = other.enetHost_;
+  peer_ = other.peer_;
+  state_ = other.state_;
+  iceBridge_ = std::move(other.iceBridge_);
+  iceAgent_ = std::move(other.iceAgent_);
+  pendingChecksums_ = std::move(other.pendingChecksums_);
+  tickSeq_ = other.tickSeq_;
+  rxLoss_ = other.rxLoss_;
+  rxLossQ8_.store(other.rxLossQ8_.load());
   if (enetHost_) {
     RegisterTransport(enetHost_, this);
   }
@@ -69,11 +162,16 @@ NetTransport::NetTransport(NetTransport&& other) noexcept
 NetTransport& NetTransport::operator=(NetTransport&& other) noexcept {
   if (this != &other) {
     Disconnect();
+    other.StopIoThread();
     enetHost_ = other.enetHost_;
     peer_ = other.peer_;
     state_ = other.state_;
     iceBridge_ = std::move(other.iceBridge_);
     iceAgent_ = std::move(other.iceAgent_);
+    pendingChecksums_ = std::move(other.pendingChecksums_);
+    tickSeq_ = other.tickSeq_;
+    rxLoss_ = other.rxLoss_;
+    rxLossQ8_.store(other.rxLossQ8_.load());
     if (enetHost_) {
       RegisterTransport(enetHost_, this);
     }
@@ -90,6 +188,7 @@ NetTransport::~NetTransport() {
 }
 
 void NetTransport::Disconnect() {
+  StopIoThread();
   if (peer_) {
     enet_peer_disconnect_now(peer_, 0);
     peer_ = nullptr;
@@ -99,6 +198,7 @@ void NetTransport::Disconnect() {
     enet_host_destroy(enetHost_);
     enetHost_ = nullptr;
   }
+  pendingChecksums_.clear();
   state_ = kDisconnected;
 }
 
@@ -246,6 +346,12 @@ bool NetTransport::Poll() {
     return false;
   }
 
+  // With the I/O thread running, it services ICE as well (under
+  // enet_mutex, with the bridge), so the agent is never touched from here.
+  if (io_) {
+    return PollDeferred();
+  }
+
   if (iceAgent_) {
     iceAgent_->Poll();
   }
@@ -261,259 +367,408 @@ bool NetTransport::Poll() {
         }
         break;
 
-      case ENET_EVENT_TYPE_RECEIVE: {
-        uint8_t const* data = event.packet->data;
-        size_t const kLen = event.packet->dataLength;
+      case ENET_EVENT_TYPE_RECEIVE:
+        if (event.packet->dataLength <= kMaxPacketSize) {
+          Dispatch(event.packet->data, event.packet->dataLength);
+        }
+        enet_packet_destroy(event.packet);
+        break;
 
-        static constexpr size_t kMaxPacketSize = 10 * 1024 * 1024;
-        if (kLen > kMaxPacketSize) {
-          enet_packet_destroy(event.packet);
-          break;
+      case ENET_EVENT_TYPE_DISCONNECT:
+      case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+        peer_ = nullptr;
+        state_ = kDisconnected;
+        if (on_disconnected) {
+          on_disconnected();
         }
+        return false;
 
-        // Behind OPENLIERO_CHECKSUM_LOG=1: count received packet types
-        // so we can tell whether checksum packets are reaching the wire
-        // at all (vs being lost in the ICE bridge or never sent).
-        if (kLen >= 1) {
-          static const bool kLogEnabled = []() {
-            char const* e = std::getenv("OPENLIERO_CHECKSUM_LOG");
-            return e && *e && *e != '0';
-          }();
-          if (kLogEnabled) {
-            static uint64_t cnt_input = 0;
-            static uint64_t cnt_batch = 0;
-            static uint64_t cnt_checksum = 0;
-            static uint64_t cnt_other = 0;
-            switch (data[0]) {
-              case kPacketInput:
-                ++cnt_input;
-                break;
-              case kPacketInputBatch:
-                ++cnt_batch;
-                break;
-              case kPacketChecksum:
-                ++cnt_checksum;
-                break;
-              default:
-                ++cnt_other;
-                break;
-            }
-            uint64_t const kTotal = cnt_input + cnt_batch + cnt_checksum + cnt_other;
-            if (kTotal > 0 && kTotal % 140 == 0) {
-              std::fprintf(stderr,
-                           "[transport rx] input=%llu batch=%llu checksum=%llu other=%llu\n",
-                           static_cast<unsigned long long>(cnt_input),
-                           static_cast<unsigned long long>(cnt_batch),
-                           static_cast<unsigned long long>(cnt_checksum),
-                           static_cast<unsigned long long>(cnt_other));
-            }
-          }
+      case ENET_EVENT_TYPE_NONE:
+        break;
+    }
+  }
+
+  // Forward ENet outgoing packets through ICE bridge AFTER enet_host_service
+  // (ENet sends during service, bridge picks up and forwards to libjuice)
+  if (iceBridge_) {
+    iceBridge_->Poll();
+  }
+
+  return state_ == kConnected || state_ == kListening || state_ == kConnecting;
+}
+
+void NetTransport::Dispatch(uint8_t const* data, size_t len) {
+  ZoneScopedN("Net::Dispatch");
+  if (len < 1) {
+    return;
+  }
+  LogRxPacket(data[0]);
+
+  switch (data[0]) {
+    case kPacketInput:
+      if (len == 6 && on_remote_input) {
+        uint32_t frame = 0;
+        std::memcpy(&frame, data + 1, 4);
+        on_remote_input(frame, data[5]);
+      }
+      break;
+    case kPacketTick: {
+      TickPacket t;
+      if (DecodeTickPacket(data + 1, len - 1, t)) {
+        NoteTickSeq(t.seq);
+        DeliverTick(t);
+      }
+      break;
+    }
+    case kPacketHandshake:
+      // [type:1][version:1][seed:4][hash:4][rollbackWindow:1] = 11 B.
+      // The version byte sits at the same offset in older layouts, so a
+      // mismatched peer still gets the diagnostic below.
+      if (len >= 2 && on_handshake) {
+        if (data[1] != kProtocolVersion) {
+          // Loud on stderr: a silent drop here surfaces as the
+          // session sitting in Handshaking forever, which is
+          // hard to attribute to a version mismatch. Surface
+          // the actual cause so mixed-version test setups are
+          // diagnosable immediately.
+          std::fprintf(stderr,
+                       "[transport] handshake protocol version mismatch: peer=%u local=%u "
+                       "— peers must be on the same build\n",
+                       static_cast<unsigned>(data[1]),
+                       static_cast<unsigned>(kProtocolVersion));
+          break;
+        }
+        if (len != 11) {
+          break;
         }
+        uint32_t seed = 0;
+        uint32_t hash = 0;
+        std::memcpy(&seed, data + 2, 4);
+        std::memcpy(&hash, data + 6, 4);
+        on_handshake(seed, hash, data[10]);
+      }
+      break;
+    case kPacketTimeSync:
+      if (len == 9 && on_time_sync) {
+        uint16_t seq = 0;
+        uint16_t echo_seq = 0;
+        int16_t lead_q4 = 0;
+        std::memcpy(&seq, data + 1, 2);
+        std::memcpy(&echo_seq, data + 3, 2);
+        std::memcpy(&lead_q4, data + 6, 2);
+        on_time_sync(seq, echo_seq, data[5], lead_q4, data[8]);
+      }
+      break;
+    case kPacketPlayerInfo:
+      if (len == 1 + kPlayerInfoWireSize && on_player_info) {
+        PlayerInfo info{};
+        const uint8_t* p = data + 1;
+        for (int i = 0; i < 5; ++i, p += 4) {
+          info.weapons[i] = ReadU32(p);
+        }
+        info.color = ReadI32(p);
+        p += 4;
+        for (int i = 0; i < 3; ++i, p += 4) {
+          info.rgb[i] = ReadI32(p);
+        }
+        std::memcpy(info.name, p, 24);
+        on_player_info(info);
+      }
+      break;
+    case kPacketMatchSettings:
+      if (len == 1 + kMatchSettingsWireSize && on_match_settings) {
+        MatchSettingsData msd{};
+        const uint8_t* p = data + 1;
+        msd.lives = ReadI32(p);
+        p += 4;
+        msd.loading_time = ReadI32(p);
+        p += 4;
+        msd.game_mode = ReadU32(p);
+        p += 4;
+        msd.blood = ReadI32(p);
+        p += 4;
+        msd.max_bonuses = ReadI32(p);
+        p += 4;
+        msd.time_to_lose = ReadI32(p);
+        p += 4;
+        msd.flags_to_win = ReadI32(p);
+        p += 4;
+        msd.load_change = *p++;
+        for (int i = 0; i < 40; ++i, p += 4) {
+          msd.weap_table[i] = ReadU32(p);
+        }
+        msd.regenerate_level = *p++;
+        msd.shadow = *p++;
+        msd.names_on_bonuses = *p++;
+        msd.blood_particle_max = ReadI32(p);
+        p += 4;
+        msd.zone_timeout = ReadI32(p);
+        p += 4;
+        msd.input_delay = ReadI32(p);
+        on_match_settings(msd);
+      }
+      break;
+    case kPacketMapData:
+      if (len > 5 && on_map_data) {
+        on_map_data(data + 1, len - 1);
+      }
+      break;
+    case kPacketPause:
+      if (on_pause) {
+        on_pause();
+      }
+      break;
+    case kPacketResume:
+      if (on_resume) {
+        on_resume();
+      }
+      break;
+    case kPacketRematchReady:
+      if (len == 2 && on_rematch_ready) {
+        on_rematch_ready(data[1] != 0);
+      }
+      break;
+    case kPacketRematchLevel:
+      if (len >= 2 && on_rematch_level) {
+        bool const kRandom = data[1] != 0;
+        std::string file;
+        if (len > 2) {
+          file.assign(reinterpret_cast<const char*>(data + 2), len - 2);
+        }
+        on_rematch_level(kRandom, std::move(file));
+      }
+      break;
+    case kPacketEndMatch:
+      if (on_end_match) {
+        on_end_match();
+      }
+      break;
+    case kPacketPeerLeft:
+      if (on_peer_left) {
+        on_peer_left();
+      }
+      break;
+    case kPacketTcInfo:
+      if (len >= 5 && on_tc_info) {
+        uint32_t hash = 0;
+        std::memcpy(&hash, data + 1, 4);
+        std::string name;
+        if (len > 5) {
+          name.assign(reinterpret_cast<const char*>(data + 5), len - 5);
+        }
+        on_tc_info(hash, std::move(name));
+      }
+      break;
+    case kPacketTcResponse:
+      if (len == 2 && on_tc_response) {
+        on_tc_response(data[1] != 0);
+      }
+      break;
+    case kPacketTcData:
+      if (len > 1 && on_tc_data) {
+        on_tc_data(data + 1, len - 1);
+      }
+      break;
+    case kPacketResyncRequest:
+      if (len == 6 && on_resync_request) {
+        uint32_t frame = 0;
+        std::memcpy(&frame, data + 2, 4);
+        on_resync_request(data[1], frame);
+      }
+      break;
+    case kPacketResyncState:
+      if (len > 11 && on_resync_state) {
+        uint32_t frame = 0;
+        std::memcpy(&frame, data + 2, 4);
+        on_resync_state(data[1], frame, data + 6, len - 6);
+      }
+      break;
+    case kPacketResyncAck:
+      if (len == 3 && on_resync_ack) {
+        on_resync_ack(data[1], data[2] != 0);
+      }
+      break;
+    default:
+      break;
+  }
+}
 
-        if (kLen >= 1) {
-          switch (data[0]) {
-            case kPacketInput:
-              if (kLen == 6 && on_remote_input) {
-                uint32_t frame = 0;
-                std::memcpy(&frame, data + 1, 4);
-                on_remote_input(frame, data[5]);
-              }
-              break;
-            case kPacketInputBatch:
-              // [type:1][gen:1][baseFrame:u32 LE][count:u8][localDelta:u8]
-              // [input[count]:u8]. Validate that localDelta is in range
-              // (< count) and that the payload length matches count
-              // exactly — anything else is malformed or a version drift.
-              if (kLen >= 8 && on_remote_input_batch) {
-                uint8_t const kGen = data[1];
-                uint32_t base_frame = 0;
-                std::memcpy(&base_frame, data + 2, 4);
-                uint8_t const kCount = data[6];
-                uint8_t const kLocalDelta = data[7];
-                if (kCount == 0 || kLen != size_t{8} + kCount) {
-                  break;
-                }
-                if (kLocalDelta >= kCount) {
-                  break;
-                }
-                uint32_t const kRemoteLocalFrame = base_frame + kLocalDelta;
-                on_remote_input_batch(kGen, base_frame, kCount, data + 8, kRemoteLocalFrame);
-              }
-              break;
-            case kPacketHandshake:
-              // [type:1][version:1][seed:4][hash:4] = 10 B.
-              if (kLen == 10 && on_handshake) {
-                if (data[1] != kProtocolVersion) {
-                  // Loud on stderr: a silent drop here surfaces as the
-                  // session sitting in Handshaking forever, which is
-                  // hard to attribute to a version mismatch. Surface
-                  // the actual cause so mixed-version test setups are
-                  // diagnosable immediately.
-                  std::fprintf(stderr,
-                               "[transport] handshake protocol version mismatch: peer=%u local=%u "
-                               "— peers must be on the same build\n",
-                               static_cast<unsigned>(data[1]),
-                               static_cast<unsigned>(kProtocolVersion));
-                  break;
-                }
-                uint32_t seed = 0;
-                uint32_t hash = 0;
-                std::memcpy(&seed, data + 2, 4);
-                std::memcpy(&hash, data + 6, 4);
-                on_handshake(seed, hash);
-              }
-              break;
-            case kPacketChecksum:
-              // [type:1][gen:1][frame:u32 LE][checksum:u32 LE] = 10 B.
-              if (kLen == 10 && on_checksum) {
-                uint8_t const kGen = data[1];
-                uint32_t frame = 0;
-                uint32_t checksum = 0;
-                std::memcpy(&frame, data + 2, 4);
-                std::memcpy(&checksum, data + 6, 4);
-                on_checksum(kGen, frame, checksum);
-              }
-              break;
-            case kPacketPlayerInfo:
-              if (kLen == 1 + kPlayerInfoWireSize && on_player_info) {
-                PlayerInfo info{};
-                const uint8_t* p = data + 1;
-                for (int i = 0; i < 5; ++i, p += 4) {
-                  info.weapons[i] = ReadU32(p);
-                }
-                info.color = ReadI32(p);
-                p += 4;
-                for (int i = 0; i < 3; ++i, p += 4) {
-                  info.rgb[i] = ReadI32(p);
-                }
-                std::memcpy(info.name, p, 24);
-                on_player_info(info);
-              }
-              break;
-            case kPacketMatchSettings:
-              if (kLen == 1 + kMatchSettingsWireSize && on_match_settings) {
-                MatchSettingsData msd{};
-                const uint8_t* p = data + 1;
-                msd.lives = ReadI32(p);
-                p += 4;
-                msd.loading_time = ReadI32(p);
-                p += 4;
-                msd.game_mode = ReadU32(p);
-                p += 4;
-                msd.blood = ReadI32(p);
-                p += 4;
-                msd.max_bonuses = ReadI32(p);
-                p += 4;
-                msd.time_to_lose = ReadI32(p);
-                p += 4;
-                msd.flags_to_win = ReadI32(p);
-                p += 4;
-                msd.load_change = *p++;
-                for (int i = 0; i < 40; ++i, p += 4) {
-                  msd.weap_table[i] = ReadU32(p);
-                }
-                msd.regenerate_level = *p++;
-                msd.shadow = *p++;
-                msd.names_on_bonuses = *p++;
-                msd.blood_particle_max = ReadI32(p);
-                p += 4;
-                msd.zone_timeout = ReadI32(p);
-                p += 4;
-                msd.input_delay = ReadI32(p);
-                on_match_settings(msd);
-              }
-              break;
-            case kPacketMapData:
-              if (kLen > 5 && on_map_data) {
-                on_map_data(data + 1, kLen - 1);
-              }
-              break;
-            case kPacketPause:
-              if (on_pause) {
-                on_pause();
-              }
-              break;
-            case kPacketResume:
-              if (on_resume) {
-                on_resume();
-              }
-              break;
-            case kPacketRematchReady:
-              if (kLen == 2 && on_rematch_ready) {
-                on_rematch_ready(data[1] != 0);
-              }
-              break;
-            case kPacketRematchLevel:
-              if (kLen >= 2 && on_rematch_level) {
-                bool const kRandom = data[1] != 0;
-                std::string file;
-                if (kLen > 2) {
-                  file.assign(reinterpret_cast<const char*>(data + 2), kLen - 2);
-                }
-                on_rematch_level(kRandom, std::move(file));
-              }
-              break;
-            case kPacketEndMatch:
-              if (on_end_match) {
-                on_end_match();
-              }
-              break;
-            case kPacketPeerLeft:
-              if (on_peer_left) {
-                on_peer_left();
-              }
-              break;
-            case kPacketTcInfo:
-              if (kLen >= 5 && on_tc_info) {
-                uint32_t hash = 0;
-                std::memcpy(&hash, data + 1, 4);
-                std::string name;
-                if (kLen > 5) {
-                  name.assign(reinterpret_cast<const char*>(data + 5), kLen - 5);
+// --- Network I/O thread ---
+
+bool NetTransport::StartIoThread() {
+  if (io_) {
+    return true;
+  }
+  if (!enetHost_) {
+    return false;
+  }
+  io_ = std::make_unique<IoThread>();
+  try {
+    io_->thread = std::thread(&NetTransport::RunIo, this);
+  } catch (std::system_error const&) {
+    io_.reset();
+    return false;
+  }
+  return true;
+}
+
+void NetTransport::StopIoThread() {
+  if (!io_) {
+    return;
+  }
+  io_->stop.store(true, std::memory_order_release);
+  io_->thread.join();
+  // Queued tick packets still go out, through the plain path.
+  // Received-but-undelivered ones are dropped with the thread.
+  TickBytes out;
+  while (io_->out_ticks.TryPop(out)) {
+    SendTickNow(out.data, out.len);
+  }
+  io_.reset();
+}
+
+void NetTransport::RunIo() {
+  trace::SetThreadName("net io");
+  IoThread& io = *io_;
+  while (!io.stop.load(std::memory_order_acquire)) {
+    {
+      ZoneScopedN("Net::Io");
+      std::scoped_lock const kLock(io.enet_mutex);
+
+      if (iceAgent_) {
+        iceAgent_->Poll();
+      }
+
+      TickBytes out;
+      while (io.out_ticks.TryPop(out)) {
+        SendTickNow(out.data, out.len);
+      }
+      TickPacket tick;
+
+      ENetEvent event;
+      while (enet_host_service(enetHost_, &event, 0) > 0) {
+        DeferredEvent deferred{.type = event.type, .data = {}};
+        switch (event.type) {
+          case ENET_EVENT_TYPE_CONNECT:
+            peer_ = event.peer;
+            break;
+          case ENET_EVENT_TYPE_RECEIVE: {
+            uint8_t const* data = event.packet->data;
+            size_t const kLen = event.packet->dataLength;
+            if (kLen >= 1 && kLen <= kMaxPacketSize) {
+              // Tick packets bypass Dispatch(), so count them here;
+              // everything else is counted when the game thread dispatches it.
+              if (data[0] == kPacketTick) {
+                LogRxPacket(data[0]);
+                if (DecodeTickPacket(data + 1, kLen - 1, tick)) {
+                  NoteTickSeq(tick.seq);
+                  io.in_ticks.TryPush(tick);
                 }
-                on_tc_info(hash, std::move(name));
-              }
-              break;
-            case kPacketTcResponse:
-              if (kLen == 2 && on_tc_response) {
-                on_tc_response(data[1] != 0);
+              } else {
+                deferred.data.assign(data, data + kLen);
               }
-              break;
-            case kPacketTcData:
-              if (kLen > 1 && on_tc_data) {
-                on_tc_data(data + 1, kLen - 1);
-              }
-              break;
-            default:
-              break;
+            }
+            enet_packet_destroy(event.packet);
+            if (deferred.data.empty()) {
+              continue;
+            }
+            break;
           }
+          case ENET_EVENT_TYPE_DISCONNECT:
+          case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+            peer_ = nullptr;
+            break;
+          case ENET_EVENT_TYPE_NONE:
+            continue;
         }
+        std::scoped_lock const kDeferredLock(io.deferred_mutex);
+        io.deferred.push_back(std::move(deferred));
+      }
+      enet_host_flush(enetHost_);
 
-        enet_packet_destroy(event.packet);
-        break;
+      if (iceBridge_) {
+        iceBridge_->Poll();
       }
+    }
+
+    // Wake on incoming data, or after kWaitMs to pick up queued sends.
+    enet_uint32 wait_condition = ENET_SOCKET_WAIT_RECEIVE;
+    if (enet_socket_wait(enetHost_->socket, &wait_condition, IoThread::kWaitMs) != 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(IoThread::kWaitMs));
+    }
+  }
+}
+
+bool NetTransport::PollDeferred() {
+  std::vector<DeferredEvent> events;
+  {
+    std::scoped_lock const kLock(io_->deferred_mutex);
+    events.swap(io_->deferred);
+  }
 
+  for (DeferredEvent const& ev : events) {
+    switch (ev.type) {
+      case ENET_EVENT_TYPE_CONNECT:
+        state_ = kConnected;
+        if (on_connected) {
+          on_connected();
+        }
+        break;
+      case ENET_EVENT_TYPE_RECEIVE:
+        Dispatch(ev.data.data(), ev.data.size());
+        break;
       case ENET_EVENT_TYPE_DISCONNECT:
       case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
-        peer_ = nullptr;
         state_ = kDisconnected;
         if (on_disconnected) {
           on_disconnected();
         }
         return false;
-
       case ENET_EVENT_TYPE_NONE:
         break;
     }
   }
 
-  // Forward ENet outgoing packets through ICE bridge AFTER enet_host_service
-  // (ENet sends during service, bridge picks up and forwards to libjuice)
-  if (iceBridge_) {
-    iceBridge_->Poll();
+  PumpInput();
+  return state_ == kConnected || state_ == kListening || state_ == kConnecting;
+}
+
+void NetTransport::PumpInput() {
+  if (!io_) {
+    return;
   }
+  TickPacket tick;
+  while (io_->in_ticks.TryPop(tick)) {
+    DeliverTick(tick);
+  }
+}
 
-  return state_ == kConnected || state_ == kListening || state_ == kConnecting;
+void NetTransport::NoteTickSeq(uint16_t seq) {
+  rxLoss_.OnSeq(seq);
+  rxLossQ8_.store(rxLoss_.LossQ8(), std::memory_order_relaxed);
+}
+
+void NetTransport::DeliverTick(TickPacket const& tick) {
+  if (on_remote_input_batch) {
+    on_remote_input_batch(tick.generation, tick.base_frame, tick.count, tick.inputs.data(),
+                          tick.LocalFrame());
+  }
+  if (on_input_ack) {
+    on_input_ack(tick.generation, tick.ack_next, tick.loss_q8);
+  }
+  if (on_checksum) {
+    for (uint8_t k = 0; k < tick.checksum_count; ++k) {
+      TickChecksum const& c = tick.checksums[k];
+      on_checksum(tick.generation, c.epoch, c.frame, c.checksum);
+    }
+  }
+}
+
+std::unique_lock<std::mutex> NetTransport::LockEnet() {
+  if (!io_) {
+    return {};
+  }
+  return std::unique_lock(io_->enet_mutex);
 }
 
 // --- Send helpers ---
@@ -527,60 +782,104 @@ void NetTransport::SendInput(uint32_t frame, uint8_t input) {
 }
 
 void NetTransport::SendInputBatch(uint8_t generation, uint32_t base_frame, uint8_t count,
-                                  uint8_t local_delta, uint8_t const* inputs) {
-  if (!peer_ || count == 0 || local_delta >= count) {
+                                  uint32_t local_frame, uint8_t const* inputs, uint32_t ack_next) {
+  TickPacket t;
+  t.generation = generation;
+  t.seq = ++tickSeq_;
+  t.ack_next = ack_next;
+  t.loss_q8 = rxLossQ8_.load(std::memory_order_relaxed);
+  t.base_frame = base_frame;
+  t.count = count;
+  if (count == 0 || count > TickPacket::kMaxInputs || local_frame > t.NewestFrame() ||
+      t.NewestFrame() - local_frame > 0xff) {
     return;
   }
-  // Cap to a defensive maximum so a misuse can't blow the stack
-  // buffer. Rollback uses count = kMaxRollback + 1 (= 8); accept
-  // anything up to 64 for headroom.
-  static constexpr uint8_t kMaxCount = 64;
-  if (count > kMaxCount) {
-    return;
+  t.lag = static_cast<uint8_t>(t.NewestFrame() - local_frame);
+  std::memcpy(t.inputs.data(), inputs, count);
+
+  // Checksums from an earlier phase describe frames that no longer
+  // exist; whatever doesn't fit waits for the next tick.
+  size_t taken = 0;
+  for (PendingChecksum const& p : pendingChecksums_) {
+    if (t.checksum_count == TickPacket::kMaxChecksums) {
+      break;
+    }
+    ++taken;
+    if (p.generation == generation && t.CanCarry(p.checksum.frame)) {
+      t.checksums[t.checksum_count++] = p.checksum;
+    }
   }
+  pendingChecksums_.erase(pendingChecksums_.begin(),
+                          pendingChecksums_.begin() + static_cast<std::ptrdiff_t>(taken));
 
-  uint8_t buf[8 + kMaxCount];
-  buf[0] = kPacketInputBatch;
-  buf[1] = generation;
-  std::memcpy(buf + 2, &base_frame, 4);
-  buf[6] = count;
-  buf[7] = local_delta;
-  std::memcpy(buf + 8, inputs, count);
+  TickBytes out;
+  out.data[0] = kPacketTick;
+  size_t const kLen = EncodeTickPacket(t, out.data + 1);
+  if (kLen == 0) {
+    return;
+  }
+  out.len = static_cast<uint16_t>(1 + kLen);
+  if (io_) {
+    // A full queue drops the packet; its input is resent until acked.
+    io_->out_ticks.TryPush(out);
+    return;
+  }
+  SendTickNow(out.data, out.len);
+}
 
-  size_t const kLen = size_t{8} + count;
-  // UNSEQUENCED, not 0: sequenced-discard would drop an older batch
+void NetTransport::SendTickNow(uint8_t const* data, size_t len) {
+  if (!peer_) {
+    return;
+  }
+  // UNSEQUENCED, not 0: sequenced-discard would drop an older packet
   // delivered after a newer one. injectRemoteInput already dedups.
-  ENetPacket* packet = enet_packet_create(buf, kLen, ENET_PACKET_FLAG_UNSEQUENCED);
+  ENetPacket* packet = enet_packet_create(data, len, ENET_PACKET_FLAG_UNSEQUENCED);
   if (!packet) {
     return;
   }
-  if (enet_peer_send(peer_, kChannelInputBatch, packet) < 0) {
+  if (enet_peer_send(peer_, kChannelTick, packet) < 0) {
     enet_packet_destroy(packet);
   }
 }
 
-void NetTransport::SendChecksum(uint8_t generation, uint32_t frame, uint32_t checksum) {
-  uint8_t buf[10];
-  buf[0] = kPacketChecksum;
-  buf[1] = generation;
-  std::memcpy(buf + 2, &frame, 4);
-  std::memcpy(buf + 6, &checksum, 4);
+void NetTransport::SendChecksum(uint8_t generation, uint8_t epoch, uint32_t frame,
+                                uint32_t checksum) {
+  if (pendingChecksums_.size() == kMaxPendingChecksums) {
+    pendingChecksums_.erase(pendingChecksums_.begin());
+  }
+  pendingChecksums_.push_back(
+      {.generation = generation,
+       .checksum = {.epoch = epoch, .frame = frame, .checksum = checksum}});
+}
 
+void NetTransport::SendTimeSync(uint16_t seq, uint16_t echo_seq, uint8_t echo_hold,
+                                int16_t lead_q4, uint8_t input_delay) {
+  uint8_t buf[9];
+  buf[0] = kPacketTimeSync;
+  std::memcpy(buf + 1, &seq, 2);
+  std::memcpy(buf + 3, &echo_seq, 2);
+  buf[5] = echo_hold;
+  std::memcpy(buf + 6, &lead_q4, 2);
+  buf[8] = input_delay;
+
+  auto const kLock = LockEnet();
   if (!peer_) {
     return;
   }
   ENetPacket* packet = enet_packet_create(buf, sizeof(buf), ENET_PACKET_FLAG_UNSEQUENCED);
-  if (packet) {
-    enet_peer_send(peer_, kChannelUnreliable, packet);
+  if (packet && enet_peer_send(peer_, kChannelUnreliable, packet) < 0) {
+    enet_packet_destroy(packet);
   }
 }
 
-void NetTransport::SendHandshake(uint32_t seed, uint32_t settings_hash) {
-  uint8_t buf[10];
+void NetTransport::SendHandshake(uint32_t seed, uint32_t settings_hash,
+                                 uint8_t rollback_window) {
+  uint8_t buf[11];
   buf[0] = kPacketHandshake;
   buf[1] = kProtocolVersion;
   std::memcpy(buf + 2, &seed, 4);
   std::memcpy(buf + 6, &settings_hash, 4);
+  buf[10] = rollback_window;
   SendPacket(buf, sizeof(buf));
 }
 
@@ -638,6 +937,7 @@ void NetTransport::SendMapData(const void* data, size_t len) {
   buf[0] = kPacketMapData;
   std::memcpy(buf.data() + 1, data, len);
 
+  auto const kLock = LockEnet();
   if (!peer_) {
     return;
   }
@@ -707,6 +1007,7 @@ void NetTransport::SendTcData(const void* data, size_t len) {
   buf[0] = kPacketTcData;
   std::memcpy(buf.data() + 1, data, len);
 
+  auto const kLock = LockEnet();
   if (!peer_) {
     return;
   }
@@ -719,7 +1020,33 @@ void NetTransport::SendTcData(const void* data, size_t len) {
   }
 }
 
+void NetTransport::SendResyncRequest(uint8_t epoch, uint32_t frame) {
+  uint8_t buf[6];
+  buf[0] = kPacketResyncRequest;
+  buf[1] = epoch;
+  std::memcpy(buf + 2, &frame, 4);
+  SendPacket(buf, sizeof(buf));
+}
+
+void NetTransport::SendResyncState(uint8_t epoch, uint32_t frame, const void* data, size_t len) {
+  std::vector<uint8_t> buf(6 + len);
+  buf[0] = kPacketResyncState;
+  buf[1] = epoch;
+  std::memcpy(buf.data() + 2, &frame, 4);
+  std::memcpy(buf.data() + 6, data, len);
+  SendPacket(buf.data(), buf.size());
+}
+
+void NetTransport::SendResyncAck(uint8_t epoch, bool ok) {
+  uint8_t buf[3];
+  buf[0] = kPacketResyncAck;
+  buf[1] = epoch;
+  buf[2] = ok ? 1 : 0;
+  SendPacket(buf, sizeof(buf));
+}
+
 void NetTransport::SendPacket(const void* data, size_t len) {
+  auto const kLock = LockEnet();
   if (!peer_) {
     return;
   }
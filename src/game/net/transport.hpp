@@ -1,10 +1,13 @@
 #pragma once
 
 #include "iceBridge.hpp"
+#include "tickPacket.hpp"
 
 #include <cstdint>
 #include <functional>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -28,7 +31,13 @@ struct NetTransport {
   //     (previously 6-bit VGA values).
   // v7: level map blob includes display layer (display_data/display_valid).
   // v8: level map blob includes anim layer (argb_ramps/display_anim).
-  static constexpr uint8_t kProtocolVersion = 8;
+  // v9: kPacketTimeSync.
+  // v10: handshake carries the sender's rollback window offer.
+  // v11: kPacketChecksum carries SnapshotChecksum (kSnapshotChecksumVersion 1)
+  //      instead of WideRollbackChecksum.
+  // v12: kPacketChecksum carries the resync epoch; kPacketResync*.
+  // v13: kPacketTick replaces kPacketInputBatch and kPacketChecksum.
+  static constexpr uint8_t kProtocolVersion = 13;
 
   // Wire sizes for hand-serialized structs (no compiler padding).
   static constexpr size_t kPlayerInfoWireSize = 5 * 4 + 4 + 3 * 4 + 24;
@@ -38,7 +47,7 @@ struct NetTransport {
   enum PacketType : uint8_t {
     kPacketInput = 1,
     kPacketHandshake = 2,
-    kPacketChecksum = 3,
+    // 3 was kPacketChecksum until v13.
     kPacketPlayerInfo = 4,
     kPacketMatchSettings = 5,
     kPacketMapData = 6,
@@ -50,17 +59,32 @@ struct NetTransport {
     kPacketTcInfo = 12,
     kPacketTcResponse = 13,
     kPacketTcData = 14,
-    // K-wide redundant input window with the sender's current sim
-    // frame, delivered unreliable-sequenced.
-    //   [type:1][gen:1][baseFrame:u32 LE][count:u8][localDelta:u8][input[count]:u8]
-    // The receiver reconstructs `remoteLocalFrame = baseFrame + localDelta`
-    // for frame-advantage tracking; `gen` lets the receiver drop
-    // pre-transition packets after a WS→game reset.
-    kPacketInputBatch = 15,
+    // 15 was kPacketInputBatch until v13.
     // Sender is leaving the match (pause menu "Disconnect"). Receiver
     // should drop back to the menu without showing stats or a
     // "peer disconnected" InfoBox.
     kPacketPeerLeft = 16,
+    // Rollback time sync / link estimation, ~10 per second, unreliable.
+    //   [type:1][seq:u16 LE][echoSeq:u16 LE][echoHold:u8][lead:i16 LE][inputDelay:u8]
+    // `lead` is in 1/16 frames. See rollback/time_sync.hpp.
+    kPacketTimeSync = 17,
+    // Desync recovery (see NetSession::OnDesync), all reliable.
+    // Client asks the host for its state after a checksum mismatch in
+    // `epoch`:
+    //   [type:1][epoch:1][frame:u32 LE]
+    kPacketResyncRequest = 18,
+    // Host's authoritative state as of `frame`; `epoch` is the new epoch
+    // checksums are tagged with once the client has adopted it.
+    //   [type:1][epoch:1][frame:u32 LE][compressed:1][rawSize:u32 LE][data]
+    kPacketResyncState = 19,
+    // Client adopted (ok=1) or rejected (ok=0) the state for `epoch`.
+    //   [type:1][epoch:1][ok:1]
+    kPacketResyncAck = 20,
+    // One per rollback tick, unreliable: input window, ack and loss
+    // report for the peer's input, and pending checksums. Layout in
+    // tickPacket.hpp. `gen` lets the receiver drop pre-transition
+    // packets after a WS→game reset.
+    kPacketTick = 21,
   };
 
   struct PlayerInfo {
@@ -127,20 +151,48 @@ struct NetTransport {
   void AttachIce(std::unique_ptr<IceBridge> bridge, std::unique_ptr<IceAgent> agent);
 
   // --- General ---
-  // Poll for events. Call once per frame.
+  // Poll for events. Call once per frame. With the I/O thread running
+  // this only delivers what the thread has received since the last call.
   bool Poll();
 
+  // --- Network I/O thread ---
+  // Optional thread that services ENet and ICE (agent and bridge) continuously
+  // instead of once per Poll(). Tick packets it receives are queued
+  // lock-free for PumpInput(); every other event is queued for Poll(),
+  // so all callbacks still fire on the game thread (except
+  // on_intercepted_packet, which runs on the I/O thread). Tick packets
+  // are handed to the thread and hit the wire within a millisecond of
+  // being sent instead of at the next Poll(). Requires a host; returns
+  // false if none exists or no thread can be started.
+  bool StartIoThread();
+  void StopIoThread();
+  bool IoThreadRunning() const { return io_ != nullptr; }
+
+  // Fires the tick packet callbacks for everything the I/O
+  // thread has queued. Poll() calls this too; the rollback controller
+  // calls it right before it consumes remote input so a batch that
+  // arrived mid-frame is used this tick. No-op without the I/O thread.
+  void PumpInput();
+
   void SendInput(uint32_t frame, uint8_t input);
-  // Rollback batched input send. `inputs` covers frames
-  // [baseFrame, baseFrame + count - 1]. `localDelta` is the sender's
-  // `simFrame - baseFrame` at send time (range [0, count - 1]).
-  // `generation` is the sender's phase generation; receivers drop
-  // older generations. Unreliable-sequenced; receiver dedups against
-  // confirmed frames.
-  void SendInputBatch(uint8_t generation, uint32_t base_frame, uint8_t count, uint8_t local_delta,
-                      uint8_t const* inputs);
-  void SendChecksum(uint8_t generation, uint32_t frame, uint32_t checksum);
-  void SendHandshake(uint32_t seed, uint32_t settings_hash);
+  // Sends this tick's kPacketTick. `inputs` covers frames
+  // [baseFrame, baseFrame + count - 1]; `localFrame` is the sender's
+  // simFrame, at most 255 frames behind the newest input. `ackNext` is
+  // the first of the peer's frames we are still missing. Pending
+  // checksums of the same generation ride along. `generation` is the
+  // sender's phase generation; receivers drop older generations.
+  // Unreliable and unsequenced; receiver dedups against confirmed frames.
+  void SendInputBatch(uint8_t generation, uint32_t base_frame, uint8_t count, uint32_t local_frame,
+                      uint8_t const* inputs, uint32_t ack_next);
+  // Queues a checksum for the next SendInputBatch. `epoch` counts
+  // completed resyncs this match; receivers drop checksums from any
+  // other epoch.
+  void SendChecksum(uint8_t generation, uint8_t epoch, uint32_t frame, uint32_t checksum);
+  void SendTimeSync(uint16_t seq, uint16_t echo_seq, uint8_t echo_hold, int16_t lead_q4,
+                    uint8_t input_delay);
+  // `rollback_window` is the widest rollback window the sender will play
+  // with; both peers use the smaller of the two offers.
+  void SendHandshake(uint32_t seed, uint32_t settings_hash, uint8_t rollback_window);
   void SendPlayerInfo(const PlayerInfo& info);
   void SendMatchSettings(const MatchSettingsData& data);
   void SendMapData(const void* data, size_t len);
@@ -153,6 +205,11 @@ struct NetTransport {
   void SendTcInfo(uint32_t hash, const std::string& name);
   void SendTcResponse(bool need_data);
   void SendTcData(const void* data, size_t len);
+  void SendResyncRequest(uint8_t epoch, uint32_t frame);
+  // `data` is the compressed-flag / size / payload envelope SendMapData
+  // also uses.
+  void SendResyncState(uint8_t epoch, uint32_t frame, const void* data, size_t len);
+  void SendResyncAck(uint8_t epoch, bool ok);
 
   State CurrentState() const { return state_; }
   uint16_t ListeningPort() const;
@@ -169,8 +226,16 @@ struct NetTransport {
   std::function<void(uint8_t generation, uint32_t base_frame, uint8_t count, uint8_t const* inputs,
                      uint32_t remote_local_frame)>
       on_remote_input_batch;
-  std::function<void(uint32_t seed, uint32_t settings_hash)> on_handshake;
-  std::function<void(uint8_t generation, uint32_t frame, uint32_t checksum)> on_checksum;
+  std::function<void(uint32_t seed, uint32_t settings_hash, uint8_t rollback_window)>
+      on_handshake;
+  // Peer has every one of our frames before `nextFrame`, and lost
+  // `lossQ8`/256 of our recent tick packets.
+  std::function<void(uint8_t generation, uint32_t next_frame, uint8_t loss_q8)> on_input_ack;
+  std::function<void(uint8_t generation, uint8_t epoch, uint32_t frame, uint32_t checksum)>
+      on_checksum;
+  std::function<void(uint16_t seq, uint16_t echo_seq, uint8_t echo_hold, int16_t lead_q4,
+                     uint8_t input_delay)>
+      on_time_sync;
   std::function<void(const PlayerInfo& info)> on_player_info;
   std::function<void(const MatchSettingsData& data)> on_match_settings;
   std::function<void(const void* data, size_t len)> on_map_data;
@@ -183,16 +248,34 @@ struct NetTransport {
   std::function<void(uint32_t hash, std::string name)> on_tc_info;
   std::function<void(bool need_data)> on_tc_response;
   std::function<void(const void* data, size_t len)> on_tc_data;
+  std::function<void(uint8_t epoch, uint32_t frame)> on_resync_request;
+  std::function<void(uint8_t epoch, uint32_t frame, const void* data, size_t len)>
+      on_resync_state;
+  std::function<void(uint8_t epoch, bool ok)> on_resync_ack;
   std::function<void()> on_connected;
   std::function<void()> on_disconnected;
   // Called for each non-ENet packet intercepted (STUN, etc.)
-  // Return true if consumed.
+  // Return true if consumed. Runs on the I/O thread while it is active.
   std::function<bool(const uint8_t* data, size_t len)> on_intercepted_packet;
 
  private:
+  struct IoThread;
+
   void SendPacket(const void* data, size_t len);
+  void SendTickNow(uint8_t const* data, size_t len);
+  // Feeds the loss meter; runs on whichever thread services ENet.
+  void NoteTickSeq(uint16_t seq);
+  // Fires the callbacks for one received tick packet.
+  void DeliverTick(TickPacket const& tick);
   bool CreateHost(uint16_t port);
   void SetupIntercept();
+  // Routes one received packet to its callback.
+  void Dispatch(uint8_t const* data, size_t len);
+  // Held around ENet calls made from the game thread while the I/O
+  // thread runs; empty otherwise.
+  std::unique_lock<std::mutex> LockEnet();
+  void RunIo();
+  bool PollDeferred();
 
   static int InterceptCallback(ENetHost* host, void* event);
 
@@ -201,4 +284,16 @@ struct NetTransport {
   enum State state_ { kDisconnected };
   std::unique_ptr<IceBridge> iceBridge_;
   std::unique_ptr<IceAgent> iceAgent_;
+  std::unique_ptr<IoThread> io_;
+
+  struct PendingChecksum {
+    uint8_t generation;
+    TickChecksum checksum;
+  };
+  // Game thread only.
+  std::vector<PendingChecksum> pendingChecksums_;
+  uint16_t tickSeq_ = 0;
+  // Written by the receiving thread, read when sending.
+  LossMeter rxLoss_;
+  std::atomic<uint8_t> rxLossQ8_{0};
 };
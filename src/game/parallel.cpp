@@ -0,0 +1,67 @@
+#include "parallel.hpp"
+
+#include "profiling.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+void ParallelFor(std::size_t count, std::function<void(std::size_t)> const& fn,
+                 unsigned max_threads) {
+  if (count == 0) {
+    return;
+  }
+
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto work = [&] {
+    ZoneScopedN("ParallelFor");
+    for (;;) {
+      std::size_t const kI = next.fetch_add(1, std::memory_order_relaxed);
+      if (kI >= count || failed.load(std::memory_order_relaxed)) {
+        return;
+      }
+      try {
+        fn(kI);
+      } catch (...) {
+        std::lock_guard<std::mutex> const kLock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  unsigned threads = max_threads != 0 ? max_threads : std::thread::hardware_concurrency();
+  threads = std::max(threads, 1U);
+  std::size_t const kHelpers = std::min<std::size_t>(threads, count) - 1;
+
+  std::vector<std::thread> helpers;
+  helpers.reserve(kHelpers);
+  for (std::size_t i = 0; i < kHelpers; ++i) {
+    try {
+      helpers.emplace_back([&] {
+        trace::SetThreadName("parallel worker");
+        work();
+      });
+    } catch (std::system_error const&) {
+      break;
+    }
+  }
+  work();
+  for (std::thread& t : helpers) {
+    t.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
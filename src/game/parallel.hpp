@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Calls fn(i) for every i in [0, count) and returns once all calls are
+// done. The calls are spread over up to `max_threads` threads (0 = one
+// per hardware thread), the calling thread included, in no particular
+// order; `fn` must only write state that belongs to its `i`.
+//
+// Where threads can't be started (std::thread throws, e.g. Emscripten
+// builds without pthreads) the calls run inline. If a call throws, the
+// indices not yet started are skipped and the first exception is
+// rethrown here.
+void ParallelFor(std::size_t count, std::function<void(std::size_t)> const& fn,
+                 unsigned max_threads = 0);
@@ -1,19 +1,46 @@
 #pragma once
 
-// Thin wrapper around Tracy. When OPENLIERO_ENABLE_TRACY is defined (set by
-// CMake when -DOPENLIERO_ENABLE_TRACY=ON is passed), real Tracy macros are
-// used. Otherwise every macro expands to nothing so instrumented source
-// compiles without any Tracy headers on the include path.
+// Profiling zones. ZoneScoped/ZoneScopedN open a zone for the rest of the
+// enclosing scope, which feeds:
+//   - the built-in trace recorder (trace.hpp), always compiled in and
+//     switched on at runtime;
+//   - Tracy, when OPENLIERO_ENABLE_TRACY is defined (set by CMake when
+//     -DOPENLIERO_ENABLE_TRACY=ON is passed). Without it FrameMark and the
+//     other Tracy macros expand to nothing, so instrumented source compiles
+//     without any Tracy headers on the include path;
+//   - the allocation tracker (alloc_tracker.hpp), when
+//     OPENLIERO_ENABLE_ALLOC_TRACKING is defined.
+// Zone names are kept by address, so pass string literals.
+
+#include "trace.hpp"
 
 #ifdef OPENLIERO_ENABLE_TRACY
 #include <tracy/Tracy.hpp>
+#define OL_TRACY_ZONE ZoneNamed(___tracy_scoped_zone, true);
+#define OL_TRACY_ZONE_N(name) ZoneNamedN(___tracy_scoped_zone, name, true);
+#undef ZoneScoped
+#undef ZoneScopedN
 #else
+#define OL_TRACY_ZONE
+#define OL_TRACY_ZONE_N(name)
 // These no-op macros match Tracy's mixed-case API names exactly so instrumented
 // call sites compile identically with and without Tracy.
 // NOLINTBEGIN(readability-identifier-naming)
-#define ZoneScoped
-#define ZoneScopedN(name)
 #define FrameMark
 #define FrameMarkNamed(name)
 // NOLINTEND(readability-identifier-naming)
 #endif
+
+#ifdef OPENLIERO_ENABLE_ALLOC_TRACKING
+#include "alloc_tracker.hpp"
+#define OL_ALLOC_ZONE(name) alloc_tracker::Zone const ol_alloc_zone(name);
+#else
+#define OL_ALLOC_ZONE(name)
+#endif
+
+// NOLINTBEGIN(readability-identifier-naming, bugprone-macro-parentheses)
+#define ZoneScoped \
+  OL_TRACY_ZONE OL_ALLOC_ZONE(__func__) trace::Scope const ol_trace_scope(__func__)
+#define ZoneScopedN(name) \
+  OL_TRACY_ZONE_N(name) OL_ALLOC_ZONE(name) trace::Scope const ol_trace_scope(name)
+// NOLINTEND(readability-identifier-naming, bugprone-macro-parentheses)
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <span>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -23,6 +24,9 @@ struct ReaderFile {
   }
 
   explicit ReaderFile(io::Reader& r) {
+    std::span<uint8_t const> const kBuf = r.Buffered();
+    data_.assign(kBuf.begin(), kBuf.end());
+    r.TrySkip(kBuf.size());
     uint8_t buf[4096];
     for (;;) {
       std::size_t const kGot = r.TryGet(buf, sizeof(buf));
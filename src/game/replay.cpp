@@ -2,6 +2,7 @@
 
 #include "game.hpp"
 #include "io/coding.hpp"
+#include "profiling.hpp"
 #include "viewport.hpp"
 #include "worm.hpp"
 
@@ -11,8 +12,11 @@
 
 #include <cassert>
 #include <set>
+#include <span>
 #include <sstream>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 // #define DEBUG_REPLAYS 1
 
@@ -65,32 +69,32 @@ static void CerealWrite(io::Writer& writer, T& obj) {
     cereal::PortableBinaryOutputArchive ar(ss);  // NOLINT(misc-const-correctness)
     ar(obj);
   }
-  std::string buf = ss.str();
-  io::WriteUint32(writer, static_cast<uint32_t>(buf.size()));
-  writer.Put(reinterpret_cast<uint8_t const*>(buf.data()), buf.size());
+  std::string_view const kBuf = ss.view();
+  io::WriteUint32(writer, static_cast<uint32_t>(kBuf.size()));
+  writer.Put(reinterpret_cast<uint8_t const*>(kBuf.data()), kBuf.size());
 }
 
 // Helper: read [uint32 length][blob] from the replay stream and
-// deserialize into obj via cereal.
+// deserialize into obj via cereal, straight out of the reader's buffer.
 template <typename T>
 static void CerealRead(io::MemReader& reader, T& obj) {
   uint32_t const kLen = io::ReadUint32(reader);
-  std::string buf(kLen, '\0');
-  for (uint32_t i = 0; i < kLen; ++i) {
-    buf[i] = static_cast<char>(reader.Get());
-  }
-  std::istringstream ss(buf, std::ios::binary);
+  std::vector<uint8_t> scratch;
+  std::span<uint8_t const> const kBlob = reader.Borrow(kLen, scratch);
+  io::SpanIStream ss(kBlob);
   {
     cereal::PortableBinaryInputArchive ar(ss);  // NOLINT(misc-const-correctness)
     ar(obj);
   }
 }
 
-ReplayWriter::ReplayWriter(std::unique_ptr<io::Writer> sink) : writer(std::move(sink)) {}
+ReplayWriter::ReplayWriter(std::unique_ptr<io::Writer> sink)
+    : writer(std::make_unique<io::DeflateWriter>(std::move(sink))) {}
 
 ReplayWriter::~ReplayWriter() {
   try {
     EndRecord();
+    writer.Close();
   } catch (...) {  // NOLINT(bugprone-empty-catch) — destructor: writes during destruction are
                    // best-effort.
   }
@@ -146,6 +150,7 @@ std::unique_ptr<Game> ReplayReader::BeginPlayback(
 }
 
 void ReplayWriter::BeginRecord(Game& game) {
+  ZoneScopedN("Replay::BeginRecord");
   io::WriteUint32(writer, kReplayMagic);
   writer.Put(kMyReplayVersion);
 
@@ -160,6 +165,7 @@ void ReplayWriter::BeginRecord(Game& game) {
   }
   last_settings_hash = game.settings->UpdateHash();
   this->game = &game;
+  writer.Commit();
 }
 
 void ReplayWriter::EndRecord() { writer.Put(kReplayTagEnd); }
@@ -258,6 +264,7 @@ uint32_t WideRollbackChecksum(Game& game) {
 }
 
 bool ReplayReader::PlaybackFrame(Renderer& renderer) {
+  ZoneScopedN("Replay::Playback");
   Game& game = *this->game;
 
   bool settings_changed = false;
@@ -326,6 +333,7 @@ bool ReplayReader::PlaybackFrame(Renderer& renderer) {
 }
 
 void ReplayWriter::RecordFrame() {
+  ZoneScopedN("Replay::Record");
   Game& game = *this->game;
 
   if (settings_expired) {
@@ -370,6 +378,7 @@ void ReplayWriter::RecordFrame() {
     uint32_t const kChecksum = WideRollbackChecksum(game);
     io::WriteUint32(writer, kChecksum);
   }
+  writer.Commit();
 }
 
 void ReplayWriter::Unfocus() {
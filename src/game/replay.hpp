@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include "common.hpp"
+#include "io/async_writer.hpp"
 #include "io/deflate.hpp"
 #include "io/stream.hpp"
 #include "mixer/player.hpp"
@@ -25,7 +26,9 @@ struct ReplayWriter : Replay {
   void Unfocus();
   void Focus();
 
-  io::DeflateWriter writer;
+  // Frame records go into the async writer's ring; deflate and the sink run
+  // on its worker thread. Each BeginRecord / RecordFrame commits its bytes.
+  io::AsyncWriter writer;
   uint64_t last_settings_hash;
   bool settings_expired{true};
 
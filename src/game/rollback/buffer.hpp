@@ -2,11 +2,16 @@
 
 // Input + snapshot ring buffer.
 //
-// Holds the last (kMaxRollback + 1) frames of sim state and the input
-// bytes that produced them. Slots are pre-allocated; writing a new
-// frame reuses the slot at `frame % kCapacity`, evicting whatever was
-// there before. The rollback controller reads from `find()` to restore
-// a snapshot and calls `write()` after each advanced frame.
+// Holds the last (window + 1) frames of sim state and the input bytes
+// that produced them. Slots are pre-allocated; writing a new frame
+// reuses the slot at `frame % Capacity()`, evicting whatever was there
+// before. The rollback controller reads from `find()` to restore a
+// snapshot and calls `write()` after each advanced frame.
+//
+// The window is negotiated per match (see NetSession), so the capacity
+// is set at runtime with Resize(). Prepare() then lays the slots out
+// against kSnapshotBudgetBytes: whole-level copies when they fit, level
+// deltas otherwise (GameSnapshot::LevelStorage).
 //
 // Pure data structure — knows nothing about Game, processFrame, or the
 // wire format.
@@ -15,11 +20,11 @@
 #include "serialization/weapsel_snapshot.hpp"
 
 #include <algorithm>
-#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <utility>
+#include <vector>
 
 namespace rollback {
 
@@ -27,6 +32,12 @@ namespace rollback {
 // docs/ideas/rollback.md ("Buffer Sizing & Player Count"): ~100 ms of
 // tolerance at 70 fps.
 constexpr int kMaxRollback = 7;
+// Widest window a match may negotiate: ~430 ms at 70 fps, enough for
+// intercontinental links.
+constexpr int kMaxRollbackLimit = 30;
+// Level bytes the ring may spend on whole-level copies before it switches
+// to delta slots.
+constexpr std::size_t kSnapshotBudgetBytes = std::size_t{64} << 20;
 
 enum class RemoteState : uint8_t {
   kPredicted,
@@ -54,14 +65,40 @@ struct Slot {
 
 class RollbackBuffer {
  public:
-  // One extra slot so we can hold frames [F - kMaxRollback, F] inclusive.
+  // Default capacity: one extra slot so we can hold frames
+  // [F - kMaxRollback, F] inclusive.
   static constexpr std::size_t kCapacity = static_cast<std::size_t>(kMaxRollback) + 1;
 
+  RollbackBuffer() : slots_(kCapacity) {}
+
+  // Re-size the ring to hold `capacity` frames (window + 1). Drops every
+  // slot, so call before Prepare() and the first write.
+  void Resize(std::size_t capacity) {
+    assert(capacity >= 2);
+    slots_.clear();
+    slots_.resize(capacity);
+    newest_ = -1;
+  }
+
+  std::size_t Capacity() const { return slots_.size(); }
+
+  // Level layout Prepare() picks for `level`: whole copies while the ring
+  // stays inside kSnapshotBudgetBytes, deltas beyond that.
+  GameSnapshot::LevelStorage StorageFor(Level const& level) const {
+    std::size_t const kFull = GameSnapshot::FullLevelBytes(level);
+    return kFull == 0 || slots_.size() <= kSnapshotBudgetBytes / kFull
+               ? GameSnapshot::LevelStorage::kFull
+               : GameSnapshot::LevelStorage::kDelta;
+  }
+
   // Pre-size every slot's snapshot vectors. Call once after the level is
-  // generated; no allocations happen on subsequent save/load.
+  // generated; whole-level slots don't allocate on subsequent save/load,
+  // and delta slots are reserved for Level::kDeltaReserveCells, which the
+  // controller's rebase on confirmed frames keeps them under.
   void Prepare(Game const& game) {
+    GameSnapshot::LevelStorage const kStorage = StorageFor(game.level);
     for (auto& slot : slots_) {
-      slot.snapshot.Prepare(game);
+      slot.snapshot.Prepare(game, kStorage);
     }
   }
 
@@ -132,7 +169,7 @@ class RollbackBuffer {
     if (newest_ < 0) {
       return -1;
     }
-    int const kFloor = newest_ - static_cast<int>(kCapacity) + 1;
+    int const kFloor = newest_ - static_cast<int>(slots_.size()) + 1;
     return kFloor < 0 ? 0 : kFloor;
   }
 
@@ -143,21 +180,21 @@ class RollbackBuffer {
       return 0;
     }
     int const kSpan = newest_ + 1;
-    return std::cmp_less(kSpan, kCapacity) ? static_cast<std::size_t>(kSpan) : kCapacity;
+    return std::cmp_less(kSpan, slots_.size()) ? static_cast<std::size_t>(kSpan) : slots_.size();
   }
 
  private:
-  static std::size_t IndexOf(int frame) {
+  std::size_t IndexOf(int frame) const {
     // frame is non-negative in practice (sim frames start at 0), but stay
     // defensive in case a caller passes -1.
-    return static_cast<std::size_t>(static_cast<unsigned>(frame) % kCapacity);
+    return static_cast<std::size_t>(static_cast<unsigned>(frame) % slots_.size());
   }
 
   bool Resident(int frame) const {
     return frame >= 0 && frame >= OldestFrame() && frame <= newest_;
   }
 
-  std::array<Slot, kCapacity> slots_{};
+  std::vector<Slot> slots_;
   int newest_ = -1;
 };
 
@@ -0,0 +1,201 @@
+#pragma once
+
+// Link estimation and time synchronisation for the rollback controller.
+//
+// Every kInterval ticks each peer sends a small TimeSyncMessage carrying
+// a sequence number, an echo of the last sequence it received (plus how
+// long it held it), its own lead over the other peer and the input delay
+// it wants. From the echoes we get a smoothed round-trip time and its
+// mean deviation (RFC 6298 style), both in ticks. From the two leads we
+// get the GGPO "frame advantage" imbalance: half the difference between
+// how far we think we are ahead and how far the peer thinks it is ahead.
+//
+// The leading peer pays the imbalance back by stretching its next few
+// frames by a millisecond or two instead of stalling whole ticks. The
+// agreed input delay is the larger of the two peers' proposals, so both
+// sides converge on the same value without an extra round trip.
+//
+// Ticks are controller Process() calls, i.e. display frames, so the
+// estimates stay deterministic under the lock-stepped test harnesses.
+//
+// Pure data structure — knows nothing about Game or the wire format.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace rollback {
+
+struct TimeSyncMessage {
+  uint16_t seq = 0;
+  // Last seq received from the peer; 0 = none yet.
+  uint16_t echo_seq = 0;
+  // Ticks between receiving echo_seq and sending this message.
+  uint8_t echo_hold = 0;
+  // Sender's estimate of how far its sim is ahead of the receiver's,
+  // in 1/16 frames.
+  int16_t lead_q4 = 0;
+  // Input delay the sender would like to use.
+  uint8_t input_delay = 0;
+};
+
+// Event counts bucketed by size; the last bucket collects everything
+// larger.
+struct Histogram {
+  static constexpr std::size_t kBuckets = 16;
+
+  void Add(uint32_t value) { ++counts[std::min<std::size_t>(value, kBuckets - 1)]; }
+  uint64_t Total() const {
+    uint64_t total = 0;
+    for (uint64_t const kC : counts) {
+      total += kC;
+    }
+    return total;
+  }
+
+  std::array<uint64_t, kBuckets> counts{};
+};
+
+class TimeSync {
+ public:
+  // ~10 messages a second at 70 Hz.
+  static constexpr uint32_t kInterval = 7;
+  // Nominal frame period, matching Gfx::Flip's pacing.
+  static constexpr int kFrameMs = 14;
+  // Most a single frame is stretched by; keeps the slowdown under ~15%.
+  static constexpr int kMaxStretchMs = 2;
+  // Imbalances under this many frames are noise and left alone.
+  static constexpr float kDeadZone = 0.5F;
+  // Predicted frames we are willing to run on before adding input delay.
+  static constexpr float kPredictionBudget = 3.0F;
+
+  // Advances the tick clock. Returns true when a message is due.
+  bool Tick() {
+    ++tick_;
+    return tick_ - last_send_tick_ >= kInterval;
+  }
+
+  uint32_t Now() const { return tick_; }
+
+  TimeSyncMessage MakeMessage(float local_lead, uint8_t input_delay) {
+    last_send_tick_ = tick_;
+    seq_ = static_cast<uint16_t>(seq_ + 1 == 0 ? 1 : seq_ + 1);
+    send_ticks_[seq_ % kSendRing] = {.seq = seq_, .tick = tick_};
+    local_lead_ = Smooth(local_lead_, local_lead);
+    TimeSyncMessage msg;
+    msg.seq = seq_;
+    msg.echo_seq = last_recv_seq_;
+    msg.echo_hold = static_cast<uint8_t>(std::min<uint32_t>(tick_ - last_recv_tick_, 255));
+    msg.lead_q4 = static_cast<int16_t>(std::clamp(std::lround(local_lead * 16.0F), -32768L, 32767L));
+    msg.input_delay = input_delay;
+    return msg;
+  }
+
+  void OnMessage(TimeSyncMessage const& msg) {
+    // Drop duplicates and anything reordered behind a newer message.
+    if (msg.seq == 0 ||
+        (last_recv_seq_ != 0 && static_cast<int16_t>(msg.seq - last_recv_seq_) <= 0)) {
+      return;
+    }
+    last_recv_seq_ = msg.seq;
+    last_recv_tick_ = tick_;
+
+    SendRecord const& sent = send_ticks_[msg.echo_seq % kSendRing];
+    if (msg.echo_seq != 0 && sent.seq == msg.echo_seq) {
+      uint32_t const kElapsed = tick_ - sent.tick;
+      float const kSample =
+          kElapsed > msg.echo_hold ? static_cast<float>(kElapsed - msg.echo_hold) : 0.0F;
+      if (!has_rtt_) {
+        srtt_ = kSample;
+        rttvar_ = kSample / 2.0F;
+        has_rtt_ = true;
+      } else {
+        rttvar_ += (std::fabs(srtt_ - kSample) - rttvar_) / 4.0F;
+        srtt_ += (kSample - srtt_) / 8.0F;
+      }
+    }
+
+    remote_lead_ = Smooth(remote_lead_, static_cast<float>(msg.lead_q4) / 16.0F);
+    remote_delay_ = msg.input_delay;
+    has_remote_ = true;
+
+    // The leading peer sees a positive imbalance and owes that many
+    // frames of slowdown; the trailing peer sees a negative one and
+    // leaves it to the leader.
+    float const kImbalance = Imbalance();
+    stretch_debt_ms_ = kImbalance > kDeadZone ? kImbalance * static_cast<float>(kFrameMs) : 0.0F;
+  }
+
+  // Milliseconds to add to the current frame. Call once per displayed
+  // frame; pays down the outstanding debt kMaxStretchMs at a time.
+  int TakeStretchMs() {
+    if (stretch_debt_ms_ < 1.0F) {
+      return 0;
+    }
+    int const kMs = std::min(kMaxStretchMs, static_cast<int>(stretch_debt_ms_));
+    stretch_debt_ms_ -= static_cast<float>(kMs);
+    return kMs;
+  }
+
+  // Input delay this peer would like for the current link: enough to
+  // cover the one-way trip plus two deviations, minus what prediction
+  // is allowed to cover, clamped to [floor, ceiling].
+  uint32_t DesiredDelay(uint32_t floor, uint32_t ceiling) const {
+    if (!has_rtt_) {
+      return floor;
+    }
+    float const kNeed = std::ceil((srtt_ / 2.0F) + (2.0F * rttvar_) - kPredictionBudget);
+    auto const kDelay = static_cast<uint32_t>(std::max(kNeed, 0.0F));
+    return std::clamp(kDelay, floor, ceiling);
+  }
+
+  // Both peers take the larger of the two proposals, so they agree.
+  uint32_t AgreedDelay(uint32_t floor, uint32_t ceiling) const {
+    uint32_t const kLocal = DesiredDelay(floor, ceiling);
+    if (!has_remote_) {
+      return kLocal;
+    }
+    return std::clamp(std::max<uint32_t>(kLocal, remote_delay_), floor, ceiling);
+  }
+
+  bool HasRtt() const { return has_rtt_; }
+  // Smoothed round-trip time and its mean deviation, in ticks.
+  float RttTicks() const { return srtt_; }
+  float JitterTicks() const { return rttvar_; }
+  float OneWayTicks() const { return srtt_ / 2.0F; }
+  // Positive when we are ahead of the peer, in frames.
+  float Imbalance() const { return has_remote_ ? (local_lead_ - remote_lead_) / 2.0F : 0.0F; }
+
+ private:
+  static constexpr std::size_t kSendRing = 16;
+
+  struct SendRecord {
+    uint16_t seq = 0;
+    uint32_t tick = 0;
+  };
+
+  static float Smooth(float avg, float sample) { return avg + ((sample - avg) / 4.0F); }
+
+  uint32_t tick_ = 0;
+  uint32_t last_send_tick_ = 0;
+  uint16_t seq_ = 0;
+  std::array<SendRecord, kSendRing> send_ticks_{};
+
+  uint16_t last_recv_seq_ = 0;
+  uint32_t last_recv_tick_ = 0;
+
+  bool has_rtt_ = false;
+  float srtt_ = 0.0F;
+  float rttvar_ = 0.0F;
+
+  float local_lead_ = 0.0F;
+  float remote_lead_ = 0.0F;
+  uint8_t remote_delay_ = 0;
+  bool has_remote_ = false;
+
+  float stretch_debt_ms_ = 0.0F;
+};
+
+}  // namespace rollback
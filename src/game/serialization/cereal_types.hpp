@@ -490,7 +490,5 @@ void load(Archive& ar, Game& game) {
   // Rebuild materials from material_id + Common (materials are not serialized —
   // they're derived from level.material_id and the material table in Common).
   game.level.materials.resize(game.level.width * game.level.height);
-  for (std::size_t i = 0; i < game.level.material_id.size(); ++i) {
-    game.level.materials[i] = game.common->materials[game.level.material_id[i]];
-  }
+  game.level.RebuildMaterials(*game.common);
 }
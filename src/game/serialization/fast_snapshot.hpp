@@ -156,16 +156,29 @@ struct GameSnapshot {
   std::vector<BObject> bobjects_arr;
   std::size_t bobjects_count = 0;
 
-  // Level material_id bytes.  On the first save to this slot a full copy of
-  // the live level is written; only dirty cells are overwritten on each
-  // subsequent save to the same slot.
+  // How the level layers are held. kFull keeps a whole W×H copy per slot,
+  // which restores with a single memcpy; kDelta keeps only the values of
+  // the cells in Level::delta_list, so a slot costs as much as has been dug
+  // since the last confirmed rebase rather than the size of the map.
+  // RollbackBuffer::Prepare picks the layout against its memory budget.
+  enum class LevelStorage : uint8_t {
+    kFull,
+    kDelta,
+  };
+  LevelStorage level_storage = LevelStorage::kFull;
+
+  // kFull: level material_id bytes.  On the first save to this slot a full
+  // copy of the live level is written; only dirty cells are overwritten on
+  // each subsequent save to the same slot.
+  // kDelta: level_data[i] is the material_id of delta_list[i] at save time;
+  // cells dirtied after the save are restored from
+  // Level::delta_base_material_id.
   // level_materials is omitted: it is always derivable as
   //   common.materials[material_id[i]]
   // and is recomputed on restore (see Game::LoadSnapshotFast).
   std::vector<uint8_t> level_data;
   // display_valid is snapshotted because terrain destruction zeroes it.
-  // First save to this slot copies the full live array; dirty cells are
-  // overwritten on each subsequent save to the same slot.
+  // Laid out like level_data for the slot's LevelStorage.
   // display_data is static (never written during simulation) and intentionally
   // omitted here — omitting 64 MB/slot (4096² ARGB) keeps the ring buffer
   // from bloating to ~500 MB for large levels.
@@ -173,6 +186,10 @@ struct GameSnapshot {
 
   uint32_t checksum = 0;
 
+  // kDelta: Level::delta_epoch at the save. Game::RebaseLevelDelta
+  // re-expresses the slots it is given and stamps them with the new epoch.
+  uint32_t delta_epoch = 0;
+
   // True after the first SaveSnapshotFast call to this slot.  Until then the
   // level_data / level_display_valid buffers are allocated but contain
   // uninitialised data; SaveSnapshotFast uses this flag to trigger a one-time
@@ -183,16 +200,34 @@ struct GameSnapshot {
   // write directly without reallocating.  Intentionally does NOT copy level
   // data — that copy is deferred to the first SaveSnapshotFast call so that
   // initialising all ring-buffer slots during weapon-selection setup does not
-  // block the main loop with a large upfront memcpy.
+  // block the main loop with a large upfront memcpy.  kDelta slots start
+  // empty, with room for Level::kDeltaReserveCells cells.
   // Call once after the level is generated, before the first SaveSnapshotFast.
-  void Prepare(Game const& game) {
+  void Prepare(Game const& game, LevelStorage storage = LevelStorage::kFull) {
     bobjects_arr.resize(game.bobjects.limit);
-    std::size_t const kCells =
-        static_cast<std::size_t>(game.level.width) * static_cast<std::size_t>(game.level.height);
-    level_data.resize(kCells);
-    if (!game.level.display_data.empty()) {
-      level_display_valid.resize(kCells);
+    level_storage = storage;
+    if (storage == LevelStorage::kDelta) {
+      level_data.clear();
+      level_display_valid.clear();
+      level_data.reserve(Level::kDeltaReserveCells);
+      if (!game.level.display_data.empty()) {
+        level_display_valid.reserve(Level::kDeltaReserveCells);
+      }
+    } else {
+      std::size_t const kCells = static_cast<std::size_t>(game.level.width) *
+                                 static_cast<std::size_t>(game.level.height);
+      level_data.resize(kCells);
+      if (!game.level.display_data.empty()) {
+        level_display_valid.resize(kCells);
+      }
     }
     initialized = false;
   }
+
+  // Bytes of level layers a kFull slot holds for `level`.
+  static std::size_t FullLevelBytes(Level const& level) {
+    std::size_t const kCells =
+        static_cast<std::size_t>(level.width) * static_cast<std::size_t>(level.height);
+    return level.display_data.empty() ? kCells : 2 * kCells;
+  }
 };
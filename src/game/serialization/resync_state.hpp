@@ -0,0 +1,337 @@
+#pragma once
+
+// Authoritative state the host hands the client to recover from a desync
+// (see RollbackController::ExportResyncState and NetSession::OnDesync).
+//
+// Carries the sim fields of one rollback slot's GameSnapshot, written with
+// the cereal glue from snapshot.hpp so the Worm* / Weapon const* /
+// WormWeapon* pointers travel as indices, plus the level as the cells that
+// differ from the level both peers started the match with
+// (Level::dirty_base_*). The base itself never goes over the wire; its
+// digest does, so a client that started from a different map rejects the
+// state instead of adopting half of it.
+
+#include "cereal_types.hpp"
+#include "fast_snapshot.hpp"
+#include "snapshot.hpp"
+
+#include "game.hpp"
+#include "level.hpp"
+#include "stateHash.hpp"
+
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/cereal.hpp>
+#include <cereal/types/vector.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Bump on any change to the layout below. Carried in the blob, so a peer
+// with a different layout fails the load rather than misreading it.
+inline constexpr uint32_t kResyncStateVersion = 1;
+
+struct ResyncHeader {
+  uint32_t frame = 0;
+  // Inputs that produced `frame`, by worm index.
+  std::array<uint8_t, 2> inputs{};
+  // HashGameComponents on the sender at `frame`, for the desync log.
+  ComponentHashes hashes{};
+  int32_t width = 0;
+  int32_t height = 0;
+  uint64_t base_digest = 0;
+};
+
+// One level cell that differs from the match's starting level.
+struct ResyncCell {
+  uint32_t idx = 0;
+  uint8_t material = 0;
+  uint8_t display_valid = 0;
+};
+
+template <class Archive>
+void serialize(Archive& ar, ComponentHashes& c) {
+  ar(cereal::make_nvp("rng", c.rng), cereal::make_nvp("level", c.level),
+     cereal::make_nvp("worm0", c.worms[0]), cereal::make_nvp("worm1", c.worms[1]),
+     cereal::make_nvp("bobjects", c.bobjects), cereal::make_nvp("bonuses", c.bonuses),
+     cereal::make_nvp("sobjects", c.sobjects), cereal::make_nvp("nobjects", c.nobjects),
+     cereal::make_nvp("wobjects", c.wobjects));
+}
+
+template <class Archive>
+void serialize(Archive& ar, ResyncHeader& h) {
+  ar(cereal::make_nvp("frame", h.frame), cereal::make_nvp("input0", h.inputs[0]),
+     cereal::make_nvp("input1", h.inputs[1]), cereal::make_nvp("hashes", h.hashes),
+     cereal::make_nvp("width", h.width), cereal::make_nvp("height", h.height),
+     cereal::make_nvp("baseDigest", h.base_digest));
+}
+
+template <class Archive>
+void serialize(Archive& ar, ResyncCell& c) {
+  ar(cereal::make_nvp("idx", c.idx), cereal::make_nvp("m", c.material),
+     cereal::make_nvp("dv", c.display_valid));
+}
+
+// ---- WormSimState ----
+// Same fields as the Worm serializer in cereal_types.hpp plus the steering
+// sums. ninjarope.anchor and weapons[].type are context-dependent and
+// written by the Save/LoadSnapshotSimState pair below.
+template <class Archive>
+void serialize(Archive& ar, WormSimState& s) {
+  ar(cereal::make_nvp("pos", s.pos), cereal::make_nvp("vel", s.vel),
+     cereal::make_nvp("logicRespawn", s.logic_respawn), cereal::make_nvp("hotspotX", s.hotspot_x),
+     cereal::make_nvp("hotspotY", s.hotspot_y), cereal::make_nvp("aimingAngle", s.aiming_angle),
+     cereal::make_nvp("aimingSpeed", s.aiming_speed),
+     cereal::make_nvp("ableToJump", s.able_to_jump), cereal::make_nvp("ableToDig", s.able_to_dig),
+     cereal::make_nvp("keyChangePressed", s.key_change_pressed),
+     cereal::make_nvp("movable", s.movable), cereal::make_nvp("animate", s.animate),
+     cereal::make_nvp("visible", s.visible), cereal::make_nvp("ready", s.ready),
+     cereal::make_nvp("flag", s.flag), cereal::make_nvp("makeSightGreen", s.make_sight_green),
+     cereal::make_nvp("health", s.health), cereal::make_nvp("lives", s.lives),
+     cereal::make_nvp("kills", s.kills), cereal::make_nvp("timer", s.timer),
+     cereal::make_nvp("killedTimer", s.killed_timer),
+     cereal::make_nvp("currentFrame", s.current_frame), cereal::make_nvp("flags", s.flags),
+     cereal::make_nvp("ninjarope", s.ninjarope),
+     cereal::make_nvp("currentWeapon", s.current_weapon),
+     cereal::make_nvp("lastKilledByIdx", s.last_killed_by_idx),
+     cereal::make_nvp("fireCone", s.fire_cone),
+     cereal::make_nvp("leaveShellTimer", s.leave_shell_timer), cereal::make_nvp("index", s.index),
+     cereal::make_nvp("direction", s.direction),
+     cereal::make_nvp("controlStates", s.control_states),
+     cereal::make_nvp("prevControlStates", s.prev_control_states),
+     cereal::make_nvp("steerableSumX", s.steerable_sum_x),
+     cereal::make_nvp("steerableSumY", s.steerable_sum_y),
+     cereal::make_nvp("steerableCount", s.steerable_count));
+  for (int i = 0; i < 4; ++i) {
+    ar(cereal::make_nvp("react" + std::to_string(i), s.reacts[i]));
+  }
+  for (int i = 0; i < NUM_WEAPONS; ++i) {
+    ar(cereal::make_nvp("weapon" + std::to_string(i), s.weapons[i]));
+  }
+}
+
+// ---- GameSnapshot sim fields ----
+// Everything SaveSnapshotFast writes except the level layers. `game` is
+// the Game the snapshot belongs to; it resolves pointers to indices on
+// save and back on load.
+template <class Archive>
+void SaveSnapshotSimState(Archive& ar, Game const& game, GameSnapshot const& snap) {
+  ar(cereal::make_nvp("rand", const_cast<Rand&>(snap.rand)),
+     cereal::make_nvp("cycles", snap.cycles), cereal::make_nvp("screenFlash", snap.screen_flash),
+     cereal::make_nvp("lastKilledIdx", snap.last_killed_idx),
+     cereal::make_nvp("gotChanged", snap.got_changed),
+     cereal::make_nvp("holdazone", const_cast<Holdazone&>(snap.holdazone)));
+
+  for (WormSimState const& s : snap.worms) {
+    ar(cereal::make_nvp("worm", const_cast<WormSimState&>(s)));
+    int32_t anchor_idx = -1;
+    for (std::size_t i = 0; i < game.worms.size(); ++i) {
+      if (game.worms[i].get() == s.ninjarope.anchor) {
+        anchor_idx = static_cast<int32_t>(i);
+        break;
+      }
+    }
+    ar(cereal::make_nvp("anchorIdx", anchor_idx));
+    for (int i = 0; i < NUM_WEAPONS; ++i) {
+      int32_t weap_idx = s.weapons[i].type
+                             ? static_cast<int32_t>(s.weapons[i].type - game.common->weapons.data())
+                             : -1;
+      ar(cereal::make_nvp("weapIdx" + std::to_string(i), weap_idx));
+    }
+  }
+
+  ar(cereal::make_nvp("bonuses", const_cast<Game::BonusList&>(snap.bonuses)));
+  ar(cereal::make_nvp("sobjects", const_cast<Game::SObjectList&>(snap.sobjects)));
+  SaveNObjects(ar, game, snap.nobjects);
+  SaveWObjects(ar, game, snap.wobjects);
+
+  auto count = static_cast<uint32_t>(snap.bobjects_count);
+  ar(cereal::make_nvp("bobjectCount", count));
+  for (uint32_t i = 0; i < count; ++i) {
+    ar(cereal::make_nvp("e", const_cast<BObject&>(snap.bobjects_arr[i])));
+  }
+}
+
+// Returns false if the blob doesn't fit `game` (object counts or indices
+// out of range); the typed pools throw cereal::Exception for theirs.
+template <class Archive>
+bool LoadSnapshotSimState(Archive& ar, Game& game, GameSnapshot& snap) {
+  ar(cereal::make_nvp("rand", snap.rand), cereal::make_nvp("cycles", snap.cycles),
+     cereal::make_nvp("screenFlash", snap.screen_flash),
+     cereal::make_nvp("lastKilledIdx", snap.last_killed_idx),
+     cereal::make_nvp("gotChanged", snap.got_changed),
+     cereal::make_nvp("holdazone", snap.holdazone));
+
+  auto const kWeaponCount = static_cast<int32_t>(game.common->weapons.size());
+  for (WormSimState& s : snap.worms) {
+    ar(cereal::make_nvp("worm", s));
+    int32_t anchor_idx = -1;
+    ar(cereal::make_nvp("anchorIdx", anchor_idx));
+    if (anchor_idx >= static_cast<int32_t>(game.worms.size())) {
+      return false;
+    }
+    s.ninjarope.anchor = anchor_idx >= 0 ? game.worms[anchor_idx].get() : nullptr;
+    for (int i = 0; i < NUM_WEAPONS; ++i) {
+      int32_t weap_idx = 0;
+      ar(cereal::make_nvp("weapIdx" + std::to_string(i), weap_idx));
+      if (weap_idx >= kWeaponCount) {
+        return false;
+      }
+      s.weapons[i].type = weap_idx >= 0 ? &game.common->weapons[weap_idx] : nullptr;
+    }
+  }
+
+  ar(cereal::make_nvp("bonuses", snap.bonuses));
+  ar(cereal::make_nvp("sobjects", snap.sobjects));
+  auto const kSObjectTypes = static_cast<int>(game.common->sobject_types.size());
+  for (Bonus const& b : snap.bonuses.arr) {
+    if (b.used && (b.frame < 0 || b.frame >= NUM_BONUS_SOBJECTS || b.weapon < 0 ||
+                   b.weapon >= kWeaponCount)) {
+      return false;
+    }
+  }
+  for (SObject const& o : snap.sobjects.arr) {
+    if (o.used && (o.id < 0 || o.id >= kSObjectTypes)) {
+      return false;
+    }
+  }
+  LoadNObjects(ar, game, snap.nobjects);
+  LoadWObjects(ar, game, snap.wobjects);
+
+  uint32_t count = 0;
+  ar(cereal::make_nvp("bobjectCount", count));
+  if (count > game.bobjects.limit) {
+    return false;
+  }
+  snap.bobjects_arr.resize(game.bobjects.limit);
+  snap.bobjects_count = count;
+  for (uint32_t i = 0; i < count; ++i) {
+    ar(cereal::make_nvp("e", snap.bobjects_arr[i]));
+  }
+  return true;
+}
+
+// Cells of `level` that differ from the match's base (dirty_base_*) as of
+// the save into `snap`. kFull slots are indexed by cell and only the cells
+// in dirty_list can differ. kDelta slots hold delta_list[k] at
+// level_data[k]; every other cell held its delta base value at the save,
+// and the delta base itself has moved away from the match's base, so the
+// rest of the map is compared as well. That scan is O(cells), which a
+// resync (rare, and already sending a whole state) can afford.
+inline void CollectResyncCells(GameSnapshot const& snap, Level const& level,
+                               std::vector<ResyncCell>& out) {
+  out.clear();
+  bool const kHasDv = !level.dirty_base_display_valid.empty();
+  auto put = [&](std::size_t idx, uint8_t mat, uint8_t dv) {
+    uint8_t const kBaseMat = level.dirty_base_material_id[idx];
+    uint8_t const kBaseDv = kHasDv ? level.dirty_base_display_valid[idx] : 0;
+    if (mat != kBaseMat || dv != kBaseDv) {
+      out.push_back({.idx = static_cast<uint32_t>(idx), .material = mat, .display_valid = dv});
+    }
+  };
+  if (snap.level_storage != GameSnapshot::LevelStorage::kDelta) {
+    for (int32_t const kCell : level.dirty_list) {
+      auto const kIdx = static_cast<std::size_t>(kCell);
+      uint8_t const kBaseMat = level.dirty_base_material_id[kIdx];
+      uint8_t const kBaseDv = kHasDv ? level.dirty_base_display_valid[kIdx] : 0;
+      uint8_t const kMat = kIdx < snap.level_data.size() ? snap.level_data[kIdx] : kBaseMat;
+      uint8_t const kDv = kHasDv && kIdx < snap.level_display_valid.size()
+                              ? snap.level_display_valid[kIdx]
+                              : kBaseDv;
+      put(kIdx, kMat, kDv);
+    }
+    return;
+  }
+  bool const kDeltaHasDv = kHasDv && !level.delta_base_display_valid.empty();
+  auto base_dv = [&](std::size_t idx) -> uint8_t {
+    return kDeltaHasDv ? level.delta_base_display_valid[idx] : 0;
+  };
+  for (std::size_t k = 0; k < level.delta_list.size(); ++k) {
+    auto const kIdx = static_cast<std::size_t>(level.delta_list[k]);
+    if (k < snap.level_data.size()) {
+      uint8_t const kDv = kHasDv && k < snap.level_display_valid.size()
+                              ? snap.level_display_valid[k]
+                              : base_dv(kIdx);
+      put(kIdx, snap.level_data[k], kDv);
+    } else {
+      put(kIdx, level.delta_base_material_id[kIdx], base_dv(kIdx));
+    }
+  }
+  for (std::size_t i = 0; i < level.delta_bits.size(); ++i) {
+    if (!level.delta_bits[i]) {
+      put(i, level.delta_base_material_id[i], base_dv(i));
+    }
+  }
+}
+
+// `snap` was saved from `game`, whose level has dirty tracking running.
+// `header.base_digest` / width / height are filled in here.
+inline void SaveResyncState(std::vector<uint8_t>& out, Game const& game, ResyncHeader header,
+                            GameSnapshot const& snap) {
+  header.width = game.level.width;
+  header.height = game.level.height;
+  header.base_digest = game.level.dirty_base_digest;
+  std::vector<ResyncCell> cells;
+  CollectResyncCells(snap, game.level, cells);
+
+  std::ostringstream ss(std::ios::binary);
+  {
+    cereal::PortableBinaryOutputArchive ar(ss);
+    uint32_t version = kResyncStateVersion;
+    ar(cereal::make_nvp("version", version), cereal::make_nvp("header", header));
+    SaveSnapshotSimState(ar, game, snap);
+    ar(cereal::make_nvp("cells", cells));
+  }
+  std::string const& buf = ss.str();
+  out.assign(buf.begin(), buf.end());
+}
+
+// Fills `snap`'s sim fields and `cells`; leaves `snap`'s level layers
+// alone. False on a version mismatch, a truncated or malformed blob, or a
+// level that doesn't match `game`'s dimensions. The blob comes from the
+// peer, so every index is checked before it is used and the cell count is
+// checked before anything is allocated for it.
+inline bool LoadResyncState(uint8_t const* data, std::size_t len, Game& game,
+                            ResyncHeader& header, GameSnapshot& snap,
+                            std::vector<ResyncCell>& cells) {
+  std::size_t const kCells =
+      static_cast<std::size_t>(game.level.width) * static_cast<std::size_t>(game.level.height);
+  std::string buf(reinterpret_cast<char const*>(data), len);
+  std::istringstream ss(std::move(buf), std::ios::binary);
+  try {
+    cereal::PortableBinaryInputArchive ar(ss);
+    uint32_t version = 0;
+    ar(cereal::make_nvp("version", version));
+    if (version != kResyncStateVersion) {
+      return false;
+    }
+    ar(cereal::make_nvp("header", header));
+    if (header.width != game.level.width || header.height != game.level.height) {
+      return false;
+    }
+    if (!LoadSnapshotSimState(ar, game, snap)) {
+      return false;
+    }
+    // Same layout as cereal's vector load, with the count capped first.
+    cereal::size_type count = 0;
+    ar(cereal::make_size_tag(count));
+    if (count > kCells) {
+      return false;
+    }
+    cells.resize(static_cast<std::size_t>(count));
+    for (ResyncCell& c : cells) {
+      ar(c);
+    }
+  } catch (std::exception const&) {
+    return false;
+  }
+  for (ResyncCell const& c : cells) {
+    if (c.idx >= kCells) {
+      return false;
+    }
+  }
+  return true;
+}
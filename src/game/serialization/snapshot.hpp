@@ -99,7 +99,7 @@ inline WormWeapon* DecodeFiredBy(Game& game, FiredByRef ref) {
   if (ref.worm_idx < 0 || ref.slot < 0) {
     return nullptr;
   }
-  if (static_cast<std::size_t>(ref.worm_idx) >= game.worms.size()) {
+  if (static_cast<std::size_t>(ref.worm_idx) >= game.worms.size() || ref.slot >= NUM_WEAPONS) {
     return nullptr;
   }
   return &game.worms[ref.worm_idx]->weapons[ref.slot];
@@ -170,6 +170,92 @@ void load(Archive& ar, FastObjectList<T>& list) {
   }
 }
 
+// ---- Typed pools (NObject / WObject) ----
+// Per slot { used, [scalars, typeIdx, firedBy if used] }. Take the list
+// separately from the Game that resolves the pointers, so a pool held in
+// a GameSnapshot goes through the same code as the live one. A type index
+// or firedBy slot past the end of its table throws cereal::Exception.
+template <class Archive>
+void SaveNObjects(Archive& ar, Game const& game, Game::NObjectList const& list) {
+  for (int i = 0; i < 600; ++i) {
+    NObject const& n = list.arr[i];
+    ar(cereal::make_nvp("u", n.used));
+    if (n.used) {
+      SerializeNObjectScalars(ar, const_cast<NObject&>(n));
+      int32_t type_idx =
+          n.type ? static_cast<int32_t>(n.type - game.common->nobject_types.data()) : -1;
+      FiredByRef fb = EncodeFiredBy(game, n.fired_by);
+      ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
+    }
+  }
+}
+
+template <class Archive>
+void SaveWObjects(Archive& ar, Game const& game, Game::WObjectList const& list) {
+  for (int i = 0; i < 600; ++i) {
+    WObject const& w = list.arr[i];
+    ar(cereal::make_nvp("u", w.used));
+    if (w.used) {
+      SerializeWObjectScalars(ar, const_cast<WObject&>(w));
+      int32_t type_idx = w.type ? static_cast<int32_t>(w.type - game.common->weapons.data()) : -1;
+      FiredByRef fb = EncodeFiredBy(game, w.fired_by);
+      ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
+    }
+  }
+}
+
+template <class Archive>
+void LoadNObjects(Archive& ar, Game& game, Game::NObjectList& list) {
+  list.Clear();
+  for (int i = 0; i < 600; ++i) {
+    bool used = false;
+    ar(cereal::make_nvp("u", used));
+    if (used) {
+      NObject& n = list.arr[i];
+      SerializeNObjectScalars(ar, n);
+      n.used = true;
+      list.free_list[static_cast<uint32_t>(i) >> 5] &=
+          ~(static_cast<uint32_t>(1) << (static_cast<uint32_t>(i) & 31));
+      ++list.count;
+      int32_t type_idx = 0;
+      FiredByRef fb;
+      ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
+      if (type_idx >= static_cast<int32_t>(game.common->nobject_types.size()) ||
+          fb.slot >= NUM_WEAPONS) {
+        throw cereal::Exception("nobject type or firedBy out of range");
+      }
+      n.type = (type_idx >= 0) ? &game.common->nobject_types[type_idx] : nullptr;
+      n.fired_by = DecodeFiredBy(game, fb);
+    }
+  }
+}
+
+template <class Archive>
+void LoadWObjects(Archive& ar, Game& game, Game::WObjectList& list) {
+  list.Clear();
+  for (int i = 0; i < 600; ++i) {
+    bool used = false;
+    ar(cereal::make_nvp("u", used));
+    if (used) {
+      WObject& w = list.arr[i];
+      SerializeWObjectScalars(ar, w);
+      w.used = true;
+      list.free_list[static_cast<uint32_t>(i) >> 5] &=
+          ~(static_cast<uint32_t>(1) << (static_cast<uint32_t>(i) & 31));
+      ++list.count;
+      int32_t type_idx = 0;
+      FiredByRef fb;
+      ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
+      if (type_idx >= static_cast<int32_t>(game.common->weapons.size()) ||
+          fb.slot >= NUM_WEAPONS) {
+        throw cereal::Exception("wobject type or firedBy out of range");
+      }
+      w.type = (type_idx >= 0) ? &game.common->weapons[type_idx] : nullptr;
+      w.fired_by = DecodeFiredBy(game, fb);
+    }
+  }
+}
+
 // ---- Snapshot save/load for Game ----
 //
 // Composes the existing Game save/load (cereal_types.hpp) with the extra
@@ -185,36 +271,9 @@ void SaveGameSnapshot(Archive& ar, Game const& game) {
   ar(cereal::make_nvp("bonuses", const_cast<Game::BonusList&>(game.bonuses)));
   ar(cereal::make_nvp("sobjects", const_cast<Game::SObjectList&>(game.sobjects)));
 
-  // NObjects: store scalar fields per slot, with type index + firedBy ref.
-  {
-    auto const& list = game.nobjects;
-    for (int i = 0; i < 600; ++i) {
-      NObject const& n = list.arr[i];
-      ar(cereal::make_nvp("u", n.used));
-      if (n.used) {
-        SerializeNObjectScalars(ar, const_cast<NObject&>(n));
-        int32_t type_idx =
-            n.type ? static_cast<int32_t>(n.type - game.common->nobject_types.data()) : -1;
-        FiredByRef fb = EncodeFiredBy(game, n.fired_by);
-        ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
-      }
-    }
-  }
-
-  // WObjects: same shape.
-  {
-    auto const& list = game.wobjects;
-    for (int i = 0; i < 600; ++i) {
-      WObject const& w = list.arr[i];
-      ar(cereal::make_nvp("u", w.used));
-      if (w.used) {
-        SerializeWObjectScalars(ar, const_cast<WObject&>(w));
-        int32_t type_idx = w.type ? static_cast<int32_t>(w.type - game.common->weapons.data()) : -1;
-        FiredByRef fb = EncodeFiredBy(game, w.fired_by);
-        ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
-      }
-    }
-  }
+  // NObjects / WObjects: scalar fields per slot, with type index + firedBy ref.
+  SaveNObjects(ar, game, game.nobjects);
+  SaveWObjects(ar, game, game.wobjects);
 
   // Blood particles.
   ar(cereal::make_nvp("bobjects", const_cast<Game::BObjectList&>(game.bobjects)));
@@ -229,51 +288,8 @@ void LoadGameSnapshot(Archive& ar, Game& game) {
   ar(cereal::make_nvp("bonuses", game.bonuses));
   ar(cereal::make_nvp("sobjects", game.sobjects));
 
-  // NObjects
-  {
-    auto& list = game.nobjects;
-    list.Clear();
-    for (int i = 0; i < 600; ++i) {
-      bool used = false;
-      ar(cereal::make_nvp("u", used));
-      if (used) {
-        NObject& n = list.arr[i];
-        SerializeNObjectScalars(ar, n);
-        n.used = true;
-        list.free_list[static_cast<uint32_t>(i) >> 5] &=
-            ~(static_cast<uint32_t>(1) << (static_cast<uint32_t>(i) & 31));
-        ++list.count;
-        int32_t type_idx = 0;
-        FiredByRef fb;
-        ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
-        n.type = (type_idx >= 0) ? &game.common->nobject_types[type_idx] : nullptr;
-        n.fired_by = DecodeFiredBy(game, fb);
-      }
-    }
-  }
-
-  // WObjects
-  {
-    auto& list = game.wobjects;
-    list.Clear();
-    for (int i = 0; i < 600; ++i) {
-      bool used = false;
-      ar(cereal::make_nvp("u", used));
-      if (used) {
-        WObject& w = list.arr[i];
-        SerializeWObjectScalars(ar, w);
-        w.used = true;
-        list.free_list[static_cast<uint32_t>(i) >> 5] &=
-            ~(static_cast<uint32_t>(1) << (static_cast<uint32_t>(i) & 31));
-        ++list.count;
-        int32_t type_idx = 0;
-        FiredByRef fb;
-        ar(cereal::make_nvp("typeIdx", type_idx), cereal::make_nvp("firedBy", fb));
-        w.type = (type_idx >= 0) ? &game.common->weapons[type_idx] : nullptr;
-        w.fired_by = DecodeFiredBy(game, fb);
-      }
-    }
-  }
+  LoadNObjects(ar, game, game.nobjects);
+  LoadWObjects(ar, game, game.wobjects);
 
   ar(cereal::make_nvp("bobjects", game.bobjects));
 }
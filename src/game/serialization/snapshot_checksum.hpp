@@ -0,0 +1,233 @@
+#pragma once
+
+// Per-frame desync checksum for rollback play, computed from a GameSnapshot
+// right after SaveSnapshotFast filled it.
+//
+// Sim fields are packed into a flat word buffer in a fixed order and
+// hashed with one XXH3 call. Object pools are walked slot by slot and only
+// live slots (ExactObjectListBase::used) contribute, together with their
+// slot index: the sim iterates pools in slot order, so layout divergence
+// matters even when the set of objects agrees. Pointers are folded in as
+// the ids / worm indices they refer to, never as addresses.
+//
+// The level is covered by Level::CellDigest summed over every cell. The
+// base sum is taken when tracking starts (and moved along with the delta
+// base); per frame only the listed cells have their term swapped for the
+// value the snapshot holds, so the cost follows how much has been dug
+// rather than the map size. The sum does not depend on list order or on
+// cells that were dug in a mispredicted branch and put back, both of which
+// differ between peers.
+//
+// Replays keep using WideRollbackChecksum: their stored checksums are part
+// of the on-disk format.
+
+#include <xxhash.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "level.hpp"
+#include "serialization/fast_snapshot.hpp"
+
+// Bump when the fields hashed below or their order change. Peers compare
+// these checksums frame by frame, so any bump must come with a
+// NetTransport::kProtocolVersion bump.
+inline constexpr uint32_t kSnapshotChecksumVersion = 1;
+
+namespace snapshot_checksum_detail {
+
+struct Words {
+  std::vector<uint32_t> buf;
+
+  void Put(int32_t v) { buf.push_back(static_cast<uint32_t>(v)); }
+  void Put(uint32_t v) { buf.push_back(v); }
+  void Put(bool v) { buf.push_back(v ? 1U : 0U); }
+  void Put(IVec2 v) {
+    Put(v.x);
+    Put(v.y);
+  }
+  void Put(uint64_t v) {
+    Put(static_cast<uint32_t>(v));
+    Put(static_cast<uint32_t>(v >> 32));
+  }
+};
+
+inline void PutWorm(Words& w, WormSimState const& s) {
+  w.Put(s.pos);
+  w.Put(s.vel);
+  w.Put(s.logic_respawn);
+  w.Put(s.hotspot_x);
+  w.Put(s.hotspot_y);
+  w.Put(s.aiming_angle);
+  w.Put(s.aiming_speed);
+  w.Put(static_cast<uint32_t>(s.able_to_jump) | (static_cast<uint32_t>(s.able_to_dig) << 1) |
+        (static_cast<uint32_t>(s.key_change_pressed) << 2) |
+        (static_cast<uint32_t>(s.movable) << 3) | (static_cast<uint32_t>(s.animate) << 4) |
+        (static_cast<uint32_t>(s.visible) << 5) | (static_cast<uint32_t>(s.ready) << 6) |
+        (static_cast<uint32_t>(s.flag) << 7) | (static_cast<uint32_t>(s.make_sight_green) << 8));
+  w.Put(s.health);
+  w.Put(s.lives);
+  w.Put(s.kills);
+  w.Put(s.timer);
+  w.Put(s.killed_timer);
+  w.Put(s.current_frame);
+  w.Put(s.flags);
+  w.Put(s.ninjarope.out);
+  w.Put(s.ninjarope.attached);
+  w.Put(s.ninjarope.anchor ? s.ninjarope.anchor->index : -1);
+  w.Put(s.ninjarope.pos);
+  w.Put(s.ninjarope.vel);
+  w.Put(s.ninjarope.length);
+  w.Put(s.ninjarope.cur_len);
+  w.Put(s.current_weapon);
+  w.Put(s.last_killed_by_idx);
+  w.Put(s.fire_cone);
+  w.Put(s.leave_shell_timer);
+  for (int const kReact : s.reacts) {
+    w.Put(kReact);
+  }
+  for (WormWeapon const& ww : s.weapons) {
+    w.Put(ww.type ? ww.type->id : -1);
+    w.Put(ww.ammo);
+    w.Put(ww.delay_left);
+    w.Put(ww.loading_left);
+  }
+  w.Put(s.direction);
+  w.Put(s.control_states.istate);
+  w.Put(s.prev_control_states.istate);
+  w.Put(s.steerable_sum_x);
+  w.Put(s.steerable_sum_y);
+  w.Put(s.steerable_count);
+  w.Put(s.index);
+}
+
+// Walks the live slots of an ExactObjectList; the trailing sentinel slot
+// is always marked used and is skipped.
+template <typename List, typename F>
+void PutLive(Words& w, List const& list, F&& put) {
+  constexpr std::size_t kLimit = std::extent_v<decltype(List::arr)> - 1;
+  w.Put(static_cast<uint32_t>(list.count));
+  for (std::size_t i = 0; i < kLimit; ++i) {
+    if (list.arr[i].used) {
+      w.Put(static_cast<uint32_t>(i));
+      put(list.arr[i]);
+    }
+  }
+}
+
+// Level digest as of the save, read from the slot. kFull slots are
+// indexed by cell and checked against the match's base over dirty_list;
+// kDelta slots hold delta_list[k] at level_data[k] and are checked against
+// the delta base, so only the cells dug since the last rebase are walked.
+// Cells dirtied after the save (past the end of a delta slot) still held
+// their base value then. A layer the slot doesn't hold counts as unchanged.
+inline uint64_t LevelDigest(GameSnapshot const& snap, Level const& level) {
+  bool const kDelta = snap.level_storage == GameSnapshot::LevelStorage::kDelta;
+  if (kDelta ? level.delta_bits.empty() : level.dirty_bits.empty()) {
+    return level.ContentDigest();
+  }
+  std::vector<int32_t> const& list = kDelta ? level.delta_list : level.dirty_list;
+  std::vector<uint8_t> const& base_mat =
+      kDelta ? level.delta_base_material_id : level.dirty_base_material_id;
+  std::vector<uint8_t> const& base_dv =
+      kDelta ? level.delta_base_display_valid : level.dirty_base_display_valid;
+  bool const kHasDv = !base_dv.empty();
+  uint64_t digest = kDelta ? level.delta_base_digest : level.dirty_base_digest;
+  for (std::size_t k = 0; k < list.size(); ++k) {
+    auto const kIdx = static_cast<std::size_t>(list[k]);
+    std::size_t const kAt = kDelta ? k : kIdx;
+    if (kDelta && kAt >= snap.level_data.size()) {
+      break;
+    }
+    uint8_t const kBaseMat = base_mat[kIdx];
+    uint8_t const kBaseDv = kHasDv ? base_dv[kIdx] : 0;
+    uint8_t const kMat = kAt < snap.level_data.size() ? snap.level_data[kAt] : kBaseMat;
+    uint8_t const kDv =
+        kHasDv && kAt < snap.level_display_valid.size() ? snap.level_display_valid[kAt] : kBaseDv;
+    if (kMat != kBaseMat || kDv != kBaseDv) {
+      digest += Level::CellDigest(kIdx, kMat, kDv) - Level::CellDigest(kIdx, kBaseMat, kBaseDv);
+    }
+  }
+  return digest;
+}
+
+}  // namespace snapshot_checksum_detail
+
+// `level` is the level `snap` was saved from; only its dirty-tracking
+// metadata is read, so it may have moved on since the save.
+inline uint32_t SnapshotChecksum(GameSnapshot const& snap, Level const& level) {
+  using snapshot_checksum_detail::Words;
+  // Reused per thread: the shadow worker hashes off the game thread.
+  thread_local Words w;
+  w.buf.clear();
+
+  w.Put(snap.rand.last);
+  w.Put(snap.cycles);
+  w.Put(snap.screen_flash);
+  w.Put(snap.last_killed_idx);
+  w.Put(snap.got_changed);
+  Holdazone const& hz = snap.holdazone;
+  w.Put(hz.rect.x1);
+  w.Put(hz.rect.y1);
+  w.Put(hz.rect.x2);
+  w.Put(hz.rect.y2);
+  w.Put(hz.holder_idx);
+  w.Put(hz.contender_idx);
+  w.Put(hz.contender_frames);
+  w.Put(hz.timeout_left);
+  w.Put(hz.zone_width);
+  w.Put(hz.zone_height);
+
+  for (WormSimState const& s : snap.worms) {
+    snapshot_checksum_detail::PutWorm(w, s);
+  }
+
+  snapshot_checksum_detail::PutLive(w, snap.bonuses, [&](Bonus const& b) {
+    w.Put(b.x);
+    w.Put(b.y);
+    w.Put(b.vel_y);
+    w.Put(b.frame);
+    w.Put(b.timer);
+    w.Put(b.weapon);
+  });
+  snapshot_checksum_detail::PutLive(w, snap.wobjects, [&](WObject const& o) {
+    w.Put(o.pos);
+    w.Put(o.vel);
+    w.Put(o.type ? o.type->id : -1);
+    w.Put(o.owner_idx);
+    w.Put(o.cur_frame);
+    w.Put(o.time_left);
+  });
+  snapshot_checksum_detail::PutLive(w, snap.sobjects, [&](SObject const& o) {
+    w.Put(o.x);
+    w.Put(o.y);
+    w.Put(o.id);
+    w.Put(o.cur_frame);
+    w.Put(o.anim_delay);
+  });
+  snapshot_checksum_detail::PutLive(w, snap.nobjects, [&](NObject const& o) {
+    w.Put(o.pos);
+    w.Put(o.vel);
+    w.Put(o.time_left);
+    w.Put(o.type ? o.type->id : -1);
+    w.Put(o.owner_idx);
+    w.Put(o.cur_frame);
+  });
+  w.Put(static_cast<uint32_t>(snap.bobjects_count));
+  for (std::size_t i = 0; i < snap.bobjects_count; ++i) {
+    BObject const& o = snap.bobjects_arr[i];
+    w.Put(o.pos);
+    w.Put(o.vel);
+    w.Put(o.color);
+  }
+
+  w.Put(level.width);
+  w.Put(level.height);
+  w.Put(snapshot_checksum_detail::LevelDigest(snap, level));
+
+  uint64_t const kHash =
+      XXH3_64bits_withSeed(w.buf.data(), w.buf.size() * sizeof(uint32_t), kSnapshotChecksumVersion);
+  return static_cast<uint32_t>(kHash ^ (kHash >> 32));
+}
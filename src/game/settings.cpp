@@ -5,6 +5,7 @@
 #include "io/stream.hpp"
 #include "keys.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <serialization/cereal_types.hpp>
 #include <serialization/toml_archive.hpp>
@@ -112,6 +113,18 @@ std::string Settings::ToToml() const {
     // TOML-only (display preference): the binary Settings blob is embedded
     // in replays and must keep its field layout.
     ar(cereal::make_nvp("modernColors", const_cast<Settings&>(*this).modern_colors));
+    ar(cereal::make_nvp("spectatorResidentLevel",
+                        const_cast<Settings&>(*this).spectator_resident_level));
+    ar(cereal::make_nvp("netIoThread", const_cast<Settings&>(*this).net_io_thread));
+    ar(cereal::make_nvp("rollbackWindow", const_cast<Settings&>(*this).rollback_window));
+    ar(cereal::make_nvp("exportMatchStats", const_cast<Settings&>(*this).export_match_stats));
+    // The generated level itself travels in replays and netplay map data,
+    // so the generator choice only needs to persist in the config.
+    ar(cereal::make_nvp("randomLevelGenerator",
+                        const_cast<Settings&>(*this).random_level_generator));
+    ar(cereal::make_nvp("traceZones", const_cast<Settings&>(*this).trace_zones));
+    ar(cereal::make_nvp("traceFrameBudgetMs",
+                        const_cast<Settings&>(*this).trace_frame_budget_ms));
     SerializeSettingsScalars(ar, const_cast<Settings&>(*this));
     SerializeArray(ar, "weapTable", const_cast<Settings&>(*this).weap_table);
     ar.finishNode();
@@ -139,9 +152,19 @@ void Settings::FromToml(std::string const& data) {
   int32_t version = 0;
   ar(cereal::make_nvp("version", version));
   ar(cereal::make_nvp("modernColors", modern_colors));
+  ar(cereal::make_nvp("spectatorResidentLevel", spectator_resident_level));
+  ar(cereal::make_nvp("netIoThread", net_io_thread));
+  ar(cereal::make_nvp("rollbackWindow", rollback_window));
+  ar(cereal::make_nvp("exportMatchStats", export_match_stats));
+  ar(cereal::make_nvp("randomLevelGenerator", random_level_generator));
+  ar(cereal::make_nvp("traceZones", trace_zones));
+  ar(cereal::make_nvp("traceFrameBudgetMs", trace_frame_budget_ms));
   SerializeSettingsScalars(ar, *this);
   SerializeArray(ar, "weapTable", weap_table);
   ar.finishNode();
+  // Indexes the hidden menu's generator names; keep hand-edited or corrupt
+  // configs in range.
+  random_level_generator = std::min<uint32_t>(random_level_generator, kMaxLevelGens - 1);
 
   static char const* const kWormNames[] = {"player1", "player2", "network_player"};
   for (int i = 0; i < kNumWormSettings; ++i) {
@@ -43,12 +43,37 @@ struct AppSettings {
   // aspect; see ComputeCappedRenderResolution). <=0 disables the cap; a no-op
   // when the spectator window is no taller than this. Display-only.
   int32_t max_spectator_render_height{1080};
+  // Keep the level resident in a texture for the spectator GPU composite and
+  // upload only changed tiles, instead of re-rendering and uploading the
+  // visible world every frame. Zoomed-out views still draw the level from its
+  // mips on the CPU. Display-only.
+  bool spectator_resident_level{true};
+  // Service the network on its own thread during online play so input is
+  // sent and received between frames instead of once per poll. Local-only.
+  bool net_io_thread{true};
+  // Widest rollback window (frames run ahead on prediction before the sim
+  // stalls) to offer in the online handshake; the match uses the smaller
+  // of the two peers' offers. 1..30, default rollback::kMaxRollback.
+  int32_t rollback_window{7};
+  // Write every match's stats events to Stats/*.lstats (columnar; see
+  // NormalStatsRecorder::ExportTo) for offline analysis. Local-only.
+  bool export_match_stats{false};
+  // Record ZoneScoped/ZoneScopedN scopes into the built-in trace rings
+  // (trace.hpp); Ctrl+F12 writes them to Traces/*.json. Local-only.
+  bool trace_zones{false};
+  // While trace_zones is on, dump the rings automatically after a frame
+  // that takes longer than this many milliseconds. 0 disables.
+  int32_t trace_frame_budget_ms{0};
 };
 
 struct Rand;
 
 struct Settings : GameplayExtensions, AppSettings {
   enum GameModes { kGmKillEmAll, kGmGameOfTag, kGmHoldazone, kGmScalesOfJustice, kMaxGameModes };
+  // Random level generators (see Level::GenerateRandom). Existing entries
+  // must keep producing the same level for the same seed; a changed
+  // generator gets a new entry instead.
+  enum LevelGenerators { kLevelGenClassic, kLevelGenTiled, kMaxLevelGens };
 
   static int const kSelectableWeapons = 5;
   static int const kZoneCaptureTime = 70;
@@ -88,6 +113,9 @@ struct Settings : GameplayExtensions, AppSettings {
   int32_t input_delay{1};
   int32_t random_map_width{504};
   int32_t random_map_height{350};
+  // Classic by default: the tiled generator's dirt pattern repeats every
+  // 256 px, which shows as seams on the classic 504x350 map.
+  uint32_t random_level_generator{kLevelGenClassic};
 
   static int const kNumWormSettings = 3;  // 0=left, 1=right, 2=network
   static int const kNetworkPlayerIdx = 2;
@@ -95,7 +123,13 @@ struct Settings : GameplayExtensions, AppSettings {
   // v4: added modernColors (default false = classic palette).
   // v5: added randomMapWidth/Height (defaults 504x350).
   // v6: added maxSpectatorRenderHeight (default 1080).
-  static int const kConfigVersion = 6;
+  // v7: added spectatorResidentLevel (default true).
+  // v8: added netIoThread (default true).
+  // v9: added rollbackWindow (default 7).
+  // v10: added exportMatchStats (default false).
+  // v11: added randomLevelGenerator (default kLevelGenClassic).
+  // v12: added traceZones (default false) and traceFrameBudgetMs (default 0).
+  static int const kConfigVersion = 12;
   std::shared_ptr<WormSettings> worm_settings[kNumWormSettings];
 
   uint64_t hash;
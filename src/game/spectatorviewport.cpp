@@ -169,11 +169,24 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
   WorldPassScratch const kWp =
       ComputeWorldPassScratch(render_w, render_h, zoom, game.level.width, game.level.height);
 
+  // Resident level: the GPU composite draws the terrain from a texture that
+  // Gfx keeps in sync with the level, so the scratch only carries the dynamic
+  // objects over a transparent background. Only at zoom >= 1: the texture has
+  // no mips, so a zoomed-out overview would alias; there the level comes from
+  // LevelMips into a scratch already bounded by the output size.
+  bool const kResidentLevel = renderer.gpu_world_composite && kWp.scale >= 1.0F &&
+                              game.level.width <= renderer.gpu_resident_level_max &&
+                              game.level.height <= renderer.gpu_resident_level_max;
+
   scratch_bmp.Alloc(kWp.w, kWp.h);
   scratch_bmp.pal32 = renderer.pal32;
   scratch_bmp.mode = renderer.mode;
   scratch_bmp.cycles = game.cycles;
-  Fill(scratch_bmp, 0);
+  if (kResidentLevel) {
+    FillTransparent(scratch_bmp);
+  } else {
+    Fill(scratch_bmp, 0);
+  }
 
   if (kWp.scale < 1.0F) {
     // ── Downscaled overview (zoom < 1) ──────────────────────────────────────
@@ -196,7 +209,7 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
 
     {
       ZoneScopedN("Spectator::WorldPass::DrawLevel");
-      DrawLevelScaled(scratch_bmp, game.level, x, y, kScale);
+      renderer.level_mips.DrawScaled(scratch_bmp, game.level, x, y, kScale);
     }
 
     {
@@ -208,8 +221,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
           continue;
         }
         if (i->timer > LC(BonusFlickerTime) || (game.cycles & 3) == 0) {
-          BlitImageScaled(scratch_bmp, common.small_sprites[common.bonus_frames[i->frame]], sx(kWx),
-                          sy(kWy), kScale);
+          BlitImageScaled(scratch_bmp,
+                          renderer.Resolved(common.small_sprites, common.bonus_frames[i->frame]),
+                          sx(kWx), sy(kWy), kScale);
         }
       }
     }
@@ -221,8 +235,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
           continue;
         }
         SObjectType const& t = common.sobject_types[i->id];
-        BlitImageScaled(scratch_bmp, common.large_sprites[i->cur_frame + t.start_frame], sx(i->x),
-                        sy(i->y), kScale);
+        BlitImageScaled(scratch_bmp,
+                        renderer.Resolved(common.large_sprites, i->cur_frame + t.start_frame),
+                        sx(i->x), sy(i->y), kScale);
       }
     }
 
@@ -252,8 +267,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
             cur_frame = (cur_frame - 12) >> 3;
             cur_frame = std::clamp(cur_frame, 0, 12);
           }
-          BlitImageScaled(scratch_bmp, common.small_sprites[w.start_frame + cur_frame], sx(kWx),
-                          sy(kWy), kScale);
+          BlitImageScaled(scratch_bmp,
+                          renderer.Resolved(common.small_sprites, w.start_frame + cur_frame),
+                          sx(kWx), sy(kWy), kScale);
         } else if (i->cur_frame > 0) {
           scratch_bmp.SetPixel(sx(Ftoi(i->pos.x)), sy(Ftoi(i->pos.y)),
                                static_cast<PalIdx>(i->cur_frame));
@@ -271,8 +287,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
         }
         NObjectType const& t = *i->type;
         if (t.start_frame > 0) {
-          BlitImageScaled(scratch_bmp, common.small_sprites[t.start_frame + i->cur_frame], sx(kWx),
-                          sy(kWy), kScale);
+          BlitImageScaled(scratch_bmp,
+                          renderer.Resolved(common.small_sprites, t.start_frame + i->cur_frame),
+                          sx(kWx), sy(kWy), kScale);
         } else if (i->cur_frame > 1) {
           scratch_bmp.SetPixel(sx(Ftoi(i->pos.x)), sy(Ftoi(i->pos.y)),
                                static_cast<PalIdx>(i->cur_frame));
@@ -293,11 +310,12 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
       if (w.ninjarope.out) {
         DrawNinjarope(common, scratch_bmp, sx(Ftoi(w.ninjarope.pos.x)), sy(Ftoi(w.ninjarope.pos.y)),
                       sx(Ftoi(w.pos.x)), sy(Ftoi(w.pos.y) - 1));
-        BlitImageScaled(scratch_bmp, common.large_sprites[84], sx(Ftoi(w.ninjarope.pos.x) - 1),
-                        sy(Ftoi(w.ninjarope.pos.y) - 1), kScale);
+        BlitImageScaled(scratch_bmp, renderer.Resolved(common.large_sprites, 84),
+                        sx(Ftoi(w.ninjarope.pos.x) - 1), sy(Ftoi(w.ninjarope.pos.y) - 1), kScale);
       }
-      BlitImageScaled(scratch_bmp, common.WormSpriteObj(w.current_frame, w.direction, w.index),
-                      sx(kWx), sy(kWy), kScale);
+      int const kWormFrame = Common::WormSpriteFrame(w.current_frame, w.direction, w.index);
+      BlitImageScaled(scratch_bmp, renderer.Resolved(common.worm_sprites, kWormFrame), sx(kWx),
+                      sy(kWy), kScale);
     }
 
     for (Game::BObjectList::Iterator i = game.bobjects.Begin(); i != game.bobjects.End(); ++i) {
@@ -319,7 +337,7 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
                               .mode = renderer.mode,
                               .cycles = game.cycles};
 
-    {
+    if (!kResidentLevel) {
       ZoneScopedN("Spectator::WorldPass::DrawLevel");
       DrawLevel(scratch_bmp, game.level, kOx, kOy);
     }
@@ -517,7 +535,7 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
           }
           if (i->timer > LC(BonusFlickerTime) || (game.cycles & 3) == 0) {
             int const kF = common.bonus_frames[i->frame];
-            BlitImage(scratch_bmp, common.small_sprites[kF], kBx, kBy);
+            BlitImage(scratch_bmp, renderer.Resolved(common.small_sprites, kF), kBx, kBy);
             if (game.settings->names_on_bonuses && i->frame == 0) {
               std::string const& name = common.weapons[i->weapon].name;
               int const kLen = static_cast<int>(name.size()) * 4;
@@ -577,8 +595,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
             }
             int const kPosX = Ftoi(i->pos.x) - 3;
             int const kPosY = Ftoi(i->pos.y) - 3;
-            BlitImage(scratch_bmp, common.small_sprites[w.start_frame + cur_frame], kPosX + kOx,
-                      kPosY + kOy);
+            BlitImage(scratch_bmp,
+                      renderer.Resolved(common.small_sprites, w.start_frame + cur_frame),
+                      kPosX + kOx, kPosY + kOy);
           } else if (i->cur_frame > 0) {
             int const kPosX = Ftoi(i->pos.x) + kOx;
             int const kPosY = Ftoi(i->pos.y) + kOy;
@@ -609,8 +628,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
           NObjectType const& t = *i->type;
           if (t.start_frame > 0) {
             auto pos = Ftoi(i->pos) - IVec2(3, 3);
-            BlitImage(scratch_bmp, common.small_sprites[t.start_frame + i->cur_frame], pos.x + kOx,
-                      pos.y + kOy);
+            BlitImage(scratch_bmp,
+                      renderer.Resolved(common.small_sprites, t.start_frame + i->cur_frame),
+                      pos.x + kOx, pos.y + kOy);
           } else if (i->cur_frame > 1) {
             auto pos = Ftoi(i->pos);
             pos.x += kOx;
@@ -648,7 +668,8 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
             int const kNinjaropeX = Ftoi(w.ninjarope.pos.x) + kOx;
             int const kNinjaropeY = Ftoi(w.ninjarope.pos.y) + kOy;
             DrawNinjarope(common, scratch_bmp, kNinjaropeX, kNinjaropeY, kTempX + 7, kTempY + 4);
-            BlitImage(scratch_bmp, common.large_sprites[84], kNinjaropeX - 1, kNinjaropeY - 1);
+            BlitImage(scratch_bmp, renderer.Resolved(common.large_sprites, 84), kNinjaropeX - 1,
+                      kNinjaropeY - 1);
           }
           if (w.weapons[w.current_weapon].type->fire_cone > 0 && w.fire_cone > 0) {
             BlitFireCone(scratch_bmp, w.fire_cone / 2,
@@ -656,8 +677,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
                          Common::fire_cone_offset[w.direction][kAngleFrame][0] + kTempX,
                          Common::fire_cone_offset[w.direction][kAngleFrame][1] + kTempY);
           }
-          BlitImage(scratch_bmp, common.WormSpriteObj(w.current_frame, w.direction, w.index),
-                    kTempX, kTempY);
+          int const kWormFrame = Common::WormSpriteFrame(w.current_frame, w.direction, w.index);
+          BlitImage(scratch_bmp, renderer.Resolved(common.worm_sprites, kWormFrame), kTempX,
+                    kTempY);
         }
         if (w.ai) {
           w.ai->DrawDebug(game, w, renderer, kOx, kOy);
@@ -674,8 +696,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
           if (temp.x + 7 < 0 || temp.x >= kScrW || temp.y + 7 < 0 || temp.y >= kScrH) {
             continue;
           }
-          BlitImage(scratch_bmp, common.small_sprites[worm.make_sight_green ? 44 : 43], temp.x,
-                    temp.y);
+          BlitImage(scratch_bmp,
+                    renderer.Resolved(common.small_sprites, worm.make_sight_green ? 44 : 43),
+                    temp.x, temp.y);
           if (worm.Pressed(Worm::kChange)) {
             std::string const& name = worm.weapons[worm.current_weapon].type->name;
             int const kLen = static_cast<int>(name.size()) * 4;
@@ -719,6 +742,11 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
     renderer.gpu_world_dst_y = kDst.y;
     renderer.gpu_world_dst_w = kDst.w;
     renderer.gpu_world_dst_h = kDst.h;
+    renderer.gpu_level = kResidentLevel ? &game.level : nullptr;
+    renderer.gpu_level_src_x = x;
+    renderer.gpu_level_src_y = y;
+    renderer.gpu_level_src_w = kViewW;
+    renderer.gpu_level_src_h = kViewH;
 
     // Clear only the rows the HUD will draw into this frame plus the previous
     // frame's banner row, leaving the rest of the overlay untouched. Force a
@@ -745,6 +773,7 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
     // scratch straight into `bmp` via ScaleDrawArea.
     ZoneScopedN("Spectator::Composite");
     renderer.gpu_world_src = nullptr;
+    renderer.gpu_level = nullptr;
     if (kDst.x > 0 || kDst.y > 0) {
       Fill(renderer.bmp, 0);
     }
@@ -815,19 +844,20 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
                   ammo_bar_width / 10 + 245);
         }
         if ((game.cycles % 20) > 10 && worm.visible) {
-          common.font.DrawString(renderer.bmp, LS(Reloading), kHudX, 164, 50);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, LS(Reloading), kHudX, 164, 50);
         }
       }
 
-      common.font.DrawString(renderer.bmp, (LS(Kills) + ToString(worm.kills)), kHudX,
-                             renderer.render_res_y - 29, 10);
-      common.font.DrawString(renderer.bmp, worm.settings->name, kHudX, renderer.render_res_y - 15,
-                             7);
+      renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                     renderer.text_cache.Format(LS(Kills), worm.kills), kHudX,
+                                     renderer.render_res_y - 29, 10);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, worm.settings->name, kHudX,
+                                     renderer.render_res_y - 15, 7);
       FillRect(renderer.bmp, kHudX - 1, renderer.render_res_y - 7 - 1, 8, 8, 7);
       FillRect(renderer.bmp, kHudX, renderer.render_res_y - 7, 6, 6, worm.settings->color);
       // FIXME: only draw this once, not once per worm
-      common.font.DrawString(
-          renderer.bmp,
+      renderer.text_cache.DrawString(
+          renderer.bmp, common.font,
           TimeToStringEx(game.cycles * 14, /*force_hours=*/false, /*force_minutes=*/true),
           kCenterX - 15, renderer.render_res_y - 15, 7);
 
@@ -842,11 +872,13 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
             }
           }
           if (worm.current_weapon == j) {
-            common.font.DrawString(renderer.bmp, worm.weapons[j].type->name, kOffsetWeaponListX,
-                                   renderer.render_res_y - 40 + j * 8, 187);
+            renderer.text_cache.DrawString(renderer.bmp, common.font, worm.weapons[j].type->name,
+                                           kOffsetWeaponListX, renderer.render_res_y - 40 + j * 8,
+                                           187);
           } else {
-            common.font.DrawString(renderer.bmp, worm.weapons[j].type->name, kOffsetWeaponListX,
-                                   renderer.render_res_y - 40 + j * 8, 185);
+            renderer.text_cache.DrawString(renderer.bmp, common.font, worm.weapons[j].type->name,
+                                           kOffsetWeaponListX, renderer.render_res_y - 40 + j * 8,
+                                           185);
           }
         }
       }
@@ -855,8 +887,9 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
       switch (game.settings->game_mode) {
         case Settings::kGmKillEmAll:
         case Settings::kGmScalesOfJustice: {
-          common.font.DrawString(renderer.bmp, (LS(Lives) + ToString(worm.lives)), kHudX,
-                                 renderer.render_res_y - 22, 6);
+          renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                         renderer.text_cache.Format(LS(Lives), worm.lives), kHudX,
+                                         renderer.render_res_y - 22, 6);
         } break;
         case Settings::kGmHoldazone: {
           int hstate = 0;
@@ -866,8 +899,8 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
             }
           }
           int const kColor = kStateColours[game.holdazone.holder_idx != worm.index][hstate];
-          common.font.DrawString(renderer.bmp, TimeToString(worm.timer), 5, 106 + 84 * worm.index,
-                                 renderer.render_res_y - 39, kColor);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, TimeToString(worm.timer),
+                                         106 + 84 * worm.index, renderer.render_res_y - 39, kColor);
         } break;
         case Settings::kGmGameOfTag: {
           int gstate = 0;
@@ -877,8 +910,8 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
             }
           }
           int const kColor = kStateColours[game.last_killed_idx != worm.index][gstate];
-          common.font.DrawString(renderer.bmp, TimeToString(worm.timer), 5, 106 + 84 * worm.index,
-                                 renderer.render_res_y - 39, kColor);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, TimeToString(worm.timer),
+                                         106 + 84 * worm.index, renderer.render_res_y - 39, kColor);
         } break;
         default:
           break;
@@ -890,8 +923,10 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
       Worm const& worm = *game.worms[i];
       if (banner_y > -8 && worm.health <= 0) {
         if (game.settings->game_mode == Settings::kGmGameOfTag && game.got_changed) {
-          common.font.DrawString(renderer.bmp, LS(YoureIt), rect.x1 + 3, banner_y + 1, 0);
-          common.font.DrawString(renderer.bmp, LS(YoureIt), rect.x1 + 2, banner_y, 50);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, LS(YoureIt), rect.x1 + 3,
+                                         banner_y + 1, 0);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, LS(YoureIt), rect.x1 + 2,
+                                         banner_y, 50);
         }
       }
     }
@@ -900,13 +935,17 @@ void SpectatorViewport::Draw(Game& game, Renderer& renderer, GameState state, bo
       if (worm.health <= 0 && banner_y > -8) {
         if (worm.last_killed_by_idx == worm.index) {
           std::string const kMsg(worm.settings->name + LS(CommittedSuicideMsg));
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 3, banner_y + 1, 0);
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 2, banner_y, 50);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 3, banner_y + 1,
+                                         0);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 2, banner_y,
+                                         50);
         } else {
           std::string const kMsg(game.worms[worm.last_killed_by_idx]->settings->name + " killed " +
                                  worm.settings->name);
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 3, banner_y + 1, 0);
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 2, banner_y, 50);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 3, banner_y + 1,
+                                         0);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 2, banner_y,
+                                         50);
         }
       }
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
 #include "bobject.hpp"
 #include "bonus.hpp"
 #include "game.hpp"
@@ -211,3 +212,13 @@ inline ComponentHashes HashGameComponents(Game& game) {
 
   return c;
 }
+
+// One line per component set for the desync log; `who` tells the peers
+// apart ("local", "host", ...).
+inline void PrintComponentHashes(char const* who, uint32_t frame, ComponentHashes const& c) {
+  std::fprintf(stderr,
+               "[desync] %s@%u rng=%08x level=%08x worm0=%08x worm1=%08x bobjects=%08x "
+               "bonuses=%08x sobjects=%08x nobjects=%08x wobjects=%08x\n",
+               who, frame, c.rng, c.level, c.worms[0], c.worms[1], c.bobjects, c.bonuses,
+               c.sobjects, c.nobjects, c.wobjects);
+}
@@ -73,8 +73,9 @@ struct StatsRenderer {
         BlitImage(renderer.bmp, common.WormSpriteObj(2, i == 0 ? 1 : 0, i), kX - 8, y);
 
         cell c(i == 0 ? TextCell::kRight : TextCell::kLeft);
-        common.font.DrawString(renderer.bmp, c << game.worms[i]->settings->name,
-                               kX + (i == 0 ? -16 : 16), y + 2, kTextColor);
+        renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                       c << game.worms[i]->settings->name, kX + (i == 0 ? -16 : 16),
+                                       y + 2, kTextColor);
       }
     });
   }
@@ -85,8 +86,8 @@ struct StatsRenderer {
       BlitImage(renderer.bmp, common.WormSpriteObj(2, i == 0 ? 1 : 0, i), kX - 8, y);
 
       cell c(i == 0 ? TextCell::kRight : TextCell::kLeft);
-      common.font.DrawString(renderer.bmp, c << game.worms[i]->settings->name,
-                             kX + (i == 0 ? -16 : 16), y + 2, kTextColor);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, c << game.worms[i]->settings->name,
+                                     kX + (i == 0 ? -16 : 16), y + 2, kTextColor);
     });
 
     if (!kVisible) {
@@ -98,8 +99,9 @@ struct StatsRenderer {
   template <typename Ws>
   void DrawWormStat(char const* name, Ws worm_stat) {
     Hblock(11, [this, name, &worm_stat] {
-      common.font.DrawString(renderer.bmp, cell(TextCell::kCenter).Ref() << name,
-                             renderer.render_res_x / 2 + offs_x, y, kTextColor);
+      renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                     cell(TextCell::kCenter).Ref() << name,
+                                     renderer.render_res_x / 2 + offs_x, y, kTextColor);
 
       for (int i = 0; i < 2; ++i) {
         TextCell::Placement const kP = i == 0 ? TextCell::kRight : TextCell::kLeft;
@@ -108,7 +110,7 @@ struct StatsRenderer {
         WormStats& w = stats.worms[i];
         cell c(kP);
         worm_stat(w, c);
-        common.font.DrawString(renderer.bmp, c, kX, y, kTextColor);
+        renderer.text_cache.DrawString(renderer.bmp, common.font, c, kX, y, kTextColor);
       }
     });
   }
@@ -116,14 +118,15 @@ struct StatsRenderer {
   template <typename Stat>
   void DrawStat(char const* name, Stat stat) {
     Hblock(11, [this, name, &stat] {
-      common.font.DrawString(renderer.bmp, cell(TextCell::kRight).Ref() << name,
-                             renderer.render_res_x / 2 + offs_x, y, kTextColor);
+      renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                     cell(TextCell::kRight).Ref() << name,
+                                     renderer.render_res_x / 2 + offs_x, y, kTextColor);
 
       int const kX = renderer.render_res_x / 2 + 10 + offs_x;
 
       cell c(TextCell::kLeft);
       stat(c);
-      common.font.DrawString(renderer.bmp, c, kX, y, kTextColor);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, c, kX, y, kTextColor);
     });
   }
 
@@ -139,7 +142,7 @@ struct StatsRenderer {
       color = 3;
     }
 
-    common.font.DrawString(renderer.bmp, c, x, y, color);
+    renderer.text_cache.DrawString(renderer.bmp, common.font, c, x, y, color);
 
     if (level == 0) {
       y += 11;
@@ -180,12 +183,23 @@ struct StatsRenderer {
   }
 
   void Heatmap(Heatmap& hm) {
+    // Fit the grid into the classic level's half-size box, keeping its
+    // aspect; a classic level's grid draws 1:1.
+    int const kBoxW = 504 / 2;
+    int const kBoxH = 350 / 2;
+    int draw_w = kBoxW;
+    int draw_h = std::max(1, hm.height * kBoxW / hm.width);
+    if (draw_h > kBoxH) {
+      draw_h = kBoxH;
+      draw_w = std::max(1, hm.width * kBoxH / hm.height);
+    }
+
     y += 2;
-    Hblock(hm.height, [&] {
-      int const kStartX = kPaneX + pane_width / 2 - (hm.width / 2) + offs_x;
+    Hblock(draw_h, [&] {
+      int const kStartX = kPaneX + pane_width / 2 - (draw_w / 2) + offs_x;
       int const kStartY = y;
 
-      DrawHeatmap(renderer.bmp, kStartX, kStartY, hm);
+      DrawHeatmap(renderer.bmp, kStartX, kStartY, hm, draw_w, draw_h);
     });
     y += 7;
   }
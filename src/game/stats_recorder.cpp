@@ -1,8 +1,23 @@
 #include "stats_recorder.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "common.hpp"
 #include "game.hpp"
+#include "io/coding.hpp"
+#include "net/spscQueue.hpp"
+#include "profiling.hpp"
 #include "text.hpp"
 
 void StatsRecorder::DamagePotential(Worm* by_worm, WormWeapon* weapon, int hp) {}
@@ -28,52 +43,312 @@ void StatsRecorder::AiProcessTime(Worm* worm, std::chrono::nanoseconds time) {}
 
 void StatsRecorder::Reset(int /*lev_w*/, int /*lev_h*/) {}
 
-void NormalStatsRecorder::DamagePotential(Worm* by_worm, WormWeapon* weapon, int hp) {
-  if (speculative) {
-    return;
+namespace {
+
+// Columnar match export (.lstats), all integers little-endian:
+//   "LSTA" [version:u8 = 1] [rows:u32] [columns:u8]
+//   per column: [nameLen:u8][name][encoding:u8][bytes:u32][data]
+// Encodings: 0 = one byte per row, 1 = zigzag LEB128 varint per row,
+// 2 = the same of the delta from the previous row. Rows are in
+// recording order; the columns are the StatsEvent fields.
+enum ColumnEncoding : uint8_t { kColumnU8, kColumnVarint, kColumnDeltaVarint };
+
+void PutVarint(std::vector<uint8_t>& out, int64_t v) {
+  auto u = (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+  while (u >= 0x80) {
+    out.push_back(static_cast<uint8_t>(u | 0x80));
+    u >>= 7;
   }
-  if (!by_worm || !weapon) {
-    return;
+  out.push_back(static_cast<uint8_t>(u));
+}
+
+struct StatsColumns {
+  uint32_t rows = 0;
+  int32_t last_frame = 0;
+  std::vector<uint8_t> frame, kind, worm, other, weapon, flags, x, y, value;
+
+  void Append(StatsEvent const& e) {
+    ++rows;
+    PutVarint(frame, static_cast<int64_t>(e.frame) - last_frame);
+    last_frame = e.frame;
+    kind.push_back(e.kind);
+    worm.push_back(e.worm);
+    other.push_back(e.other);
+    weapon.push_back(e.weapon);
+    flags.push_back(e.flags);
+    PutVarint(x, e.x);
+    PutVarint(y, e.y);
+    PutVarint(value, e.value);
+  }
+
+  void Write(io::Writer& w) const {
+    struct Column {
+      char const* name;
+      ColumnEncoding encoding;
+      std::vector<uint8_t> const& data;
+    };
+    Column const kColumns[] = {
+        {.name = "frame", .encoding = kColumnDeltaVarint, .data = frame},
+        {.name = "kind", .encoding = kColumnU8, .data = kind},
+        {.name = "worm", .encoding = kColumnU8, .data = worm},
+        {.name = "other", .encoding = kColumnU8, .data = other},
+        {.name = "weapon", .encoding = kColumnU8, .data = weapon},
+        {.name = "flags", .encoding = kColumnU8, .data = flags},
+        {.name = "x", .encoding = kColumnVarint, .data = x},
+        {.name = "y", .encoding = kColumnVarint, .data = y},
+        {.name = "value", .encoding = kColumnVarint, .data = value},
+    };
+    w.Put(reinterpret_cast<uint8_t const*>("LSTA"), 4);
+    w.Put(1);
+    io::WriteUint32Le(w, rows);
+    w.Put(static_cast<uint8_t>(std::size(kColumns)));
+    for (Column const& c : kColumns) {
+      std::size_t const kNameLen = std::strlen(c.name);
+      w.Put(static_cast<uint8_t>(kNameLen));
+      w.Put(reinterpret_cast<uint8_t const*>(c.name), kNameLen);
+      w.Put(c.encoding);
+      io::WriteUint32Le(w, static_cast<uint32_t>(c.data.size()));
+      w.Put(c.data.data(), c.data.size());
+    }
+    w.Flush();
+  }
+};
+
+}  // namespace
+
+// Ring plus consumer thread. The thread starts with the first event, so
+// recorders on scratch Games never spawn one, and stops at Finish().
+struct NormalStatsRecorder::Pipeline {
+  // A busy frame is a few dozen events; the producer only waits if the
+  // consumer falls this far behind.
+  static constexpr std::size_t kRingSize = 4096;
+
+  SpscQueue<StatsEvent, kRingSize> ring;
+  // Events pushed (producer) and folded in (consumer).
+  std::atomic<uint64_t> pushed{0};
+  std::atomic<uint64_t> consumed{0};
+
+  std::thread thread;
+  // No threads available: events are applied on the spot.
+  bool inline_apply = false;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  bool stop = false;
+
+  // Consumer-owned; read after Sync().
+  bool exporting = false;
+  StatsColumns columns;
+
+  void Wake() {
+    { std::scoped_lock const kLock(mutex); }
+    wake.notify_one();
+  }
+
+  void Run(NormalStatsRecorder& rec) {
+    trace::SetThreadName("stats");
+    uint64_t n = consumed.load(std::memory_order_relaxed);
+    StatsEvent e;
+    for (;;) {
+      {
+        ZoneScopedN("Stats::Apply");
+        while (ring.TryPop(e)) {
+          rec.Apply(e);
+          ++n;
+        }
+      }
+      consumed.store(n, std::memory_order_release);
+      std::unique_lock lock(mutex);
+      idle.notify_all();
+      wake.wait(lock, [&] { return stop || pushed.load(std::memory_order_acquire) != n; });
+      if (stop && pushed.load(std::memory_order_acquire) == n) {
+        return;
+      }
+    }
+  }
+
+  // Drains and joins; the next Push() starts a fresh thread.
+  void Stop() {
+    if (!thread.joinable()) {
+      return;
+    }
+    {
+      std::scoped_lock const kLock(mutex);
+      stop = true;
+    }
+    wake.notify_one();
+    thread.join();
+    stop = false;
   }
+};
 
-  WormStats& ws = worms[by_worm->index];
-  WeaponStats& weap = ws.weapons[weapon->type->id];
-  weap.potential_hp += hp;
+NormalStatsRecorder::NormalStatsRecorder()
+    : frame_start(std::chrono::steady_clock::now()),
+      presence(504, 350),
+      pipeline_(std::make_unique<Pipeline>()) {
+  for (int i = 0; i < 2; ++i) {
+    worms[i].index = i;
+  }
 }
 
-void NormalStatsRecorder::DamageDealt(Worm* by_worm, WormWeapon* weapon, Worm* to_worm, int hp,
-                                      bool has_hit) {
-  if (speculative) {
+NormalStatsRecorder::NormalStatsRecorder(NormalStatsRecorder const& other)
+    : StatsRecorder(other), presence(504, 350), pipeline_(std::make_unique<Pipeline>()) {
+  const_cast<NormalStatsRecorder&>(other).Sync();
+  frame = other.frame;
+  frame_start = other.frame_start;
+  process_time_total = other.process_time_total;
+  game_time = other.game_time;
+  for (int i = 0; i < 2; ++i) {
+    worms[i] = other.worms[i];
+  }
+  presence = other.presence;
+}
+
+NormalStatsRecorder::~NormalStatsRecorder() { pipeline_->Stop(); }
+
+void NormalStatsRecorder::Push(StatsEvent const& e) {
+  Pipeline& p = *pipeline_;
+  if (!p.thread.joinable() && !p.inline_apply) {
+    try {
+      p.thread = std::thread(&Pipeline::Run, &p, std::ref(*this));
+    } catch (std::system_error const&) {
+      p.inline_apply = true;
+    }
+  }
+  if (p.inline_apply) {
+    Apply(e);
     return;
   }
-  assert(to_worm);
+  while (!p.ring.TryPush(e)) {
+    p.Wake();
+    std::this_thread::yield();
+  }
+  p.pushed.store(p.pushed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  if (e.kind == StatsEvent::kFrameEnd) {
+    p.Wake();
+  }
+}
+
+void NormalStatsRecorder::Sync() {
+  Pipeline& p = *pipeline_;
+  if (!p.thread.joinable()) {
+    return;
+  }
+  uint64_t const kTarget = p.pushed.load(std::memory_order_relaxed);
+  p.Wake();
+  std::unique_lock lock(p.mutex);
+  p.idle.wait(lock, [&] { return p.consumed.load(std::memory_order_acquire) >= kTarget; });
+}
 
-  auto& w = worms[to_worm->index];
-  w.damage += hp;
-  w.worm_frame_stats.back().damage += hp;
-  w.damage_hm.IncArea(Ftoi(to_worm->pos.x), Ftoi(to_worm->pos.y), hp);
+void NormalStatsRecorder::Apply(StatsEvent const& e) {
+  if (pipeline_->exporting) {
+    pipeline_->columns.Append(e);
+  }
 
-  if (by_worm) {
-    if (by_worm != to_worm) {
-      worms[by_worm->index].damage_dealt += hp;
-    } else {
-      worms[by_worm->index].self_damage += hp;
+  switch (e.kind) {
+    case StatsEvent::kFrameBegin: {
+      WormFrameStats& fs = worms[e.worm].worm_frame_stats.emplace_back();
+      fs.total_hp = static_cast<int>(e.value);
+      break;
+    }
+    case StatsEvent::kDamagePotential:
+      worms[e.worm].weapons[e.weapon].potential_hp += static_cast<int>(e.value);
+      break;
+    case StatsEvent::kDamageDealt: {
+      int const kHp = static_cast<int>(e.value);
+      WormStats& w = worms[e.worm];
+      w.damage += kHp;
+      if (!w.worm_frame_stats.empty()) {
+        w.worm_frame_stats.back().damage += kHp;
+      }
+      w.damage_hm.IncArea(e.x, e.y, kHp);
+
+      if (e.other == StatsEvent::kNone) {
+        break;
+      }
+      if (e.other != e.worm) {
+        worms[e.other].damage_dealt += kHp;
+      } else {
+        worms[e.other].self_damage += kHp;
+      }
+      // Don't count if projectile already hit
+      if (e.weapon != StatsEvent::kNone && e.other != e.worm) {
+        WeaponStats& weap = worms[e.other].weapons[e.weapon];
+        if (!(e.flags & StatsEvent::kHasHit)) {
+          weap.actual_hp += kHp;
+        }
+        weap.total_hp += kHp;
+      }
+      break;
+    }
+    case StatsEvent::kShot:
+      worms[e.worm].weapons[e.weapon].potential_hits += 1;
+      break;
+    case StatsEvent::kHit:
+      worms[e.worm].weapons[e.weapon].actual_hits += 1;
+      break;
+    case StatsEvent::kSpawn:
+      worms[e.worm].spawn_time = e.frame;
+      break;
+    case StatsEvent::kDeath: {
+      WormStats& w = worms[e.worm];
+      w.life_spans.emplace_back(w.spawn_time, e.frame);
+      w.spawn_time = -1;
+      break;
+    }
+    case StatsEvent::kPresence: {
+      WormStats& ws = worms[e.worm];
+      presence.Inc(e.x, e.y);
+      ws.presence.Inc(e.x, e.y);
+      bool const kOk = (e.flags & StatsEvent::kChangeOk) != 0;
+      ws.weapon_change_good += kOk;
+      ws.weapon_change_bad += !kOk;
+      break;
     }
+    case StatsEvent::kFrameEnd:
+      for (auto& ws : worms) {
+        ws.damage_hm.Flush();
+      }
+      break;
+    case StatsEvent::kAiTime:
+      worms[e.worm].ai_process_time += std::chrono::nanoseconds(e.value);
+      break;
+    default:
+      break;
   }
+}
 
+void NormalStatsRecorder::DamagePotential(Worm* by_worm, WormWeapon* weapon, int hp) {
+  if (speculative) {
+    return;
+  }
   if (!by_worm || !weapon) {
     return;
   }
 
-  if (by_worm != to_worm)  // Don't count if projectile already hit
-  {
-    WormStats& ws = worms[by_worm->index];
-    WeaponStats& weap = ws.weapons[weapon->type->id];
-    if (!has_hit) {
-      weap.actual_hp += hp;
-    }
-    weap.total_hp += hp;
+  Push({.value = hp,
+        .frame = frame,
+        .kind = StatsEvent::kDamagePotential,
+        .worm = static_cast<uint8_t>(by_worm->index),
+        .weapon = static_cast<uint8_t>(weapon->type->id)});
+}
+
+void NormalStatsRecorder::DamageDealt(Worm* by_worm, WormWeapon* weapon, Worm* to_worm, int hp,
+                                      bool has_hit) {
+  if (speculative) {
+    return;
   }
+  assert(to_worm);
+
+  Push({.value = hp,
+        .frame = frame,
+        .x = Ftoi(to_worm->pos.x),
+        .y = Ftoi(to_worm->pos.y),
+        .kind = StatsEvent::kDamageDealt,
+        .worm = static_cast<uint8_t>(to_worm->index),
+        .other = by_worm ? static_cast<uint8_t>(by_worm->index) : StatsEvent::kNone,
+        .weapon = (by_worm && weapon) ? static_cast<uint8_t>(weapon->type->id) : StatsEvent::kNone,
+        .flags = has_hit ? StatsEvent::kHasHit : uint8_t{0}});
 }
 
 void NormalStatsRecorder::Shot(Worm* by_worm, WormWeapon* weapon) {
@@ -84,9 +359,10 @@ void NormalStatsRecorder::Shot(Worm* by_worm, WormWeapon* weapon) {
     return;
   }
 
-  WormStats& ws = worms[by_worm->index];
-  WeaponStats& weap = ws.weapons[weapon->type->id];
-  weap.potential_hits += 1;
+  Push({.frame = frame,
+        .kind = StatsEvent::kShot,
+        .worm = static_cast<uint8_t>(by_worm->index),
+        .weapon = static_cast<uint8_t>(weapon->type->id)});
 }
 
 void NormalStatsRecorder::Hit(Worm* by_worm, WormWeapon* weapon, Worm* to_worm) {
@@ -95,32 +371,29 @@ void NormalStatsRecorder::Hit(Worm* by_worm, WormWeapon* weapon, Worm* to_worm)
   }
   assert(to_worm);
 
-  if (!by_worm || !weapon) {
+  if (!by_worm || !weapon || by_worm == to_worm) {
     return;
   }
 
-  if (by_worm != to_worm) {
-    WormStats& ws = worms[by_worm->index];
-    WeaponStats& weap = ws.weapons[weapon->type->id];
-    weap.actual_hits += 1;
-  }
+  Push({.frame = frame,
+        .kind = StatsEvent::kHit,
+        .worm = static_cast<uint8_t>(by_worm->index),
+        .other = static_cast<uint8_t>(to_worm->index),
+        .weapon = static_cast<uint8_t>(weapon->type->id)});
 }
 
 void NormalStatsRecorder::AfterSpawn(Worm* worm) {
   if (speculative) {
     return;
   }
-  WormStats& w = worms[worm->index];
-  w.spawn_time = frame;
+  Push({.frame = frame, .kind = StatsEvent::kSpawn, .worm = static_cast<uint8_t>(worm->index)});
 }
 
 void NormalStatsRecorder::AfterDeath(Worm* worm) {
   if (speculative) {
     return;
   }
-  WormStats& w = worms[worm->index];
-  w.life_spans.emplace_back(w.spawn_time, frame);
-  w.spawn_time = -1;
+  Push({.frame = frame, .kind = StatsEvent::kDeath, .worm = static_cast<uint8_t>(worm->index)});
 }
 
 void NormalStatsRecorder::PreTick(Game& game) {
@@ -129,17 +402,18 @@ void NormalStatsRecorder::PreTick(Game& game) {
   }
   frame_start = std::chrono::steady_clock::now();
 
-  for (auto& w : worms) {
-    w.worm_frame_stats.emplace_back();
-
-    Worm const& worm = *game.worms[w.index];
+  for (int i = 0; i < 2; ++i) {
+    Worm const& worm = *game.worms[i];
 
     int h = std::max(worm.health, 0);
     if (!worm.visible) {
       h = worm.settings->health;
     }
 
-    w.worm_frame_stats.back().total_hp = worm.lives * worm.settings->health + h;
+    Push({.value = (worm.lives * worm.settings->health) + h,
+          .frame = frame,
+          .kind = StatsEvent::kFrameBegin,
+          .worm = static_cast<uint8_t>(i)});
   }
 }
 
@@ -152,11 +426,7 @@ void NormalStatsRecorder::Tick(Game& game) {
       std::chrono::duration_cast<std::chrono::milliseconds>(frame_end - frame_start).count();
 
   for (auto const& w : game.worms) {
-    auto& ws = worms[w->index];
     if (w->visible) {
-      presence.Inc(Ftoi(w->pos.x), Ftoi(w->pos.y));
-      ws.presence.Inc(Ftoi(w->pos.x), Ftoi(w->pos.y));
-
       bool ok = true;
       if (!w->control_states[Worm::Control::kFire] &&
           (!w->control_states[Worm::Control::kChange] ||
@@ -168,15 +438,21 @@ void NormalStatsRecorder::Tick(Game& game) {
         ok = false;
       }
 
-      ws.weapon_change_good += ok;
-      ws.weapon_change_bad += !ok;
+      Push({.frame = frame,
+            .x = Ftoi(w->pos.x),
+            .y = Ftoi(w->pos.y),
+            .kind = StatsEvent::kPresence,
+            .worm = static_cast<uint8_t>(w->index),
+            .flags = ok ? StatsEvent::kChangeOk : uint8_t{0}});
     }
   }
+  Push({.frame = frame, .kind = StatsEvent::kFrameEnd});
 
   ++frame;
 }
 
 void NormalStatsRecorder::Finish(Game& game) {
+  Sync();
   for (int i = 0; i < 2; ++i) {
     auto const& gw = game.worms[i];
     WormStats& w = worms[i];
@@ -190,19 +466,54 @@ void NormalStatsRecorder::Finish(Game& game) {
   }
 
   game_time = frame;
+
+  pipeline_->Stop();
+  if (exportNode_) {
+    try {
+      auto writer = exportNode_.ToWriter();
+      WriteColumnar(*writer);
+    } catch (std::runtime_error& e) {
+      std::fprintf(stderr, "[stats] export failed: %s\n", e.what());
+    }
+    exportNode_ = FsNode();
+  }
 }
 
 void NormalStatsRecorder::AiProcessTime(Worm* worm, std::chrono::nanoseconds time) {
   if (speculative) {
     return;
   }
-  WormStats& w = worms[worm->index];
-  w.ai_process_time += time;
+  Push({.value = time.count(),
+        .frame = frame,
+        .kind = StatsEvent::kAiTime,
+        .worm = static_cast<uint8_t>(worm->index)});
 }
 
 void NormalStatsRecorder::Reset(int lev_w, int lev_h) {
-  presence = Heatmap(lev_w / 2, lev_h / 2, lev_w, lev_h);
+  Sync();
+  presence = Heatmap(lev_w, lev_h);
   for (auto& w : worms) {
     w.Reset(lev_w, lev_h);
   }
 }
+
+void NormalStatsRecorder::ExportTo(FsNode node) {
+  Sync();
+  exportNode_ = std::move(node);
+  pipeline_->exporting = true;
+  pipeline_->columns = StatsColumns();
+}
+
+void NormalStatsRecorder::WriteColumnar(io::Writer& w) {
+  Sync();
+  pipeline_->columns.Write(w);
+}
+
+FsNode MatchStatsNode(FsNode const& config_root, char const* suffix) {
+  std::time_t const kTicks = std::time(nullptr);
+  std::tm* now = std::localtime(&kTicks);
+  char time_buf[64];
+  // NOLINTNEXTLINE(cert-err33-c) — buffer is generous; truncation only on a malformed locale and is non-fatal here.
+  std::strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H.%M.%S", now);
+  return config_root / "Stats" / (std::string(time_buf) + suffix + ".lstats");
+}
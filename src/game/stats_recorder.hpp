@@ -1,6 +1,10 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "filesystem.hpp"
 #include "gfx/blit.hpp"
 #include "worm.hpp"
 
@@ -26,6 +30,10 @@ struct StatsRecorder {
 
   virtual void Reset(int lev_w, int lev_h);
 
+  // Blocks until everything recorded so far shows in the recorder's
+  // aggregates. Recorders that aggregate inline have nothing to wait for.
+  virtual void Sync() {}
+
   // When true, all recording is suppressed. Set during predicted /
   // resim frames to avoid double-counting.
   bool speculative = false;
@@ -56,19 +64,15 @@ struct WormFrameStats {
 };
 
 struct WormStats {
-  WormStats()
-      : damage_hm(504 / 2, 350 / 2, 504, 350),
-        presence(504 / 2, 350 / 2, 504, 350),
-
-        ai_process_time(0) {
+  WormStats() : damage_hm(504, 350), presence(504, 350), ai_process_time(0) {
     for (int i = 0; i < 40; ++i) {
       weapons[i].index = i;
     }
   }
 
   void Reset(int lev_w, int lev_h) {
-    damage_hm = Heatmap(lev_w / 2, lev_h / 2, lev_w, lev_h);
-    presence = Heatmap(lev_w / 2, lev_h / 2, lev_w, lev_h);
+    damage_hm = Heatmap(lev_w, lev_h);
+    presence = Heatmap(lev_w, lev_h);
   }
 
   std::vector<std::pair<int, int> > life_spans;
@@ -104,24 +108,70 @@ struct WormStats {
   std::chrono::nanoseconds ai_process_time;
 };
 
-struct NormalStatsRecorder : StatsRecorder {
-  NormalStatsRecorder()
-      : frame_start(std::chrono::steady_clock::now()),
-
-        presence(504 / 2, 350 / 2, 504, 350) {
-    for (int i = 0; i < 2; ++i) {
-      worms[i].index = i;
-    }
-  }
+// One recorded occurrence, fixed-size so the game thread can hand it to
+// the aggregation thread through a preallocated ring. Also the row of
+// the columnar match export.
+struct StatsEvent {
+  enum Kind : uint8_t {
+    kFrameBegin,       // worm; value = lives * health + health left
+    kDamagePotential,  // worm fired weapon; value = hp
+    kDamageDealt,      // worm took value hp at (x, y) from other/weapon
+    kShot,             // worm fired weapon
+    kHit,              // worm's weapon hit other
+    kSpawn,            // worm
+    kDeath,            // worm
+    kPresence,         // worm visible at (x, y)
+    kFrameEnd,
+    kAiTime,           // worm; value = nanoseconds
+    kKindCount
+  };
+
+  static constexpr uint8_t kNone = 0xff;
+
+  // flags
+  static constexpr uint8_t kHasHit = 1 << 0;    // kDamageDealt: projectile already hit
+  static constexpr uint8_t kChangeOk = 1 << 1;  // kPresence: weapon loading used well
+
+  int64_t value = 0;
+  int32_t frame = 0;
+  int32_t x = 0, y = 0;
+  uint8_t kind = kFrameEnd;
+  uint8_t worm = kNone;
+  uint8_t other = kNone;
+  uint8_t weapon = kNone;
+  uint8_t flags = 0;
+};
 
+// The recorder behind the post-game stats screen. The hooks run inside
+// the sim, so they only stamp a StatsEvent into a preallocated ring;
+// a consumer thread folds the events into `worms` and `presence`. Read
+// those only after Sync() (Finish() and Controller::StatsGame() do it).
+struct NormalStatsRecorder : StatsRecorder {
+  NormalStatsRecorder();
+  // Copies the aggregates (after syncing `other`); the copy gets its own
+  // pipeline and doesn't inherit the export.
+  NormalStatsRecorder(NormalStatsRecorder const& other);
+  NormalStatsRecorder& operator=(NormalStatsRecorder const&) = delete;
+  ~NormalStatsRecorder() override;
+
+  // Game-thread state.
   int frame{0};
-  WormStats worms[2];
   std::chrono::time_point<std::chrono::steady_clock> frame_start;
   int64_t process_time_total{0};
   int game_time{0};
 
+  // Aggregates, owned by the consumer thread until Sync().
+  WormStats worms[2];
   Heatmap presence;
 
+  // Keeps every event for the match and writes them as a columnar file
+  // to `node` on Finish().
+  void ExportTo(FsNode node);
+  // The columnar encoding of the events recorded since ExportTo().
+  void WriteColumnar(io::Writer& w);
+
+  void Sync() override;
+
   void DamagePotential(Worm* by_worm, WormWeapon* weapon, int hp) override;
   void DamageDealt(Worm* by_worm, WormWeapon* weapon, Worm* to_worm, int hp, bool has_hit) override;
 
@@ -136,4 +186,16 @@ struct NormalStatsRecorder : StatsRecorder {
   void Finish(Game& game) override;
   void AiProcessTime(Worm* worm, std::chrono::nanoseconds time) override;
   void Reset(int lev_w, int lev_h) override;
+
+ private:
+  struct Pipeline;
+
+  void Push(StatsEvent const& e);
+  void Apply(StatsEvent const& e);
+
+  std::unique_ptr<Pipeline> pipeline_;
+  FsNode exportNode_;
 };
+
+// `config_root`/Stats/<local time><suffix>.lstats
+FsNode MatchStatsNode(FsNode const& config_root, char const* suffix = "");
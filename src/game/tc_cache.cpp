@@ -0,0 +1,469 @@
+#include "tc_cache.hpp"
+
+#include <xxhash.h>
+#include <algorithm>
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/cereal.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#if _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "common_model.hpp"
+#include "console.hpp"
+#include "mixer/mixer.hpp"
+#include "serialization/cereal_types.hpp"
+
+namespace {
+
+char const kMagic[4] = {'O', 'L', 'T', 'C'};
+std::size_t const kHeaderSize = 24;
+
+// NOLINTNEXTLINE(misc-no-recursion) — mirrors the TC directory tree.
+void HashTree(XXH3_state_t* state, FsNode const& node, std::string const& name) {
+  XXH3_64bits_update(state, name.data(), name.size() + 1);
+  DirectoryListing listing = node.Iter();
+  std::ranges::sort(listing.subs, {}, &NodeName::name);
+  for (auto const& entry : listing) {
+    FsNode const kChild = node / entry.name;
+    std::string const kRelPath = name + "/" + entry.name;
+    if (entry.is_dir) {
+      HashTree(state, kChild, kRelPath);
+      continue;
+    }
+    XXH3_64bits_update(state, kRelPath.data(), kRelPath.size() + 1);
+    auto r_ptr = kChild.ToReader();
+    uint8_t buf[16384];
+    uint64_t size = 0;
+    for (;;) {
+      std::size_t const kGot = r_ptr->TryGet(buf, sizeof(buf));
+      if (kGot == 0) {
+        break;
+      }
+      XXH3_64bits_update(state, buf, kGot);
+      size += kGot;
+    }
+    XXH3_64bits_update(state, &size, sizeof(size));
+  }
+}
+
+void HashFile(XXH3_state_t* state, FsNode const& node, std::string const& name) {
+  XXH3_64bits_update(state, name.data(), name.size() + 1);
+  if (!node.Exists()) {
+    return;
+  }
+  auto r_ptr = node.ToReader();
+  uint8_t buf[16384];
+  for (;;) {
+    std::size_t const kGot = r_ptr->TryGet(buf, sizeof(buf));
+    if (kGot == 0) {
+      break;
+    }
+    XXH3_64bits_update(state, buf, kGot);
+  }
+}
+
+// Folds `path`'s size and modification time into `state`; false if it
+// isn't a plain file on disk (a zip-backed TC).
+bool StatFile(XXH3_state_t* state, std::string const& path) {
+  std::error_code ec;
+  uint64_t const kSize = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  int64_t const kTime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+  if (ec) {
+    return false;
+  }
+  XXH3_64bits_update(state, &kSize, sizeof(kSize));
+  XXH3_64bits_update(state, &kTime, sizeof(kTime));
+  return true;
+}
+
+// HashTree's walk, folding in each file's size and time instead of its
+// contents.
+// NOLINTNEXTLINE(misc-no-recursion) — mirrors the TC directory tree.
+bool StatTree(XXH3_state_t* state, FsNode const& node, std::string const& name) {
+  XXH3_64bits_update(state, name.data(), name.size() + 1);
+  DirectoryListing listing = node.Iter();
+  std::ranges::sort(listing.subs, {}, &NodeName::name);
+  for (auto const& entry : listing) {
+    FsNode const kChild = node / entry.name;
+    std::string const kRelPath = name + "/" + entry.name;
+    if (entry.is_dir) {
+      if (!StatTree(state, kChild, kRelPath)) {
+        return false;
+      }
+      continue;
+    }
+    XXH3_64bits_update(state, kRelPath.data(), kRelPath.size() + 1);
+    if (!StatFile(state, kChild.FullPath())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class Archive>
+void SerializeSpriteSet(Archive& ar, SpriteSet& s) {
+  ar(cereal::make_nvp("width", s.width), cereal::make_nvp("height", s.height),
+     cereal::make_nvp("spriteSize", s.sprite_size), cereal::make_nvp("count", s.count),
+     cereal::make_nvp("data", s.data));
+}
+
+template <class Archive>
+void SerializeFont(Archive& ar, Font& font) {
+  for (Font::Char& ch : font.chars) {
+    ar(cereal::make_nvp("width", ch.width),
+       cereal::make_nvp("data", cereal::binary_data(ch.data, sizeof(ch.data))));
+  }
+}
+
+// The tc.cfg part of Common, as LoadTcConfig leaves it. Written from the
+// resolved tables rather than through tc_cfg's structs, so hooks that
+// failed to resolve stay -1 instead of falling back to their default.
+template <class Archive>
+void SerializeTcTables(Archive& ar, Common& common) {
+  ar(cereal::make_nvp("c", common.c), cereal::make_nvp("h", common.h),
+     cereal::make_nvp("soundHook", common.sound_hook),
+     cereal::make_nvp("bonusRandTimer", common.bonus_rand_timer),
+     cereal::make_nvp("bonusSObjects", common.bonus_s_objects),
+     cereal::make_nvp("bonusFrames", common.bonus_frames),
+     cereal::make_nvp("aiParams", common.ai_params.k));
+  for (std::string& str : common.s) {
+    ar(cereal::make_nvp("s", str));
+  }
+  for (Texture& t : common.textures) {
+    ar(cereal::make_nvp("nDrawBack", t.n_draw_back), cereal::make_nvp("mFrame", t.m_frame),
+       cereal::make_nvp("sFrame", t.s_frame), cereal::make_nvp("rFrame", t.r_frame));
+  }
+  for (ColourAnim& a : common.color_anim) {
+    ar(cereal::make_nvp("from", a.from), cereal::make_nvp("to", a.to));
+  }
+  for (Material& m : common.materials) {
+    ar(cereal::make_nvp("flags", m.flags));
+  }
+}
+
+template <typename T>
+void SaveIds(cereal::PortableBinaryOutputArchive& ar, std::vector<T> const& types) {
+  auto count = static_cast<uint32_t>(types.size());
+  ar(count);
+  for (T const& t : types) {
+    ar(t.id_str);
+  }
+}
+
+template <typename T>
+void LoadIds(cereal::PortableBinaryInputArchive& ar, std::vector<T>& types) {
+  uint32_t count = 0;
+  ar(count);
+  types.clear();
+  types.resize(count);
+  for (T& t : types) {
+    ar(t.id_str);
+  }
+}
+
+void SaveSnapshot(cereal::PortableBinaryOutputArchive& ar, Common& common) {
+  // Names and ids first: the type fields below refer to each other and to
+  // sounds by name.
+  auto sound_count = static_cast<uint32_t>(common.sounds.size());
+  ar(sound_count);
+  for (SfxSample const& s : common.sounds) {
+    ar(s.name);
+  }
+  SaveIds(ar, common.weapons);
+  SaveIds(ar, common.nobject_types);
+  SaveIds(ar, common.sobject_types);
+
+  SerializeTcTables(ar, common);
+
+  for (SfxSample& s : common.sounds) {
+    bool const kPresent = s.sound != nullptr;
+    ar(kPresent, s.original_data);
+  }
+
+  ar(common.exepal, common.modernpal);
+  SerializeSpriteSet(ar, common.small_sprites);
+  SerializeSpriteSet(ar, common.large_sprites);
+  SerializeSpriteSet(ar, common.text_sprites);
+  SerializeFont(ar, common.font);
+
+  for (Weapon const& w : common.weapons) {
+    SaveWeaponFields(ar, common, w);
+  }
+  for (NObjectType const& n : common.nobject_types) {
+    SaveNObjectFields(ar, common, n);
+  }
+  for (SObjectType const& s : common.sobject_types) {
+    SaveSObjectFields(ar, common, s);
+  }
+}
+
+void LoadSnapshot(cereal::PortableBinaryInputArchive& ar, Common& common) {
+  uint32_t sound_count = 0;
+  ar(sound_count);
+  common.sounds.clear();
+  common.sounds.resize(sound_count);
+  for (SfxSample& s : common.sounds) {
+    ar(s.name);
+  }
+  LoadIds(ar, common.weapons);
+  LoadIds(ar, common.nobject_types);
+  LoadIds(ar, common.sobject_types);
+
+  SerializeTcTables(ar, common);
+
+  for (SfxSample& s : common.sounds) {
+    bool present = false;
+    ar(present, s.original_data);
+    if (present) {
+      s.sound = SfxNewSound(s.original_data.size() * 2);
+      s.CreateSound();
+    }
+  }
+
+  ar(common.exepal, common.modernpal);
+  SerializeSpriteSet(ar, common.small_sprites);
+  SerializeSpriteSet(ar, common.large_sprites);
+  SerializeSpriteSet(ar, common.text_sprites);
+  SerializeFont(ar, common.font);
+  if (std::cmp_not_equal(common.small_sprites.data.size(),
+                         common.small_sprites.sprite_size * common.small_sprites.count) ||
+      std::cmp_not_equal(common.large_sprites.data.size(),
+                         common.large_sprites.sprite_size * common.large_sprites.count) ||
+      std::cmp_not_equal(common.text_sprites.data.size(),
+                         common.text_sprites.sprite_size * common.text_sprites.count)) {
+    throw std::runtime_error("TC cache: sprite set size mismatch");
+  }
+
+  for (Weapon& w : common.weapons) {
+    LoadWeaponFields(ar, common, w);
+  }
+  for (NObjectType& n : common.nobject_types) {
+    LoadNObjectFields(ar, common, n);
+  }
+  for (SObjectType& s : common.sobject_types) {
+    LoadSObjectFields(ar, common, s);
+  }
+}
+
+void PutUint64(std::string& out, uint64_t v) {
+  for (int i = 0; i < 8; ++i) {
+    out.push_back(static_cast<char>((v >> (i * 8)) & 0xff));
+  }
+}
+
+uint64_t GetUint64(uint8_t const* p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) {
+    v |= uint64_t{p[i]} << (i * 8);
+  }
+  return v;
+}
+
+void PutHeader(std::string& out, uint64_t key, uint64_t stat_key) {
+  out.append(kMagic, sizeof(kMagic));
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((kTcCacheVersion >> (i * 8)) & 0xff));
+  }
+  PutUint64(out, key);
+  PutUint64(out, stat_key);
+}
+
+void WriteCacheFile(FsNode const& cache, std::string const& data);
+
+// Loads `cache` if it was built from the TC at `tc_root` as it is now. A
+// matching stat key is taken at its word; otherwise the content key
+// decides, and is left in `key` for a rebuild. A snapshot that only
+// passes on content gets `stat_key` written into its header, so the next
+// start skips the content hash again.
+bool TryLoadCache(Common& common, FsNode const& cache, FsNode const& tc_root, uint64_t stat_key,
+                  std::optional<uint64_t>& key) {
+  if (!cache.Exists()) {
+    return false;
+  }
+  std::string restamped;
+  try {
+    // Files come back as one buffer; parse the snapshot in place.
+    auto r_ptr = cache.ToReader();
+    std::vector<uint8_t> scratch;
+    std::span<uint8_t const> data = r_ptr->Buffered();
+    if (data.empty()) {
+      std::string const kAll = io::ReadAll(*r_ptr);
+      scratch.assign(kAll.begin(), kAll.end());
+      data = scratch;
+    }
+    std::string header;
+    PutHeader(header, 0, 0);
+    if (data.size() < kHeaderSize || std::memcmp(data.data(), header.data(), 8) != 0) {
+      return false;
+    }
+    uint64_t const kStoredKey = GetUint64(data.data() + 8);
+    uint64_t const kStoredStatKey = GetUint64(data.data() + 16);
+    if (stat_key == 0 || kStoredStatKey != stat_key) {
+      if (!key) {
+        key = TcCacheKey(tc_root);
+      }
+      if (*key != kStoredKey) {
+        return false;
+      }
+      if (stat_key != 0) {
+        PutHeader(restamped, kStoredKey, stat_key);
+        restamped.append(reinterpret_cast<char const*>(data.data()) + kHeaderSize,
+                         data.size() - kHeaderSize);
+      }
+    }
+    io::SpanIStream is(data.subspan(kHeaderSize));
+    cereal::PortableBinaryInputArchive ar(is);
+    LoadSnapshot(ar, common);
+  } catch (std::exception& e) {
+    console::WriteWarning(std::string("Ignoring unreadable TC cache: ") + e.what());
+    return false;
+  }
+  if (!restamped.empty()) {
+    try {
+      WriteCacheFile(cache, restamped);
+    } catch (std::exception& e) {
+      console::WriteWarning(std::string("Could not update TC cache: ") + e.what());
+    }
+  }
+  return true;
+}
+
+long long ProcessId() {
+#if _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+void WriteCache(Common& common, FsNode const& cache, uint64_t key, uint64_t stat_key) {
+  std::ostringstream os;
+  {
+    std::string header;
+    PutHeader(header, key, stat_key);
+    os.write(header.data(), static_cast<std::streamsize>(header.size()));
+    cereal::PortableBinaryOutputArchive ar(os);
+    SaveSnapshot(ar, common);
+  }
+  WriteCacheFile(cache, os.str());
+}
+
+void WriteCacheFile(FsNode const& cache, std::string const& data) {
+  // Written aside and renamed into place, so a concurrent reader (batch
+  // videotool jobs share one cache) never sees half a file. The temporary
+  // name is unique per writer: jobs rebuilding the same cache at once must
+  // not write into, or rename, each other's temporary file.
+  std::random_device rd;
+  char suffix[48];
+  // NOLINTNEXTLINE(cert-err33-c) — 48 bytes hold the longest pid and both words.
+  std::snprintf(suffix, sizeof(suffix), ".%lld-%08x%08x.tmp", ProcessId(), rd(), rd());
+  std::string const kTmpPath = cache.FullPath() + suffix;
+  {
+    auto w = FsNode(kTmpPath).ToWriter();
+    w->Put(reinterpret_cast<uint8_t const*>(data.data()), data.size());
+  }
+  std::error_code ec;
+  std::filesystem::rename(kTmpPath, cache.FullPath(), ec);
+  if (ec) {
+    std::error_code remove_ec;
+    std::filesystem::remove(kTmpPath, remove_ec);
+    throw std::runtime_error("Could not write " + cache.FullPath() + ": " + ec.message());
+  }
+}
+
+}  // namespace
+
+uint64_t TcCacheKey(FsNode const& tc_root) {
+  XXH3_state_t* state = XXH3_createState();
+  XXH3_64bits_reset(state);
+  HashFile(state, tc_root / "tc.cfg", "tc.cfg");
+  HashFile(state, tc_root / "modern.pal", "modern.pal");
+  for (char const* dir : {"sprites", "sounds", "weapons", "nobjects", "sobjects"}) {
+    FsNode const kDir = tc_root / dir;
+    if (kDir.Exists()) {
+      HashTree(state, kDir, dir);
+    }
+  }
+  uint64_t const kKey = XXH3_64bits_digest(state);
+  XXH3_freeState(state);
+  return kKey;
+}
+
+uint64_t TcStatKey(FsNode const& tc_root) {
+  XXH3_state_t* state = XXH3_createState();
+  XXH3_64bits_reset(state);
+  bool ok = true;
+  for (char const* file : {"tc.cfg", "modern.pal"}) {
+    XXH3_64bits_update(state, file, std::strlen(file) + 1);
+    FsNode const kFile = tc_root / file;
+    ok = ok && (!kFile.Exists() || StatFile(state, kFile.FullPath()));
+  }
+  for (char const* dir : {"sprites", "sounds", "weapons", "nobjects", "sobjects"}) {
+    FsNode const kDir = tc_root / dir;
+    ok = ok && (!kDir.Exists() || StatTree(state, kDir, dir));
+  }
+  uint64_t const kKey = XXH3_64bits_digest(state);
+  XXH3_freeState(state);
+  if (!ok) {
+    return 0;
+  }
+  // 0 means "no stat key"; a real one that happens to be 0 is bumped.
+  return kKey == 0 ? 1 : kKey;
+}
+
+std::shared_ptr<Common> LoadCommonCached(FsNode const& tc_root, FsNode const& cache) {
+  auto common = std::make_shared<Common>();
+  if (!cache) {
+    common->load(tc_root);
+    return common;
+  }
+
+  // Taken before anything is read, so a file edited mid-load leaves a stat
+  // key that no longer matches.
+  uint64_t const kStatKey = TcStatKey(tc_root);
+  std::optional<uint64_t> key;
+  if (TryLoadCache(*common, cache, tc_root, kStatKey, key)) {
+    common->Precompute();
+    return common;
+  }
+
+  // A snapshot that failed half way leaves `common` partly filled.
+  common = std::make_shared<Common>();
+  if (!key) {
+    key = TcCacheKey(tc_root);
+  }
+  common->load(tc_root);
+  try {
+    WriteCache(*common, cache, *key, kStatKey);
+  } catch (std::exception& e) {
+    console::WriteWarning(std::string("Could not write TC cache: ") + e.what());
+  }
+  return common;
+}
+
+FsNode TcCacheNode(std::string const& tc_name) {
+  FsNode const kRoot = paths::UserDataRoot();
+  if (!kRoot) {
+    return {};
+  }
+  return kRoot / "Cache" / (tc_name + ".tcc");
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "filesystem.hpp"
+
+struct Common;
+
+// Binary snapshot of a loaded TC: the tc.cfg tables and constants, the
+// weapon / nobject / sobject types, the decoded sprite sets, palettes and
+// font, and the converted sound samples. Loading it skips the TOML
+// parsing and the TGA / WAV decoding Common::load does.
+//
+// File layout: [magic "OLTC"][version:u32 LE][key:u64 LE][stat key:u64 LE]
+// then a cereal portable-binary blob. `key` is TcCacheKey() and `stat key`
+// TcStatKey() of the TC it was built from. A warm start only compares the
+// stat key, so it doesn't read the TC at all; when that differs (files
+// touched, copied or checked out again) the content key decides, and a
+// snapshot that still matches gets the new stat key. A file with another
+// version, or neither key matching, is ignored and rebuilt.
+
+// Bump on any change to the header or blob layout, or to what
+// Common::load derives from the TC files.
+inline constexpr uint32_t kTcCacheVersion = 2;
+
+// Content hash of the files Common::load reads from `tc_root` (tc.cfg,
+// modern.pal and the sprites / sounds / weapons / nobjects / sobjects
+// directories; levels aren't part of it).
+uint64_t TcCacheKey(FsNode const& tc_root);
+
+// Hash of the paths, sizes and modification times of the same files,
+// without reading them. An edit that keeps a file's size and time is
+// missed, as with make. 0 if a file isn't a plain file on disk (a
+// zip-backed TC), which leaves only the content key.
+uint64_t TcStatKey(FsNode const& tc_root);
+
+// Loads the TC at `tc_root` from `cache` if that holds a current
+// snapshot of it. Otherwise loads `tc_root` normally and writes a new
+// snapshot to `cache`; failing to write it is only a warning. A null
+// `cache` node just loads `tc_root`.
+std::shared_ptr<Common> LoadCommonCached(FsNode const& tc_root, FsNode const& cache);
+
+// `paths::UserDataRoot()`/Cache/<tc_name>.tcc
+FsNode TcCacheNode(std::string const& tc_name);
@@ -0,0 +1,464 @@
+#include "tiled_level.hpp"
+
+#include <miniz.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "io/coding.hpp"
+#include "io/stream.hpp"
+#include "level.hpp"
+#include "parallel.hpp"
+#include "settings.hpp"
+
+namespace {
+
+uint8_t const kVersion = 0;
+uint8_t const kFlagPalette = 1 << 0;
+uint8_t const kFlagDisplay = 1 << 1;
+int const kMaxDim = 4096;
+uint16_t const kMaxRampColors = 4096;
+
+// Display index widths. Widths 1 and 2 index the value table, 0 meaning
+// "not authored"; kRawDisplay stores the values themselves followed by a
+// display_valid plane, for levels with more distinct values than that.
+uint8_t const kRawDisplay = 4;
+uint32_t const kMaxTableSize[3] = {0, 0xff, 0xffff};
+
+struct TileArea {
+  int x, y, w, h;
+
+  std::size_t Cells() const { return static_cast<std::size_t>(w) * h; }
+};
+
+struct Layout {
+  int width = 0;
+  int height = 0;
+  int tile_size = 0;
+  int tiles_x = 0;
+  int tiles_y = 0;
+  uint8_t index_width = 0;  // 0: no display layer
+  bool anim = false;
+
+  Layout(int w, int h, int ts)
+      : width(w),
+        height(h),
+        tile_size(ts),
+        tiles_x((w + ts - 1) / ts),
+        tiles_y((h + ts - 1) / ts) {}
+
+  std::size_t TileCount() const { return static_cast<std::size_t>(tiles_x) * tiles_y; }
+
+  // material, display index bytes (+ valid when raw), anim
+  int Planes() const {
+    return 1 + index_width + (index_width == kRawDisplay ? 1 : 0) + (anim ? 1 : 0);
+  }
+
+  TileArea Area(std::size_t t) const {
+    int const kX = static_cast<int>(t % tiles_x) * tile_size;
+    int const kY = static_cast<int>(t / tiles_x) * tile_size;
+    return {.x = kX,
+            .y = kY,
+            .w = std::min(tile_size, width - kX),
+            .h = std::min(tile_size, height - kY)};
+  }
+};
+
+// Worst-case PackBits output for `n` input bytes: one header byte per
+// 128-byte literal.
+std::size_t MaxPackedSize(std::size_t n) { return n + ((n + 127) / 128); }
+
+// PackBits: a header byte h < 128 is followed by h + 1 literal bytes,
+// h > 128 by one byte repeated 257 - h times. 128 is unused.
+void PackBits(std::span<uint8_t const> in, std::vector<uint8_t>& out) {
+  std::size_t i = 0;
+  while (i < in.size()) {
+    std::size_t run = 1;
+    while (i + run < in.size() && run < 128 && in[i + run] == in[i]) {
+      ++run;
+    }
+    if (run >= 3) {
+      out.push_back(static_cast<uint8_t>(257 - run));
+      out.push_back(in[i]);
+      i += run;
+      continue;
+    }
+    // Literal bytes up to the next run of three or more.
+    std::size_t const kStart = i;
+    while (i < in.size() && i - kStart < 128) {
+      if (i + 2 < in.size() && in[i] == in[i + 1] && in[i] == in[i + 2]) {
+        break;
+      }
+      ++i;
+    }
+    out.push_back(static_cast<uint8_t>(i - kStart - 1));
+    out.insert(out.end(), in.begin() + static_cast<std::ptrdiff_t>(kStart),
+               in.begin() + static_cast<std::ptrdiff_t>(i));
+  }
+}
+
+// Returns false unless `in` unpacks to exactly `out.size()` bytes.
+bool UnpackBits(std::span<uint8_t const> in, std::span<uint8_t> out) {
+  std::size_t i = 0;
+  std::size_t o = 0;
+  while (i < in.size()) {
+    uint8_t const kH = in[i++];
+    if (kH < 128) {
+      std::size_t const kN = kH + 1U;
+      if (in.size() - i < kN || out.size() - o < kN) {
+        return false;
+      }
+      std::memcpy(out.data() + o, in.data() + i, kN);
+      i += kN;
+      o += kN;
+    } else if (kH > 128) {
+      std::size_t const kN = 257U - kH;
+      if (i == in.size() || out.size() - o < kN) {
+        return false;
+      }
+      std::memset(out.data() + o, in[i++], kN);
+      o += kN;
+    } else {
+      return false;
+    }
+  }
+  return o == out.size();
+}
+
+uint32_t GetU32Le(uint8_t const* p) {
+  return p[0] | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void PutU32Le(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<uint8_t>(v >> (i * 8));
+  }
+}
+
+// The tile's planes, cell by cell in row order within the tile, packed
+// and deflated behind the packed size.
+std::vector<uint8_t> EncodeTile(Level const& level, Layout const& layout, TileArea const& a,
+                                std::unordered_map<uint32_t, uint32_t> const& index_of) {
+  std::size_t const kCells = a.Cells();
+  std::vector<uint8_t> raw(kCells * layout.Planes());
+  int const kAnimPlane = layout.Planes() - 1;
+
+  for (int y = 0; y < a.h; ++y) {
+    for (int x = 0; x < a.w; ++x) {
+      std::size_t const kIdx = (static_cast<std::size_t>(a.y + y) * layout.width) + a.x + x;
+      std::size_t const kC = (static_cast<std::size_t>(y) * a.w) + x;
+      raw[kC] = level.material_id[kIdx];
+      if (layout.index_width != 0) {
+        uint32_t v = 0;
+        if (layout.index_width == kRawDisplay) {
+          v = level.display_data[kIdx];
+          raw[((1 + kRawDisplay) * kCells) + kC] = level.display_valid[kIdx];
+        } else if (level.display_valid[kIdx] != 0) {
+          v = index_of.at(level.display_data[kIdx]) + 1;
+        }
+        for (int b = 0; b < layout.index_width; ++b) {
+          raw[((1 + b) * kCells) + kC] = static_cast<uint8_t>(v >> (b * 8));
+        }
+      }
+      if (layout.anim) {
+        raw[(kAnimPlane * kCells) + kC] = level.display_anim[kIdx];
+      }
+    }
+  }
+
+  std::vector<uint8_t> packed;
+  packed.reserve(MaxPackedSize(raw.size()));
+  PackBits(raw, packed);
+
+  mz_ulong comp_size = mz_compressBound(static_cast<mz_ulong>(packed.size()));
+  std::vector<uint8_t> out(4 + comp_size);
+  PutU32Le(out.data(), static_cast<uint32_t>(packed.size()));
+  if (mz_compress(out.data() + 4, &comp_size, packed.data(),
+                  static_cast<mz_ulong>(packed.size())) != MZ_OK) {
+    throw io::StreamError("OLLEVEL3: tile compression failed");
+  }
+  out.resize(4 + comp_size);
+  return out;
+}
+
+struct TileRef {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct Tables {
+  std::vector<uint32_t> values;
+  uint8_t ramp_count = 0;
+};
+
+bool DecodeTile(Level& level, Common const& common, Layout const& layout, Tables const& tables,
+                TileArea const& a, std::span<uint8_t const> payload) {
+  std::size_t const kCells = a.Cells();
+  std::size_t const kRawSize = kCells * layout.Planes();
+  uint32_t const kPackedSize = GetU32Le(payload.data());
+  if (kPackedSize > MaxPackedSize(kRawSize)) {
+    return false;
+  }
+
+  std::vector<uint8_t> packed(kPackedSize);
+  mz_ulong dest_len = kPackedSize;
+  if (mz_uncompress(packed.data(), &dest_len, payload.data() + 4,
+                    static_cast<mz_ulong>(payload.size() - 4)) != MZ_OK ||
+      dest_len != kPackedSize) {
+    return false;
+  }
+  std::vector<uint8_t> raw(kRawSize);
+  if (!UnpackBits(packed, raw)) {
+    return false;
+  }
+
+  int const kAnimPlane = layout.Planes() - 1;
+  for (int y = 0; y < a.h; ++y) {
+    for (int x = 0; x < a.w; ++x) {
+      std::size_t const kIdx = (static_cast<std::size_t>(a.y + y) * layout.width) + a.x + x;
+      std::size_t const kC = (static_cast<std::size_t>(y) * a.w) + x;
+      uint8_t const kMat = raw[kC];
+      level.material_id[kIdx] = kMat;
+      level.materials[kIdx] = common.materials[kMat];
+      if (layout.index_width != 0) {
+        uint32_t v = 0;
+        for (int b = 0; b < layout.index_width; ++b) {
+          v |= static_cast<uint32_t>(raw[((1 + b) * kCells) + kC]) << (b * 8);
+        }
+        if (layout.index_width == kRawDisplay) {
+          level.display_data[kIdx] = v;
+          level.display_valid[kIdx] = raw[((1 + kRawDisplay) * kCells) + kC];
+        } else if (v != 0) {
+          if (v > tables.values.size()) {
+            return false;
+          }
+          level.display_data[kIdx] = tables.values[v - 1];
+          level.display_valid[kIdx] = 1;
+        }
+      }
+      if (layout.anim) {
+        uint8_t const kRamp = raw[(kAnimPlane * kCells) + kC];
+        if (kRamp > tables.ramp_count) {
+          return false;
+        }
+        level.display_anim[kIdx] = kRamp;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void WriteTiledLevel(Level const& level, io::Writer& w, int tile_size) {
+  Layout layout(level.width, level.height, std::clamp(tile_size, 1, kMaxDim));
+  bool const kDisplay = !level.display_valid.empty();
+  layout.anim = kDisplay && !level.argb_ramps.empty() && !level.display_anim.empty();
+
+  // Distinct authored values, sorted so the output doesn't depend on
+  // hashing order.
+  std::vector<uint32_t> values;
+  std::unordered_map<uint32_t, uint32_t> index_of;
+  if (kDisplay) {
+    layout.index_width = kRawDisplay;
+    for (std::size_t i = 0; i < level.display_valid.size(); ++i) {
+      if (level.display_valid[i] != 0 &&
+          index_of.emplace(level.display_data[i], 0).second &&
+          index_of.size() > kMaxTableSize[2]) {
+        break;
+      }
+    }
+    if (index_of.size() <= kMaxTableSize[2]) {
+      layout.index_width = index_of.size() <= kMaxTableSize[1] ? 1 : 2;
+      values.reserve(index_of.size());
+      for (auto const& entry : index_of) {
+        values.push_back(entry.first);
+      }
+      std::ranges::sort(values);
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        index_of[values[i]] = static_cast<uint32_t>(i);
+      }
+    }
+  }
+
+  w.Put(kTiledLevelMagic, sizeof(kTiledLevelMagic));
+  w.Put(kVersion);
+  io::WriteUint16Le(w, static_cast<uint16_t>(layout.width));
+  io::WriteUint16Le(w, static_cast<uint16_t>(layout.height));
+  io::WriteUint16Le(w, static_cast<uint16_t>(layout.tile_size));
+  w.Put(static_cast<uint8_t>((level.has_custom_palette ? kFlagPalette : 0) |
+                             (kDisplay ? kFlagDisplay : 0)));
+
+  if (level.has_custom_palette) {
+    // 6-bit channels, as in POWERLEVEL.
+    for (Color const& c : level.origpal.entries) {
+      uint8_t const kRgb[3] = {static_cast<uint8_t>(c.r >> 2), static_cast<uint8_t>(c.g >> 2),
+                               static_cast<uint8_t>(c.b >> 2)};
+      w.Put(kRgb, 3);
+    }
+  }
+
+  if (kDisplay) {
+    w.Put(layout.index_width);
+    if (layout.index_width != kRawDisplay) {
+      io::WriteUint32Le(w, static_cast<uint32_t>(values.size()));
+      for (uint32_t const kV : values) {
+        io::WriteUint32Le(w, kV);
+      }
+    }
+    std::size_t const kRampCount =
+        layout.anim ? std::min<std::size_t>(level.argb_ramps.size(), 255) : 0;
+    w.Put(static_cast<uint8_t>(kRampCount));
+    for (std::size_t i = 0; i < kRampCount; ++i) {
+      Level::ArgbRamp const& ramp = level.argb_ramps[i];
+      w.Put(ramp.shift);
+      io::WriteUint16Le(w, static_cast<uint16_t>(ramp.colors.size()));
+      for (uint32_t const kC : ramp.colors) {
+        io::WriteUint32Le(w, kC);
+      }
+    }
+  }
+
+  std::vector<std::vector<uint8_t>> tiles(layout.TileCount());
+  ParallelFor(tiles.size(), [&](std::size_t t) {
+    tiles[t] = EncodeTile(level, layout, layout.Area(t), index_of);
+  });
+
+  uint32_t offset = 0;
+  for (std::vector<uint8_t> const& tile : tiles) {
+    io::WriteUint32Le(w, offset);
+    io::WriteUint32Le(w, static_cast<uint32_t>(tile.size()));
+    offset += static_cast<uint32_t>(tile.size());
+  }
+  for (std::vector<uint8_t> const& tile : tiles) {
+    w.Put(tile.data(), tile.size());
+  }
+}
+
+bool ReadTiledLevel(Level& level, Common& common, Settings const& settings, io::Reader& r) {
+  // version(1) + width(2) + height(2) + tile_size(2) + flags(1)
+  uint8_t hdr[8] = {};
+  r.Get(hdr, sizeof(hdr));
+  int const kWidth = hdr[1] | (hdr[2] << 8);
+  int const kHeight = hdr[3] | (hdr[4] << 8);
+  int const kTileSize = hdr[5] | (hdr[6] << 8);
+  uint8_t const kFlags = hdr[7];
+  if (hdr[0] != kVersion || kWidth < 1 || kWidth > kMaxDim || kHeight < 1 ||
+      kHeight > kMaxDim || kTileSize < 1 || kTileSize > kMaxDim ||
+      (kFlags & ~(kFlagPalette | kFlagDisplay)) != 0) {
+    return false;
+  }
+  Layout layout(kWidth, kHeight, kTileSize);
+
+  Palette pal;
+  if ((kFlags & kFlagPalette) != 0) {
+    pal.Read(r);
+  }
+
+  Tables tables;
+  std::vector<Level::ArgbRamp> ramps;
+  std::vector<uint8_t> scratch;
+  if ((kFlags & kFlagDisplay) != 0) {
+    r.Get(&layout.index_width, 1);
+    if (layout.index_width != 1 && layout.index_width != 2 &&
+        layout.index_width != kRawDisplay) {
+      return false;
+    }
+    if (layout.index_width != kRawDisplay) {
+      uint32_t const kCount = io::ReadUint32Le(r);
+      if (kCount > kMaxTableSize[layout.index_width]) {
+        return false;
+      }
+      std::span<uint8_t const> const kRaw = r.Borrow(kCount * 4U, scratch);
+      tables.values.resize(kCount);
+      for (uint32_t i = 0; i < kCount; ++i) {
+        tables.values[i] = GetU32Le(kRaw.data() + (i * 4U));
+      }
+    }
+    r.Get(&tables.ramp_count, 1);
+    for (uint8_t ri = 0; ri < tables.ramp_count; ++ri) {
+      Level::ArgbRamp ramp;
+      r.Get(&ramp.shift, 1);
+      uint16_t const kColorCount = io::ReadUint16Le(r);
+      if (kColorCount == 0 || kColorCount > kMaxRampColors) {
+        return false;
+      }
+      std::span<uint8_t const> const kRaw = r.Borrow(kColorCount * 4U, scratch);
+      ramp.colors.resize(kColorCount);
+      for (uint16_t i = 0; i < kColorCount; ++i) {
+        ramp.colors[i] = GetU32Le(kRaw.data() + (i * 4U));
+      }
+      ramps.push_back(std::move(ramp));
+    }
+    layout.anim = tables.ramp_count > 0;
+  }
+
+  std::vector<TileRef> dir(layout.TileCount());
+  std::size_t data_size = 0;
+  {
+    std::span<uint8_t const> const kRaw = r.Borrow(dir.size() * 8, scratch);
+    for (std::size_t t = 0; t < dir.size(); ++t) {
+      TileRef& e = dir[t];
+      e.offset = GetU32Le(kRaw.data() + (t * 8));
+      e.size = GetU32Le(kRaw.data() + (t * 8) + 4);
+      std::size_t const kRawSize = layout.Area(t).Cells() * layout.Planes();
+      if (e.size < 4 || e.size > 4 + mz_compressBound(MaxPackedSize(kRawSize))) {
+        return false;
+      }
+      data_size = std::max(data_size, static_cast<std::size_t>(e.offset) + e.size);
+    }
+  }
+
+  // Whole files come back buffered (FsNode::ToReader), so the tiles are
+  // decoded straight out of the reader's memory.
+  std::span<uint8_t const> const kData = r.Borrow(data_size, scratch);
+
+  level.Resize(kWidth, kHeight);
+  level.display_data.clear();
+  level.display_valid.clear();
+  level.argb_ramps.clear();
+  level.display_anim.clear();
+  if (layout.index_width != 0) {
+    std::size_t const kCells = static_cast<std::size_t>(kWidth) * kHeight;
+    level.display_data.assign(kCells, 0);
+    level.display_valid.assign(kCells, 0);
+    if (layout.anim) {
+      level.display_anim.assign(kCells, 0);
+    }
+  }
+
+  std::atomic<bool> ok{true};
+  ParallelFor(dir.size(), [&](std::size_t t) {
+    if (!DecodeTile(level, common, layout, tables, layout.Area(t),
+                    kData.subspan(dir[t].offset, dir[t].size))) {
+      ok.store(false, std::memory_order_relaxed);
+    }
+  });
+  if (!ok.load()) {
+    return false;
+  }
+  level.argb_ramps = std::move(ramps);
+
+  if (!Settings::kExtensions) {
+    level.display_data.clear();
+    level.display_valid.clear();
+    level.argb_ramps.clear();
+    level.display_anim.clear();
+  }
+
+  if (Settings::kExtensions && settings.load_powerlevel_palette &&
+      (kFlags & kFlagPalette) != 0) {
+    level.origpal.ResetPalette(pal, settings);
+    level.has_custom_palette = true;
+  } else {
+    level.origpal.ResetPalette(common.exepal, settings);
+    level.has_custom_palette = false;
+  }
+  return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+struct Common;
+struct Level;
+struct Settings;
+
+namespace io {
+struct Reader;
+struct Writer;
+}  // namespace io
+
+// OLLEVEL3: the level split into square tiles, each compressed on its own
+// (PackBits RLE, then zlib), behind a directory of tile offsets so the
+// tiles can be decoded in parallel or one at a time. The display layer is
+// stored as indices into a table of the level's distinct display values.
+// See docs/modern-level-authoring.md for the byte layout.
+
+inline constexpr uint8_t kTiledLevelMagic[8] = {'O', 'L', 'L', 'E', 'V', 'E', 'L', '3'};
+inline constexpr int kTiledLevelTileSize = 256;
+
+// Writes `level` as OLLEVEL3: materials, the display and animation layers
+// if present, and origpal if has_custom_palette.
+void WriteTiledLevel(Level const& level, io::Writer& w, int tile_size = kTiledLevelTileSize);
+
+// Reads an OLLEVEL3 level whose magic has already been consumed from `r`,
+// decoding the tiles across threads. Returns false, like Level::load, if
+// the header or a tile is malformed; a truncated stream throws
+// io::EndOfStream.
+bool ReadTiledLevel(Level& level, Common& common, Settings const& settings, io::Reader& r);
@@ -0,0 +1,211 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "io/stream.hpp"
+
+namespace trace {
+
+namespace {
+
+struct Ring {
+  std::mutex mutex;
+  std::array<Event, kRingEvents> events;
+  // Scopes ever stored; the newest is at (count - 1) % kRingEvents.
+  uint64_t count{0};
+  uint32_t id{0};
+  char const* name{nullptr};
+  // Owned by a running thread. A ring whose thread has exited is handed
+  // to the next thread that needs one.
+  bool leased{false};
+};
+
+// Deliberately leaked: threads may still record while statics are torn
+// down.
+std::mutex& RegistryMutex() {
+  static auto* mutex = new std::mutex;
+  return *mutex;
+}
+
+std::vector<Ring*>& Registry() {
+  static auto* rings = new std::vector<Ring*>;
+  return *rings;
+}
+
+bool SameName(char const* a, char const* b) {
+  return a == b || (a && b && std::strcmp(a, b) == 0);
+}
+
+// One lane per thread name: a new thread takes over a free ring last used
+// under its own name (successive ParallelFor workers, say), so a lane
+// never shows scopes of a thread with another name.
+Ring* Lease(char const* name) {
+  std::lock_guard const kLock(RegistryMutex());
+  auto& rings = Registry();
+  for (Ring* ring : rings) {
+    if (!ring->leased && SameName(ring->name, name)) {
+      ring->leased = true;
+      return ring;
+    }
+  }
+  auto* ring = new Ring;
+  ring->id = static_cast<uint32_t>(rings.size()) + 1;
+  ring->name = name;
+  ring->leased = true;
+  rings.push_back(ring);
+  return ring;
+}
+
+// Hands the ring back when its thread exits.
+struct ThreadRing {
+  Ring* ring{nullptr};
+  // Kept until the ring is leased, so naming a thread that never records
+  // costs nothing.
+  char const* name{nullptr};
+
+  Ring& Get() {
+    if (!ring) {
+      ring = Lease(name);
+    }
+    return *ring;
+  }
+
+  ~ThreadRing() {
+    if (ring) {
+      std::lock_guard const kLock(RegistryMutex());
+      ring->leased = false;
+    }
+  }
+};
+
+thread_local ThreadRing t_ring;
+
+void PutString(io::Writer& out, char const* s) {
+  out.Put(reinterpret_cast<uint8_t const*>(s), std::char_traits<char>::length(s));
+}
+
+// Names are source literals, but keep the JSON valid whatever they hold.
+void PutJsonString(io::Writer& out, char const* s) {
+  out.Put('"');
+  for (; *s; ++s) {
+    auto const kC = static_cast<unsigned char>(*s);
+    if (kC == '"' || kC == '\\') {
+      out.Put('\\');
+      out.Put(kC);
+    } else if (kC < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", kC);
+      PutString(out, buf);
+    } else {
+      out.Put(kC);
+    }
+  }
+  out.Put('"');
+}
+
+}  // namespace
+
+void SetEnabled(bool enabled) { detail::g_enabled.store(enabled, std::memory_order_relaxed); }
+
+void Record(char const* name, int64_t start_ns, int64_t end_ns) {
+  Ring& ring = t_ring.Get();
+  std::lock_guard const kLock(ring.mutex);
+  ring.events[ring.count++ % kRingEvents] = {.name = name, .start_ns = start_ns, .end_ns = end_ns};
+}
+
+void SetThreadName(char const* name) {
+  t_ring.name = name;
+  if (t_ring.ring) {
+    std::lock_guard const kLock(t_ring.ring->mutex);
+    t_ring.ring->name = name;
+  }
+}
+
+std::vector<Lane> Capture() {
+  std::vector<Lane> lanes;
+  std::lock_guard const kLock(RegistryMutex());
+  for (Ring* ring : Registry()) {
+    Lane lane;
+    lane.events.reserve(kRingEvents);
+    {
+      std::lock_guard const kRingLock(ring->mutex);
+      lane.id = ring->id;
+      lane.name = ring->name;
+      uint64_t const kKept = std::min<uint64_t>(ring->count, kRingEvents);
+      for (uint64_t i = ring->count - kKept; i < ring->count; ++i) {
+        lane.events.push_back(ring->events[i % kRingEvents]);
+      }
+    }
+    if (!lane.events.empty() || lane.name) {
+      lanes.push_back(std::move(lane));
+    }
+  }
+  return lanes;
+}
+
+void Clear() {
+  std::lock_guard const kLock(RegistryMutex());
+  for (Ring* ring : Registry()) {
+    std::lock_guard const kRingLock(ring->mutex);
+    ring->count = 0;
+  }
+}
+
+void WriteChromeTrace(std::vector<Lane> const& lanes, io::Writer& out) {
+  int64_t base = std::numeric_limits<int64_t>::max();
+  for (Lane const& lane : lanes) {
+    for (Event const& e : lane.events) {
+      base = std::min(base, e.start_ns);
+    }
+  }
+
+  PutString(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+  char buf[128];
+  for (Lane const& lane : lanes) {
+    if (lane.name) {
+      std::snprintf(buf, sizeof(buf),
+                    "%s\n{\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32
+                    ",\"name\":\"thread_name\",\"args\":{\"name\":",
+                    first ? "" : ",", lane.id);
+      PutString(out, buf);
+      PutJsonString(out, lane.name);
+      PutString(out, "}}");
+      first = false;
+    }
+    for (Event const& e : lane.events) {
+      // Microseconds, as the format wants, to the nanosecond.
+      std::snprintf(buf, sizeof(buf),
+                    "%s\n{\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%" PRId64
+                    ".%03d,\"dur\":%" PRId64 ".%03d,\"name\":",
+                    first ? "" : ",", lane.id, (e.start_ns - base) / 1000,
+                    static_cast<int>((e.start_ns - base) % 1000), (e.end_ns - e.start_ns) / 1000,
+                    static_cast<int>((e.end_ns - e.start_ns) % 1000));
+      PutString(out, buf);
+      PutJsonString(out, e.name ? e.name : "?");
+      out.Put('}');
+      first = false;
+    }
+  }
+  PutString(out, "\n]}\n");
+}
+
+bool FrameBudget::Tick(int64_t now_ns, int64_t budget_ns, int64_t cooldown_ns) {
+  int64_t const kLast = last_ns_;
+  last_ns_ = now_ns;
+  if (kLast < 0 || budget_ns <= 0 || now_ns - kLast <= budget_ns || now_ns < quiet_until_ns_) {
+    return false;
+  }
+  quiet_until_ns_ = now_ns + cooldown_ns;
+  return true;
+}
+
+}  // namespace trace
@@ -0,0 +1,112 @@
+#pragma once
+
+// Built-in scoped profiler that needs no special build and no client.
+//
+// Every ZoneScoped/ZoneScopedN site (profiling.hpp) also opens a
+// trace::Scope. While recording is on (SetEnabled; the TRACE ZONES hidden
+// menu item), a Scope stamps its start and end into a ring on its thread
+// that holds the last kRingEvents scopes. While it's off, a Scope costs
+// one relaxed load. Capture() copies what the rings hold, and
+// WriteChromeTrace() writes that as Chrome trace-event JSON, which
+// chrome://tracing, Perfetto and speedscope can open.
+//
+// Rings are allocated on a thread's first recorded scope and are never
+// freed. When a thread exits, the next thread with the same name takes
+// over its ring, so short-lived workers (ParallelFor) reuse a few lanes
+// rather than piling up, and a lane only ever holds scopes of threads
+// with its name.
+//
+// FrameBudget picks out frames that run over budget, so the game can dump
+// the rings right after the one bad frame of a long match.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace io {
+struct Writer;
+}
+
+namespace trace {
+
+constexpr std::size_t kRingEvents = std::size_t{1} << 14;
+
+namespace detail {
+inline std::atomic<bool> g_enabled{false};
+}  // namespace detail
+
+inline bool Enabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+void SetEnabled(bool enabled);
+
+// Nanoseconds on the trace clock (steady_clock).
+inline int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Stores one finished scope in the calling thread's ring. `name` is kept
+// by address, so it must be a string literal or otherwise outlive every
+// capture.
+void Record(char const* name, int64_t start_ns, int64_t end_ns);
+
+// Names the calling thread's lane in traces. `name` is kept by address,
+// like a scope name.
+void SetThreadName(char const* name);
+
+class Scope {
+ public:
+  explicit Scope(char const* name) : name_(name), start_(Enabled() ? Now() : -1) {}
+  ~Scope() {
+    if (start_ >= 0) {
+      Record(name_, start_, Now());
+    }
+  }
+  Scope(Scope const&) = delete;
+  Scope& operator=(Scope const&) = delete;
+
+ private:
+  char const* name_;
+  int64_t start_;
+};
+
+struct Event {
+  char const* name{nullptr};
+  int64_t start_ns{0};
+  int64_t end_ns{0};
+};
+
+struct Lane {
+  uint32_t id{0};
+  char const* name{nullptr};
+  // Oldest first.
+  std::vector<Event> events;
+};
+
+// Every lane's events as they stand. Safe to call while other threads
+// record; it holds each ring's lock only while copying it.
+std::vector<Lane> Capture();
+
+// Drops everything recorded so far.
+void Clear();
+
+// Chrome trace-event JSON ("X" complete events, one tid per lane),
+// with timestamps relative to the earliest event.
+void WriteChromeTrace(std::vector<Lane> const& lanes, io::Writer& out);
+
+// Call Tick() once per frame. It returns true when the frame since the
+// previous Tick() took longer than the budget. After a hit, further hits
+// are held back for `cooldown_ns`, so a slow stretch (a level load, say)
+// yields one dump rather than one per frame.
+class FrameBudget {
+ public:
+  bool Tick(int64_t now_ns, int64_t budget_ns, int64_t cooldown_ns);
+
+ private:
+  int64_t last_ns_{-1};
+  int64_t quiet_until_ns_{0};
+};
+
+}  // namespace trace
@@ -8,6 +8,7 @@
 #include "gfx/renderer.hpp"
 #include "gfx/shadow_query.hpp"
 #include "math.hpp"
+#include "profiling.hpp"
 #include "text.hpp"
 
 struct PreserveClipRect {
@@ -76,6 +77,7 @@ void Viewport::Process(Game& game) {
 }
 
 void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is_replay) {
+  ZoneScopedN("Viewport::Draw");
   Common& common = *game.common;
   Worm& worm = *game.WormByIdx(worm_idx);
   int const kMultiplier = renderer.render_res_x / 320;
@@ -123,22 +125,23 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
     }
 
     if ((game.cycles % 20) > 10 && worm.visible) {
-      common.font.DrawString(renderer.bmp, LS(Reloading), worm.stats_x * kMultiplier,
-                             164 * kMultiplier, 50);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, LS(Reloading),
+                                     worm.stats_x * kMultiplier, 164 * kMultiplier, 50);
     }
   }
 
-  common.font.DrawString(renderer.bmp, (LS(Kills) + ToString(worm.kills)),
-                         worm.stats_x * kMultiplier, renderer.render_res_y - 29, 10);
+  renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                 renderer.text_cache.Format(LS(Kills), worm.kills),
+                                 worm.stats_x * kMultiplier, renderer.render_res_y - 29, 10);
 
   if (is_replay) {
-    common.font.DrawString(renderer.bmp, worm.settings->name, worm.stats_x * kMultiplier,
-                           renderer.render_res_y - 15, 7);
+    renderer.text_cache.DrawString(renderer.bmp, common.font, worm.settings->name,
+                                   worm.stats_x * kMultiplier, renderer.render_res_y - 15, 7);
     FillRect(renderer.bmp, worm.stats_x * kMultiplier, renderer.render_res_y - 7 - 1, 8, 8, 7);
     FillRect(renderer.bmp, (worm.stats_x + 1) * kMultiplier, renderer.render_res_y - 7, 6, 6,
              worm.settings->color);
-    common.font.DrawString(
-        renderer.bmp,
+    renderer.text_cache.DrawString(
+        renderer.bmp, common.font,
         TimeToStringEx(game.cycles * 14, /*force_hours=*/false, /*force_minutes=*/true),
         95 * kMultiplier, renderer.render_res_y - 15, 7);
   }
@@ -148,8 +151,9 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
   switch (game.settings->game_mode) {
     case Settings::kGmKillEmAll:
     case Settings::kGmScalesOfJustice: {
-      common.font.DrawString(renderer.bmp, (LS(Lives) + ToString(worm.lives)),
-                             worm.stats_x * kMultiplier, renderer.render_res_y - 22, 6);
+      renderer.text_cache.DrawString(renderer.bmp, common.font,
+                                     renderer.text_cache.Format(LS(Lives), worm.lives),
+                                     worm.stats_x * kMultiplier, renderer.render_res_y - 22, 6);
     } break;
 
     case Settings::kGmHoldazone: {
@@ -163,9 +167,9 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
 
       int const kColor = kStateColours[game.holdazone.holder_idx != worm.index][state];
 
-      common.font.DrawString(renderer.bmp, TimeToString(worm.timer), 5 * kMultiplier,
-                             106 * kMultiplier + 84 * worm.index * kMultiplier,
-                             renderer.render_res_y - 39, kColor);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, TimeToString(worm.timer),
+                                     106 * kMultiplier + 84 * worm.index * kMultiplier,
+                                     renderer.render_res_y - 39, kColor);
     } break;
 
     case Settings::kGmGameOfTag: {
@@ -179,9 +183,9 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
 
       int const kColor = kStateColours[game.last_killed_idx != worm.index][state];
 
-      common.font.DrawString(renderer.bmp, TimeToString(worm.timer), 5 * kMultiplier,
-                             106 * kMultiplier + 84 * worm.index * kMultiplier,
-                             renderer.render_res_y - 39, kColor);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, TimeToString(worm.timer),
+                                     106 * kMultiplier + 84 * worm.index * kMultiplier,
+                                     renderer.render_res_y - 39, kColor);
     } break;
 
     default:
@@ -233,8 +237,10 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
     }
 
     if (!worm.visible && worm.killed_timer <= 0 && !worm.ready) {
-      common.font.DrawString(renderer.bmp, LS(PressFire), rect.CenterX() - 30, 76, 0);
-      common.font.DrawString(renderer.bmp, LS(PressFire), rect.CenterX() - 31, 75, 50);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, LS(PressFire), rect.CenterX() - 30,
+                                     76, 0);
+      renderer.text_cache.DrawString(renderer.bmp, common.font, LS(PressFire), rect.CenterX() - 31,
+                                     75, 50);
 
       if (game.settings->allow_viewing_spawn_point && worm.Pressed(Worm::kChange)) {
         int const kTempX = Ftoi(worm.pos.x) - 7 + kOffs.x;
@@ -248,8 +254,10 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
 
     if (banner_y > -8 && worm.health <= 0) {
       if (game.settings->game_mode == Settings::kGmGameOfTag && game.got_changed) {
-        common.font.DrawString(renderer.bmp, LS(YoureIt), rect.x1 + 3, banner_y + 1, 0);
-        common.font.DrawString(renderer.bmp, LS(YoureIt), rect.x1 + 2, banner_y, 50);
+        renderer.text_cache.DrawString(renderer.bmp, common.font, LS(YoureIt), rect.x1 + 3,
+                                       banner_y + 1, 0);
+        renderer.text_cache.DrawString(renderer.bmp, common.font, LS(YoureIt), rect.x1 + 2,
+                                       banner_y, 50);
       }
     }
 
@@ -259,12 +267,16 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
       if (v != this && other_worm.health <= 0 && v->banner_y > -8) {
         if (other_worm.last_killed_by_idx == worm.index) {
           std::string const kMsg(LS(KilledMsg) + other_worm.settings->name);
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 3, v->banner_y + 1, 0);
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 2, v->banner_y, 50);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 3,
+                                         v->banner_y + 1, 0);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 2, v->banner_y,
+                                         50);
         } else {
           std::string const kMsg(other_worm.settings->name + LS(CommittedSuicideMsg));
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 3, v->banner_y + 1, 0);
-          common.font.DrawString(renderer.bmp, kMsg, rect.x1 + 2, v->banner_y, 50);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 3,
+                                         v->banner_y + 1, 0);
+          renderer.text_cache.DrawString(renderer.bmp, common.font, kMsg, rect.x1 + 2, v->banner_y,
+                                         50);
         }
       }
     }
@@ -403,8 +415,8 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
       for (Bonus const* i = nullptr; (i = br.Next());) {
         if (i->timer > LC(BonusFlickerTime) || (game.cycles & 3) == 0) {
           int const kF = common.bonus_frames[i->frame];
-          BlitImage(renderer.bmp, common.small_sprites[kF], Ftoi(i->x) - 3 + kOffs.x,
-                    Ftoi(i->y) - 3 + kOffs.y);
+          BlitImage(renderer.bmp, renderer.Resolved(common.small_sprites, kF),
+                    Ftoi(i->x) - 3 + kOffs.x, Ftoi(i->y) - 3 + kOffs.y);
           if (game.settings->names_on_bonuses && i->frame == 0) {
             std::string const& name = common.weapons[i->weapon].name;
             int const kLen = static_cast<int>(name.size()) * 4;
@@ -454,8 +466,9 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
           }
           int const kPosX = Ftoi(i->pos.x) - 3;
           int const kPosY = Ftoi(i->pos.y) - 3;
-          BlitImage(renderer.bmp, common.small_sprites[w.start_frame + cur_frame], kPosX + kOffs.x,
-                    kPosY + kOffs.y);
+          BlitImage(renderer.bmp,
+                    renderer.Resolved(common.small_sprites, w.start_frame + cur_frame),
+                    kPosX + kOffs.x, kPosY + kOffs.y);
         } else if (i->cur_frame > 0) {
           int const kPosX = Ftoi(i->pos.x) + kOffs.x;
           int const kPosY = Ftoi(i->pos.y) + kOffs.y;
@@ -486,7 +499,8 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
         NObjectType const& t = *i->type;
         if (t.start_frame > 0) {
           auto pos = Ftoi(i->pos) - IVec2(3, 3);
-          BlitImage(renderer.bmp, common.small_sprites[t.start_frame + i->cur_frame],
+          BlitImage(renderer.bmp,
+                    renderer.Resolved(common.small_sprites, t.start_frame + i->cur_frame),
                     pos.x + kOffs.x, pos.y + kOffs.y);
         } else if (i->cur_frame > 1) {
           auto pos = Ftoi(i->pos) + kOffs;
@@ -528,7 +542,8 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
 
           DrawNinjarope(common, renderer.bmp, kNinjaropeX, kNinjaropeY, kTempX + 7, kTempY + 4);
 
-          BlitImage(renderer.bmp, common.large_sprites[84], kNinjaropeX - 1, kNinjaropeY - 1);
+          BlitImage(renderer.bmp, renderer.Resolved(common.large_sprites, 84), kNinjaropeX - 1,
+                    kNinjaropeY - 1);
         }
 
         if (w.weapons[w.current_weapon].type->fire_cone > 0 && w.fire_cone > 0) {
@@ -542,8 +557,8 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
                        Common::fire_cone_offset[w.direction][kAngleFrame][1] + kTempY);
         }
 
-        BlitImage(renderer.bmp, common.WormSpriteObj(w.current_frame, w.direction, w.index), kTempX,
-                  kTempY);
+        int const kWormFrame = Common::WormSpriteFrame(w.current_frame, w.direction, w.index);
+        BlitImage(renderer.bmp, renderer.Resolved(common.worm_sprites, kWormFrame), kTempX, kTempY);
       }
 
       if (w.ai) {
@@ -569,7 +584,8 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
       // int tempX = ftoi(worm.pos.x) - 1 + ftoi(cosTable[ftoi(worm.aimingAngle)] * 16) + offs.x;
       // int tempY = ftoi(worm.pos.y) - 2 + ftoi(sinTable[ftoi(worm.aimingAngle)] * 16) + offs.y;
 
-      BlitImage(renderer.bmp, common.small_sprites[worm.make_sight_green ? 44 : 43], temp.x,
+      BlitImage(renderer.bmp,
+                renderer.Resolved(common.small_sprites, worm.make_sight_green ? 44 : 43), temp.x,
                 temp.y);
 
       if (worm.Pressed(Worm::kChange)) {
@@ -599,7 +615,8 @@ void Viewport::Draw(Game& game, Renderer& renderer, GameState /*state*/, bool is
         std::max((game.level.width + Level::kHudMinimapW - 1) / Level::kHudMinimapW, 1);
     int const kMinimapStepY =
         std::max((game.level.height + Level::kHudMinimapH - 1) / Level::kHudMinimapH, 1);
-    game.level.DrawMiniature(renderer.bmp, kMapX, kMapY, kMinimapStepX, kMinimapStepY);
+    renderer.minimaps.Draw(renderer.bmp, game.level, kMapX, kMapY, kMinimapStepX,
+                           kMinimapStepY);
 
     for (auto& worm : game.worms) {
       Worm const& w = *worm;
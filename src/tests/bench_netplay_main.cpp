@@ -0,0 +1,292 @@
+// Headless netcode benchmark: plays full matches between two rollback
+// peers over the in-memory JitterTransport under a sweep of network
+// profiles and prints one JSON report. Every run is seeded, so two
+// builds given the same arguments face the same links and the same
+// inputs; compare their reports to judge a netcode change.
+//
+// A "frame" below is one scripted tick in which both peers Process()
+// once. Run from the repository root (the TC is loaded from data/).
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <iterator>
+#include <vector>
+
+#include "jitter_transport.hpp"
+#include "net_game_harness.hpp"
+#include "rand.hpp"
+#include "worm.hpp"
+
+namespace {
+
+struct Profile {
+  char const* name;
+  int min_delay_frames;
+  int max_delay_frames;
+  double loss;
+  double reorder;
+  double duplicate;
+  int bandwidth_bytes_per_sec;
+  // Rollback window the peers would negotiate for this link.
+  int window;
+};
+
+// One-way delays are in 70 Hz frames (~14 ms each).
+constexpr Profile kProfiles[] = {
+    {.name = "lan",
+     .min_delay_frames = 0,
+     .max_delay_frames = 1,
+     .loss = 0.0,
+     .reorder = 0.0,
+     .duplicate = 0.0,
+     .bandwidth_bytes_per_sec = 0,
+     .window = 7},
+    {.name = "broadband",
+     .min_delay_frames = 2,
+     .max_delay_frames = 3,
+     .loss = 0.005,
+     .reorder = 0.0,
+     .duplicate = 0.0,
+     .bandwidth_bytes_per_sec = 0,
+     .window = 7},
+    {.name = "wifi",
+     .min_delay_frames = 1,
+     .max_delay_frames = 5,
+     .loss = 0.02,
+     .reorder = 0.02,
+     .duplicate = 0.005,
+     .bandwidth_bytes_per_sec = 0,
+     .window = 7},
+    {.name = "mobile",
+     .min_delay_frames = 4,
+     .max_delay_frames = 10,
+     .loss = 0.05,
+     .reorder = 0.05,
+     .duplicate = 0.0,
+     .bandwidth_bytes_per_sec = 4000,
+     .window = 12},
+    {.name = "relay",
+     .min_delay_frames = 6,
+     .max_delay_frames = 8,
+     .loss = 0.01,
+     .reorder = 0.0,
+     .duplicate = 0.0,
+     .bandwidth_bytes_per_sec = 2500,
+     .window = 12},
+    {.name = "hostile",
+     .min_delay_frames = 8,
+     .max_delay_frames = 16,
+     .loss = 0.15,
+     .reorder = 0.10,
+     .duplicate = 0.02,
+     .bandwidth_bytes_per_sec = 0,
+     .window = 20},
+};
+
+// Same damage-forcing input as test_net_full_game.cpp, so matches end.
+uint8_t CombatInput(Rand& rng, int peer_idx) {
+  uint8_t input = rng() & 0x7f;
+  if ((rng() % 10) < 6) {
+    input |= (1 << Worm::kFire);
+  }
+  if ((rng() % 10) < 4) {
+    input |= (1 << (peer_idx == 0 ? 1 : 0));
+  }
+  return input;
+}
+
+struct Totals {
+  int matches = 0;
+  int completed = 0;
+  int desynced = 0;
+  uint64_t frames = 0;
+  uint64_t rollbacks = 0;
+  uint64_t resim_frames = 0;
+  uint64_t stall_ticks = 0;
+  uint64_t desync_frames = 0;
+  uint32_t max_lag = 0;
+  int64_t process_ns = 0;
+  double cpu_seconds = 0.0;
+  uint64_t packets_sent = 0;
+  uint64_t packets_dropped = 0;
+  uint64_t bytes = 0;
+};
+
+double PerFrame(double v, uint64_t frames) {
+  return frames == 0 ? 0.0 : v / static_cast<double>(frames);
+}
+
+void PrintProfile(std::FILE* out, Profile const& p, Totals const& t, bool last) {
+  std::fprintf(out, "    {\n");
+  std::fprintf(out, "      \"name\": \"%s\",\n", p.name);
+  std::fprintf(out,
+               "      \"link\": {\"min_delay_frames\": %d, \"max_delay_frames\": %d, "
+               "\"loss\": %.3f, \"reorder\": %.3f, \"duplicate\": %.3f, "
+               "\"bandwidth_bytes_per_sec\": %d, \"window\": %d},\n",
+               p.min_delay_frames, p.max_delay_frames, p.loss, p.reorder, p.duplicate,
+               p.bandwidth_bytes_per_sec, p.window);
+  std::fprintf(out, "      \"matches\": %d,\n", t.matches);
+  std::fprintf(out, "      \"completed\": %d,\n", t.completed);
+  std::fprintf(out, "      \"frames\": %" PRIu64 ",\n", t.frames);
+  std::fprintf(out, "      \"rollbacks\": %" PRIu64 ",\n", t.rollbacks);
+  std::fprintf(out, "      \"resim_frames_per_tick\": %.4f,\n",
+               PerFrame(static_cast<double>(t.resim_frames), 2 * t.frames));
+  std::fprintf(out, "      \"stall_ticks\": %" PRIu64 ",\n", t.stall_ticks);
+  std::fprintf(out, "      \"max_lag\": %u,\n", t.max_lag);
+  std::fprintf(out, "      \"desynced_matches\": %d,\n", t.desynced);
+  std::fprintf(out, "      \"desync_frames\": %" PRIu64 ",\n", t.desync_frames);
+  std::fprintf(out, "      \"cpu_ms_per_frame\": %.4f,\n",
+               PerFrame(t.cpu_seconds * 1000.0, t.frames));
+  std::fprintf(out, "      \"process_us_per_frame\": %.3f,\n",
+               PerFrame(static_cast<double>(t.process_ns) / 1000.0, t.frames));
+  std::fprintf(out, "      \"packets_sent\": %" PRIu64 ",\n", t.packets_sent);
+  std::fprintf(out, "      \"packets_dropped\": %" PRIu64 ",\n", t.packets_dropped);
+  std::fprintf(out, "      \"wire_bytes_per_frame\": %.2f\n",
+               PerFrame(static_cast<double>(t.bytes), 2 * t.frames));
+  std::fprintf(out, "    }%s\n", last ? "" : ",");
+}
+
+void Usage() {
+  std::fprintf(stderr,
+               "usage: bench_netplay [--matches N] [--seed S] [--max-frames N]\n"
+               "                     [--profile NAME]... [--full-window] [--out FILE]\n"
+               "profiles:");
+  for (Profile const& p : kProfiles) {
+    std::fprintf(stderr, " %s", p.name);
+  }
+  std::fprintf(stderr, "\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) try {
+  int matches = 3;
+  uint32_t seed = 0xBEEF;
+  int max_frames = 70 * 60 * 3;
+  bool input_acks = true;
+  char const* out_path = nullptr;
+  std::vector<Profile> selected;
+
+  for (int i = 1; i < argc; ++i) {
+    bool const kHasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--matches") == 0 && kHasValue) {
+      matches = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && kHasValue) {
+      seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+    } else if (std::strcmp(argv[i], "--max-frames") == 0 && kHasValue) {
+      max_frames = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--full-window") == 0) {
+      // Without acks every batch carries the whole window: the
+      // pre-kPacketTick behaviour, for A/B runs.
+      input_acks = false;
+    } else if (std::strcmp(argv[i], "--out") == 0 && kHasValue) {
+      out_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--profile") == 0 && kHasValue) {
+      char const* name = argv[++i];
+      bool found = false;
+      for (Profile const& p : kProfiles) {
+        if (std::strcmp(p.name, name) == 0) {
+          selected.push_back(p);
+          found = true;
+        }
+      }
+      if (!found) {
+        std::fprintf(stderr, "unknown profile: %s\n", name);
+        Usage();
+        return 2;
+      }
+    } else {
+      Usage();
+      return 2;
+    }
+  }
+  if (matches <= 0 || max_frames <= 0) {
+    Usage();
+    return 2;
+  }
+  if (selected.empty()) {
+    selected.assign(std::begin(kProfiles), std::end(kProfiles));
+  }
+
+  std::vector<Totals> totals(selected.size());
+  for (std::size_t pi = 0; pi < selected.size(); ++pi) {
+    Profile const& p = selected[pi];
+    Totals& t = totals[pi];
+    for (int m = 0; m < matches; ++m) {
+      // Per-match seeds derive from the base seed only, never from the
+      // profile, so every profile plays the same matches.
+      uint32_t const kMatchSeed = seed + (static_cast<uint32_t>(m) * 0x9E3779B9U);
+      rollback_test::RollbackPair pair =
+          rollback_test::MakeRollbackPair({.world_seed = kMatchSeed, .max_rollback = p.window});
+      rollback_test::JitterTransport transport({.seed = kMatchSeed ^ 0x5EED,
+                                                .min_delay_frames = p.min_delay_frames,
+                                                .max_delay_frames = p.max_delay_frames,
+                                                .loss_probability = p.loss,
+                                                .duplicate_probability = p.duplicate,
+                                                .reorder_probability = p.reorder,
+                                                .bandwidth_bytes_per_sec =
+                                                    p.bandwidth_bytes_per_sec});
+      Rand rng_a(kMatchSeed ^ 0xDEAD1234U);
+      Rand rng_b(kMatchSeed ^ 0x8BF86761U);
+
+      std::clock_t const kCpuStart = std::clock();
+      auto const kResult = rollback_test::RunPairToCompletion(
+          pair, transport,
+          [&](int peer, int) { return CombatInput(peer == 0 ? rng_a : rng_b, peer); }, max_frames,
+          input_acks);
+      t.cpu_seconds += static_cast<double>(std::clock() - kCpuStart) / CLOCKS_PER_SEC;
+
+      ++t.matches;
+      t.completed += kResult.reached_game_over ? 1 : 0;
+      t.desynced += kResult.desynced ? 1 : 0;
+      t.frames += static_cast<uint64_t>(kResult.frames_elapsed);
+      t.rollbacks += kResult.rollback_count_a + kResult.rollback_count_b;
+      t.resim_frames += kResult.resim_frames;
+      t.stall_ticks += kResult.stall_ticks;
+      t.desync_frames += kResult.desync_frames;
+      t.max_lag = std::max(t.max_lag, kResult.max_lag);
+      t.process_ns += kResult.process_ns;
+      t.packets_sent += transport.packets_sent;
+      t.packets_dropped += transport.packets_dropped;
+      t.bytes += transport.bytes_a_to_b + transport.bytes_b_to_a;
+      std::fprintf(stderr, "[bench] %s match %d/%d: %d frames, %" PRIu64 " rollbacks%s\n",
+                   p.name, m + 1, matches, kResult.frames_elapsed,
+                   kResult.rollback_count_a + kResult.rollback_count_b,
+                   kResult.desynced ? ", DESYNC" : "");
+    }
+  }
+
+  std::FILE* out = out_path ? std::fopen(out_path, "we") : stdout;
+  if (!out) {
+    std::fprintf(stderr, "cannot write %s\n", out_path);
+    return 1;
+  }
+  std::fprintf(out, "{\n");
+  std::fprintf(out, "  \"tool\": \"bench_netplay\",\n");
+  std::fprintf(out, "  \"seed\": %u,\n", seed);
+  std::fprintf(out, "  \"matches_per_profile\": %d,\n", matches);
+  std::fprintf(out, "  \"max_frames\": %d,\n", max_frames);
+  std::fprintf(out, "  \"input_acks\": %s,\n", input_acks ? "true" : "false");
+  std::fprintf(out, "  \"profiles\": [\n");
+  for (std::size_t pi = 0; pi < selected.size(); ++pi) {
+    PrintProfile(out, selected[pi], totals[pi], pi + 1 == selected.size());
+  }
+  std::fprintf(out, "  ]\n}\n");
+  if (out != stdout) {
+    std::fclose(out);  // NOLINT(cert-err33-c) — benchmark tool
+  }
+
+  bool any_desync = false;
+  for (Totals const& t : totals) {
+    any_desync = any_desync || t.desynced > 0;
+  }
+  return any_desync ? 1 : 0;
+} catch (std::exception& ex) {
+  std::fprintf(stderr, "EXCEPTION: %s\n", ex.what());
+  return 1;
+}
@@ -22,6 +22,9 @@ struct HeadlessGameConfig {
   int lives{3};
   int health{25};  // per-worm health after ResetWorms; 0 → keep WormSettings::health default
   int worm_count{2};
+  // Random level size (Settings::random_map_width / random_map_height).
+  int map_width{504};
+  int map_height{350};
 };
 
 // Returns a fully-initialized Game ready for ProcessFrame(), following the
@@ -37,6 +40,8 @@ inline std::unique_ptr<Game> MakeHeadlessGame(HeadlessGameConfig const& cfg = {}
   settings->lives = cfg.lives;
   settings->loading_time = 0;
   settings->random_level = true;
+  settings->random_map_width = cfg.map_width;
+  settings->random_map_height = cfg.map_height;
   settings->game_mode = cfg.game_mode;
 
   auto sp = std::make_shared<NullSoundPlayer>();
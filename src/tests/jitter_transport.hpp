@@ -3,14 +3,20 @@
 // In-process batched-input transport between two RollbackControllers.
 // Models per-packet random delivery delay, packet loss, and optional
 // duplication. Out-of-order arrival happens naturally because per-packet
-// delays are picked from a uniform distribution independently.
+// delays are picked from a uniform distribution independently; an extra
+// reorder probability holds single packets back past their successors.
+// An optional bandwidth cap serialises each direction's packets at their
+// kPacketTick wire size, tail-dropping once the backlog gets too deep.
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <random>
 #include <vector>
 
+#include "net/tickPacket.hpp"
 #include "rollback/buffer.hpp"
 
 namespace rollback_test {
@@ -22,9 +28,21 @@ struct JitterTransport {
     int max_delay_frames = 0;
     double loss_probability = 0.0;
     double duplicate_probability = 0.0;
+    // Chance a packet is held back 1..max(2, max_delay_frames) extra
+    // frames, so packets sent after it overtake it.
+    double reorder_probability = 0.0;
+    // Per-direction link rate; 0 = unlimited.
+    int bandwidth_bytes_per_sec = 0;
+    // Backlog, in frames of link time, past which a capped link drops.
+    int queue_limit_frames = 10;
   };
 
-  static constexpr std::size_t kMaxBatch = rollback::kMaxRollback + 1;
+  // Nominal tick rate, for converting the link rate to bytes per frame.
+  static constexpr int kFramesPerSec = 70;
+  // IPv4 + UDP + ENet protocol and unsequenced-send command headers.
+  static constexpr std::size_t kDatagramOverhead = 28 + 4 + 8;
+
+  static constexpr std::size_t kMaxBatch = rollback::kMaxRollbackLimit + 1;
 
   struct InFlight {
     int deliver_at_frame;
@@ -33,6 +51,7 @@ struct JitterTransport {
     uint8_t count;
     std::array<uint8_t, kMaxBatch> inputs;
     uint32_t local_frame;
+    uint16_t seq;
   };
 
   // The on-wire generation byte travels through the transport so the
@@ -50,6 +69,14 @@ struct JitterTransport {
   uint64_t packets_sent = 0;
   uint64_t packets_dropped = 0;
   uint64_t packets_duplicated = 0;
+  uint64_t packets_reordered = 0;
+  // Wire bytes offered to each direction, dropped packets included.
+  uint64_t bytes_a_to_b = 0;
+  uint64_t bytes_b_to_a = 0;
+  // Receive-side loss estimates, as each peer's transport would report
+  // them back in its acks.
+  LossMeter loss_seen_by_a;
+  LossMeter loss_seen_by_b;
 
   explicit JitterTransport(Params p) : params(p), rng(p.seed) {}
 
@@ -73,11 +100,24 @@ struct JitterTransport {
 
   void SendAToB(uint8_t generation, uint32_t base_frame, uint8_t count, uint8_t const* inputs,
                 uint32_t local_frame) {
-    Enqueue(a_to_b, generation, base_frame, count, inputs, local_frame);
+    bytes_a_to_b += Enqueue(a_to_b, a_link_, generation, base_frame, count, inputs, local_frame);
   }
   void SendBToA(uint8_t generation, uint32_t base_frame, uint8_t count, uint8_t const* inputs,
                 uint32_t local_frame) {
-    Enqueue(b_to_a, generation, base_frame, count, inputs, local_frame);
+    bytes_b_to_a += Enqueue(b_to_a, b_link_, generation, base_frame, count, inputs, local_frame);
+  }
+
+  // Size of the kPacketTick carrying this window, datagram headers
+  // included. Checksums aren't modelled.
+  static std::size_t WireBytes(uint8_t count, uint8_t const* inputs, uint32_t base_frame,
+                               uint32_t local_frame) {
+    TickPacket t;
+    t.base_frame = base_frame;
+    t.count = count;
+    t.lag = static_cast<uint8_t>(std::min<uint32_t>(t.NewestFrame() - local_frame, count - 1U));
+    std::copy_n(inputs, count, t.inputs.begin());
+    uint8_t buf[TickPacket::kMaxSize];
+    return kDatagramOverhead + 1 + EncodeTickPacket(t, buf);
   }
 
   // Drain anything whose deliverAtFrame has elapsed, then advance the
@@ -85,8 +125,8 @@ struct JitterTransport {
   // packet may carry a later deliverAtFrame than a packet queued after
   // it, exactly modelling jittery out-of-order delivery.
   void Tick(Deliver const& deliver_a, Deliver const& deliver_b) {
-    DrainDue(a_to_b, deliver_b);
-    DrainDue(b_to_a, deliver_a);
+    DrainDue(a_to_b, loss_seen_by_b, deliver_b);
+    DrainDue(b_to_a, loss_seen_by_a, deliver_a);
     ++current_frame;
   }
 
@@ -94,9 +134,11 @@ struct JitterTransport {
   // converge both peers regardless of how late tail packets were.
   void Flush(Deliver const& deliver_a, Deliver const& deliver_b) {
     for (auto const& p : a_to_b) {
+      loss_seen_by_b.OnSeq(p.seq);
       deliver_b(p.generation, p.base_frame, p.count, p.inputs.data(), p.local_frame);
     }
     for (auto const& p : b_to_a) {
+      loss_seen_by_a.OnSeq(p.seq);
       deliver_a(p.generation, p.base_frame, p.count, p.inputs.data(), p.local_frame);
     }
     a_to_b.clear();
@@ -106,15 +148,46 @@ struct JitterTransport {
   bool Empty() const { return a_to_b.empty() && b_to_a.empty(); }
 
  private:
-  void Enqueue(std::vector<InFlight>& q, uint8_t generation, uint32_t base_frame, uint8_t count,
-               uint8_t const* inputs, uint32_t local_frame) {
+  // One direction's sender side.
+  struct Link {
+    uint16_t seq = 0;
+    // Frame (fractional) at which the link finishes sending its backlog.
+    double free_at = 0.0;
+  };
+
+  // Returns the packet's wire size.
+  std::size_t Enqueue(std::vector<InFlight>& q, Link& link, uint8_t generation,
+                      uint32_t base_frame, uint8_t count, uint8_t const* inputs,
+                      uint32_t local_frame) {
     ++packets_sent;
+    ++link.seq;
+    std::size_t const kBytes = WireBytes(count, inputs, base_frame, local_frame);
     if (Roll(params.loss_probability)) {
       ++packets_dropped;
-      return;
+      return kBytes;
+    }
+    // On a capped link the packet first waits for the ones ahead of it.
+    int serialize_delay = 0;
+    if (params.bandwidth_bytes_per_sec > 0) {
+      double const kNow = current_frame;
+      double const kStart = std::max(kNow, link.free_at);
+      if (kStart - kNow > params.queue_limit_frames) {
+        ++packets_dropped;
+        return kBytes;
+      }
+      double const kBytesPerFrame =
+          static_cast<double>(params.bandwidth_bytes_per_sec) / kFramesPerSec;
+      link.free_at = kStart + (static_cast<double>(kBytes) / kBytesPerFrame);
+      serialize_delay = static_cast<int>(link.free_at - kNow);
     }
     InFlight p{};
-    p.deliver_at_frame = current_frame + RandomDelay();
+    p.deliver_at_frame = current_frame + serialize_delay + RandomDelay();
+    if (Roll(params.reorder_probability)) {
+      ++packets_reordered;
+      std::uniform_int_distribution<int> extra(1, std::max(2, params.max_delay_frames));
+      p.deliver_at_frame += extra(rng);
+    }
+    p.seq = link.seq;
     p.generation = generation;
     p.base_frame = base_frame;
     p.count = count;
@@ -126,15 +199,17 @@ struct JitterTransport {
     if (Roll(params.duplicate_probability)) {
       ++packets_duplicated;
       InFlight d = p;
-      d.deliver_at_frame = current_frame + RandomDelay();
+      d.deliver_at_frame = current_frame + serialize_delay + RandomDelay();
       q.push_back(d);
     }
+    return kBytes;
   }
 
-  void DrainDue(std::vector<InFlight>& q, Deliver const& deliver) const {
+  void DrainDue(std::vector<InFlight>& q, LossMeter& loss, Deliver const& deliver) const {
     auto it = q.begin();
     while (it != q.end()) {
       if (it->deliver_at_frame <= current_frame) {
+        loss.OnSeq(it->seq);
         deliver(it->generation, it->base_frame, it->count, it->inputs.data(), it->local_frame);
         it = q.erase(it);
       } else {
@@ -142,6 +217,9 @@ struct JitterTransport {
       }
     }
   }
+
+  Link a_link_;
+  Link b_link_;
 };
 
 }  // namespace rollback_test
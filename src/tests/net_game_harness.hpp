@@ -29,6 +29,7 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <map>
@@ -47,6 +48,7 @@ struct NetGameConfig {
   int game_mode{Settings::kGmKillEmAll};
   int lives{1};
   int health{15};  // per-worm spawn health; 0 → keep WormSettings default
+  int max_rollback{rollback::kMaxRollback};  // negotiated rollback window
 };
 
 // The two controllers plus the env keeping their shared Common/Settings
@@ -87,10 +89,12 @@ inline RollbackPair MakeRollbackPair(NetGameConfig const& cfg = {}) {
   pair.b = std::make_unique<RollbackController>(common, settings, 1);
   pair.a->SetSkipWeaponSelection(/*skip=*/true);
   pair.b->SetSkipWeaponSelection(/*skip=*/true);
+  pair.a->SetMaxRollback(cfg.max_rollback);
+  pair.b->SetMaxRollback(cfg.max_rollback);
   // The frame-advantage stall is a time-sync clamp orthogonal to the
   // rollback algorithm; disable it so the peers freely run ahead and
   // exercise prediction, exactly as the rollback correctness/loss tests
-  // do. Confirmation lag is still bounded by the ring (kMaxRollback).
+  // do. Confirmation lag is still bounded by the ring (max_rollback).
   pair.a->SetFrameAdvantageEnabled(/*enabled=*/false);
   pair.b->SetFrameAdvantageEnabled(/*enabled=*/false);
   // Identical world RNG on both peers — without this the per-frame
@@ -106,9 +110,13 @@ struct NetRunResult {
   bool reached_game_over{false};  // both peers latched kStateGameEnded
   bool desynced{false};           // a confirmed-frame checksum disagreed
   uint64_t compared_frames{0};    // confirmed frames compared (>0 ⇒ non-vacuous)
+  uint64_t desync_frames{0};      // of those, how many disagreed
   uint64_t rollback_count_a{0};
   uint64_t rollback_count_b{0};
   uint32_t max_lag{0};  // max(simFrame - (confirmedFrame+1)) over both, post-warmup
+  uint64_t resim_frames{0};  // frames resimulated by both peers
+  uint64_t stall_ticks{0};   // peer ticks that didn't advance simFrame, both peers
+  int64_t process_ns{0};     // wall time inside both peers' Process()
 };
 
 // input_fn(peer_idx, frame) returns the 7-bit control byte for that
@@ -116,8 +124,13 @@ struct NetRunResult {
 // already reached game-over is fed idle input.
 using PairInputFn = std::function<uint8_t(int peer_idx, int frame)>;
 
+// `input_acks` feeds each delivered batch's receiver the sender's ack
+// and measured loss, as kPacketTick carries them, so input windows
+// shrink to the unacked frames. The ack is read at delivery rather than
+// at send; it only grows, so it is never staler than the wire's.
 inline NetRunResult RunPairToCompletion(RollbackPair& pair, JitterTransport& transport,
-                                        PairInputFn const& input_fn, int max_frames = 200000) {
+                                        PairInputFn const& input_fn, int max_frames = 200000,
+                                        bool input_acks = false) {
   RollbackController& a = *pair.a;
   RollbackController& b = *pair.b;
 
@@ -136,6 +149,7 @@ inline NetRunResult RunPairToCompletion(RollbackPair& pair, JitterTransport& tra
       ++res.compared_frames;
       if (it->second != chk) {
         res.desynced = true;
+        ++res.desync_frames;
       }
     }
   };
@@ -164,9 +178,15 @@ inline NetRunResult RunPairToCompletion(RollbackPair& pair, JitterTransport& tra
 
   auto deliver_a = [&](uint8_t gen, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
     a.InjectRemoteBatch(gen, bf, c, in, lf);
+    if (input_acks) {
+      a.InjectInputAck(gen, b.RemoteInputNeeded(), transport.loss_seen_by_b.LossQ8());
+    }
   };
   auto deliver_b = [&](uint8_t gen, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
     b.InjectRemoteBatch(gen, bf, c, in, lf);
+    if (input_acks) {
+      b.InjectInputAck(gen, a.RemoteInputNeeded(), transport.loss_seen_by_a.LossQ8());
+    }
   };
 
   int frame = 0;
@@ -179,8 +199,19 @@ inline NetRunResult RunPairToCompletion(RollbackPair& pair, JitterTransport& tra
 
     a.SetLocalControlState(kAOver ? uint8_t{0} : input_fn(0, frame));
     b.SetLocalControlState(kBOver ? uint8_t{0} : input_fn(1, frame));
+    uint32_t const kPrevA = a.CurrentFrame();
+    uint32_t const kPrevB = b.CurrentFrame();
+    auto const kStart = std::chrono::steady_clock::now();
     a.Process();
     b.Process();
+    res.process_ns +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             kStart)
+            .count();
+    res.resim_frames += a.LastTickResimFrames() + b.LastTickResimFrames();
+    // Past game over a peer only idles toward the end of the run.
+    res.stall_ticks += static_cast<uint64_t>(!kAOver && a.CurrentFrame() == kPrevA) +
+                       static_cast<uint64_t>(!kBOver && b.CurrentFrame() == kPrevB);
     transport.Tick(deliver_a, deliver_b);
 
     // Skip the warm-up window so it doesn't pollute the running maximum.
@@ -0,0 +1,286 @@
+// Heap allocation tracking (alloc_tracker.hpp) and the allocation-free
+// steady state it guards.
+//
+// This target links the counting operator new (alloc_hooks), so every
+// allocation on the test thread is visible. Verifies:
+//   1. The tracker counts this thread's allocations, and only those.
+//   2. Zones charge allocations to the innermost zone.
+//   3. After warm-up, Game::ProcessFrame allocates nothing.
+//   4. After warm-up, SaveSnapshotFast, LoadSnapshotFast and a rollback
+//      resim through the RollbackBuffer allocate nothing, with whole-level
+//      slots and with delta slots on a large level that keeps being dug.
+//
+// Work on other threads (the stats consumer folding events into its
+// aggregates) is outside what these tests count, by design: the game
+// thread only has to hand it over without allocating.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "alloc_tracker.hpp"
+#include "game_harness.hpp"
+#include "rand.hpp"
+#include "rollback/buffer.hpp"
+#include "serialization/fast_snapshot.hpp"
+
+namespace {
+
+// Allocations `fn` makes on the calling thread.
+template <typename F>
+uint64_t AllocationsDuring(F const& fn) {
+  alloc_tracker::Counts const kBefore = alloc_tracker::ThreadCounts();
+  fn();
+  return (alloc_tracker::ThreadCounts() - kBefore).allocations;
+}
+
+// Busy scripted play, as in test_snapshot_fast: moving, digging, firing
+// and changing weapons, so worms die and respawn during the run.
+uint8_t ScriptedInput(Rand& input_rng, int idx) {
+  uint32_t input = input_rng() & 0x7f;
+  if ((input_rng() % 10) < 6) {
+    input |= (1 << 4);
+  }
+  if ((input_rng() % 10) < 4) {
+    input |= (1 << (idx == 0 ? 1 : 0));
+  }
+  return static_cast<uint8_t>(input);
+}
+
+void SetInputs(Game& game, Rand& input_rng) {
+  for (int idx = 0; idx < 2; ++idx) {
+    game.worms[idx]->control_states.Unpack(ScriptedInput(input_rng, idx));
+  }
+}
+
+// Long enough for the first spawns, deaths, respawns and bonus drops, and
+// for the stats pipeline to start its consumer thread.
+constexpr int kWarmUpFrames = 1500;
+
+}  // namespace
+
+TEST_CASE("alloc_tracker counts this thread's allocations", "[alloc]") {
+  REQUIRE(alloc_tracker::Installed());
+
+  alloc_tracker::Counts const kBefore = alloc_tracker::ThreadCounts();
+  void* p = ::operator new(100);
+  void* q = ::operator new[](28, std::align_val_t{64});
+  alloc_tracker::Counts const kDelta = alloc_tracker::ThreadCounts() - kBefore;
+  bool const kAligned = reinterpret_cast<std::uintptr_t>(q) % 64 == 0;
+  ::operator delete[](q, std::align_val_t{64});
+  ::operator delete(p);
+
+  CHECK(kDelta.allocations == 2);
+  CHECK(kDelta.bytes == 128);
+  CHECK(kAligned);
+}
+
+TEST_CASE("alloc_tracker ignores other threads", "[alloc]") {
+  std::atomic<bool> go{false};
+  alloc_tracker::Counts worker_delta;
+  std::thread worker([&] {
+    while (!go.load()) {
+      std::this_thread::yield();
+    }
+    alloc_tracker::Counts const kBefore = alloc_tracker::ThreadCounts();
+    for (int i = 0; i < 5; ++i) {
+      ::operator delete(::operator new(16));
+    }
+    worker_delta = alloc_tracker::ThreadCounts() - kBefore;
+  });
+
+  alloc_tracker::Counts const kBefore = alloc_tracker::ThreadCounts();
+  go.store(true);
+  worker.join();
+  alloc_tracker::Counts const kDelta = alloc_tracker::ThreadCounts() - kBefore;
+
+  CHECK(kDelta.allocations == 0);
+  CHECK(worker_delta.allocations == 5);
+}
+
+TEST_CASE("alloc_tracker charges the innermost zone", "[alloc]") {
+  static char const kOuter[] = "test::Outer";
+  static char const kInner[] = "test::Inner";
+
+  alloc_tracker::ResetThreadZones();
+  {
+    alloc_tracker::Zone const kOuterZone(kOuter);
+    ::operator delete(::operator new(10));
+    {
+      alloc_tracker::Zone const kInnerZone(kInner);
+      for (int i = 0; i < 3; ++i) {
+        ::operator delete(::operator new(20));
+      }
+    }
+    ::operator delete(::operator new(30));
+  }
+  ::operator delete(::operator new(40));  // outside every zone
+  auto const kZones = alloc_tracker::ThreadZones();
+
+  REQUIRE(kZones.size() == 2);
+  CHECK(kZones[0].name == kInner);
+  CHECK(kZones[0].counts.allocations == 3);
+  CHECK(kZones[0].counts.bytes == 60);
+  CHECK(kZones[1].name == kOuter);
+  CHECK(kZones[1].counts.allocations == 2);
+  CHECK(kZones[1].counts.bytes == 40);
+
+  SECTION("zones past the table's size are lumped together") {
+    static char const kNames[alloc_tracker::kMaxZones + 6][2] = {};
+    alloc_tracker::ResetThreadZones();
+    for (auto const& name : kNames) {
+      alloc_tracker::Zone const kZone(name);
+      ::operator delete(::operator new(1));
+    }
+    auto const kAll = alloc_tracker::ThreadZones();
+
+    REQUIRE(kAll.size() == alloc_tracker::kMaxZones);
+    CHECK(std::string_view(kAll[0].name) == "(other zones)");
+    CHECK(kAll[0].counts.allocations == 7);
+  }
+}
+
+TEST_CASE("Steady-state ProcessFrame doesn't allocate", "[alloc][game]") {
+  auto game = MakeHeadlessGame({.lives = 50});
+  Rand input_rng(0xA110C);
+  for (int f = 0; f < kWarmUpFrames; ++f) {
+    SetInputs(*game, input_rng);
+    game->ProcessFrame();
+  }
+
+  uint64_t const kAllocations = AllocationsDuring([&] {
+    for (int f = 0; f < 2000; ++f) {
+      SetInputs(*game, input_rng);
+      game->ProcessFrame();
+    }
+  });
+  REQUIRE(kAllocations == 0);
+}
+
+TEST_CASE("Snapshots and rollback resim don't allocate after warm-up", "[alloc][rollback]") {
+  auto game = MakeHeadlessGame({.lives = 50});
+  rollback::RollbackBuffer buffer;
+  buffer.Prepare(*game);
+  REQUIRE(buffer.StorageFor(game->level) == GameSnapshot::LevelStorage::kFull);
+
+  // Forward play as the rollback controller does it: snapshot the state
+  // each frame starts from, keyed by frame, alongside its inputs.
+  Rand input_rng(0xB0B);
+  int frame = 0;
+  auto advance = [&] {
+    rollback::Slot& slot = buffer.Write(frame);
+    game->SaveSnapshotFast(slot.snapshot);
+    slot.local_input = ScriptedInput(input_rng, 0);
+    slot.remote_input = ScriptedInput(input_rng, 1);
+    game->worms[0]->control_states.Unpack(slot.local_input);
+    game->worms[1]->control_states.Unpack(slot.remote_input);
+    game->ProcessFrame();
+    ++frame;
+  };
+  for (int f = 0; f < kWarmUpFrames; ++f) {
+    advance();
+  }
+
+  SECTION("save and load") {
+    GameSnapshot& snap = buffer.Write(frame).snapshot;
+    uint64_t const kSaveAllocations = AllocationsDuring([&] { game->SaveSnapshotFast(snap); });
+    uint64_t const kLoadAllocations = AllocationsDuring([&] { game->LoadSnapshotFast(snap); });
+    REQUIRE(kSaveAllocations == 0);
+    REQUIRE(kLoadAllocations == 0);
+  }
+
+  SECTION("resim") {
+    // Restore the oldest resident frame and replay up to the present,
+    // re-saving each slot, as a late confirmed input would trigger. The
+    // inputs are unchanged, so no cell is dug for the first time. First
+    // digs append to Level::dirty_list, which whole-level slots keep for
+    // the whole match; the delta case below covers play that keeps digging.
+    uint64_t const kAllocations = AllocationsDuring([&] {
+      for (int round = 0; round < 50; ++round) {
+        int const kFrom = buffer.OldestFrame();
+        game->LoadSnapshotFast(buffer.Find(kFrom)->snapshot);
+        game->SetSpeculative(true);
+        for (int f = kFrom; f < frame; ++f) {
+          rollback::Slot& slot = *buffer.Find(f);
+          game->SaveSnapshotFast(slot.snapshot);
+          game->worms[0]->control_states.Unpack(slot.local_input);
+          game->worms[1]->control_states.Unpack(slot.remote_input);
+          game->ProcessFrame<Game::FrameMode::kSimOnly>();
+        }
+        game->SetSpeculative(false);
+      }
+    });
+    REQUIRE(kAllocations == 0);
+  }
+}
+
+TEST_CASE("Delta snapshots don't allocate while the level is dug", "[alloc][rollback]") {
+  // Too big for whole-level copies across the widest window.
+  auto game = MakeHeadlessGame({.lives = 50, .map_width = 2048, .map_height = 1536});
+  rollback::RollbackBuffer buffer;
+  buffer.Resize(static_cast<std::size_t>(rollback::kMaxRollbackLimit) + 1);
+  buffer.Prepare(*game);
+  REQUIRE(buffer.StorageFor(game->level) == GameSnapshot::LevelStorage::kDelta);
+
+  // As the rollback controller does it, with the confirmed frame a full
+  // default window behind and a low rebase threshold, so the delta base
+  // moves all through the run rather than once the list is long.
+  constexpr int kLag = rollback::kMaxRollback;
+  constexpr std::size_t kRebaseCells = 256;
+  std::vector<GameSnapshot*> later;
+  later.reserve(buffer.Capacity());
+  Rand input_rng(0xDE17A);
+  int frame = 0;
+  auto advance = [&] {
+    rollback::Slot& slot = buffer.Write(frame);
+    game->SaveSnapshotFast(slot.snapshot);
+    slot.local_input = ScriptedInput(input_rng, 0);
+    slot.remote_input = ScriptedInput(input_rng, 1);
+    game->worms[0]->control_states.Unpack(slot.local_input);
+    game->worms[1]->control_states.Unpack(slot.remote_input);
+    game->ProcessFrame();
+    ++frame;
+    rollback::Slot* base = buffer.Find(frame - 1 - kLag);
+    if (!base) {
+      return;
+    }
+    later.clear();
+    for (int f = frame - kLag; f < frame; ++f) {
+      later.push_back(&buffer.Find(f)->snapshot);
+    }
+    game->RebaseLevelDelta(base->snapshot, later, kRebaseCells);
+  };
+  for (int f = 0; f < kWarmUpFrames; ++f) {
+    advance();
+  }
+  uint32_t const kWarmEpoch = game->level.delta_epoch;
+  REQUIRE(kWarmEpoch > 1);
+
+  uint64_t const kAllocations = AllocationsDuring([&] {
+    for (int f = 0; f < 2000; ++f) {
+      advance();
+    }
+    // A late confirmed input: back to the confirmed frame and forward
+    // again, re-saving each slot.
+    int const kFrom = frame - 1 - kLag;
+    game->LoadSnapshotFast(buffer.Find(kFrom)->snapshot);
+    game->SetSpeculative(true);
+    for (int f = kFrom; f < frame; ++f) {
+      rollback::Slot& slot = *buffer.Find(f);
+      game->SaveSnapshotFast(slot.snapshot);
+      game->worms[0]->control_states.Unpack(slot.local_input);
+      game->worms[1]->control_states.Unpack(slot.remote_input);
+      game->ProcessFrame<Game::FrameMode::kSimOnly>();
+    }
+    game->SetSpeculative(false);
+  });
+  // Digging went on (the base kept moving) without touching the heap.
+  REQUIRE(game->level.delta_epoch > kWarmEpoch);
+  REQUIRE(kAllocations == 0);
+}
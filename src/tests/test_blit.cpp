@@ -454,3 +454,74 @@ TEST_CASE("spectator-resize: freeze-restore must not shrink renderer bmp",
   REQUIRE(renderer.bmp.pitch == static_cast<unsigned int>(renderer.render_res_x));
   REQUIRE(renderer.bmp.h == renderer.render_res_y);
 }
+
+TEST_CASE("heatmap keeps the classic half-resolution grid", "[blit][heatmap]") {
+  Heatmap hm(504, 350);
+  REQUIRE(hm.width == 252);
+  REQUIRE(hm.height == 175);
+  // Nothing allocated until the first sample.
+  REQUIRE(hm.map.empty());
+
+  hm.Inc(11, 7);
+  hm.Inc(10, 6, 2);
+  hm.Inc(-5, 9999);
+  REQUIRE(hm.At(5, 3) == 3);
+  REQUIRE(hm.At(0, 174) == 1);
+}
+
+TEST_CASE("heatmap size is independent of the level", "[blit][heatmap]") {
+  Heatmap hm(4096, 4096);
+  REQUIRE(hm.width <= Heatmap::kMaxSide);
+  REQUIRE(hm.height <= Heatmap::kMaxSide);
+  hm.Inc(4095, 4095);
+  hm.IncArea(2048, 100, 3);
+  hm.Flush();
+  REQUIRE(hm.At(hm.width - 1, hm.height - 1) == 1);
+  REQUIRE(hm.MemoryBytes() <= 300 * 1024);
+
+  Heatmap wide(8192, 350);
+  REQUIRE(wide.width == Heatmap::kMaxSide);
+  REQUIRE(wide.height * wide.cell_size >= 350);
+}
+
+TEST_CASE("heatmap splats are applied on flush", "[blit][heatmap]") {
+  Heatmap hm(504, 350);
+  hm.IncArea(100, 100, 2);
+  hm.IncArea(101, 101, 3);  // same cell: merged
+  REQUIRE(hm.At(50, 50) == 0);
+  hm.Flush();
+  // 5x5 kernel, weight 16 - (dx * dy)²: 16 along the axes, 0 at the
+  // far corners.
+  REQUIRE(hm.At(50, 50) == 5 * 16);
+  REQUIRE(hm.At(52, 50) == 5 * 16);
+  REQUIRE(hm.At(51, 51) == 5 * 15);
+  REQUIRE(hm.At(51, 52) == 5 * 12);
+  REQUIRE(hm.At(52, 52) == 0);
+  REQUIRE(hm.At(53, 50) == 0);
+
+  // Clipped at the edge.
+  hm.IncArea(0, 0, 1);
+  hm.Flush();
+  REQUIRE(hm.At(0, 0) == 16);
+  REQUIRE(hm.At(1, 1) == 15);
+}
+
+TEST_CASE("drawheatmap resamples to the requested size", "[blit][heatmap]") {
+  Renderer renderer;
+  renderer.Init(16, 16);
+  renderer.UpdatePal32();
+  Fill(renderer.bmp, 1);
+
+  Heatmap hm(8, 8);  // 4x4 cells of 2x2 pixels
+  hm.Inc(0, 0);
+  hm.Inc(7, 7, 5);
+  DrawHeatmap(renderer.bmp, 0, 0, hm, 8, 8);
+
+  // Values rank into the heat ramp; the empty cells use index 0.
+  REQUIRE(renderer.bmp.GetPixel(0, 0) == renderer.pal32[104]);
+  REQUIRE(renderer.bmp.GetPixel(1, 1) == renderer.pal32[104]);
+  REQUIRE(renderer.bmp.GetPixel(7, 7) == renderer.pal32[112]);
+  REQUIRE(renderer.bmp.GetPixel(3, 3) == renderer.pal32[0]);
+  // Nothing drawn outside the destination rect.
+  REQUIRE(renderer.bmp.GetPixel(8, 8) == renderer.pal32[1]);
+}
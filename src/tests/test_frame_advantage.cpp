@@ -12,6 +12,8 @@
 #include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <cstdint>
+#include <deque>
+#include <map>
 #include <memory>
 
 #include "controller/rollbackController.hpp"
@@ -20,6 +22,7 @@
 #include "math.hpp"
 #include "mixer/player.hpp"
 #include "rollback/buffer.hpp"
+#include "rollback/time_sync.hpp"
 
 namespace {
 
@@ -145,3 +148,108 @@ TEST_CASE("Frame advantage caps the simFrame gap under asymmetric delay",
     REQUIRE(r.max_abs_gap <= 2 * RollbackController::kFrameAdvantage);
   }
 }
+
+// With time sync wired both peers measure the link, agree on a larger
+// input delay and keep producing identical confirmed checksums while the
+// delay changes under them.
+TEST_CASE("Time sync raises input delay on a slow link and peers stay in sync",
+          "[rollback][frame-advantage][time-sync]") {
+  auto [common, settings] = MakeEnv();
+  auto a = std::make_unique<RollbackController>(common, settings, 0);
+  auto b = std::make_unique<RollbackController>(common, settings, 1);
+  a->SetSkipWeaponSelection(/*skip=*/true);
+  b->SetSkipWeaponSelection(/*skip=*/true);
+  a->SetInputDelay(1);
+  b->SetInputDelay(1);
+  a->game.rand.Seed(0xBEEF);
+  b->game.rand.Seed(0xBEEF);
+
+  constexpr int kOneWay = 8;
+  rollback_test::JitterTransport t_ab({.seed = 0x1111,
+                                       .min_delay_frames = kOneWay,
+                                       .max_delay_frames = kOneWay,
+                                       .loss_probability = 0.0,
+                                       .duplicate_probability = 0.0});
+  rollback_test::JitterTransport t_ba({.seed = 0x2222,
+                                       .min_delay_frames = kOneWay,
+                                       .max_delay_frames = kOneWay,
+                                       .loss_probability = 0.0,
+                                       .duplicate_probability = 0.0});
+  a->SetInputCallbacks([&](uint8_t gen, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    t_ab.SendAToB(gen, bf, c, in, lf);
+  });
+  b->SetInputCallbacks([&](uint8_t gen, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    t_ba.SendAToB(gen, bf, c, in, lf);
+  });
+
+  struct SyncInFlight {
+    int deliver_at;
+    rollback::TimeSyncMessage msg;
+  };
+  std::deque<SyncInFlight> sync_to_a;
+  std::deque<SyncInFlight> sync_to_b;
+  int tick = 0;
+  a->SetTimeSyncCallback([&](rollback::TimeSyncMessage const& m) {
+    sync_to_b.push_back({.deliver_at = tick + kOneWay, .msg = m});
+  });
+  b->SetTimeSyncCallback([&](rollback::TimeSyncMessage const& m) {
+    sync_to_a.push_back({.deliver_at = tick + kOneWay, .msg = m});
+  });
+
+  std::map<uint32_t, uint32_t> a_checks;
+  std::map<uint32_t, uint32_t> b_checks;
+  a->SetChecksumCallback([&](uint8_t /*gen*/, uint32_t f, uint32_t c) { a_checks[f] = c; });
+  b->SetChecksumCallback([&](uint8_t /*gen*/, uint32_t f, uint32_t c) { b_checks[f] = c; });
+
+  a->Focus();
+  b->Focus();
+  a->InjectRemoteInput(0, 0);
+  b->InjectRemoteInput(0, 0);
+
+  auto deliver_b = [&](uint8_t /*gen*/, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    b->InjectRemoteBatch(bf, c, in, lf);
+  };
+  auto deliver_a = [&](uint8_t /*gen*/, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    a->InjectRemoteBatch(bf, c, in, lf);
+  };
+  auto deliver_noop = [&](uint8_t, uint32_t, uint8_t, uint8_t const*, uint32_t) {};
+
+  for (tick = 0; tick < 1500; ++tick) {
+    // Changing inputs so a delay change that dropped or duplicated a
+    // frame's input would show up as a checksum mismatch.
+    a->SetLocalControlState(static_cast<uint8_t>((tick / 5) & 0x7f));
+    b->SetLocalControlState(static_cast<uint8_t>((tick / 9 * 3) & 0x7f));
+    a->Process();
+    b->Process();
+    t_ab.Tick(deliver_noop, deliver_b);
+    t_ba.Tick(deliver_noop, deliver_a);
+    while (!sync_to_b.empty() && sync_to_b.front().deliver_at <= tick) {
+      b->InjectTimeSync(sync_to_b.front().msg);
+      sync_to_b.pop_front();
+    }
+    while (!sync_to_a.empty() && sync_to_a.front().deliver_at <= tick) {
+      a->InjectTimeSync(sync_to_a.front().msg);
+      sync_to_a.pop_front();
+    }
+  }
+
+  INFO("rttA=" << a->TimeSync().RttTicks() << " delayA=" << a->InputDelay()
+               << " delayB=" << b->InputDelay());
+  REQUIRE(a->TimeSync().HasRtt());
+  REQUIRE(a->TimeSync().RttTicks() >= 2.0F * kOneWay - 2.0F);
+  REQUIRE(a->InputDelay() > 1);
+  REQUIRE(a->InputDelay() == b->InputDelay());
+
+  std::size_t compared = 0;
+  for (auto const& [frame, sum] : a_checks) {
+    auto it = b_checks.find(frame);
+    if (it != b_checks.end()) {
+      REQUIRE(it->second == sum);
+      ++compared;
+    }
+  }
+  REQUIRE(compared > 500);
+
+  REQUIRE(a->RollbackDepthHistogram().Total() == a->RollbackCount());
+  REQUIRE(b->RollbackDepthHistogram().Total() == b->RollbackCount());
+}
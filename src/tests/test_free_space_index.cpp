@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <set>
+#include <utility>
+
+#include "common.hpp"
+#include "free_space_index.hpp"
+#include "level.hpp"
+#include "rand.hpp"
+
+// FreeSpaceIndex answers the spawn and bonus placement rect tests; they
+// must match a cell-by-cell walk exactly, including after level damage.
+
+static void FillMaterials(Common& common) {
+  for (int i = 0; i < 256; ++i) {
+    common.materials[i].flags = static_cast<uint8_t>(i & 0x3f);
+  }
+}
+
+static void FillLevel(Level& level, Common& common, int w, int h, uint32_t seed) {
+  Rand rand(seed);
+  level.Resize(w, h);
+  for (std::size_t i = 0; i < level.material_id.size(); ++i) {
+    // Mostly open, so free rects of spawn size exist.
+    auto const kPix = static_cast<uint8_t>(rand(10) == 0 ? rand(256) : 8);
+    level.material_id[i] = kPix;
+    level.materials[i] = common.materials[kPix];
+  }
+}
+
+static int Walk(Level& level, Rect rect, uint8_t flags) {
+  rect.Intersect(level.Bounds());
+  int blocked = 0;
+  for (int y = rect.y1; y < rect.y2; ++y) {
+    for (int x = rect.x1; x < rect.x2; ++x) {
+      blocked += (level.Mat(x, y).flags & flags) != 0 ? 1 : 0;
+    }
+  }
+  return blocked;
+}
+
+static void RequireMatchesWalk(Level& level, FreeSpaceIndex& index, uint8_t flags,
+                               uint32_t seed) {
+  Rand rand(seed);
+  for (int i = 0; i < 3000; ++i) {
+    int const kX = static_cast<int>(rand(level.width + 40)) - 20;
+    int const kY = static_cast<int>(rand(level.height + 40)) - 20;
+    // Mostly spawn-sized, sometimes spanning many tiles.
+    int const kMax = rand(8) == 0 ? 200 : 12;
+    Rect const kRect(kX, kY, kX + static_cast<int>(rand(kMax)),
+                     kY + static_cast<int>(rand(kMax)));
+    REQUIRE(index.Blocked(level, kRect) == Walk(level, kRect, flags));
+    REQUIRE(index.Free(level, kRect) == (Walk(level, kRect, flags) == 0));
+  }
+}
+
+TEST_CASE("FreeSpaceIndex matches a cell walk", "[free-space]") {
+  Common common;
+  FillMaterials(common);
+  Level level(common);
+  // Not a multiple of the tile size on either axis.
+  FillLevel(level, common, 301, 203, 1);
+
+  REQUIRE(level.rock_space.Free(level, Rect(5, 5, 5, 9)));  // empty rect
+  RequireMatchesWalk(level, level.rock_space, Material::kRock, 2);
+  RequireMatchesWalk(level, level.dirt_rock_space,
+                     Material::kDirt | Material::kDirt2 | Material::kRock, 3);
+}
+
+TEST_CASE("FreeSpaceIndex follows level changes", "[free-space]") {
+  Common common;
+  FillMaterials(common);
+  Level level(common);
+  FillLevel(level, common, 260, 140, 4);
+  level.InitDirtyTracking();
+  RequireMatchesWalk(level, level.rock_space, Material::kRock, 5);
+
+  SECTION("cells written through SetPixel") {
+    Rand rand(6);
+    for (int i = 0; i < 500; ++i) {
+      level.SetPixel(static_cast<int>(rand(level.width)), static_cast<int>(rand(level.height)),
+                     static_cast<PalIdx>(rand(256)), common);
+    }
+    RequireMatchesWalk(level, level.rock_space, Material::kRock, 7);
+  }
+
+  SECTION("a level replaced wholesale") {
+    Level other(common);
+    FillLevel(other, common, 190, 330, 8);
+    level.Swap(other);
+    RequireMatchesWalk(level, level.rock_space, Material::kRock, 9);
+    RequireMatchesWalk(other, other.rock_space, Material::kRock, 10);
+
+    Rand rand(11);
+    for (auto& id : level.material_id) {
+      id = static_cast<uint8_t>(rand(256));
+    }
+    level.RebuildMaterials(common);
+    RequireMatchesWalk(level, level.rock_space, Material::kRock, 12);
+  }
+
+  SECTION("a copied level") {
+    Level copy(level);
+    copy.SetPixel(3, 3, Material::kRock, common);
+    RequireMatchesWalk(copy, copy.rock_space, Material::kRock, 13);
+    RequireMatchesWalk(level, level.rock_space, Material::kRock, 14);
+  }
+}
+
+TEST_CASE("FreeSpaceIndex samples every free position", "[free-space]") {
+  Common common;
+  FillMaterials(common);
+  Level level(common);
+  level.Resize(40, 30);
+  for (std::size_t i = 0; i < level.material_id.size(); ++i) {
+    level.material_id[i] = Material::kRock;
+    level.materials[i] = common.materials[Material::kRock];
+  }
+  // Two 4x3 holes: the 3x2 rects fit in 2 * 2 * 2 = 8 places.
+  for (auto const& [kX0, kY0] : {std::pair{2, 2}, std::pair{30, 20}}) {
+    for (int y = kY0; y < kY0 + 3; ++y) {
+      for (int x = kX0; x < kX0 + 4; ++x) {
+        level.material_id[x + (y * level.width)] = 0;
+        level.materials[x + (y * level.width)] = common.materials[0];
+      }
+    }
+  }
+
+  Rand rand(15);
+  std::set<std::pair<int, int>> seen;
+  for (int i = 0; i < 400; ++i) {
+    IVec2 pos;
+    REQUIRE(level.rock_space.Sample(level, rand, 3, 2, level.Bounds(), pos));
+    REQUIRE(level.rock_space.Free(level, Rect(pos.x, pos.y, pos.x + 3, pos.y + 2)));
+    seen.emplace(pos.x, pos.y);
+  }
+  CHECK(seen.size() == 8);
+
+  SECTION("none fits") {
+    Rand before = rand;
+    IVec2 pos;
+    CHECK_FALSE(level.rock_space.Sample(level, rand, 5, 2, level.Bounds(), pos));
+    CHECK_FALSE(level.rock_space.Sample(level, rand, 3, 2, Rect(10, 10, 20, 20), pos));
+    CHECK(rand == before);
+  }
+}
@@ -1,10 +1,15 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <random>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "io/async_writer.hpp"
 #include "io/coding.hpp"
 #include "io/deflate.hpp"
 #include "io/stream.hpp"
@@ -71,6 +76,77 @@ TEST_CASE("io::coding BE round-trip", "[io]") {
   REQUIRE(io::ReadUint32(r) == 0x12345678);
 }
 
+TEST_CASE("io::Reader::Borrow points into a MemReader's buffer", "[io]") {
+  std::vector<uint8_t> const kData{1, 2, 3, 4, 5, 6};
+  io::MemReader r(kData);
+  REQUIRE(r.Get() == 1);
+  REQUIRE(r.Buffered().size() == 5);
+
+  std::vector<uint8_t> scratch;
+  std::span<uint8_t const> const kMid = r.Borrow(3, scratch);
+  REQUIRE(kMid.data() == kData.data() + 1);
+  REQUIRE(kMid.size() == 3);
+  REQUIRE(scratch.empty());
+  REQUIRE(r.Tellg() == 4);
+
+  REQUIRE_THROWS_AS(r.Borrow(3, scratch), io::EndOfStream);
+}
+
+TEST_CASE("io::Reader::Borrow copies from streaming readers", "[io]") {
+  std::vector<uint8_t> packed;
+  {
+    io::DeflateWriter w(std::make_unique<io::VectorWriter>(packed));
+    uint8_t const kBytes[] = {9, 8, 7, 6};
+    w.Put(kBytes, 4);
+  }
+  io::InflateReader r(std::make_unique<io::MemReader>(packed));
+  REQUIRE(r.Buffered().empty());
+
+  std::vector<uint8_t> scratch;
+  std::span<uint8_t const> const kGot = r.Borrow(3, scratch);
+  REQUIRE(kGot.data() == scratch.data());
+  REQUIRE(std::ranges::equal(kGot, std::vector<uint8_t>{9, 8, 7}));
+  REQUIRE(io::ReadAll(r) == "\x06");
+}
+
+TEST_CASE("io::Reader::Borrow rejects lengths past the end without allocating them",
+          "[io]") {
+  std::size_t const kHuge = std::size_t{1} << 40;
+  std::vector<uint8_t> scratch;
+
+  std::vector<uint8_t> const kData{1, 2, 3};
+  io::MemReader mem(kData);
+  REQUIRE_THROWS_AS(mem.Borrow(kHuge, scratch), io::EndOfStream);
+  REQUIRE(scratch.capacity() == 0);
+
+  std::vector<uint8_t> packed;
+  {
+    io::DeflateWriter w(std::make_unique<io::VectorWriter>(packed));
+    w.Put(kData.data(), kData.size());
+  }
+  io::InflateReader inflate(std::make_unique<io::MemReader>(packed));
+  REQUIRE_THROWS_AS(inflate.Borrow(kHuge, scratch), io::EndOfStream);
+  REQUIRE(scratch.capacity() <= (std::size_t{1} << 17));
+}
+
+TEST_CASE("io::BufferReader and SpanIStream read in place", "[io]") {
+  std::string const kText = "tc.cfg contents";
+  io::MemReader src(kText);
+  auto r = io::BufferReader::ReadFrom(src, 4);
+  REQUIRE(r->Buffered().size() == kText.size());
+  REQUIRE(io::ReadUint32(*r) == 0x74632E63);  // "tc.c"
+  REQUIRE(io::ReadAll(*r) == "fg contents");
+  REQUIRE(r->Buffered().empty());
+
+  std::vector<uint8_t> const kWords{'a', 'b', ' ', 'c', 'd'};
+  io::SpanIStream is(kWords);
+  std::string first;
+  std::string second;
+  is >> first >> second;
+  REQUIRE(first == "ab");
+  REQUIRE(second == "cd");
+}
+
 TEST_CASE("io::DeflateWriter / InflateReader round-trip random payload", "[io]") {
   std::vector<uint8_t> payload(64 * 1024);
   // NOLINTNEXTLINE(cert-msc32-c, cert-msc51-cpp, bugprone-random-generator-seed) — fixed seed for reproducible test payload.
@@ -126,3 +202,147 @@ TEST_CASE("io::DeflateWriter compresses repetitive data well", "[io]") {
   REQUIRE(ir.TryGet(roundtrip.data(), roundtrip.size()) == roundtrip.size());
   REQUIRE(roundtrip == payload);
 }
+
+TEST_CASE("io::AsyncWriter delivers bytes in order through a small ring", "[io]") {
+  std::vector<uint8_t> payload(100000);
+  // NOLINTNEXTLINE(cert-msc32-c, cert-msc51-cpp, bugprone-random-generator-seed) — fixed seed for reproducible test payload.
+  std::mt19937 rng(0xBEEF);
+  for (auto& b : payload) {
+    b = static_cast<uint8_t>(rng());
+  }
+
+  std::vector<uint8_t> out;
+  {
+    // A 64-byte ring forces both wrap-around and overflow spills.
+    io::AsyncWriter aw(std::make_unique<io::VectorWriter>(out), 64);
+    std::size_t i = 0;
+    while (i < payload.size()) {
+      std::size_t const kChunk = std::min<std::size_t>(1 + (rng() % 300), payload.size() - i);
+      if (kChunk == 1) {
+        aw.Put(payload[i]);
+      } else {
+        aw.Put(payload.data() + i, kChunk);
+      }
+      i += kChunk;
+      aw.Commit();
+    }
+  }
+  REQUIRE(out == payload);
+}
+
+TEST_CASE("io::AsyncWriter never blocks the producer when the worker stalls", "[io]") {
+  // Sink that blocks until released, standing in for a slow disk.
+  struct GateWriter : io::Writer {
+    std::vector<uint8_t>& buf;
+    std::atomic<bool>& open;
+    GateWriter(std::vector<uint8_t>& b, std::atomic<bool>& o) : buf(b), open(o) {}
+    void Put(uint8_t b) override { Put(&b, 1); }
+    void Put(uint8_t const* src, std::size_t n) override {
+      open.wait(false);
+      buf.insert(buf.end(), src, src + n);
+    }
+  };
+
+  std::vector<uint8_t> out;
+  std::atomic<bool> open{false};
+  std::vector<uint8_t> payload(4096);
+  for (std::size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  io::AsyncWriter aw(std::make_unique<GateWriter>(out, open), 64);
+  for (uint8_t const kB : payload) {
+    aw.Put(kB);
+    aw.Commit();
+  }
+  // Everything past the ring is spilled rather than waited on.
+  REQUIRE(aw.Overflow() >= payload.size() - 64);
+
+  open = true;
+  open.notify_all();
+  aw.Flush();
+  REQUIRE(out == payload);
+  aw.Close();
+  REQUIRE(out == payload);
+}
+
+TEST_CASE("io::AsyncWriter gives up past its overflow limit", "[io]") {
+  struct GateWriter : io::Writer {
+    std::vector<uint8_t>& buf;
+    std::atomic<bool>& open;
+    GateWriter(std::vector<uint8_t>& b, std::atomic<bool>& o) : buf(b), open(o) {}
+    void Put(uint8_t b) override { Put(&b, 1); }
+    void Put(uint8_t const* src, std::size_t n) override {
+      open.wait(false);
+      buf.insert(buf.end(), src, src + n);
+    }
+  };
+
+  std::vector<uint8_t> out;
+  std::atomic<bool> open{false};
+  std::vector<uint8_t> payload(4096);
+  for (std::size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<uint8_t>(i * 5);
+  }
+
+  io::AsyncWriter aw(std::make_unique<GateWriter>(out, open), 64, 1024);
+  std::size_t written = 0;
+  REQUIRE_THROWS_AS(
+      [&] {
+        for (; written < payload.size(); ++written) {
+          aw.Put(payload[written]);
+          aw.Commit();
+        }
+      }(),
+      io::StreamError);
+  // The spill is dropped rather than kept around, and the writer stays shut.
+  REQUIRE(written <= 64 + 1024);
+  REQUIRE(aw.Overflow() == 0);
+  REQUIRE_THROWS_AS(aw.Put(payload.data(), 1), io::StreamError);
+  REQUIRE_THROWS_AS(aw.Commit(), io::StreamError);
+
+  // Close doesn't wait for the dropped bytes; the sink gets what reached
+  // the ring, in order.
+  open = true;
+  open.notify_all();
+  REQUIRE_NOTHROW(aw.Close());
+  REQUIRE(out.size() <= written);
+  REQUIRE(std::equal(out.begin(), out.end(), payload.begin()));
+}
+
+TEST_CASE("io::AsyncWriter over DeflateWriter finishes the stream on close", "[io]") {
+  std::vector<uint8_t> payload(8192);
+  for (std::size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<uint8_t>(i / 13);
+  }
+
+  std::vector<uint8_t> compressed;
+  io::AsyncWriter aw(
+      std::make_unique<io::DeflateWriter>(std::make_unique<io::VectorWriter>(compressed)));
+  aw.Put(payload.data(), payload.size());
+  aw.Close();
+  REQUIRE_THROWS_AS(aw.Put(payload.data(), 1), io::StreamError);
+
+  auto src = std::make_unique<io::MemReader>(compressed);
+  io::InflateReader ir(std::move(src));
+  std::vector<uint8_t> roundtrip(payload.size() + 1);
+  REQUIRE(ir.TryGet(roundtrip.data(), roundtrip.size()) == payload.size());
+  roundtrip.resize(payload.size());
+  REQUIRE(roundtrip == payload);
+}
+
+TEST_CASE("io::AsyncWriter reports sink errors on the producer side", "[io]") {
+  struct FailingWriter : io::Writer {
+    void Put(uint8_t /*b*/) override { throw io::StreamError("disk full"); }
+    void Put(uint8_t const* /*src*/, std::size_t /*n*/) override {
+      throw io::StreamError("disk full");
+    }
+  };
+
+  io::AsyncWriter aw(std::make_unique<FailingWriter>());
+  aw.Put(1);
+  REQUIRE_THROWS_AS(aw.Flush(), io::StreamError);
+  REQUIRE_THROWS_AS(aw.Commit(), io::StreamError);
+  REQUIRE_THROWS_AS(aw.Close(), io::StreamError);
+  REQUIRE_NOTHROW(aw.Close());
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game/common.hpp"
+#include "game/gfx/blit.hpp"
+#include "game/gfx/level_mips.hpp"
+#include "game/level.hpp"
+
+namespace {
+
+struct MipsFixture {
+  Common common;
+  Level level;
+  LevelMips mips;
+  uint32_t pal32[256] = {};
+
+  MipsFixture(int w, int h) : level(common) {
+    level.width = w;
+    level.height = h;
+    std::size_t const kCells = static_cast<std::size_t>(w) * h;
+    level.material_id.resize(kCells);
+    level.materials.resize(kCells);
+    for (std::size_t i = 0; i < kCells; ++i) {
+      level.material_id[i] = static_cast<PalIdx>((i * 13 + i / w) % 256);
+    }
+    for (int i = 0; i < 256; ++i) {
+      pal32[i] = 0xFF000000U | static_cast<uint32_t>((i * 0x050301) & 0xFFFFFF);
+    }
+  }
+
+  // Reference pyramid built from scratch with the same edge rule.
+  std::vector<uint32_t> Expected(int k, int& out_w, int& out_h) const {
+    int w = level.width;
+    int h = level.height;
+    std::vector<uint32_t> img(static_cast<std::size_t>(w) * h);
+    for (int i = 0; i < w * h; ++i) {
+      img[i] = level.AppearanceAt(i, ColorMode::kClassic, pal32, 0);
+    }
+    for (int l = 0; l <= k; ++l) {
+      int const kW = (w + 1) / 2;
+      int const kH = (h + 1) / 2;
+      std::vector<uint32_t> next(static_cast<std::size_t>(kW) * kH);
+      for (int y = 0; y < kH; ++y) {
+        for (int x = 0; x < kW; ++x) {
+          int const kX1 = std::min((2 * x) + 1, w - 1);
+          int const kY1 = std::min((2 * y) + 1, h - 1);
+          uint32_t const kPix[4] = {img[(2 * y * w) + (2 * x)], img[(2 * y * w) + kX1],
+                                    img[(kY1 * w) + (2 * x)], img[(kY1 * w) + kX1]};
+          uint32_t out = 0;
+          for (int c = 0; c < 32; c += 8) {
+            uint32_t sum = 2;
+            for (uint32_t const kP : kPix) {
+              sum += (kP >> c) & 0xFFU;
+            }
+            out |= (sum / 4) << c;
+          }
+          next[(y * kW) + x] = out;
+        }
+      }
+      img.swap(next);
+      w = kW;
+      h = kH;
+    }
+    out_w = w;
+    out_h = h;
+    return img;
+  }
+
+  bool MipsMatch() const {
+    for (int k = 0; k < LevelMips::kLevels; ++k) {
+      int w = 0;
+      int h = 0;
+      std::vector<uint32_t> const kExpected = Expected(k, w, h);
+      LevelMips::Mip const& mip = mips.Get(k);
+      if (mip.w != w || mip.h != h || mip.argb != kExpected) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("mips are box-filtered reductions of the level", "[level_mips]") {
+  for (auto [w, h] : {std::pair{128, 96}, std::pair{101, 67}}) {
+    MipsFixture f(w, h);
+    f.mips.Update(f.level, f.pal32, ColorMode::kClassic, 0);
+    REQUIRE(f.MipsMatch());
+  }
+}
+
+TEST_CASE("mips follow dirty cells and palette changes", "[level_mips]") {
+  MipsFixture f(101, 67);
+  f.mips.Update(f.level, f.pal32, ColorMode::kClassic, 0);
+
+  f.level.SetPixel(3, 4, 77, f.common);
+  f.level.SetPixel(100, 66, 1, f.common);
+  f.level.SetPixel(50, 40, 0, f.common);
+  f.mips.Update(f.level, f.pal32, ColorMode::kClassic, 0);
+  REQUIRE(f.MipsMatch());
+
+  f.pal32[77] = 0xFF102030U;
+  f.mips.Update(f.level, f.pal32, ColorMode::kClassic, 0);
+  REQUIRE(f.MipsMatch());
+}
+
+TEST_CASE("drawscaled samples the matching mip", "[level_mips]") {
+  MipsFixture f(200, 120);
+  Bitmap scr;
+  scr.Alloc(40, 24);
+  scr.pal32 = f.pal32;
+
+  // Quarter scale reads the 4x mip at the positions DrawLevelScaled uses.
+  Fill(scr, 0);
+  f.mips.DrawScaled(scr, f.level, 20, 10, 0.25F);
+  LevelMips::Mip const& mip = f.mips.Get(1);
+  for (int py = 0; py < 24; ++py) {
+    for (int px = 0; px < 40; ++px) {
+      int const kWx = 20 + (px * 4);
+      int const kWy = 10 + (py * 4);
+      uint32_t const kWant =
+          kWx < 200 && kWy < 120 ? mip.argb[((kWy >> 2) * mip.w) + (kWx >> 2)] : scr.pal32[0];
+      REQUIRE(scr.GetPixel(px, py) == kWant);
+    }
+  }
+
+  // Above half scale it is plain DrawLevelScaled.
+  Bitmap expected;
+  expected.Alloc(40, 24);
+  expected.pal32 = f.pal32;
+  Fill(expected, 0);
+  DrawLevelScaled(expected, f.level, 7, 3, 0.75F);
+  Fill(scr, 0);
+  f.mips.DrawScaled(scr, f.level, 7, 3, 0.75F);
+  for (int py = 0; py < 24; ++py) {
+    for (int px = 0; px < 40; ++px) {
+      REQUIRE(scr.GetPixel(px, py) == expected.GetPixel(px, py));
+    }
+  }
+}
@@ -0,0 +1,140 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "gfx/blit.hpp"
+#include "level.hpp"
+#include "rand.hpp"
+
+// MakeShadow and large CorrectShadow calls run in parallel row bands
+// (Level::RewriteCells). They must leave the level exactly as the serial
+// x-major passes they replaced did.
+
+static void FillMaterials(Common& common) {
+  // Every combination of the flags the shadow passes test.
+  for (int i = 0; i < 256; ++i) {
+    common.materials[i].flags = static_cast<uint8_t>(i & 0x3f);
+  }
+}
+
+static void FillLevel(Level& level, Common& common, int w, int h, uint32_t seed) {
+  Rand rand(seed);
+  level.Resize(w, h);
+  level.display_data.assign(static_cast<std::size_t>(w) * h, 0xFF000000U);
+  level.display_valid.assign(static_cast<std::size_t>(w) * h, 1);
+  for (std::size_t i = 0; i < level.material_id.size(); ++i) {
+    // Bias towards the shadowable ranges so both rules fire often.
+    uint32_t const kR = rand(4);
+    uint8_t const kPix = kR == 0   ? static_cast<uint8_t>(12 + rand(7))
+                         : kR == 1 ? static_cast<uint8_t>(160 + rand(8))
+                                   : static_cast<uint8_t>(rand(256));
+    level.material_id[i] = kPix;
+    level.materials[i] = common.materials[kPix];
+  }
+}
+
+// The serial passes, as they were before RewriteCells.
+static void ReferenceMakeShadow(Level& level, Common& common) {
+  for (int x = 0; x < level.width - 3; ++x) {
+    for (int y = 3; y < level.height; ++y) {
+      if (level.Mat(x, y).SeeShadow() && level.Mat(x + 3, y - 3).DirtRock()) {
+        level.SetPixel(x, y, level.Pixel(x, y) + 4, common);
+      }
+      if (level.Pixel(x, y) >= 12 && level.Pixel(x, y) <= 18 && level.Mat(x + 3, y - 3).Rock()) {
+        level.SetPixel(x, y, level.Pixel(x, y) - 2, common);
+        if (level.Pixel(x, y) < 12) {
+          level.SetPixel(x, y, 12, common);
+        }
+      }
+    }
+  }
+  for (int x = 0; x < level.width; ++x) {
+    if (level.Mat(x, level.height - 1).Background()) {
+      level.SetPixel(x, level.height - 1, 13, common);
+    }
+  }
+}
+
+static void ReferenceCorrectShadow(Level& level, Common& common, Rect rect) {
+  rect.Intersect(Rect(0, 3, level.width - 3, level.height));
+  for (int x = rect.x1; x < rect.x2; ++x) {
+    for (int y = rect.y1; y < rect.y2; ++y) {
+      PalIdx const kPix = level.Pixel(x, y);
+      if (level.Mat(x, y).SeeShadow() && level.Mat(x + 3, y - 3).DirtRock()) {
+        level.SetPixel(x, y, kPix + 4, common);
+      } else if (kPix >= 164 && kPix <= 167 && !level.Mat(x + 3, y - 3).DirtRock()) {
+        level.SetPixel(x, y, kPix - 4, common);
+      }
+    }
+  }
+}
+
+static void RequireSameCells(Level const& a, Level const& b, Common const& common) {
+  REQUIRE(a.material_id == b.material_id);
+  REQUIRE(a.display_valid == b.display_valid);
+  for (std::size_t i = 0; i < a.material_id.size(); ++i) {
+    REQUIRE(b.materials[i].flags == common.materials[b.material_id[i]].flags);
+  }
+  // Same cells dirtied; the bulk pass marks them in row order.
+  std::vector<int32_t> da = a.dirty_list;
+  std::vector<int32_t> db = b.dirty_list;
+  std::ranges::sort(da);
+  std::ranges::sort(db);
+  REQUIRE(da == db);
+}
+
+TEST_CASE("MakeShadow matches the serial pass", "[level-shadow]") {
+  Common common;
+  FillMaterials(common);
+
+  // Several bands wide, and a classic level that runs as one band.
+  for (auto const& [kW, kH] : {std::pair{1200, 700}, std::pair{504, 350}, std::pair{5, 4}}) {
+    Level expected(common);
+    FillLevel(expected, common, kW, kH, static_cast<uint32_t>(kW));
+    Level actual(common);
+    FillLevel(actual, common, kW, kH, static_cast<uint32_t>(kW));
+    expected.InitDirtyTracking();
+    actual.InitDirtyTracking();
+
+    ReferenceMakeShadow(expected, common);
+    actual.MakeShadow(common);
+    RequireSameCells(expected, actual, common);
+  }
+}
+
+TEST_CASE("CorrectShadow over a large rectangle matches the serial pass", "[level-shadow]") {
+  Common common;
+  FillMaterials(common);
+
+  Level expected(common);
+  FillLevel(expected, common, 1100, 800, 7);
+  Level actual(common);
+  FillLevel(actual, common, 1100, 800, 7);
+  expected.InitDirtyTracking();
+  actual.InitDirtyTracking();
+
+  // Overhangs the level on every side, so clipping is exercised too.
+  Rect const kRect(-20, -20, 1200, 900);
+  ReferenceCorrectShadow(expected, common, kRect);
+  CorrectShadow(common, actual, kRect);
+  RequireSameCells(expected, actual, common);
+}
+
+TEST_CASE("RebuildMaterials derives every cell's material", "[level-shadow]") {
+  Common common;
+  FillMaterials(common);
+
+  Level level(common);
+  FillLevel(level, common, 900, 700, 3);
+  for (Material& m : level.materials) {
+    m.flags = 0xff;
+  }
+  level.RebuildMaterials(common);
+  for (std::size_t i = 0; i < level.material_id.size(); ++i) {
+    REQUIRE(level.materials[i].flags == common.materials[level.material_id[i]].flags);
+  }
+}
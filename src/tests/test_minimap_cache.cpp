@@ -0,0 +1,162 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "game/common.hpp"
+#include "game/gfx/blit.hpp"
+#include "game/gfx/minimap_cache.hpp"
+#include "game/gfx/renderer.hpp"
+#include "game/level.hpp"
+
+namespace {
+
+// A level with a varied material pattern, drawn through the cache and through
+// Level::DrawMiniature onto identical backgrounds.
+struct MinimapCacheFixture {
+  Common common;
+  Level level;
+  Renderer renderer;
+
+  MinimapCacheFixture(int level_w, int level_h) : level(common) {
+    level.width = level_w;
+    level.height = level_h;
+    std::size_t const kCells = static_cast<std::size_t>(level_w) * level_h;
+    level.material_id.resize(kCells);
+    level.materials.resize(kCells);
+    for (std::size_t i = 0; i < kCells; ++i) {
+      level.material_id[i] = static_cast<PalIdx>(1 + ((i * 7 + i / level_w) % 200));
+    }
+
+    renderer.Init(96, 64);
+    renderer.pal.Clear();
+    for (int i = 1; i < 256; ++i) {
+      auto const kV = static_cast<uint8_t>(i);
+      renderer.pal.entries[i] = {.r = kV, .g = static_cast<uint8_t>(kV * 3), .b = 9, .unused = 0};
+    }
+    renderer.UpdatePal32();
+  }
+
+  void SetPal(int i, uint8_t r) {
+    renderer.pal.entries[i].r = r;
+    renderer.UpdatePal32();
+  }
+
+  bool SameAsDrawMiniature(int x, int y, int step_x, int step_y) {
+    Bitmap expected;
+    expected.Alloc(96, 64);
+    expected.pal32 = renderer.pal32;
+    expected.mode = renderer.bmp.mode;
+    expected.cycles = renderer.bmp.cycles;
+    Fill(expected, 0);
+    level.DrawMiniature(expected, x, y, step_x, step_y);
+
+    Fill(renderer.bmp, 0);
+    renderer.minimaps.Draw(renderer.bmp, level, x, y, step_x, step_y);
+
+    for (int py = 0; py < 64; ++py) {
+      for (int px = 0; px < 96; ++px) {
+        if (expected.GetPixel(px, py) != renderer.bmp.GetPixel(px, py)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("cached minimap matches drawminiature", "[minimap_cache]") {
+  MinimapCacheFixture f(150, 100);
+  for (auto [sx, sy] : {std::pair{2, 2}, std::pair{3, 5}, std::pair{4, 3}}) {
+    for (auto [x, y] : {std::pair{0, 0}, std::pair{-7, -4}, std::pair{60, 30}}) {
+      REQUIRE(f.SameAsDrawMiniature(x, y, sx, sy));
+    }
+  }
+}
+
+TEST_CASE("unchanged level re-resolves nothing", "[minimap_cache]") {
+  MinimapCacheFixture f(150, 100);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  REQUIRE(f.renderer.minimaps.LastResolved() == 75 * 50);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  REQUIRE(f.renderer.minimaps.LastResolved() == 0);
+}
+
+TEST_CASE("dirty tiles re-resolve only their samples", "[minimap_cache]") {
+  MinimapCacheFixture f(150, 100);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+
+  f.level.SetPixel(41, 21, 77, f.common);
+  f.level.SetPixel(3, 97, 12, f.common);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  // A full 32x32 tile of 16x16 samples, and the bottom tile row's 16x2.
+  REQUIRE(f.renderer.minimaps.LastResolved() == (16 * 16) + (16 * 2));
+
+  // A second image of the same level tracks the same revisions.
+  f.level.SetPixel(101, 51, 3, f.common);
+  REQUIRE(f.SameAsDrawMiniature(5, 5, 3, 3));
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  REQUIRE(f.renderer.minimaps.LastResolved() == 16 * 16);
+}
+
+TEST_CASE("palette changes outside animated ranges re-resolve everything",
+          "[minimap_cache]") {
+  MinimapCacheFixture f(150, 100);
+  f.renderer.minimaps.SetAnimated(5, 5);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  int const kAll = f.renderer.minimaps.LastResolved();
+
+  f.SetPal(5, 200);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  REQUIRE(f.renderer.minimaps.LastResolved() > 0);
+  REQUIRE(f.renderer.minimaps.LastResolved() < kAll);
+
+  f.SetPal(6, 200);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  REQUIRE(f.renderer.minimaps.LastResolved() == kAll);
+}
+
+TEST_CASE("animated ramps follow cycles in modern mode", "[minimap_cache]") {
+  MinimapCacheFixture f(64, 64);
+  std::size_t const kCells = 64 * 64;
+  f.level.display_data.assign(kCells, 0xFF112233U);
+  f.level.display_valid.assign(kCells, 1);
+  f.level.display_anim.assign(kCells, 0);
+  f.level.argb_ramps.push_back({.colors = {0xFF000001U, 0xFF000002U, 0xFF000003U}, .shift = 0});
+  for (std::size_t i = 0; i < kCells; i += 5) {
+    f.level.display_anim[i] = 1;
+    f.level.display_data[i] = static_cast<uint32_t>(i % 3);
+  }
+  f.renderer.mode = ColorMode::kModern;
+  f.renderer.UpdatePal32();
+
+  for (int c = 0; c < 4; ++c) {
+    f.renderer.bmp.cycles = c;
+    REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  }
+  REQUIRE(f.renderer.minimaps.LastResolved() > 0);
+  REQUIRE(f.renderer.minimaps.LastResolved() < 32 * 32);
+
+  // Drawing over a ramp cell drops it back to the palette path.
+  f.level.SetPixel(1, 1, 9, f.common);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+}
+
+TEST_CASE("replaced level contents rebuild the image", "[minimap_cache]") {
+  MinimapCacheFixture f(150, 100);
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+
+  // Bulk writes that bypass MarkDirty (loading, Resize) invalidate the level.
+  f.level.Resize(120, 90);
+  for (auto& m : f.level.material_id) {
+    m = 4;
+  }
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+  REQUIRE(f.renderer.minimaps.LastResolved() == 60 * 45);
+
+  f.level.material_id[0] = 9;
+  f.level.InvalidateRender();
+  REQUIRE(f.SameAsDrawMiniature(0, 0, 2, 2));
+}
@@ -11,6 +11,9 @@
 //      inevitable; the steady-state confirmation lag must stay bounded
 //      by kMaxRollback, rollback must actually fire, and the confirmed
 //      timeline must still agree.
+//   3. long-haul latency with a wide negotiated window — prediction runs
+//      well past the default 7 frames, bounded by the wider window, and
+//      the confirmed timeline must still agree.
 //
 // Convergence is asserted via the confirmed-frame checksum callbacks
 // (NetRunResult::desynced / compared_frames), not by comparing the two
@@ -98,3 +101,31 @@ TEST_CASE("Layer A: two rollback peers reach game-over under jitter + 10% loss",
   REQUIRE(kResult.compared_frames > 0);
   REQUIRE_FALSE(kResult.desynced);
 }
+
+TEST_CASE("Layer A: a wide rollback window rides out long-haul latency", "[net_full_game]") {
+  constexpr int kWindow = 24;
+  rollback_test::RollbackPair pair =
+      rollback_test::MakeRollbackPair({.world_seed = 0xBEEF, .max_rollback = kWindow});
+  // ~150-200 ms one way at 70 fps: further than the default window reaches.
+  rollback_test::JitterTransport transport(
+      {.seed = 0xFA2AA7, .min_delay_frames = 10, .max_delay_frames = 14, .loss_probability = 0.02});
+
+  Rand rng_a(kInputSeed);
+  Rand rng_b(kInputSeed ^ 0x55555555U);
+  auto const kResult = rollback_test::RunPairToCompletion(
+      pair, transport, [&](int peer, int) { return CombatInput(peer == 0 ? rng_a : rng_b, peer); },
+      kMaxFrames);
+
+  INFO("frames=" << kResult.frames_elapsed << " compared=" << kResult.compared_frames
+                 << " max_lag=" << kResult.max_lag << " rb_a=" << kResult.rollback_count_a
+                 << " rb_b=" << kResult.rollback_count_b);
+  REQUIRE(kResult.reached_game_over);
+  REQUIRE(kResult.frames_elapsed < kMaxFrames);
+  // Prediction ran deeper than the default window would allow...
+  REQUIRE(kResult.max_lag > static_cast<uint32_t>(rollback::kMaxRollback));
+  // ...but never past the negotiated one...
+  REQUIRE(kResult.max_lag <= static_cast<uint32_t>(kWindow));
+  // ...and the confirmed timeline still converged.
+  REQUIRE(kResult.compared_frames > 0);
+  REQUIRE_FALSE(kResult.desynced);
+}
@@ -0,0 +1,40 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "parallel.hpp"
+
+TEST_CASE("ParallelFor calls every index once", "[parallel]") {
+  for (unsigned const kThreads : {0U, 1U, 3U, 64U}) {
+    std::vector<std::atomic<int>> calls(1000);
+    ParallelFor(calls.size(), [&](std::size_t i) { calls[i].fetch_add(1); }, kThreads);
+    for (auto const& c : calls) {
+      REQUIRE(c.load() == 1);
+    }
+  }
+}
+
+TEST_CASE("ParallelFor with no work returns at once", "[parallel]") {
+  bool called = false;
+  ParallelFor(0, [&](std::size_t) { called = true; });
+  CHECK_FALSE(called);
+}
+
+TEST_CASE("ParallelFor rethrows the first exception", "[parallel]") {
+  std::atomic<int> calls{0};
+  CHECK_THROWS_AS(ParallelFor(
+                      100000,
+                      [&](std::size_t i) {
+                        calls.fetch_add(1);
+                        if (i == 10) {
+                          throw std::runtime_error("boom");
+                        }
+                      },
+                      4),
+                  std::runtime_error);
+  // The indices not yet handed out were skipped.
+  CHECK(calls.load() < 100000);
+}
@@ -23,8 +23,13 @@ TEST_CASE("Settings random_map_height defaults to 350", "[random-map-size]") {
   CHECK(kS.random_map_height == 350);
 }
 
-TEST_CASE("Settings config version is 6", "[random-map-size]") {
-  CHECK(Settings::kConfigVersion == 6);
+TEST_CASE("Settings random_level_generator defaults to classic", "[random-map-size]") {
+  Settings const kS;
+  CHECK(kS.random_level_generator == Settings::kLevelGenClassic);
+}
+
+TEST_CASE("Settings config version is 12", "[random-map-size]") {
+  CHECK(Settings::kConfigVersion == 12);
 }
 
 // ---------------------------------------------------------------------------
@@ -45,9 +50,33 @@ TEST_CASE("Settings random_map dimensions round-trip through TOML", "[random-map
   CHECK(loaded.random_map_height == 192);
 }
 
-TEST_CASE("Settings TOML contains version = 6", "[random-map-size]") {
+TEST_CASE("Settings random_level_generator round-trips through TOML", "[random-map-size]") {
+  Settings original;
+  original.random_level_generator = Settings::kLevelGenClassic;
+
+  Settings loaded;
+  loaded.FromToml(original.ToToml());
+
+  CHECK(loaded.random_level_generator == Settings::kLevelGenClassic);
+}
+
+TEST_CASE("Settings clamps an out-of-range randomLevelGenerator on load", "[random-map-size]") {
+  Settings original;
+  original.random_level_generator = Settings::kLevelGenTiled;
+  std::string toml = original.ToToml();
+  std::string const kKey = "randomLevelGenerator = " + std::to_string(Settings::kLevelGenTiled);
+  auto const kPos = toml.find(kKey);
+  REQUIRE(kPos != std::string::npos);
+  toml.replace(kPos, kKey.length(), "randomLevelGenerator = 4000000000");
+
+  Settings loaded;
+  loaded.FromToml(toml);
+  CHECK(loaded.random_level_generator == Settings::kMaxLevelGens - 1);
+}
+
+TEST_CASE("Settings TOML contains the current config version", "[random-map-size]") {
   Settings const kSettings;
-  CHECK(kSettings.ToToml().contains("version = 6"));
+  CHECK(kSettings.ToToml().contains("version = " + std::to_string(Settings::kConfigVersion)));
 }
 
 // Configs written before v5 lack randomMapWidth/randomMapHeight.
@@ -125,3 +154,65 @@ TEST_CASE("GenerateFromSettings default dimensions produce 504x350 level", "[ran
   CHECK(level.width == 504);
   CHECK(level.height == 350);
 }
+
+TEST_CASE("Tiled generator gives the same level on any thread count", "[random-map-size]") {
+  auto common = std::make_shared<Common>();
+  FsNode const kTcRoot(FsNode("data") / "TC" / "openliero");
+  common->load(kTcRoot);
+
+  // Partial tiles on both axes.
+  int const kW = (3 * Level::kGenTileSize) + 37;
+  int const kH = (2 * Level::kGenTileSize) + 90;
+
+  Level reference(*common);
+  reference.Resize(kW, kH);
+  Rand ref_rand;
+  ref_rand.Seed(7);
+  reference.GenerateTiled(*common, ref_rand, 1);
+
+  for (unsigned const kThreads : {2U, 5U, 0U}) {
+    Level level(*common);
+    level.Resize(kW, kH);
+    Rand rand;
+    rand.Seed(7);
+    level.GenerateTiled(*common, rand, kThreads);
+
+    REQUIRE(level.material_id == reference.material_id);
+    // The match RNG advances the same amount either way.
+    CHECK(rand == ref_rand);
+  }
+
+  Level other(*common);
+  other.Resize(kW, kH);
+  Rand other_rand;
+  other_rand.Seed(8);
+  other.GenerateTiled(*common, other_rand, 1);
+  CHECK(other.material_id != reference.material_id);
+}
+
+TEST_CASE("GenerateFromSettings still offers the classic generator", "[random-map-size]") {
+  auto common = std::make_shared<Common>();
+  FsNode const kTcRoot(FsNode("data") / "TC" / "openliero");
+  common->load(kTcRoot);
+
+  Settings settings;
+  settings.random_level = true;
+  settings.random_level_generator = Settings::kLevelGenTiled;
+
+  Level tiled(*common);
+  Rand tiled_rand;
+  tiled_rand.Seed(3);
+  tiled.GenerateFromSettings(*common, settings, tiled_rand);
+
+  settings.random_level_generator = Settings::kLevelGenClassic;
+  Level classic(*common);
+  Rand classic_rand;
+  classic_rand.Seed(3);
+  classic.GenerateFromSettings(*common, settings, classic_rand);
+
+  CHECK(classic.width == 504);
+  CHECK(classic.height == 350);
+  CHECK(classic.old_random_level_generator == Settings::kLevelGenClassic);
+  CHECK(tiled.old_random_level_generator == Settings::kLevelGenTiled);
+  CHECK(classic.material_id != tiled.material_id);
+}
@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game/common.hpp"
+#include "game/gfx/blit.hpp"
+#include "game/gfx/resident_level.hpp"
+#include "game/level.hpp"
+
+namespace {
+
+// A level plus a CPU stand-in for the resident texture: Update() copies each
+// upload into `texture` the way SDL_UpdateTexture would.
+struct ResidentFixture {
+  Common common;
+  Level level;
+  ResidentLevel resident;
+  uint32_t pal32[256] = {};
+  std::vector<uint32_t> texture;
+
+  ResidentFixture(int w, int h) : level(common) {
+    level.width = w;
+    level.height = h;
+    std::size_t const kCells = static_cast<std::size_t>(w) * h;
+    level.material_id.resize(kCells);
+    level.materials.resize(kCells);
+    for (std::size_t i = 0; i < kCells; ++i) {
+      level.material_id[i] = static_cast<PalIdx>(10 + (i % 5));
+    }
+    for (int i = 0; i < 256; ++i) {
+      pal32[i] = 0xFF000000U | static_cast<uint32_t>(i * 0x010203);
+    }
+    texture.assign(kCells, 0);
+  }
+
+  // Updates and applies; returns the number of uploaded pixels.
+  std::size_t Update(ColorMode mode = ColorMode::kClassic, int cycles = 0) {
+    resident.Update(level, pal32, mode, cycles);
+    std::size_t pixels = 0;
+    for (std::size_t i = 0; i < resident.Uploads().size(); ++i) {
+      UploadRect const& r = resident.Uploads()[i];
+      uint32_t const* src = resident.Pixels(i);
+      for (int y = 0; y < r.h; ++y) {
+        for (int x = 0; x < r.w; ++x) {
+          texture[((r.y + y) * level.width) + r.x + x] = src[(y * r.w) + x];
+        }
+      }
+      pixels += static_cast<std::size_t>(r.w) * r.h;
+    }
+    return pixels;
+  }
+
+  bool TextureMatches(ColorMode mode = ColorMode::kClassic, int cycles = 0) const {
+    for (int i = 0; i < level.width * level.height; ++i) {
+      if (texture[i] != level.AppearanceAt(i, mode, pal32, cycles)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("first update uploads the whole level", "[resident_level]") {
+  ResidentFixture f(100, 70);
+  REQUIRE(f.Update() == 100 * 70);
+  REQUIRE(f.TextureMatches());
+  REQUIRE(f.Update() == 0);
+}
+
+TEST_CASE("terrain changes upload only their tiles", "[resident_level]") {
+  ResidentFixture f(100, 70);
+  f.Update();
+
+  f.level.SetPixel(40, 5, 3, f.common);
+  f.level.SetPixel(41, 6, 4, f.common);
+  REQUIRE(f.Update() == 32 * 32);
+  REQUIRE(f.TextureMatches());
+
+  // Adjacent dirty tiles merge into one rect; the edge tile is clipped.
+  f.level.SetPixel(63, 66, 3, f.common);
+  f.level.SetPixel(64, 66, 3, f.common);
+  f.level.SetPixel(99, 69, 3, f.common);
+  f.Update();
+  REQUIRE(f.resident.Uploads().size() == 1);
+  REQUIRE(f.resident.Uploads()[0].x == 32);
+  REQUIRE(f.resident.Uploads()[0].w == 100 - 32);
+  REQUIRE(f.resident.Uploads()[0].h == 70 - 64);
+  REQUIRE(f.TextureMatches());
+}
+
+TEST_CASE("palette changes upload animated tiles or everything", "[resident_level]") {
+  ResidentFixture f(100, 70);
+  f.resident.SetAnimated(200, 201);
+  f.level.SetPixel(70, 40, 200, f.common);
+  f.Update();
+
+  f.pal32[200] = 0xFF123456U;
+  REQUIRE(f.Update() == 32 * 32);
+  REQUIRE(f.TextureMatches());
+
+  // Tiles are flagged for showing any animated entry, not a specific one.
+  f.pal32[201] = 0xFF654321U;
+  REQUIRE(f.Update() == 32 * 32);
+
+  f.pal32[11] = 0xFFABCDEFU;
+  REQUIRE(f.Update() == 100 * 70);
+  REQUIRE(f.TextureMatches());
+}
+
+TEST_CASE("modern ramps re-upload their tiles as cycles advance", "[resident_level]") {
+  ResidentFixture f(64, 64);
+  std::size_t const kCells = 64 * 64;
+  f.level.display_data.assign(kCells, 0xFF0000AAU);
+  f.level.display_valid.assign(kCells, 1);
+  f.level.display_anim.assign(kCells, 0);
+  f.level.argb_ramps.push_back({.colors = {0xFF000001U, 0xFF000002U}, .shift = 0});
+  f.level.display_anim[(40 * 64) + 40] = 1;
+  f.level.display_data[(40 * 64) + 40] = 0;
+
+  f.Update(ColorMode::kModern, 0);
+  REQUIRE(f.TextureMatches(ColorMode::kModern, 0));
+  REQUIRE(f.Update(ColorMode::kModern, 0) == 0);
+  REQUIRE(f.Update(ColorMode::kModern, 1) == 32 * 32);
+  REQUIRE(f.TextureMatches(ColorMode::kModern, 1));
+
+  REQUIRE(f.Update(ColorMode::kClassic, 1) == 64 * 64);
+  REQUIRE(f.TextureMatches(ColorMode::kClassic, 1));
+}
+
+TEST_CASE("replaced levels and new textures upload everything", "[resident_level]") {
+  ResidentFixture f(100, 70);
+  f.Update();
+  f.resident.Invalidate();
+  REQUIRE(f.Update() == 100 * 70);
+
+  f.level.InvalidateRender();
+  REQUIRE(f.Update() == 100 * 70);
+}
+
+TEST_CASE("sparse overlay uploads drawn and just-cleared tiles", "[resident_level]") {
+  Bitmap overlay;
+  overlay.Alloc(100, 70);
+  FillTransparent(overlay);
+  SparseOverlay sparse;
+
+  auto area = [](std::vector<UploadRect> const& rects) {
+    int n = 0;
+    for (auto const& r : rects) {
+      n += r.w * r.h;
+    }
+    return n;
+  };
+
+  REQUIRE(area(sparse.Collect(overlay, 100, 70)) == 100 * 70);
+  REQUIRE(sparse.Collect(overlay, 100, 70).empty());
+
+  overlay.GetPixel(5, 5) = 0xFF00FF00U;
+  overlay.GetPixel(90, 65) = 0xFF00FF00U;
+  REQUIRE(area(sparse.Collect(overlay, 100, 70)) == (32 * 32) + (32 * 6));
+
+  // Next frame draws nothing: the same tiles are uploaded once to clear them.
+  FillTransparent(overlay);
+  REQUIRE(area(sparse.Collect(overlay, 100, 70)) == (32 * 32) + (32 * 6));
+  REQUIRE(sparse.Collect(overlay, 100, 70).empty());
+
+  sparse.Invalidate();
+  REQUIRE(area(sparse.Collect(overlay, 100, 70)) == 100 * 70);
+}
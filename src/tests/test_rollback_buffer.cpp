@@ -208,3 +208,30 @@ TEST_CASE("RollbackBuffer reports oldestFrame correctly while filling", "[rollba
   REQUIRE(buf.OldestFrame() == 1);
   REQUIRE(buf.NewestFrame() == static_cast<int>(RollbackBuffer::kCapacity));
 }
+
+TEST_CASE("RollbackBuffer resizes to a negotiated window", "[rollback]") {
+  RollbackBuffer buf;
+  REQUIRE(buf.Capacity() == RollbackBuffer::kCapacity);
+  buf.Write(3);
+
+  // Resize drops the old contents.
+  constexpr std::size_t kWide = static_cast<std::size_t>(rollback::kMaxRollbackLimit) + 1;
+  buf.Resize(kWide);
+  REQUIRE(buf.Capacity() == kWide);
+  REQUIRE(buf.Empty());
+
+  constexpr int kFrames = static_cast<int>(kWide) + 5;
+  for (int f = 0; f < kFrames; ++f) {
+    buf.Write(f).snapshot.checksum = static_cast<uint32_t>(f);
+  }
+  REQUIRE(buf.Size() == kWide);
+  REQUIRE(buf.OldestFrame() == kFrames - static_cast<int>(kWide));
+  // The whole window is resident: a rollback kMaxRollbackLimit frames deep
+  // still finds its snapshot.
+  for (int f = buf.OldestFrame(); f < kFrames; ++f) {
+    Slot const* s = buf.Find(f);
+    REQUIRE(s != nullptr);
+    REQUIRE(s->snapshot.checksum == static_cast<uint32_t>(f));
+  }
+  REQUIRE(buf.Find(buf.OldestFrame() - 1) == nullptr);
+}
@@ -17,11 +17,18 @@
 //       mismatch within 200 frames of the injection — proving the
 //       detector still fires under rollback's prediction/resim churn.
 //
+//   (c) Resync: B's state is corrupted for real, B adopts A's exported
+//       state, and from there on every compared frame agrees again. A
+//       truncated or malformed state is rejected first.
+//
 // The peers don't run a full NetSession in this test; we model the
 // desync detector inline as a frame-keyed map.
 
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -32,6 +39,8 @@
 #include "math.hpp"
 #include "mixer/player.hpp"
 #include "rollback/buffer.hpp"
+#include "serialization/resync_state.hpp"
+#include "stateHash.hpp"
 
 namespace {
 
@@ -269,3 +278,177 @@ TEST_CASE("Rollback desync detection — 1-bit injection fires within 200 frames
   REQUIRE(first_alarm_frame >= kInjectFrame);
   REQUIRE(first_alarm_frame < kInjectFrame + 200);
 }
+
+TEST_CASE("Rollback resync — client adopts the host state and checksums agree again",
+          "[rollback][desync]") {
+  constexpr uint32_t kWorldSeed = 0xBEEF;
+  constexpr uint32_t kInputSeed = 0xC0FFEE;
+  constexpr uint32_t kTransportSeed = 0xA1B2;
+  constexpr int kTicks = 600;
+  constexpr int kDivergeTick = 250;
+
+  ScriptedInputs script = GenerateInputs(kInputSeed, kTicks);
+
+  auto [common, settings] = MakeEnv();
+  auto a = std::make_unique<RollbackController>(common, settings, 0);
+  auto b = std::make_unique<RollbackController>(common, settings, 1);
+  a->SetSkipWeaponSelection(/*skip=*/true);
+  b->SetSkipWeaponSelection(/*skip=*/true);
+  a->SetFrameAdvantageEnabled(/*enabled=*/false);
+  b->SetFrameAdvantageEnabled(/*enabled=*/false);
+  a->game.rand.Seed(kWorldSeed);
+  b->game.rand.Seed(kWorldSeed);
+
+  rollback_test::JitterTransport transport(
+      {.seed = kTransportSeed, .min_delay_frames = 1, .max_delay_frames = 4});
+
+  a->SetInputCallbacks([&](uint8_t gen, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    transport.SendAToB(gen, bf, c, in, lf);
+  });
+  b->SetInputCallbacks([&](uint8_t gen, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    transport.SendBToA(gen, bf, c, in, lf);
+  });
+
+  std::unordered_map<uint32_t, uint32_t> a_checks;
+  std::unordered_map<uint32_t, uint32_t> b_checks;
+  a->SetChecksumCallback([&](uint8_t /*gen*/, uint32_t f, uint32_t c) { a_checks[f] = c; });
+  b->SetChecksumCallback([&](uint8_t /*gen*/, uint32_t f, uint32_t c) { b_checks[f] = c; });
+
+  a->Focus();
+  b->Focus();
+
+  for (uint32_t f = 0; f < 3; ++f) {
+    a->InjectRemoteInput(f, 0);
+    b->InjectRemoteInput(f, 0);
+  }
+
+  auto deliver_a = [&](uint8_t /*gen*/, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    a->InjectRemoteBatch(bf, c, in, lf);
+  };
+  auto deliver_b = [&](uint8_t /*gen*/, uint32_t bf, uint8_t c, uint8_t const* in, uint32_t lf) {
+    b->InjectRemoteBatch(bf, c, in, lf);
+  };
+  auto run = [&](int from, int to) {
+    for (int i = from; i < to; ++i) {
+      a->SetLocalControlState(script.a[i]);
+      b->SetLocalControlState(script.b[i]);
+      a->Process();
+      b->Process();
+      transport.Tick(deliver_a, deliver_b);
+    }
+  };
+  // Idle input never mispredicts, so nothing rolls back across a drain.
+  auto drain = [&]() {
+    a->SetLocalControlState(0);
+    b->SetLocalControlState(0);
+    for (int i = 0; i < 12; ++i) {
+      a->Process();
+      b->Process();
+      transport.Tick(deliver_a, deliver_b);
+    }
+  };
+  auto mismatches = [&](uint32_t after) {
+    std::size_t compared = 0;
+    std::size_t differ = 0;
+    for (auto const& [frame, ca] : a_checks) {
+      auto it = b_checks.find(frame);
+      if (frame <= after || it == b_checks.end()) {
+        continue;
+      }
+      ++compared;
+      differ += ca != it->second ? 1 : 0;
+    }
+    return std::pair{compared, differ};
+  };
+
+  run(0, kDivergeTick);
+  drain();
+  REQUIRE(a->CurrentFrame() == b->CurrentFrame());
+
+  // Corrupt B outside the sim; the drain confirms the corrupted frames,
+  // so no rollback can undo it.
+  uint32_t const kDiverged = b->CurrentFrame();
+  b->game.worms[1]->health -= 7;
+  drain();
+  auto const [kBeforeCompared, kBeforeDiffer] = mismatches(kDiverged);
+  REQUIRE(kBeforeCompared > 0);
+  REQUIRE(kBeforeDiffer > 0);
+
+  std::vector<uint8_t> state;
+  REQUIRE(a->ExportResyncState(state));
+  auto const kAt = static_cast<uint32_t>(a->ConfirmedFrame());
+
+  // A cut-off state is rejected and leaves B as it was.
+  REQUIRE_FALSE(b->ApplyResyncState(state.data(), state.size() / 2));
+  REQUIRE(b->ResyncCount() == 0);
+
+  // So is one whose indices or cell count don't fit the match. Each is
+  // A's state at kAt with one field broken, sent uncompressed.
+  {
+    GameSnapshot const& at = a->RollbackBuffer().Find(static_cast<int>(kAt))->snapshot;
+    auto malformed = [&](auto&& break_snap, bool oversized_cells) {
+      auto snap = std::make_unique<GameSnapshot>(at);
+      break_snap(*snap);
+      std::vector<uint8_t> raw;
+      SaveResyncState(raw, a->game, ResyncHeader{.frame = kAt}, *snap);
+      if (oversized_cells) {
+        // The cell count is the 8-byte size tag ahead of the 6-byte cells.
+        std::vector<ResyncCell> cells;
+        CollectResyncCells(*snap, a->game.level, cells);
+        std::size_t const kTag = raw.size() - (cells.size() * 6) - 8;
+        std::fill_n(raw.begin() + static_cast<std::ptrdiff_t>(kTag), 8, uint8_t{0x7F});
+      }
+      std::vector<uint8_t> out(5);
+      auto const kRawSize = static_cast<uint32_t>(raw.size());
+      std::memcpy(out.data() + 1, &kRawSize, 4);
+      out.insert(out.end(), raw.begin(), raw.end());
+      return out;
+    };
+    auto const kWeaponEnd = a->game.common->weapons.data() + a->game.common->weapons.size();
+    auto const kNTypeEnd =
+        a->game.common->nobject_types.data() + a->game.common->nobject_types.size();
+    std::vector<std::vector<uint8_t>> const kBad = {
+        malformed(
+            [&](GameSnapshot& s) {
+              s.wobjects.arr[0].used = true;
+              s.wobjects.arr[0].type = kWeaponEnd;
+            },
+            false),
+        malformed(
+            [&](GameSnapshot& s) {
+              s.nobjects.arr[0].used = true;
+              s.nobjects.arr[0].type = kNTypeEnd;
+            },
+            false),
+        malformed(
+            [&](GameSnapshot& s) {
+              s.sobjects.arr[0].used = true;
+              s.sobjects.arr[0].id = 1 << 20;
+            },
+            false),
+        malformed([](GameSnapshot& /*s*/) {}, true),
+    };
+    for (std::vector<uint8_t> const& bad : kBad) {
+      REQUIRE_FALSE(b->ApplyResyncState(bad.data(), bad.size()));
+    }
+    REQUIRE(b->ResyncCount() == 0);
+  }
+
+  b_checks.clear();
+  REQUIRE(b->ApplyResyncState(state.data(), state.size()));
+  REQUIRE(b->ResyncCount() == 1);
+  REQUIRE(b->ConfirmedFrame() == static_cast<int32_t>(kAt));
+  REQUIRE(b->CurrentFrame() == kAt + 1);
+  REQUIRE(b->RollbackBuffer().Find(static_cast<int>(kAt))->checksum ==
+          a->RollbackBuffer().Find(static_cast<int>(kAt))->checksum);
+
+  run(kDivergeTick, kTicks);
+  transport.Flush(deliver_a, deliver_b);
+  drain();
+
+  REQUIRE(a->CurrentFrame() == b->CurrentFrame());
+  auto const [kAfterCompared, kAfterDiffer] = mismatches(kAt);
+  REQUIRE(kAfterCompared > static_cast<std::size_t>((kTicks - kDivergeTick) / 2));
+  REQUIRE(kAfterDiffer == 0);
+  REQUIRE(HashGameState(a->game) == HashGameState(b->game));
+}
@@ -339,8 +339,8 @@ TEST_CASE("NetSession TC sync skips transfer when hashes match", "[session][tc]"
   REQUIRE_FALSE(tc_reloaded);
 }
 
-TEST_CASE("NetTransport protocol version is 8 for anim blob", "[session][anim-layer]") {
-  CHECK(NetTransport::kProtocolVersion == 8);
+TEST_CASE("NetTransport protocol version is 13 (anim blob since 8)", "[session][anim-layer]") {
+  CHECK(NetTransport::kProtocolVersion == 13);
 }
 
 TEST_CASE("level blob round-trip preserves anim layer", "[session][anim-layer]") {
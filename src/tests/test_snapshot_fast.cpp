@@ -8,6 +8,13 @@
 //   3. Performance: save and load both well under 500 µs.
 //   4. Dirty-cell tracking: only modified cells are written on each save;
 //      level_materials is absent from the slot (recomputed on restore).
+//   5. Delta level storage: a deep ring of delta slots restores every
+//      slot exactly while holding only the dirtied cells, and moving the
+//      delta base up to a confirmed slot keeps the later ones restorable
+//      (and checksummed the same) while the list stops growing.
+//   6. Sim-only frames: same state as full frames, viewports untouched.
+//   7. SnapshotChecksum: agrees across storage layouts and dirty-tracking
+//      start points, and sees objects in sparse pool slots.
 
 #include <algorithm>
 #include <catch2/catch_test_macros.hpp>
@@ -21,6 +28,7 @@
 #include "math.hpp"
 #include "mixer/player.hpp"
 #include "serialization/fast_snapshot.hpp"
+#include "serialization/snapshot_checksum.hpp"
 #include "stateHash.hpp"
 #include "viewport.hpp"
 #include "weapon.hpp"
@@ -74,6 +82,7 @@ struct GameRunner {
     game->ResetWorms();
   }
 
+  template <Game::FrameMode kMode = Game::FrameMode::kFull>
   void Step(Rand& input_rng) const {
     for (int idx = 0; idx < 2; ++idx) {
       uint32_t input = input_rng() & 0x7f;
@@ -85,7 +94,7 @@ struct GameRunner {
       }
       game->worms[idx]->control_states.Unpack(input);
     }
-    game->ProcessFrame();
+    game->ProcessFrame<kMode>();
   }
 };
 
@@ -374,3 +383,279 @@ TEST_CASE("Dirty-cell tracking: sparse save, correct restore", "[snapshot][rollb
   // snap_b predates the modification, so display_valid restores to 1.
   REQUIRE(game.level.display_valid[static_cast<std::size_t>(kIdx)] == 1);
 }
+
+TEST_CASE("Delta level storage restores every slot of a deep ring", "[snapshot][rollback][dirty]") {
+  constexpr uint32_t kSeed = 0x5EED0DE1;
+  constexpr int kWarm = 150;
+  constexpr std::size_t kSlots = 31;
+
+  GameRunner r(kSeed);
+  Game& game = *r.game;
+  std::size_t const kCells =
+      static_cast<std::size_t>(game.level.width) * static_cast<std::size_t>(game.level.height);
+  // Exercise the display_valid half of the delta as well.
+  game.level.display_data.assign(kCells, 0);
+  game.level.display_valid.assign(kCells, static_cast<uint8_t>(1));
+
+  Rand input_rng(kSeed ^ 0xDEAD);
+  for (int f = 0; f < kWarm; ++f) {
+    r.Step(input_rng);
+  }
+
+  std::vector<GameSnapshot> ring(kSlots);
+  std::vector<uint32_t> hashes;
+  std::vector<std::vector<uint8_t>> levels;
+  std::vector<std::vector<uint8_t>> valid;
+  for (std::size_t i = 0; i < kSlots; ++i) {
+    ring[i].Prepare(game, GameSnapshot::LevelStorage::kDelta);
+    r.Step(input_rng);
+    game.SaveSnapshotFast(ring[i]);
+    hashes.push_back(HashGameState(game));
+    levels.emplace_back(game.level.material_id.begin(), game.level.material_id.end());
+    valid.push_back(game.level.display_valid);
+  }
+  // Keep digging past the newest slot so every restore has cells dirtied
+  // after its save to put back.
+  for (int f = 0; f < 60; ++f) {
+    r.Step(input_rng);
+  }
+
+  // Slots hold only what has been dug, not the map.
+  REQUIRE(!game.level.delta_list.empty());
+  REQUIRE(ring.back().level_data.size() < kCells / 4);
+
+  // Restore newest to oldest and back again: each load must undo
+  // whatever the previously loaded slot (or the run-ahead) left behind.
+  for (std::size_t n = 0; n < 2 * kSlots; ++n) {
+    std::size_t const kI = n < kSlots ? kSlots - 1 - n : n - kSlots;
+    game.LoadSnapshotFast(ring[kI]);
+    INFO("slot " << kI);
+    REQUIRE(HashGameState(game) == hashes[kI]);
+    REQUIRE(std::equal(levels[kI].begin(), levels[kI].end(), game.level.material_id.begin()));
+    REQUIRE(game.level.display_valid == valid[kI]);
+    for (std::size_t c = 0; c < kCells; ++c) {
+      if (game.level.materials[c].flags !=
+          game.common->materials[game.level.material_id[c]].flags) {
+        FAIL("materials out of step with material_id at cell " << c);
+      }
+    }
+  }
+}
+
+TEST_CASE("Delta rebase keeps later slots restorable and the list bounded",
+          "[snapshot][rollback][dirty]") {
+  constexpr uint32_t kSeed = 0x4EBA5E;
+  constexpr int kWarm = 150;
+  constexpr int kFrames = 300;
+  constexpr int kSlots = 8;
+  constexpr int kLag = 4;
+
+  // `a` moves its delta base to the slot kLag frames back after every
+  // save, as the controller does with the confirmed frame; `b` never does.
+  GameRunner a(kSeed);
+  GameRunner b(kSeed);
+  Level const& level = a.game->level;
+  std::size_t const kCells =
+      static_cast<std::size_t>(level.width) * static_cast<std::size_t>(level.height);
+  for (GameRunner* r : {&a, &b}) {
+    r->game->level.display_data.assign(kCells, 0);
+    r->game->level.display_valid.assign(kCells, static_cast<uint8_t>(1));
+  }
+  Rand a_inputs(kSeed ^ 0xBA5E);
+  Rand b_inputs(kSeed ^ 0xBA5E);
+  for (int f = 0; f < kWarm; ++f) {
+    a.Step(a_inputs);
+    b.Step(b_inputs);
+  }
+
+  std::vector<GameSnapshot> a_ring(kSlots);
+  std::vector<GameSnapshot> b_ring(kSlots);
+  for (int i = 0; i < kSlots; ++i) {
+    a_ring[i].Prepare(*a.game, GameSnapshot::LevelStorage::kDelta);
+    b_ring[i].Prepare(*b.game, GameSnapshot::LevelStorage::kDelta);
+  }
+  std::vector<uint32_t> hashes(kSlots);
+  std::vector<std::vector<uint8_t>> levels(kSlots);
+  std::vector<std::vector<uint8_t>> valid(kSlots);
+  std::vector<GameSnapshot*> later;
+  for (int f = 0; f < kFrames; ++f) {
+    a.Step(a_inputs);
+    b.Step(b_inputs);
+    int const kAt = f % kSlots;
+    a.game->SaveSnapshotFast(a_ring[kAt]);
+    b.game->SaveSnapshotFast(b_ring[kAt]);
+    hashes[kAt] = HashGameState(*a.game);
+    levels[kAt].assign(a.game->level.material_id.begin(), a.game->level.material_id.end());
+    valid[kAt] = a.game->level.display_valid;
+    if (f < kLag) {
+      continue;
+    }
+    later.clear();
+    for (int g = f - kLag + 1; g <= f; ++g) {
+      later.push_back(&a_ring[g % kSlots]);
+    }
+    a.game->RebaseLevelDelta(a_ring[(f - kLag) % kSlots], later, 0);
+
+    INFO("frame " << f);
+    for (int g = f - kLag; g <= f; ++g) {
+      REQUIRE(SnapshotChecksum(a_ring[g % kSlots], a.game->level) ==
+              SnapshotChecksum(b_ring[g % kSlots], b.game->level));
+    }
+  }
+
+  // Only what the window dug is still listed.
+  REQUIRE(!b.game->level.delta_list.empty());
+  REQUIRE(a.game->level.delta_list.size() < b.game->level.delta_list.size());
+  for (GameSnapshot const* s : later) {
+    REQUIRE(s->level_data.size() <= a.game->level.delta_list.size());
+  }
+  // Frames older than the new base are gone.
+  REQUIRE(!a.game->CanLoadSnapshotFast(a_ring[(kFrames - kLag - 2) % kSlots]));
+
+  // The base and every later slot, newest to oldest and back again.
+  for (int n = 0; n < 2 * (kLag + 1); ++n) {
+    int const kF = n <= kLag ? kFrames - 1 - n : kFrames - 1 - 2 * kLag - 1 + n;
+    int const kI = kF % kSlots;
+    INFO("frame " << kF);
+    REQUIRE(a.game->CanLoadSnapshotFast(a_ring[kI]));
+    a.game->LoadSnapshotFast(a_ring[kI]);
+    REQUIRE(HashGameState(*a.game) == hashes[kI]);
+    REQUIRE(std::equal(levels[kI].begin(), levels[kI].end(), a.game->level.material_id.begin()));
+    REQUIRE(a.game->level.display_valid == valid[kI]);
+    for (std::size_t c = 0; c < kCells; ++c) {
+      if (a.game->level.materials[c].flags !=
+          a.game->common->materials[a.game->level.material_id[c]].flags) {
+        FAIL("materials out of step with material_id at cell " << c);
+      }
+    }
+  }
+}
+
+TEST_CASE("Sim-only frames match full frames and leave viewports alone", "[snapshot][rollback]") {
+  constexpr uint32_t kSeed = 0x51A0;
+  constexpr int kFrames = 600;
+
+  GameRunner full(kSeed);
+  GameRunner sim(kSeed);
+  Rand full_inputs(kSeed ^ 0xBEEF);
+  Rand sim_inputs(kSeed ^ 0xBEEF);
+
+  Viewport const& start = *sim.game->viewports[0];
+  int const kX = start.x;
+  int const kY = start.y;
+  int const kBannerY = start.banner_y;
+  uint32_t const kRandLast = start.rand.last;
+  for (int f = 0; f < kFrames; ++f) {
+    full.Step(full_inputs);
+    sim.Step<Game::FrameMode::kSimOnly>(sim_inputs);
+    INFO("frame " << f);
+    REQUIRE(HashGameState(*sim.game) == HashGameState(*full.game));
+    REQUIRE(WideRollbackChecksum(*sim.game) == WideRollbackChecksum(*full.game));
+  }
+
+  // The full run scrolled its camera; the sim-only one never touched it.
+  Viewport const& after = *sim.game->viewports[0];
+  REQUIRE(after.x == kX);
+  REQUIRE(after.y == kY);
+  REQUIRE(after.banner_y == kBannerY);
+  REQUIRE(after.rand.last == kRandLast);
+  Viewport const& moved = *full.game->viewports[0];
+  REQUIRE((moved.x != kX || moved.y != kY || moved.banner_y != kBannerY));
+}
+
+TEST_CASE("Snapshot checksum is independent of level storage and tracking start",
+          "[snapshot][rollback][checksum]") {
+  constexpr uint32_t kSeed = 0xC4EC5;
+  constexpr int kLateStart = 120;
+  constexpr int kFrames = 400;
+
+  GameRunner a(kSeed);
+  GameRunner b(kSeed);
+  Rand a_inputs(kSeed ^ 0x1234);
+  Rand b_inputs(kSeed ^ 0x1234);
+
+  // A tracks from frame 0 into full slots; B only starts tracking (and so
+  // takes its base digest) after a good deal of digging, into delta slots.
+  std::vector<GameSnapshot> snaps(3);
+  snaps[0].Prepare(*a.game);
+  snaps[1].Prepare(*a.game, GameSnapshot::LevelStorage::kDelta);
+  snaps[2].Prepare(*b.game, GameSnapshot::LevelStorage::kDelta);
+  a.game->SaveSnapshotFast(snaps[0]);
+  for (int f = 0; f < kFrames; ++f) {
+    a.Step(a_inputs);
+    b.Step(b_inputs);
+    if (f < kLateStart) {
+      continue;
+    }
+    a.game->SaveSnapshotFast(snaps[0]);
+    a.game->SaveSnapshotFast(snaps[1]);
+    b.game->SaveSnapshotFast(snaps[2]);
+    INFO("frame " << f);
+    uint32_t const kFull = SnapshotChecksum(snaps[0], a.game->level);
+    REQUIRE(SnapshotChecksum(snaps[1], a.game->level) == kFull);
+    REQUIRE(SnapshotChecksum(snaps[2], b.game->level) == kFull);
+  }
+
+  // Same answer as digesting the whole map from scratch.
+  Level& level = a.game->level;
+  uint64_t const kTracked = snapshot_checksum_detail::LevelDigest(snaps[0], level);
+  REQUIRE(kTracked == level.ContentDigest());
+
+  // A cell that was dug and put back (as after a mispredicted branch)
+  // leaves the checksum alone; a real change does not.
+  uint32_t const kBefore = SnapshotChecksum(snaps[1], level);
+  int idx = 0;
+  while (level.dirty_bits[static_cast<std::size_t>(idx)]) {
+    ++idx;
+  }
+  auto const kCell = static_cast<std::size_t>(idx);
+  uint8_t const kOld = level.material_id[kCell];
+  level.material_id[kCell] = static_cast<uint8_t>(kOld ^ 1);
+  level.MarkDirty(idx);
+  a.game->SaveSnapshotFast(snaps[1]);
+  REQUIRE(SnapshotChecksum(snaps[1], level) != kBefore);
+  level.material_id[kCell] = kOld;
+  a.game->SaveSnapshotFast(snaps[1]);
+  REQUIRE(SnapshotChecksum(snaps[1], level) == kBefore);
+}
+
+TEST_CASE("Snapshot checksum covers live pool slots past the live count",
+          "[snapshot][rollback][checksum]") {
+  GameRunner r(0x5A1E);
+  Game& game = *r.game;
+  Rand input_rng(0x5A1E);
+  for (int f = 0; f < 60; ++f) {
+    r.Step(input_rng);
+  }
+
+  std::vector<GameSnapshot> snaps(1);
+  snaps[0].Prepare(game);
+  game.SaveSnapshotFast(snaps[0]);
+  GameSnapshot& snap = snaps[0];
+
+  // Leave a single live nobject in the last slot, well past count.
+  constexpr int kLast = 599;
+  for (auto& o : snap.nobjects.arr) {
+    o.used = false;
+  }
+  snap.nobjects.arr[600].used = true;
+  snap.nobjects.count = 1;
+  NObject& o = snap.nobjects.arr[kLast];
+  o.used = true;
+  o.pos = fixedvec(1000, 2000);
+  o.vel = fixedvec(0, 0);
+  o.type = &game.common->nobject_types[0];
+  o.owner_idx = 0;
+  o.cur_frame = 0;
+  o.time_left = 10;
+
+  uint32_t const kBase = SnapshotChecksum(snap, game.level);
+  o.pos.x += 1;
+  REQUIRE(SnapshotChecksum(snap, game.level) != kBase);
+  o.pos.x -= 1;
+  REQUIRE(SnapshotChecksum(snap, game.level) == kBase);
+
+  // Freed slots are ignored whatever they still hold.
+  snap.nobjects.arr[0].pos = fixedvec(7, 7);
+  REQUIRE(SnapshotChecksum(snap, game.level) == kBase);
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "game/gfx/blit.hpp"
+#include "game/gfx/renderer.hpp"
+#include "game/gfx/sprite_cache.hpp"
+
+namespace {
+
+// Two 4x4 frames. Frame 0 mixes transparent (0), static (5, 6) and
+// colour-animated (130) pixels; frame 1 is all static index 6.
+struct CacheFixture {
+  Renderer renderer;
+  SpriteSet set;
+
+  CacheFixture() {
+    renderer.Init(12, 12);
+    renderer.sprite_cache.SetAnimated(129, 132);
+    renderer.pal.Clear();
+    renderer.pal.entries[1] = {.r = 0x01, .g = 0x01, .b = 0x01, .unused = 0};
+    renderer.pal.entries[5] = {.r = 0x10, .g = 0x20, .b = 0x30, .unused = 0};
+    renderer.pal.entries[6] = {.r = 0x40, .g = 0x50, .b = 0x60, .unused = 0};
+    renderer.pal.entries[130] = {.r = 0xaa, .g = 0x00, .b = 0x00, .unused = 0};
+    renderer.UpdatePal32();
+
+    set.Allocate(4, 4, 2);
+    PalIdx const kFrame0[16] = {0, 5, 5, 0,  //
+                                6, 130, 6, 0,  //
+                                0, 5, 130, 5,  //
+                                0, 0, 6, 0};
+    std::copy(kFrame0, kFrame0 + 16, set.SpritePtr(0));
+    std::fill(set.SpritePtr(1), set.SpritePtr(1) + 16, PalIdx{6});
+  }
+
+  // Draws `frame` at (x, y) with both the indexed and the cached blit into
+  // separate copies of a filled background and returns whether they match.
+  bool SameAsIndexed(int frame, int x, int y) {
+    Bitmap expected;
+    expected.Alloc(12, 12);
+    expected.pal32 = renderer.pal32;
+    Fill(expected, 1);
+    BlitImage(expected, set[frame], x, y);
+
+    Fill(renderer.bmp, 1);
+    BlitImage(renderer.bmp, renderer.Resolved(set, frame), x, y);
+
+    for (int py = 0; py < 12; ++py) {
+      for (int px = 0; px < 12; ++px) {
+        if (expected.GetPixel(px, py) != renderer.bmp.GetPixel(px, py)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("cached blit matches indexed blit", "[blit][sprite_cache]") {
+  CacheFixture f;
+  REQUIRE(f.SameAsIndexed(0, 4, 4));
+  REQUIRE(f.SameAsIndexed(1, 4, 4));
+  // Clipped on every edge, including patches falling outside the bitmap.
+  REQUIRE(f.SameAsIndexed(0, -2, -1));
+  REQUIRE(f.SameAsIndexed(0, 10, 9));
+  REQUIRE(f.SameAsIndexed(0, -4, 0));
+}
+
+TEST_CASE("cached frame lists animated pixels as patches", "[blit][sprite_cache]") {
+  CacheFixture f;
+  ResolvedSprite const kSpr = f.renderer.Resolved(f.set, 0);
+  REQUIRE(kSpr.patch_count == 2);
+  REQUIRE(kSpr.patches[0].x == 1);
+  REQUIRE(kSpr.patches[0].y == 1);
+  REQUIRE(kSpr.patches[1].x == 2);
+  REQUIRE(kSpr.patches[1].y == 2);
+  // Animated and transparent pixels are out of the masked copy.
+  REQUIRE(kSpr.mask[0] == 0);
+  REQUIRE(kSpr.mask[1] == 0xFFFFFFFFU);
+  REQUIRE(kSpr.mask[5] == 0);
+  REQUIRE(kSpr.argb[1] == 0xFF102030U);
+}
+
+TEST_CASE("animated palette entries do not invalidate the cache", "[blit][sprite_cache]") {
+  CacheFixture f;
+  f.renderer.Resolved(f.set, 0);
+  uint32_t const kGeneration = f.renderer.sprite_cache.Generation();
+
+  // A colour-animation step: only the animated range changes.
+  f.renderer.pal.entries[130] = {.r = 0x00, .g = 0xbb, .b = 0x00, .unused = 0};
+  f.renderer.UpdatePal32();
+  REQUIRE(f.renderer.sprite_cache.Generation() == kGeneration);
+
+  // The patch still picks up the rotated colour at draw time.
+  Fill(f.renderer.bmp, 1);
+  BlitImage(f.renderer.bmp, f.renderer.Resolved(f.set, 0), 0, 0);
+  REQUIRE(f.renderer.bmp.GetPixel(1, 1) == 0xFF00BB00U);
+  REQUIRE(f.SameAsIndexed(0, 3, 2));
+}
+
+TEST_CASE("static palette changes re-resolve cached frames", "[blit][sprite_cache]") {
+  CacheFixture f;
+  f.renderer.Resolved(f.set, 1);
+  uint32_t const kGeneration = f.renderer.sprite_cache.Generation();
+
+  // Re-uploading an identical palette is not a change.
+  f.renderer.UpdatePal32();
+  REQUIRE(f.renderer.sprite_cache.Generation() == kGeneration);
+
+  f.renderer.pal.entries[6] = {.r = 0x01, .g = 0x02, .b = 0x03, .unused = 0};
+  f.renderer.UpdatePal32();
+  REQUIRE(f.renderer.sprite_cache.Generation() != kGeneration);
+  REQUIRE(f.renderer.Resolved(f.set, 1).argb[0] == 0xFF010203U);
+  REQUIRE(f.SameAsIndexed(1, 0, 0));
+}
+
+TEST_CASE("cached scaled blit matches indexed scaled blit", "[blit][sprite_cache]") {
+  CacheFixture f;
+  for (float const kScale : {0.5F, 1.0F, 2.0F}) {
+    Bitmap expected;
+    expected.Alloc(12, 12);
+    expected.pal32 = f.renderer.pal32;
+    Fill(expected, 1);
+    BlitImageScaled(expected, f.set[0], 1, 1, kScale);
+
+    Fill(f.renderer.bmp, 1);
+    BlitImageScaled(f.renderer.bmp, f.renderer.Resolved(f.set, 0), 1, 1, kScale);
+
+    for (int py = 0; py < 12; ++py) {
+      for (int px = 0; px < 12; ++px) {
+        REQUIRE(expected.GetPixel(px, py) == f.renderer.bmp.GetPixel(px, py));
+      }
+    }
+  }
+}
@@ -0,0 +1,107 @@
+// NormalStatsRecorder's event pipeline.
+//
+// The hooks only queue events; a consumer thread folds them into the
+// aggregates. Checks that Sync() makes every event visible, that a burst
+// far larger than the ring is neither lost nor reordered, that copies
+// carry the aggregates, and the layout of the columnar export.
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "io/stream.hpp"
+#include "stats_recorder.hpp"
+#include "worm.hpp"
+
+TEST_CASE("Stats events reach the aggregates after Sync", "[stats]") {
+  NormalStatsRecorder rec;
+  Worm w0;
+  w0.index = 0;
+  Worm w1;
+  w1.index = 1;
+
+  rec.frame = 5;
+  rec.AfterSpawn(&w0);
+  rec.frame = 40;
+  rec.AfterDeath(&w0);
+  rec.AfterSpawn(&w0);
+  rec.frame = 90;
+  rec.AfterDeath(&w0);
+
+  // Many times the ring's capacity: the producer has to wait for the
+  // consumer rather than drop.
+  for (int i = 0; i < 20000; ++i) {
+    rec.AiProcessTime(&w1, std::chrono::nanoseconds(3));
+  }
+
+  // Speculative frames stay invisible.
+  rec.speculative = true;
+  rec.AfterSpawn(&w1);
+  rec.AiProcessTime(&w1, std::chrono::nanoseconds(1000));
+  rec.speculative = false;
+
+  rec.Sync();
+  REQUIRE(rec.worms[0].life_spans == std::vector<std::pair<int, int>>{{5, 40}, {40, 90}});
+  REQUIRE(rec.worms[0].spawn_time == -1);
+  REQUIRE(rec.worms[1].ai_process_time == std::chrono::nanoseconds(60000));
+  REQUIRE(rec.worms[1].spawn_time == -1);
+
+  NormalStatsRecorder const kCopy(rec);
+  REQUIRE(kCopy.frame == 90);
+  REQUIRE(kCopy.worms[0].life_spans == rec.worms[0].life_spans);
+  REQUIRE(kCopy.worms[1].ai_process_time == rec.worms[1].ai_process_time);
+}
+
+TEST_CASE("Stats columnar export layout", "[stats]") {
+  NormalStatsRecorder rec;
+  Worm w;
+  w.index = 1;
+
+  rec.AfterSpawn(&w);  // before the export: not included
+  rec.ExportTo(FsNode());
+  rec.frame = 3;
+  rec.AfterDeath(&w);
+  rec.frame = 200;
+  rec.AiProcessTime(&w, std::chrono::nanoseconds(-7));
+
+  std::vector<uint8_t> out;
+  io::VectorWriter writer(out);
+  rec.WriteColumnar(writer);
+
+  REQUIRE(out.size() > 10);
+  REQUIRE(std::memcmp(out.data(), "LSTA", 4) == 0);
+  REQUIRE(out[4] == 1);
+  uint32_t rows = 0;
+  std::memcpy(&rows, out.data() + 5, 4);
+  REQUIRE(rows == 2);
+  REQUIRE(out[9] == 9);
+
+  // First column: frame, delta-coded zigzag varints: 3 -> 6, 197 -> 394.
+  std::size_t pos = 10;
+  REQUIRE(out[pos] == 5);
+  REQUIRE(std::memcmp(out.data() + pos + 1, "frame", 5) == 0);
+  pos += 6;
+  REQUIRE(out[pos] == 2);
+  uint32_t bytes = 0;
+  std::memcpy(&bytes, out.data() + pos + 1, 4);
+  pos += 5;
+  REQUIRE(bytes == 3);
+  REQUIRE(out[pos] == 6);
+  REQUIRE(out[pos + 1] == (0x80 | (394 & 0x7f)));
+  REQUIRE(out[pos + 2] == (394 >> 7));
+  pos += bytes;
+
+  // Second column: kind, one byte per row.
+  REQUIRE(out[pos] == 4);
+  REQUIRE(std::memcmp(out.data() + pos + 1, "kind", 4) == 0);
+  pos += 5;
+  REQUIRE(out[pos] == 0);
+  std::memcpy(&bytes, out.data() + pos + 1, 4);
+  pos += 5;
+  REQUIRE(bytes == 2);
+  REQUIRE(out[pos] == StatsEvent::kDeath);
+  REQUIRE(out[pos + 1] == StatsEvent::kAiTime);
+}
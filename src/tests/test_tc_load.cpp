@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -13,6 +18,7 @@
 #include "level.hpp"
 #include "math.hpp"
 #include "mixer/player.hpp"
+#include "tc_cache.hpp"
 #include "viewport.hpp"
 #include "worm.hpp"
 
@@ -235,6 +241,141 @@ TEST_CASE("TC with a missing sound WAV loads and keeps indices stable", "[tc_loa
   fs::remove_all(kTempTc);
 }
 
+namespace {
+
+std::string WeaponCfg(Common const& common, Weapon const& w) {
+  std::stringstream ss;
+  SaveWeaponConfig(common, w, ss);
+  return ss.str();
+}
+
+std::string NObjectCfg(Common const& common, NObjectType const& n) {
+  std::stringstream ss;
+  SaveNObjectConfig(common, n, ss);
+  return ss.str();
+}
+
+std::string SObjectCfg(Common const& common, SObjectType const& s) {
+  std::stringstream ss;
+  SaveSObjectConfig(common, s, ss);
+  return ss.str();
+}
+
+void RequireSameTc(Common const& a, Common const& b) {
+  {
+    std::stringstream sa;
+    std::stringstream sb;
+    SaveTcConfig(a, sa);
+    SaveTcConfig(b, sb);
+    REQUIRE(sa.str() == sb.str());
+  }
+  REQUIRE(std::equal(std::begin(a.sound_hook), std::end(a.sound_hook), std::begin(b.sound_hook)));
+  REQUIRE(std::equal(std::begin(a.c), std::end(a.c), std::begin(b.c)));
+
+  REQUIRE(a.weapons.size() == b.weapons.size());
+  for (std::size_t i = 0; i < a.weapons.size(); ++i) {
+    REQUIRE(a.weapons[i].id_str == b.weapons[i].id_str);
+    REQUIRE(WeaponCfg(a, a.weapons[i]) == WeaponCfg(b, b.weapons[i]));
+  }
+  REQUIRE(a.nobject_types.size() == b.nobject_types.size());
+  for (std::size_t i = 0; i < a.nobject_types.size(); ++i) {
+    REQUIRE(NObjectCfg(a, a.nobject_types[i]) == NObjectCfg(b, b.nobject_types[i]));
+  }
+  REQUIRE(a.sobject_types.size() == b.sobject_types.size());
+  for (std::size_t i = 0; i < a.sobject_types.size(); ++i) {
+    REQUIRE(SObjectCfg(a, a.sobject_types[i]) == SObjectCfg(b, b.sobject_types[i]));
+  }
+  REQUIRE(a.weap_order == b.weap_order);
+
+  REQUIRE(a.sounds.size() == b.sounds.size());
+  for (std::size_t i = 0; i < a.sounds.size(); ++i) {
+    REQUIRE(a.sounds[i].name == b.sounds[i].name);
+    REQUIRE((a.sounds[i].sound == nullptr) == (b.sounds[i].sound == nullptr));
+    REQUIRE(a.sounds[i].original_data == b.sounds[i].original_data);
+  }
+
+  REQUIRE(a.small_sprites.data == b.small_sprites.data);
+  REQUIRE(a.large_sprites.data == b.large_sprites.data);
+  REQUIRE(a.text_sprites.data == b.text_sprites.data);
+  REQUIRE(a.worm_sprites.data == b.worm_sprites.data);
+  REQUIRE(a.fire_cone_sprites.data == b.fire_cone_sprites.data);
+  REQUIRE(std::memcmp(a.exepal.entries, b.exepal.entries, sizeof(a.exepal.entries)) == 0);
+  REQUIRE(std::memcmp(a.modernpal.entries, b.modernpal.entries, sizeof(a.modernpal.entries)) ==
+          0);
+  for (std::size_t i = 0; i < a.font.chars.size(); ++i) {
+    REQUIRE(a.font.chars[i].width == b.font.chars[i].width);
+    REQUIRE(std::memcmp(a.font.chars[i].data, b.font.chars[i].data,
+                        sizeof(a.font.chars[i].data)) == 0);
+  }
+}
+
+}  // namespace
+
+TEST_CASE("TC cache round-trips a loaded TC", "[tc_load][tc_cache]") {
+  namespace fs = std::filesystem;
+  fs::path const kTempDir = fs::temp_directory_path() / "openliero_test_tc_cache";
+  fs::remove_all(kTempDir);
+  fs::path const kTempTc = kTempDir / "tc";
+  fs::copy(GetTcPath(), kTempTc, fs::copy_options::recursive | fs::copy_options::copy_symlinks);
+  FsNode const kTcRoot(kTempTc.string());
+  FsNode const kCache((kTempDir / "cache" / "tc.tcc").string());
+
+  Common plain;
+  plain.load(kTcRoot);
+
+  // Cold: loads the TC and writes the snapshot.
+  auto cold = LoadCommonCached(kTcRoot, kCache);
+  REQUIRE(kCache.Exists());
+  RequireSameTc(plain, *cold);
+
+  // Warm: everything comes from the snapshot.
+  auto const kSize = fs::file_size(kCache.FullPath());
+  auto warm = LoadCommonCached(kTcRoot, kCache);
+  RequireSameTc(plain, *warm);
+  REQUIRE(fs::file_size(kCache.FullPath()) == kSize);
+
+  // Touching a file only changes the stat key: the content key still
+  // matches, so the snapshot is kept and only its header is restamped.
+  auto read_cache = [&] {
+    std::ifstream in(kCache.FullPath(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+  };
+  uint64_t const kKey = TcCacheKey(kTcRoot);
+  uint64_t const kStatKey = TcStatKey(kTcRoot);
+  REQUIRE(kStatKey != 0);
+  std::string const kBefore = read_cache();
+  {
+    fs::path const kCfg = kTempTc / "tc.cfg";
+    fs::last_write_time(kCfg, fs::last_write_time(kCfg) + std::chrono::hours(1));
+  }
+  REQUIRE(TcCacheKey(kTcRoot) == kKey);
+  REQUIRE(TcStatKey(kTcRoot) != kStatKey);
+  auto touched = LoadCommonCached(kTcRoot, kCache);
+  RequireSameTc(plain, *touched);
+  std::string const kAfter = read_cache();
+  REQUIRE(kAfter.size() == kBefore.size());
+  REQUIRE(kAfter.compare(16, 8, kBefore, 16, 8) != 0);
+  REQUIRE(kAfter.compare(24, std::string::npos, kBefore, 24, std::string::npos) == 0);
+
+  // Editing a weapon changes both keys, so the snapshot is rebuilt.
+  {
+    fs::path const kCfg = kTempTc / "weapons" / (plain.weapons.front().id_str + ".cfg");
+    std::ofstream(kCfg, std::ios::app) << "\n";
+  }
+  REQUIRE(TcCacheKey(kTcRoot) != kKey);
+  auto edited = LoadCommonCached(kTcRoot, kCache);
+  RequireSameTc(plain, *edited);
+
+  // A damaged snapshot is ignored and replaced.
+  fs::resize_file(kCache.FullPath(), fs::file_size(kCache.FullPath()) / 2);
+  auto damaged = LoadCommonCached(kTcRoot, kCache);
+  RequireSameTc(plain, *damaged);
+  auto repaired = LoadCommonCached(kTcRoot, kCache);
+  RequireSameTc(plain, *repaired);
+
+  fs::remove_all(kTempDir);
+}
+
 TEST_CASE("TC supports game initialization", "[tc_load]") {
   PrecomputeTables();
 
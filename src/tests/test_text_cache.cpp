@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <string>
+
+#include "game/gfx/blit.hpp"
+#include "game/gfx/font.hpp"
+#include "game/gfx/renderer.hpp"
+#include "game/gfx/text_cache.hpp"
+#include "game/gfx/text_cell.hpp"
+
+namespace {
+
+// Every glyph is a distinct diagonal-ish pattern so misplaced glyphs or
+// clipping errors show up as pixel mismatches.
+struct TextFixture {
+  Renderer renderer;
+  Font font;
+
+  TextFixture() {
+    renderer.Init(64, 24);
+    renderer.pal.Clear();
+    for (int i = 1; i < 256; ++i) {
+      auto const kV = static_cast<uint8_t>(i);
+      renderer.pal.entries[i] = {
+          .r = kV, .g = static_cast<uint8_t>(255 - kV), .b = 7, .unused = 0};
+    }
+    renderer.UpdatePal32();
+
+    for (std::size_t c = 0; c < font.chars.size(); ++c) {
+      for (int p = 0; p < 8 * 7; ++p) {
+        font.chars[c].data[p] = ((p + static_cast<int>(c)) % 3) == 0 ? 1 : 0;
+      }
+      font.chars[c].width = 4 + static_cast<int>(c % 3);
+    }
+  }
+
+  // Draws via the cache and directly through the font onto the same
+  // background and compares the results.
+  template <typename Cached, typename Direct>
+  bool SameAsFont(Cached cached, Direct direct) {
+    Bitmap expected;
+    expected.Alloc(64, 24);
+    expected.pal32 = renderer.pal32;
+    Fill(expected, 3);
+    direct(expected);
+
+    Fill(renderer.bmp, 3);
+    cached(renderer.bmp);
+
+    for (int y = 0; y < 24; ++y) {
+      for (int x = 0; x < 64; ++x) {
+        if (expected.GetPixel(x, y) != renderer.bmp.GetPixel(x, y)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("cached text matches font drawstring", "[text_cache]") {
+  TextFixture f;
+  for (std::string const& str :
+       {std::string("Kills: 12"), std::string("0:42"), std::string("Reloading")}) {
+    for (auto [x, y] : {std::pair{2, 2}, std::pair{-5, -3}, std::pair{40, 20}}) {
+      REQUIRE(f.SameAsFont(
+          [&](Bitmap& scr) { f.renderer.text_cache.DrawString(scr, f.font, str, x, y, 10); },
+          [&](Bitmap& scr) { f.font.DrawString(scr, str, x, y, 10); }));
+    }
+  }
+
+  // Font::DrawChar clips scaled glyphs by their unscaled size, so compare a
+  // scaled run that stays clear of the edges.
+  REQUIRE(f.SameAsFont(
+      [&](Bitmap& scr) { f.renderer.text_cache.DrawString(scr, f.font, "0:42", 1, 2, 10, 2); },
+      [&](Bitmap& scr) { f.font.DrawString(scr, "0:42", 4, 1, 2, 10, 2); }));
+}
+
+TEST_CASE("cached centered text and cells honour placement", "[text_cache]") {
+  TextFixture f;
+  REQUIRE(f.SameAsFont(
+      [&](Bitmap& scr) {
+        f.renderer.text_cache.DrawCenteredText(scr, f.font, "SETUP", 32, 4, 7, 2);
+      },
+      [&](Bitmap& scr) { f.font.DrawCenteredText(scr, "SETUP", 32, 4, 7, 2); }));
+
+  for (auto const kPlacement : {TextCell::kLeft, TextCell::kCenter, TextCell::kRight}) {
+    TextCell c(kPlacement);
+    c << "timer " << 42;
+    REQUIRE(f.SameAsFont(
+        [&](Bitmap& scr) { f.renderer.text_cache.DrawString(scr, f.font, c, 32, 8, 7); },
+        [&](Bitmap& scr) { f.font.DrawString(scr, c, 32, 8, 7); }));
+  }
+}
+
+TEST_CASE("unchanged text is a cache hit", "[text_cache]") {
+  TextFixture f;
+  TextCache& cache = f.renderer.text_cache;
+  cache.DrawString(f.renderer.bmp, f.font, cache.Format("Lives: ", 3), 0, 0, 6);
+  REQUIRE(cache.Misses() == 1);
+  cache.DrawString(f.renderer.bmp, f.font, cache.Format("Lives: ", 3), 0, 0, 6);
+  REQUIRE(cache.Misses() == 1);
+
+  // Different text, colour or size are separate runs.
+  cache.DrawString(f.renderer.bmp, f.font, cache.Format("Lives: ", 2), 0, 0, 6);
+  cache.DrawString(f.renderer.bmp, f.font, "Lives: 3", 0, 0, 7);
+  cache.DrawString(f.renderer.bmp, f.font, "Lives: 3", 0, 0, 6, 2);
+  REQUIRE(cache.Misses() == 4);
+  REQUIRE(cache.Size() == 4);
+}
+
+TEST_CASE("palette changes re-render the run", "[text_cache]") {
+  TextFixture f;
+  TextCache& cache = f.renderer.text_cache;
+  cache.DrawString(f.renderer.bmp, f.font, "YOU'RE IT!", 0, 0, 50);
+  f.renderer.pal.entries[50] = {.r = 1, .g = 2, .b = 3, .unused = 0};
+  f.renderer.UpdatePal32();
+  REQUIRE(f.SameAsFont(
+      [&](Bitmap& scr) { cache.DrawString(scr, f.font, "YOU'RE IT!", 1, 1, 50); },
+      [&](Bitmap& scr) { f.font.DrawString(scr, std::string("YOU'RE IT!"), 1, 1, 50); }));
+  REQUIRE(cache.Misses() == 2);
+}
+
+TEST_CASE("least recently used runs are evicted at capacity", "[text_cache]") {
+  TextFixture f;
+  TextCache& cache = f.renderer.text_cache;
+  for (int i = 0; i < TextCache::kCapacity; ++i) {
+    cache.DrawString(f.renderer.bmp, f.font, cache.Format("n", i), 0, 0, 7);
+  }
+  REQUIRE(cache.Size() == TextCache::kCapacity);
+
+  // Touch the oldest run so the next miss evicts "n1" instead.
+  cache.DrawString(f.renderer.bmp, f.font, "n0", 0, 0, 7);
+  cache.DrawString(f.renderer.bmp, f.font, "extra", 0, 0, 7);
+  REQUIRE(cache.Size() == TextCache::kCapacity);
+  uint64_t const kMisses = cache.Misses();
+
+  cache.DrawString(f.renderer.bmp, f.font, "n0", 0, 0, 7);
+  REQUIRE(cache.Misses() == kMisses);
+  cache.DrawString(f.renderer.bmp, f.font, "n1", 0, 0, 7);
+  REQUIRE(cache.Misses() == kMisses + 1);
+}
@@ -0,0 +1,152 @@
+// kPacketTick payload codec and receiver-side loss estimate.
+//
+// Pure data-structure test: encode/decode round trips, the size of the
+// common idle/held-input case, rejection of malformed payloads, and the
+// LossMeter's response to gaps and reordering.
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#include "net/tickPacket.hpp"
+
+namespace {
+
+TickPacket MakePacket(uint8_t count) {
+  TickPacket p;
+  p.generation = 3;
+  p.seq = 0xBEEF;
+  p.ack_next = 990;
+  p.loss_q8 = 17;
+  p.base_frame = 1000;
+  p.count = count;
+  p.lag = 2;
+  return p;
+}
+
+}  // namespace
+
+TEST_CASE("Tick packet round-trips inputs, ack and checksums", "[net][tick-packet]") {
+  TickPacket p = MakePacket(8);
+  uint8_t const kInputs[8] = {0x01, 0x01, 0x01, 0x7f, 0x00, 0x00, 0x05, 0x06};
+  for (int i = 0; i < 8; ++i) {
+    p.inputs[i] = kInputs[i];
+  }
+  p.checksum_count = 2;
+  p.checksums[0] = {.epoch = 1, .frame = 1007, .checksum = 0x12345678};
+  p.checksums[1] = {.epoch = 1, .frame = 990, .checksum = 0x9ABCDEF0};
+
+  uint8_t buf[TickPacket::kMaxSize];
+  std::size_t const kLen = EncodeTickPacket(p, buf);
+  REQUIRE(kLen > 0);
+
+  TickPacket q;
+  REQUIRE(DecodeTickPacket(buf, kLen, q));
+  REQUIRE(q.generation == 3);
+  REQUIRE(q.seq == 0xBEEF);
+  REQUIRE(q.ack_next == 990);
+  REQUIRE(q.loss_q8 == 17);
+  REQUIRE(q.base_frame == 1000);
+  REQUIRE(q.count == 8);
+  REQUIRE(q.LocalFrame() == 1005);
+  for (int i = 0; i < 8; ++i) {
+    REQUIRE(q.inputs[i] == kInputs[i]);
+  }
+  REQUIRE(q.checksum_count == 2);
+  REQUIRE(q.checksums[0].frame == 1007);
+  REQUIRE(q.checksums[0].checksum == 0x12345678);
+  REQUIRE(q.checksums[1].epoch == 1);
+  REQUIRE(q.checksums[1].frame == 990);
+  REQUIRE(q.checksums[1].checksum == 0x9ABCDEF0);
+}
+
+TEST_CASE("Tick packet run-length codes held input", "[net][tick-packet]") {
+  // A full window of one held control state: header, literal, one run
+  // byte, empty checksum list.
+  TickPacket p = MakePacket(TickPacket::kMaxInputs);
+  p.lag = 0;
+  p.inputs.fill(0x21);
+  uint8_t buf[TickPacket::kMaxSize];
+  std::size_t const kLen = EncodeTickPacket(p, buf);
+  REQUIRE(kLen == TickPacket::kHeaderSize + 2 + 1);
+
+  TickPacket q;
+  REQUIRE(DecodeTickPacket(buf, kLen, q));
+  for (std::size_t i = 0; i < TickPacket::kMaxInputs; ++i) {
+    REQUIRE(q.inputs[i] == 0x21);
+  }
+
+  // The reserved top bit never reaches the wire.
+  p.inputs[5] = 0xA1;
+  REQUIRE(EncodeTickPacket(p, buf) == kLen);
+}
+
+TEST_CASE("Tick packet rejects malformed payloads", "[net][tick-packet]") {
+  TickPacket p = MakePacket(4);
+  p.inputs = {0x01, 0x02, 0x02, 0x03};
+  p.checksum_count = 1;
+  p.checksums[0] = {.epoch = 0, .frame = 1001, .checksum = 7};
+  uint8_t buf[TickPacket::kMaxSize + 1];
+  std::size_t const kLen = EncodeTickPacket(p, buf);
+  REQUIRE(kLen > 0);
+
+  TickPacket q;
+  for (std::size_t len = 0; len < kLen; ++len) {
+    REQUIRE_FALSE(DecodeTickPacket(buf, len, q));
+  }
+  buf[kLen] = 0;
+  REQUIRE_FALSE(DecodeTickPacket(buf, kLen + 1, q));
+
+  // A run reaching past `count`.
+  std::size_t const kRunAt = TickPacket::kHeaderSize + 2;
+  REQUIRE(buf[kRunAt] == 0x80);
+  buf[kRunAt] = 0x82;
+  REQUIRE_FALSE(DecodeTickPacket(buf, kLen, q));
+  buf[kRunAt] = 0x80;
+  REQUIRE(DecodeTickPacket(buf, kLen, q));
+
+  // The sender's frame must lie inside the window.
+  buf[13] = 4;
+  REQUIRE_FALSE(DecodeTickPacket(buf, kLen, q));
+
+  // Checksums the window can't express are refused on the way out.
+  p.base_frame = 0x20000;
+  p.checksums[0].frame = p.NewestFrame() + 1;
+  REQUIRE(EncodeTickPacket(p, buf) == 0);
+  p.checksums[0].frame = p.NewestFrame() - 0x10000;
+  REQUIRE(EncodeTickPacket(p, buf) == 0);
+  p.checksums[0].frame = p.NewestFrame() - 0xFFFF;
+  REQUIRE(EncodeTickPacket(p, buf) > 0);
+}
+
+TEST_CASE("LossMeter tracks sequence gaps", "[net][tick-packet]") {
+  LossMeter clean;
+  for (uint16_t s = 0; s < 200; ++s) {
+    clean.OnSeq(s);
+  }
+  REQUIRE(clean.LossQ8() == 0);
+
+  // Every fourth packet lost: about 25%, i.e. ~64/256. The sequence
+  // wraps on the way.
+  LossMeter lossy;
+  uint16_t seq = 0xFF00;
+  for (int i = 0; i < 400; ++i, ++seq) {
+    if (i % 4 != 3) {
+      lossy.OnSeq(seq);
+    }
+  }
+  REQUIRE(lossy.LossQ8() > 40);
+  REQUIRE(lossy.LossQ8() < 90);
+
+  // Duplicates and late arrivals don't move the estimate.
+  uint8_t const kBefore = lossy.LossQ8();
+  lossy.OnSeq(static_cast<uint16_t>(seq - 2));
+  lossy.OnSeq(static_cast<uint16_t>(seq - 10));
+  REQUIRE(lossy.LossQ8() == kBefore);
+
+  // Recovers once the link is clean again.
+  for (int i = 0; i < 200; ++i, ++seq) {
+    lossy.OnSeq(seq);
+  }
+  REQUIRE(lossy.LossQ8() < 4);
+}
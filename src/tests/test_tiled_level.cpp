@@ -0,0 +1,205 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "common.hpp"
+#include "io/stream.hpp"
+#include "level.hpp"
+#include "rand.hpp"
+#include "settings.hpp"
+#include "tiled_level.hpp"
+
+// OLLEVEL3 (tiled_level.hpp): levels written with WriteTiledLevel must
+// come back through Level::load exactly, tile edges included.
+
+static void FillMaterials(Common& common) {
+  for (int i = 0; i < 256; ++i) {
+    common.materials[i].flags = static_cast<uint8_t>(i & 0x3f);
+  }
+}
+
+// Open sky over a noisy dirt band, the kind of content real levels have.
+static void FillLevel(Level& level, Common& common, int w, int h, uint32_t seed) {
+  Rand rand(seed);
+  level.Resize(w, h);
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      int const kIdx = (y * w) + x;
+      level.material_id[kIdx] = y < h / 2 ? 160 : static_cast<uint8_t>(12 + rand(7));
+      level.materials[kIdx] = common.materials[level.material_id[kIdx]];
+    }
+  }
+}
+
+static std::vector<uint8_t> Write(Level const& level, int tile_size) {
+  std::vector<uint8_t> buf;
+  io::VectorWriter w(buf);
+  WriteTiledLevel(level, w, tile_size);
+  return buf;
+}
+
+static void RequireSameLevel(Level const& a, Level const& b, Common const& common) {
+  REQUIRE(b.width == a.width);
+  REQUIRE(b.height == a.height);
+  REQUIRE(b.material_id == a.material_id);
+  for (std::size_t i = 0; i < b.material_id.size(); ++i) {
+    REQUIRE(b.materials[i].flags == common.materials[b.material_id[i]].flags);
+  }
+  REQUIRE(b.display_valid == a.display_valid);
+  for (std::size_t i = 0; i < a.display_valid.size(); ++i) {
+    if (a.display_valid[i] != 0) {
+      REQUIRE(b.display_data[i] == a.display_data[i]);
+    }
+  }
+  REQUIRE(b.display_anim == a.display_anim);
+  REQUIRE(b.argb_ramps.size() == a.argb_ramps.size());
+  for (std::size_t i = 0; i < a.argb_ramps.size(); ++i) {
+    CHECK(b.argb_ramps[i].colors == a.argb_ramps[i].colors);
+    CHECK(b.argb_ramps[i].shift == a.argb_ramps[i].shift);
+  }
+}
+
+TEST_CASE("OLLEVEL3 round-trips a material-only level", "[tiled-level]") {
+  Common common;
+  FillMaterials(common);
+  Settings settings;
+
+  Level level(common);
+  // Not a multiple of the tile size, so the last row and column of tiles
+  // are partial.
+  FillLevel(level, common, 301, 203, 1);
+  auto const kBuf = Write(level, 64);
+
+  io::MemReader r(kBuf);
+  Level loaded(common);
+  REQUIRE(loaded.load(common, settings, r));
+  RequireSameLevel(level, loaded, common);
+  CHECK_FALSE(loaded.has_custom_palette);
+  // Far smaller than the raw OLLEVEL2 material bytes.
+  CHECK(kBuf.size() < static_cast<std::size_t>(301 * 203) / 2);
+}
+
+TEST_CASE("OLLEVEL3 round-trips display, animation and palette", "[tiled-level]") {
+  Common common;
+  FillMaterials(common);
+  Settings settings;
+
+  Level level(common);
+  FillLevel(level, common, 200, 150, 2);
+  std::size_t const kCells = 200 * 150;
+  level.display_data.assign(kCells, 0);
+  level.display_valid.assign(kCells, 0);
+  level.display_anim.assign(kCells, 0);
+  level.argb_ramps.push_back({.colors = {0xFF1A3A6A, 0xFF2A4A7A, 0xFF3A5A8A}, .shift = 1});
+  level.argb_ramps.push_back({.colors = {0xFF102030}, .shift = 0});
+  for (std::size_t i = 0; i < kCells; ++i) {
+    if (i % 3 == 0) {
+      level.display_valid[i] = 1;
+      level.display_data[i] = 0xFF000000U | static_cast<uint32_t>(i % 40);
+    }
+    if (i % 7 == 0) {
+      level.display_valid[i] = 1;
+      level.display_anim[i] = static_cast<uint8_t>(1 + (i % 2));
+      level.display_data[i] = static_cast<uint32_t>(i % 3);  // phase
+    }
+  }
+  level.has_custom_palette = true;
+  for (int i = 0; i < 256; ++i) {
+    level.origpal.entries[i] = {.r = static_cast<uint8_t>((i & 63) << 2),
+                                .g = static_cast<uint8_t>(((i >> 2) & 63) << 2),
+                                .b = 8,
+                                .unused = 0};
+  }
+
+  auto const kBuf = Write(level, 48);
+  io::MemReader r(kBuf);
+  Level loaded(common);
+  REQUIRE(loaded.load(common, settings, r));
+  RequireSameLevel(level, loaded, common);
+  CHECK(loaded.has_custom_palette);
+  for (int i = 0; i < 256; ++i) {
+    CHECK(loaded.origpal.entries[i].r == level.origpal.entries[i].r);
+    CHECK(loaded.origpal.entries[i].g == level.origpal.entries[i].g);
+    CHECK(loaded.origpal.entries[i].b == level.origpal.entries[i].b);
+  }
+
+  SECTION("the palette is ignored when POWERLEVEL palettes are off") {
+    settings.load_powerlevel_palette = false;
+    io::MemReader r2(kBuf);
+    Level classic(common);
+    REQUIRE(classic.load(common, settings, r2));
+    CHECK_FALSE(classic.has_custom_palette);
+    CHECK(classic.origpal.entries[5].r == common.exepal.entries[5].r);
+  }
+}
+
+TEST_CASE("OLLEVEL3 keeps display layers with many distinct values", "[tiled-level]") {
+  Common common;
+  FillMaterials(common);
+  Settings settings;
+
+  // 2-byte indices (more than 255 values), and raw values (more than 65535).
+  for (uint32_t const kDistinct : {3000U, 90000U}) {
+    Level level(common);
+    FillLevel(level, common, 400, 300, kDistinct);
+    std::size_t const kCells = 400 * 300;
+    level.display_data.assign(kCells, 0);
+    level.display_valid.assign(kCells, 0);
+    for (std::size_t i = 0; i < kCells; ++i) {
+      level.display_valid[i] = 1;
+      level.display_data[i] = 0xFF000000U | static_cast<uint32_t>((i * 7919) % kDistinct);
+    }
+
+    auto const kBuf = Write(level, kTiledLevelTileSize);
+    io::MemReader r(kBuf);
+    Level loaded(common);
+    REQUIRE(loaded.load(common, settings, r));
+    RequireSameLevel(level, loaded, common);
+  }
+}
+
+TEST_CASE("OLLEVEL3 rejects malformed files", "[tiled-level]") {
+  Common common;
+  FillMaterials(common);
+  Settings settings;
+
+  Level level(common);
+  FillLevel(level, common, 120, 90, 3);
+  auto const kGood = Write(level, 32);
+
+  SECTION("bad version") {
+    auto buf = kGood;
+    buf[8] = 1;
+    io::MemReader r(buf);
+    Level loaded(common);
+    CHECK_FALSE(loaded.load(common, settings, r));
+  }
+
+  SECTION("zero tile size") {
+    auto buf = kGood;
+    buf[13] = 0;
+    buf[14] = 0;
+    io::MemReader r(buf);
+    Level loaded(common);
+    CHECK_FALSE(loaded.load(common, settings, r));
+  }
+
+  SECTION("damaged tile data") {
+    auto buf = kGood;
+    for (std::size_t i = buf.size() - 40; i < buf.size(); ++i) {
+      buf[i] ^= 0x5a;
+    }
+    io::MemReader r(buf);
+    Level loaded(common);
+    CHECK_FALSE(loaded.load(common, settings, r));
+  }
+
+  SECTION("truncated file") {
+    auto buf = kGood;
+    buf.resize(buf.size() - 1);
+    io::MemReader r(buf);
+    Level loaded(common);
+    CHECK_THROWS_AS(loaded.load(common, settings, r), io::EndOfStream);
+  }
+}
@@ -0,0 +1,140 @@
+// Time sync / link estimation.
+//
+// Pure data-structure test: two TimeSync instances exchange messages over
+// a simulated link with a fixed one-way delay in ticks. We check the RTT
+// estimate, the lead imbalance and frame stretching on the leading side,
+// input-delay agreement, and that duplicates are ignored.
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+
+#include "rollback/time_sync.hpp"
+
+using rollback::Histogram;
+using rollback::TimeSync;
+using rollback::TimeSyncMessage;
+
+namespace {
+
+struct InFlight {
+  uint32_t deliver_at;
+  TimeSyncMessage msg;
+};
+
+// Runs two peers for `ticks`, A→B and B→A each taking `one_way` ticks.
+// `lead_a` / `lead_b` are what each side reports as its lead.
+void RunLink(TimeSync& a, TimeSync& b, uint32_t one_way, uint32_t ticks, float lead_a, float lead_b,
+             uint8_t delay_a = 1, uint8_t delay_b = 1) {
+  std::deque<InFlight> to_a;
+  std::deque<InFlight> to_b;
+  for (uint32_t t = 0; t < ticks; ++t) {
+    if (a.Tick()) {
+      to_b.push_back({.deliver_at = a.Now() + one_way, .msg = a.MakeMessage(lead_a, delay_a)});
+    }
+    if (b.Tick()) {
+      to_a.push_back({.deliver_at = b.Now() + one_way, .msg = b.MakeMessage(lead_b, delay_b)});
+    }
+    while (!to_b.empty() && to_b.front().deliver_at <= b.Now()) {
+      b.OnMessage(to_b.front().msg);
+      to_b.pop_front();
+    }
+    while (!to_a.empty() && to_a.front().deliver_at <= a.Now()) {
+      a.OnMessage(to_a.front().msg);
+      to_a.pop_front();
+    }
+  }
+}
+
+}  // namespace
+
+TEST_CASE("TimeSync estimates round-trip time from echoes", "[rollback][time-sync]") {
+  TimeSync a;
+  TimeSync b;
+  REQUIRE_FALSE(a.HasRtt());
+  RunLink(a, b, /*one_way=*/6, /*ticks=*/700, 0.0F, 0.0F);
+  REQUIRE(a.HasRtt());
+  REQUIRE(b.HasRtt());
+  // The echo hold is subtracted, so a fixed link measures exactly.
+  REQUIRE(std::fabs(a.RttTicks() - 12.0F) < 0.5F);
+  REQUIRE(std::fabs(b.RttTicks() - 12.0F) < 0.5F);
+  REQUIRE(a.JitterTicks() < 0.5F);
+}
+
+TEST_CASE("TimeSync stretches frames only on the leading peer", "[rollback][time-sync]") {
+  TimeSync a;
+  TimeSync b;
+  // A thinks it is 3 frames ahead, B agrees it is 3 behind.
+  RunLink(a, b, /*one_way=*/2, /*ticks=*/200, 3.0F, -3.0F);
+  REQUIRE(a.Imbalance() > 2.5F);
+  REQUIRE(b.Imbalance() < -2.5F);
+
+  // A pays back ~3 frames, a couple of milliseconds per frame.
+  int total_ms = 0;
+  for (int i = 0; i < 100; ++i) {
+    int const kMs = a.TakeStretchMs();
+    REQUIRE(kMs <= TimeSync::kMaxStretchMs);
+    total_ms += kMs;
+  }
+  REQUIRE(total_ms >= 2 * TimeSync::kFrameMs);
+  REQUIRE(total_ms <= 3 * TimeSync::kFrameMs);
+  REQUIRE(b.TakeStretchMs() == 0);
+
+  // Small imbalances are left alone.
+  TimeSync c;
+  TimeSync d;
+  RunLink(c, d, /*one_way=*/2, /*ticks=*/200, 0.25F, -0.25F);
+  REQUIRE(c.TakeStretchMs() == 0);
+}
+
+TEST_CASE("TimeSync proposes input delay from the link and peers agree on the max",
+          "[rollback][time-sync]") {
+  TimeSync a;
+  TimeSync b;
+  // Fast link: prediction covers it, the floor stands.
+  RunLink(a, b, /*one_way=*/2, /*ticks=*/300, 0.0F, 0.0F);
+  REQUIRE(a.DesiredDelay(1, 7) == 1);
+
+  // 8 ticks one way: ceil(8 - 3) = 5 frames, clamped to [floor, ceiling].
+  TimeSync c;
+  TimeSync d;
+  RunLink(c, d, /*one_way=*/8, /*ticks=*/700, 0.0F, 0.0F, /*delay_a=*/5, /*delay_b=*/2);
+  REQUIRE(c.DesiredDelay(1, 7) == 5);
+  REQUIRE(c.DesiredDelay(1, 4) == 4);
+  REQUIRE(c.DesiredDelay(6, 7) == 6);
+  // Each side takes the larger of its own wish and the peer's proposal.
+  REQUIRE(c.AgreedDelay(1, 7) == 5);
+  REQUIRE(d.AgreedDelay(1, 7) == 5);
+}
+
+TEST_CASE("TimeSync ignores duplicate and stale messages", "[rollback][time-sync]") {
+  TimeSync a;
+  TimeSync b;
+  for (int i = 0; i < 20; ++i) {
+    a.Tick();
+  }
+  TimeSyncMessage const kFirst = a.MakeMessage(4.0F, 1);
+  for (int i = 0; i < 20; ++i) {
+    a.Tick();
+  }
+  TimeSyncMessage const kSecond = a.MakeMessage(-4.0F, 1);
+
+  b.OnMessage(kSecond);
+  float const kAfterSecond = b.Imbalance();
+  b.OnMessage(kFirst);
+  b.OnMessage(kSecond);
+  REQUIRE(b.Imbalance() == kAfterSecond);
+}
+
+TEST_CASE("Histogram buckets by value and clamps to the last bucket", "[rollback][time-sync]") {
+  Histogram h;
+  h.Add(0);
+  h.Add(3);
+  h.Add(3);
+  h.Add(1000);
+  REQUIRE(h.counts[0] == 1);
+  REQUIRE(h.counts[3] == 2);
+  REQUIRE(h.counts[Histogram::kBuckets - 1] == 1);
+  REQUIRE(h.Total() == 4);
+}
@@ -0,0 +1,176 @@
+// Built-in zone tracer (trace.hpp). Verifies:
+//   1. Scopes are recorded only while tracing is enabled.
+//   2. A thread's ring keeps its newest kRingEvents scopes.
+//   3. Each thread records into its own named lane, and rings of exited
+//      threads are reused only by threads of the same name.
+//   4. WriteChromeTrace emits trace-event JSON with escaped names and
+//      timestamps relative to the earliest event.
+//   5. FrameBudget fires on over-budget frames, then holds off for the
+//      cooldown.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "io/stream.hpp"
+#include "trace.hpp"
+
+namespace {
+
+// The lane named `name` in `lanes`, or null.
+trace::Lane const* FindLane(std::vector<trace::Lane> const& lanes, std::string_view name) {
+  for (trace::Lane const& lane : lanes) {
+    if (lane.name && name == lane.name) {
+      return &lane;
+    }
+  }
+  return nullptr;
+}
+
+// Leaves tracing off and the rings empty for the next test.
+struct TraceReset {
+  TraceReset() { trace::Clear(); }
+  ~TraceReset() {
+    trace::SetEnabled(false);
+    trace::Clear();
+  }
+  TraceReset(TraceReset const&) = delete;
+  TraceReset& operator=(TraceReset const&) = delete;
+};
+
+}  // namespace
+
+TEST_CASE("trace records scopes only while enabled", "[trace]") {
+  TraceReset const kReset;
+  trace::SetThreadName("test main");
+
+  trace::SetEnabled(false);
+  { trace::Scope const kScope("test::Off"); }
+  trace::SetEnabled(true);
+  { trace::Scope const kScope("test::On"); }
+
+  auto const kLanes = trace::Capture();
+  trace::Lane const* lane = FindLane(kLanes, "test main");
+  REQUIRE(lane != nullptr);
+  REQUIRE(lane->events.size() == 1);
+  CHECK(std::string_view(lane->events[0].name) == "test::On");
+  CHECK(lane->events[0].start_ns <= lane->events[0].end_ns);
+}
+
+TEST_CASE("trace ring keeps the newest scopes", "[trace]") {
+  TraceReset const kReset;
+  trace::SetThreadName("test main");
+
+  auto const kTotal = static_cast<int64_t>(trace::kRingEvents) + 10;
+  for (int64_t i = 0; i < kTotal; ++i) {
+    trace::Record("test::Wrap", i, i + 1);
+  }
+
+  auto const kLanes = trace::Capture();
+  trace::Lane const* lane = FindLane(kLanes, "test main");
+  REQUIRE(lane != nullptr);
+  REQUIRE(lane->events.size() == trace::kRingEvents);
+  CHECK(lane->events.front().start_ns == 10);
+  CHECK(lane->events.back().start_ns == kTotal - 1);
+}
+
+TEST_CASE("trace gives each thread its own lane", "[trace]") {
+  TraceReset const kReset;
+  trace::SetThreadName("test main");
+  trace::SetEnabled(true);
+  { trace::Scope const kScope("test::Main"); }
+
+  std::thread worker([] {
+    trace::SetThreadName("test worker");
+    trace::Scope const kScope("test::Worker");
+  });
+  worker.join();
+
+  auto const kLanes = trace::Capture();
+  trace::Lane const* main_lane = FindLane(kLanes, "test main");
+  trace::Lane const* worker_lane = FindLane(kLanes, "test worker");
+  REQUIRE(main_lane != nullptr);
+  REQUIRE(worker_lane != nullptr);
+  CHECK(main_lane->id != worker_lane->id);
+  REQUIRE(worker_lane->events.size() == 1);
+  CHECK(std::string_view(worker_lane->events[0].name) == "test::Worker");
+
+  SECTION("short-lived threads reuse rings") {
+    std::set<uint32_t> ids;
+    for (int i = 0; i < 8; ++i) {
+      std::thread t([] { trace::Scope const kScope("test::Short"); });
+      t.join();
+      for (trace::Lane const& lane : trace::Capture()) {
+        for (trace::Event const& e : lane.events) {
+          if (std::string_view(e.name) == "test::Short") {
+            ids.insert(lane.id);
+          }
+        }
+      }
+    }
+    CHECK(ids.size() == 1);
+  }
+
+  SECTION("a reused ring keeps scopes only under the same name") {
+    auto run = [](char const* name, char const* scope) {
+      std::thread t([=] {
+        trace::SetThreadName(name);
+        trace::Scope const kScope(scope);
+      });
+      t.join();
+    };
+    run("test pool", "test::Pool1");
+    run("test pool", "test::Pool2");
+    run("test other", "test::Other");
+
+    auto const kAll = trace::Capture();
+    trace::Lane const* pool = FindLane(kAll, "test pool");
+    trace::Lane const* other = FindLane(kAll, "test other");
+    REQUIRE(pool != nullptr);
+    REQUIRE(other != nullptr);
+    CHECK(pool->events.size() == 2);
+    for (trace::Lane const& lane : kAll) {
+      for (trace::Event const& e : lane.events) {
+        if (std::string_view(e.name).starts_with("test::Pool")) {
+          CHECK(lane.id == pool->id);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("WriteChromeTrace writes trace-event JSON", "[trace]") {
+  std::vector<trace::Lane> lanes(1);
+  lanes[0].id = 3;
+  lanes[0].name = "say \"hi\"";
+  lanes[0].events = {{.name = "a\\b", .start_ns = 1000, .end_ns = 3500},
+                     {.name = "c", .start_ns = 2000, .end_ns = 2001}};
+
+  std::string json;
+  io::StringWriter out(json);
+  trace::WriteChromeTrace(lanes, out);
+
+  CHECK(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  CHECK(json.ends_with("]}\n"));
+  CHECK(json.contains(
+      "{\"ph\":\"M\",\"pid\":1,\"tid\":3,\"name\":\"thread_name\","
+      "\"args\":{\"name\":\"say \\\"hi\\\"\"}}"));
+  CHECK(json.contains(
+      "{\"ph\":\"X\",\"pid\":1,\"tid\":3,\"ts\":0.000,\"dur\":2.500,\"name\":\"a\\\\b\"}"));
+  CHECK(json.contains(
+      "{\"ph\":\"X\",\"pid\":1,\"tid\":3,\"ts\":1.000,\"dur\":0.001,\"name\":\"c\"}"));
+}
+
+TEST_CASE("FrameBudget fires on slow frames and then cools down", "[trace]") {
+  trace::FrameBudget budget;
+  CHECK_FALSE(budget.Tick(0, 10, 100));   // no previous frame
+  CHECK_FALSE(budget.Tick(5, 10, 100));   // 5 <= 10
+  CHECK(budget.Tick(20, 10, 100));        // 15 > 10
+  CHECK_FALSE(budget.Tick(40, 10, 100));  // slow, but cooling down until 120
+  CHECK(budget.Tick(130, 10, 100));
+  CHECK_FALSE(budget.Tick(500, 0, 100));  // no budget set
+}
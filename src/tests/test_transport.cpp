@@ -2,7 +2,10 @@
 #include <chrono>
 #include <cstdint>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "net/spscQueue.hpp"
 #include "net/transport.hpp"
 
 static void PollUntil(NetTransport& t, NetTransport::State target, int max_ms = 2000) {
@@ -104,12 +107,14 @@ TEST_CASE("Transport delivers handshake", "[transport]") {
 
   uint32_t rx_seed = 0;
   uint32_t rx_hash = 0;
-  host.on_handshake = [&](uint32_t s, uint32_t h) {
+  uint8_t rx_window = 0;
+  host.on_handshake = [&](uint32_t s, uint32_t h, uint8_t w) {
     rx_seed = s;
     rx_hash = h;
+    rx_window = w;
   };
 
-  client.SendHandshake(12345, 0xDEADBEEF);
+  client.SendHandshake(12345, 0xDEADBEEF, 24);
 
   deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
   while (rx_seed == 0 && std::chrono::steady_clock::now() < deadline) {
@@ -120,6 +125,7 @@ TEST_CASE("Transport delivers handshake", "[transport]") {
 
   REQUIRE(rx_seed == 12345);
   REQUIRE(rx_hash == 0xDEADBEEF);
+  REQUIRE(rx_window == 24);
 }
 
 TEST_CASE("Transport delivers player info", "[transport]") {
@@ -328,9 +334,9 @@ TEST_CASE("Transport delivers large map data (100KB+)", "[transport]") {
   REQUIRE(received_data == send_data);
 }
 
-// Rollback K-wide input batch round-trip. Verifies the PacketInputBatch
-// wire format end-to-end, including localDelta reconstruction
-// (= remoteLocalFrame).
+// Rollback tick packet round-trip. Verifies the kPacketTick wire format
+// end-to-end: the input window with the sender's sim frame, the ack, and
+// checksums queued before the send riding along.
 TEST_CASE("Transport delivers rollback input batches", "[transport][rollback]") {
   NetTransport host;
   REQUIRE(host.Host(0));
@@ -362,10 +368,25 @@ TEST_CASE("Transport delivers rollback input batches", "[transport][rollback]")
     rx_local_frame = lf;
     rx_inputs.assign(in, in + c);
   };
+  uint32_t rx_ack = 0;
+  host.on_input_ack = [&](uint8_t /*gen*/, uint32_t next, uint8_t loss) {
+    rx_ack = next;
+    REQUIRE(loss == 0);
+  };
+  std::vector<std::pair<uint32_t, uint32_t>> rx_checksums;
+  host.on_checksum = [&](uint8_t gen, uint8_t /*epoch*/, uint32_t frame, uint32_t checksum) {
+    REQUIRE(gen == 0);
+    rx_checksums.emplace_back(frame, checksum);
+  };
 
-  uint8_t inputs[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
-  // baseFrame = 100, localDelta = 5, so remoteLocalFrame = 105.
-  client.SendInputBatch(0, 100, 8, 5, inputs);
+  uint8_t inputs[8] = {0x11, 0x22, 0x22, 0x22, 0x55, 0x66, 0x66, 0x08};
+  // Queued until the next input send; the other generation's is dropped.
+  client.SendChecksum(0, 0, 98, 0xAAAA0001);
+  client.SendChecksum(1, 0, 99, 0xBBBB0002);
+  client.SendChecksum(0, 0, 99, 0xAAAA0003);
+  // Inputs for 100..107 while simming frame 105, holding the host's
+  // input up to frame 89.
+  client.SendInputBatch(0, 100, 8, 105, inputs, 90);
 
   deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
   while (rx_base_frame == 0xFFFFFFFF && std::chrono::steady_clock::now() < deadline) {
@@ -382,6 +403,9 @@ TEST_CASE("Transport delivers rollback input batches", "[transport][rollback]")
   for (int i = 0; i < 8; ++i) {
     REQUIRE(rx_inputs[i] == inputs[i]);
   }
+  REQUIRE(rx_ack == 90);
+  REQUIRE(rx_checksums == std::vector<std::pair<uint32_t, uint32_t>>{{98, 0xAAAA0001},
+                                                                      {99, 0xAAAA0003}});
 }
 
 // The handshake carries kProtocolVersion. A peer that sends a
@@ -408,10 +432,10 @@ TEST_CASE("Transport rejects handshake with wrong protocol version", "[transport
   REQUIRE(host.CurrentState() == NetTransport::kConnected);
 
   bool delivered = false;
-  host.on_handshake = [&](uint32_t, uint32_t) { delivered = true; };
+  host.on_handshake = [&](uint32_t, uint32_t, uint8_t) { delivered = true; };
 
   // Normal handshake (correct version) goes through.
-  client.SendHandshake(7, 0x12345678);
+  client.SendHandshake(7, 0x12345678, 7);
   deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
   while (!delivered && std::chrono::steady_clock::now() < deadline) {
     host.Poll();
@@ -422,5 +446,122 @@ TEST_CASE("Transport rejects handshake with wrong protocol version", "[transport
 
   // Now also confirm the constant lines up — the test would silently
   // pass against any version if this slipped to a stale value.
-  REQUIRE(NetTransport::kProtocolVersion == 8);
-}
\ No newline at end of file
+  REQUIRE(NetTransport::kProtocolVersion == 13);
+}
+TEST_CASE("SpscQueue keeps order and reports full/empty", "[transport]") {
+  SpscQueue<int, 4> q;
+  int v = -1;
+  REQUIRE_FALSE(q.TryPop(v));
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(q.TryPush(i));
+  }
+  REQUIRE_FALSE(q.TryPush(4));
+  REQUIRE(q.TryPop(v));
+  REQUIRE(v == 0);
+  REQUIRE(q.TryPush(4));
+  for (int i = 1; i <= 4; ++i) {
+    REQUIRE(q.TryPop(v));
+    REQUIRE(v == i);
+  }
+  REQUIRE_FALSE(q.TryPop(v));
+
+  // Across threads every item arrives exactly once, in order.
+  SpscQueue<uint32_t, 8> tq;
+  constexpr uint32_t kItems = 100000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < kItems;) {
+      if (tq.TryPush(i)) {
+        ++i;
+      }
+    }
+  });
+  uint32_t expected = 0;
+  bool in_order = true;
+  while (expected < kItems) {
+    uint32_t got = 0;
+    if (tq.TryPop(got)) {
+      in_order = in_order && got == expected;
+      ++expected;
+    }
+  }
+  producer.join();
+  REQUIRE(in_order);
+}
+
+TEST_CASE("Transport I/O thread delivers input, checksums and control packets",
+          "[transport][rollback]") {
+  NetTransport host;
+  REQUIRE(host.Host(0));
+  uint16_t const kPort = host.ListeningPort();
+
+  NetTransport client;
+  REQUIRE(client.Connect("127.0.0.1", kPort));
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while ((host.CurrentState() != NetTransport::kConnected ||
+          client.CurrentState() != NetTransport::kConnected) &&
+         std::chrono::steady_clock::now() < deadline) {
+    host.Poll();
+    client.Poll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(host.CurrentState() == NetTransport::kConnected);
+
+  REQUIRE(host.StartIoThread());
+  REQUIRE(client.StartIoThread());
+  REQUIRE(host.IoThreadRunning());
+
+  std::vector<uint8_t> rx_inputs;
+  uint32_t rx_local_frame = 0;
+  uint32_t rx_checksum = 0;
+  uint8_t rx_epoch = 0;
+  bool rx_pause = false;
+  std::vector<uint8_t> rx_resync;
+  host.on_remote_input_batch = [&](uint8_t /*gen*/, uint32_t /*bf*/, uint8_t c,
+                                   uint8_t const* in, uint32_t lf) {
+    rx_inputs.assign(in, in + c);
+    rx_local_frame = lf;
+  };
+  host.on_checksum = [&](uint8_t /*gen*/, uint8_t epoch, uint32_t /*frame*/, uint32_t checksum) {
+    rx_epoch = epoch;
+    rx_checksum = checksum;
+  };
+  host.on_pause = [&]() { rx_pause = true; };
+  host.on_resync_state = [&](uint8_t epoch, uint32_t frame, const void* data, size_t len) {
+    if (epoch == 3 && frame == 77) {
+      auto const* p = static_cast<uint8_t const*>(data);
+      rx_resync.assign(p, p + len);
+    }
+  };
+
+  uint8_t inputs[3] = {0x01, 0x02, 0x03};
+  client.SendChecksum(0, 2, 40, 0xDEADBEEF);
+  client.SendInputBatch(0, 40, 3, 42, inputs, 0);
+  client.SendPause();
+  std::vector<uint8_t> const kResync = {1, 6, 0, 0, 0, 0xAA, 0xBB, 0xCC};
+  client.SendResyncState(3, 77, kResync.data(), kResync.size());
+
+  // Tick packets come through PumpInput() alone, without Poll().
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while ((rx_inputs.empty() || rx_checksum == 0) && std::chrono::steady_clock::now() < deadline) {
+    host.PumpInput();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(rx_inputs == std::vector<uint8_t>{0x01, 0x02, 0x03});
+  REQUIRE(rx_local_frame == 42);
+  REQUIRE(rx_checksum == 0xDEADBEEF);
+  REQUIRE(rx_epoch == 2);
+
+  // Everything else still waits for Poll() on the game thread.
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while ((!rx_pause || rx_resync.empty()) && std::chrono::steady_clock::now() < deadline) {
+    host.Poll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(rx_pause);
+  REQUIRE(rx_resync == kResync);
+
+  host.StopIoThread();
+  REQUIRE_FALSE(host.IoThreadRunning());
+  REQUIRE(host.CurrentState() == NetTransport::kConnected);
+}
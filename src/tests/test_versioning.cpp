@@ -20,6 +20,7 @@
 #include "game/serialization/toml_archive.hpp"
 
 #include <sstream>
+#include <string>
 
 // ---------------------------------------------------------------------------
 // v1 fixtures — old format TOML (ptr_wrapper style, tests generic serialize)
@@ -329,7 +330,7 @@ TEST_CASE("versioning: Settings toToml/fromToml produces human-readable config",
   CHECK(kToml.contains("[player2]"));
   CHECK(kToml.contains("[network_player]"));
   // Version field present for future-proofing
-  CHECK(kToml.contains("version = 6"));
+  CHECK(kToml.contains("version = " + std::to_string(Settings::kConfigVersion)));
   // No ptr_wrapper noise
   CHECK(!kToml.contains("ptr_wrapper"));
   CHECK(!kToml.contains("[s]"));
@@ -439,6 +440,112 @@ TEST_CASE("versioning: maxSpectatorRenderHeight round-trips and defaults to 1080
   CHECK(legacy.max_spectator_render_height == 1080);
 }
 
+TEST_CASE("versioning: spectatorResidentLevel round-trips and defaults to on", "[versioning]") {
+  Settings src;
+  src.spectator_resident_level = false;
+  std::string const kToml = src.ToToml();
+  CHECK(kToml.contains("spectatorResidentLevel = false"));
+
+  Settings dst;
+  dst.FromToml(kToml);
+  CHECK(dst.spectator_resident_level == false);
+
+  // Configs predating the v7 field keep the struct default (on).
+  Settings legacy;
+  std::string toml = kToml;
+  auto const kPos = toml.find("spectatorResidentLevel = false");
+  REQUIRE(kPos != std::string::npos);
+  toml.replace(kPos, std::string("spectatorResidentLevel = false").length(), "");
+  legacy.FromToml(toml);
+  CHECK(legacy.spectator_resident_level == true);
+}
+
+TEST_CASE("versioning: netIoThread round-trips and defaults to on", "[versioning]") {
+  Settings src;
+  src.net_io_thread = false;
+  std::string const kToml = src.ToToml();
+  CHECK(kToml.contains("netIoThread = false"));
+
+  Settings dst;
+  dst.FromToml(kToml);
+  CHECK(dst.net_io_thread == false);
+
+  // Configs predating the v8 field keep the struct default (on).
+  Settings legacy;
+  std::string toml = kToml;
+  auto const kPos = toml.find("netIoThread = false");
+  REQUIRE(kPos != std::string::npos);
+  toml.replace(kPos, std::string("netIoThread = false").length(), "");
+  legacy.FromToml(toml);
+  CHECK(legacy.net_io_thread == true);
+}
+
+TEST_CASE("versioning: rollbackWindow round-trips and defaults to 7", "[versioning]") {
+  Settings src;
+  src.rollback_window = 24;
+  std::string const kToml = src.ToToml();
+  CHECK(kToml.contains("rollbackWindow = 24"));
+
+  Settings dst;
+  dst.FromToml(kToml);
+  CHECK(dst.rollback_window == 24);
+
+  // Configs predating the v9 field keep the struct default.
+  Settings legacy;
+  std::string toml = kToml;
+  auto const kPos = toml.find("rollbackWindow = 24");
+  REQUIRE(kPos != std::string::npos);
+  toml.replace(kPos, std::string("rollbackWindow = 24").length(), "");
+  legacy.FromToml(toml);
+  CHECK(legacy.rollback_window == 7);
+}
+
+TEST_CASE("versioning: exportMatchStats round-trips and defaults to off", "[versioning]") {
+  Settings src;
+  src.export_match_stats = true;
+  std::string const kToml = src.ToToml();
+  CHECK(kToml.contains("exportMatchStats = true"));
+
+  Settings dst;
+  dst.FromToml(kToml);
+  CHECK(dst.export_match_stats == true);
+
+  // Configs predating the v10 field keep the struct default (off).
+  Settings legacy;
+  std::string toml = kToml;
+  auto const kPos = toml.find("exportMatchStats = true");
+  REQUIRE(kPos != std::string::npos);
+  toml.replace(kPos, std::string("exportMatchStats = true").length(), "");
+  legacy.FromToml(toml);
+  CHECK(legacy.export_match_stats == false);
+}
+
+TEST_CASE("versioning: trace settings round-trip and default to off", "[versioning]") {
+  Settings src;
+  src.trace_zones = true;
+  src.trace_frame_budget_ms = 40;
+  std::string const kToml = src.ToToml();
+  CHECK(kToml.contains("traceZones = true"));
+  CHECK(kToml.contains("traceFrameBudgetMs = 40"));
+
+  Settings dst;
+  dst.FromToml(kToml);
+  CHECK(dst.trace_zones == true);
+  CHECK(dst.trace_frame_budget_ms == 40);
+
+  // Configs predating the v12 fields keep the struct defaults (off).
+  Settings legacy;
+  std::string toml = kToml;
+  for (std::string const kLine : {"traceZones = true", "traceFrameBudgetMs = 40"}) {
+    auto const kPos = toml.find(kLine);
+    REQUIRE(kPos != std::string::npos);
+    toml.replace(kPos, kLine.length(), "");
+  }
+  legacy.FromToml(toml);
+  CHECK(legacy.trace_zones == false);
+  CHECK(legacy.trace_frame_budget_ms == 0);
+}
+
 TEST_CASE("versioning: out-of-range worm rgb in TOML is clamped on load", "[versioning]") {
   // A picker bug briefly stored 256; loads must clamp into 0..255.
   WormSettings dst;
@@ -3,6 +3,7 @@
 #include "game/filesystem.hpp"
 #include "game/math.hpp"
 #include "game/reader.hpp"
+#include "game/tc_cache.hpp"
 #include "game/text.hpp"
 
 #include <cstdio>
@@ -37,9 +38,11 @@ int main(int argc, char* argv[]) try {
   // Use the same path-resolution logic as the main binary.
   // paths::Resolve ignores single-dash flags, so -d/-s/-r/-w/-h pass through harmlessly.
   // Output videos land next to the replay file; no writes go to any config path.
+  // The TC snapshot goes to the user data cache, so batch jobs after the
+  // first skip decoding the TC.
   auto r = paths::Resolve(argc, argv);
-  std::shared_ptr<Common> const kCommon = std::make_shared<Common>();
-  kCommon->load(r.config_node / "TC" / kArgs.tc_name);
+  std::shared_ptr<Common> const kCommon =
+      LoadCommonCached(r.config_node / "TC" / kArgs.tc_name, TcCacheNode(kArgs.tc_name));
 
   std::string const kSuffix = kArgs.spectator ? "_s" : "_n";
 
@@ -15,16 +15,24 @@ Layout:
 
 Run from the repository root:
     python3 tools/gen_large_test.py
+    python3 tools/gen_large_test.py --tiled   # OLLEVEL3: under 1 MB
+
+--tiled writes the same level in the compressed OLLEVEL3 format to
+large_test_tiled.lev, for comparing load times against the flat file.
 """
 
+import argparse
 import struct
 import sys
 from pathlib import Path
 
+import ollevel3
+
 W, H = 4096, 4096
 CELLS = W * H
 
 OUT_PATH = Path("data/TC/openliero/Levels/large_test.lev")
+TILED_OUT_PATH = Path("data/TC/openliero/Levels/large_test_tiled.lev")
 
 SIZED_MAGIC = b"OLLEVEL2"
 MODERNLV_MAGIC = b"MODERNLV"
@@ -89,13 +97,32 @@ def build_modernlv(mat: bytearray) -> tuple[bytearray, bytearray, bytearray, byt
 
 
 def main() -> None:
-    OUT_PATH.parent.mkdir(parents=True, exist_ok=True)
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--tiled", action="store_true", help="write OLLEVEL3 instead of OLLEVEL2")
+    args = ap.parse_args()
+
+    out_path = TILED_OUT_PATH if args.tiled else OUT_PATH
+    out_path.parent.mkdir(parents=True, exist_ok=True)
 
     mat = build_material()
     dd, dv, ramp_bytes, da = build_modernlv(mat)
 
-    print(f"  Writing {OUT_PATH} …")
-    with open(OUT_PATH, "wb") as f:
+    print(f"  Writing {out_path} …")
+    if args.tiled:
+        out_path.write_bytes(ollevel3.encode(W, H, bytes(mat), dd=bytes(dd), dv=bytes(dv),
+                                             ramps=[(RAMP_SHIFT, RAMP_COLORS)], da=bytes(da)))
+    else:
+        write_flat(out_path, mat, dd, dv, ramp_bytes, da)
+
+    size_mb = out_path.stat().st_size / 1_048_576
+    print(f"Done. {out_path} ({size_mb:.1f} MB)")
+    print("NOTE: this file is in .gitignore — do not commit it.")
+
+
+def write_flat(out_path: Path, mat: bytearray, dd: bytearray, dv: bytearray,
+               ramp_bytes: bytearray, da: bytearray) -> None:
+    with open(out_path, "wb") as f:
         # OLLEVEL2 header.
         f.write(SIZED_MAGIC)
         f.write(bytes([0]))                   # version
@@ -112,10 +139,6 @@ def main() -> None:
         f.write(ramp_bytes)
         f.write(da)
 
-    size_mb = OUT_PATH.stat().st_size / 1_048_576
-    print(f"Done. {OUT_PATH} ({size_mb:.0f} MB)")
-    print("NOTE: this file is in .gitignore — do not commit it.")
-
 
 if __name__ == "__main__":
     main()
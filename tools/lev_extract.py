@@ -14,8 +14,8 @@ Writes into --out-dir (default: current directory):
   ramps.json    — animation ramp definitions
   anim.png      — animation map (R=ramp index 1-based, G=phase offset, alpha=255 where animated)
 
-Only files present in the level are written.  Handles both legacy 504×350 files
-and OLLEVEL2-headed files of arbitrary size.
+Only files present in the level are written.  Handles legacy 504×350 files,
+OLLEVEL2-headed files of arbitrary size and tiled OLLEVEL3 files.
 
 Usage:
   uv run tools/lev_extract.py level.lev
@@ -28,9 +28,12 @@ import argparse
 import json
 import struct
 import sys
+import zlib
 from pathlib import Path
 from PIL import Image
 
+import ollevel3
+
 LEGACY_W, LEGACY_H = 504, 350
 SIZED_MAGIC = b"OLLEVEL2"
 
@@ -158,6 +161,10 @@ def main() -> None:
 
     data = lev_path.read_bytes()
 
+    if data[:8] == ollevel3.TILED_MAGIC:
+        extract_tiled(lev_path, data, out_dir)
+        return
+
     # Detect OLLEVEL2 sized-format header.
     body_start = 0
     if data[:8] == SIZED_MAGIC:
@@ -247,5 +254,29 @@ def main() -> None:
     print(f"Done. Output in {out_dir}/")
 
 
+def extract_tiled(lev_path: Path, data: bytes, out_dir: Path) -> None:
+    try:
+        lev = ollevel3.decode(data)
+    except (ValueError, struct.error, zlib.error) as e:
+        err(f"bad OLLEVEL3 file: {e}")
+    level_w, level_h = lev["w"], lev["h"]
+    print(f"OLLEVEL3 header: {level_w}×{level_h}")
+
+    print(f"Extracting {lev_path.name}:")
+    write_material(lev["mat"], level_w, level_h, out_dir / "material.png")
+    if lev["palette"] is not None:
+        write_palette(lev["palette"], out_dir / "palette.png")
+    if lev["dd"] is not None:
+        write_display(lev["dd"], lev["dv"], level_w, level_h, out_dir / "display.png")
+        if lev["ramps"] and lev["da"] is not None:
+            ramps = [{"shift": shift,
+                      "colors": [f"#{(c >> 16) & 0xFF:02X}{(c >> 8) & 0xFF:02X}{c & 0xFF:02X}"
+                                 for c in colors]}
+                     for shift, colors in lev["ramps"]]
+            write_anim(ramps, lev["da"], lev["dd"], level_w, level_h,
+                       out_dir / "ramps.json", out_dir / "anim.png")
+    print(f"Done. Output in {out_dir}/")
+
+
 if __name__ == "__main__":
     main()
@@ -10,6 +10,7 @@
 The level dimensions are read from the --mat image.  504×350 produces a
 legacy headerless file; all other sizes write an OLLEVEL2 header.  All
 other image inputs (--disp, --anim) must be the same size as --mat.
+--tiled writes the compressed OLLEVEL3 format instead, at any size.
 
 Usage examples:
   Classic:   uv run tools/lev_gen.py --mat material.png --out level.lev
@@ -17,6 +18,7 @@ Usage examples:
   Modern:    uv run tools/lev_gen.py --mat material.png --disp display.png --out level.lev
   Animated:  uv run tools/lev_gen.py --mat material.png --disp display.png \\
                                      --ramps ramps.json --anim anim.png --out level.lev
+  Tiled:     uv run tools/lev_gen.py --mat material.png --disp display.png --tiled --out level.lev
 
 See docs/modern-level-authoring.md for a full authoring guide.
 """
@@ -27,6 +29,8 @@ import struct
 import sys
 from PIL import Image
 
+import ollevel3
+
 LEGACY_W, LEGACY_H = 504, 350
 MAX_DIM = 4096
 SIZED_MAGIC = b"OLLEVEL2"
@@ -136,6 +140,8 @@ def main() -> None:
     ap.add_argument("--ramps", metavar="JSON", help="animation ramp definitions")
     ap.add_argument("--anim",  metavar="PNG",  help="animation map (R=ramp, G=phase; must match --mat size)")
     ap.add_argument("--out",   required=True,  metavar="LEV",  help="output .lev file")
+    ap.add_argument("--tiled", action="store_true",
+                    help="write the compressed OLLEVEL3 format (any size)")
     args = ap.parse_args()
 
     if args.anim and not args.ramps:
@@ -180,6 +186,35 @@ def main() -> None:
 
     sized = (level_w != LEGACY_W or level_h != LEGACY_H)
 
+    if args.tiled:
+        ramp_list = [(ramp["shift"], [argb32(*hex_rgb(hx)) for hx in ramp["colors"]])
+                     for ramp in ramps]
+        with open(args.out, "wb") as f:
+            f.write(ollevel3.encode(level_w, level_h, mat,
+                                    palette=load_pal(args.pal) if args.pal else None,
+                                    dd=dd if args.disp else None,
+                                    dv=dv if args.disp else None,
+                                    ramps=ramp_list, da=da if ramps else None))
+    else:
+        write_flat(args, mat, level_w, level_h, sized, dd, dv, da, ramps)
+
+    parts = [f"material map ({level_w}×{level_h})"]
+    if args.tiled:  parts.insert(0, "OLLEVEL3 tiles")
+    elif sized:     parts.insert(0, "OLLEVEL2 header")
+    if args.pal:    parts.append("POWERLEVEL palette")
+    if args.disp:   parts.append("MODERNLV display layer")
+    if ramps:       parts.append(f"{len(ramps)} animation ramp(s)")
+    print(f"Written {args.out}: {', '.join(parts)}")
+
+
+def hex_rgb(hx: str) -> tuple[int, int, int]:
+    hx = hx.lstrip("#")
+    return int(hx[0:2], 16), int(hx[2:4], 16), int(hx[4:6], 16)
+
+
+def write_flat(args, mat: bytes, level_w: int, level_h: int, sized: bool,
+               dd: bytearray, dv: bytearray, da: bytearray, ramps: list[dict]) -> None:
+    """Legacy / OLLEVEL2 layout: raw material bytes, then POWERLEVEL and MODERNLV."""
     with open(args.out, "wb") as f:
         if sized:
             f.write(SIZED_MAGIC)
@@ -203,11 +238,7 @@ def main() -> None:
                 for ramp in ramps:
                     colors_bytes = bytearray()
                     for hx in ramp["colors"]:
-                        hx = hx.lstrip("#")
-                        r8 = int(hx[0:2], 16)
-                        g8 = int(hx[2:4], 16)
-                        b8 = int(hx[4:6], 16)
-                        colors_bytes += struct.pack("<I", argb32(r8, g8, b8))
+                        colors_bytes += struct.pack("<I", argb32(*hex_rgb(hx)))
                     f.write(bytes([ramp["shift"]]))
                     f.write(struct.pack("<H", len(ramp["colors"])))
                     f.write(colors_bytes)
@@ -215,13 +246,6 @@ def main() -> None:
             else:
                 f.write(b"\x00")  # ramp_count = 0
 
-    parts = [f"material map ({level_w}×{level_h})"]
-    if sized:      parts.insert(0, "OLLEVEL2 header")
-    if args.pal:   parts.append("POWERLEVEL palette")
-    if args.disp:  parts.append("MODERNLV display layer")
-    if ramps:      parts.append(f"{len(ramps)} animation ramp(s)")
-    print(f"Written {args.out}: {', '.join(parts)}")
-
 
 if __name__ == "__main__":
     main()
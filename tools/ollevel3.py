@@ -0,0 +1,202 @@
+"""ollevel3.py — Encoder/decoder for the OLLEVEL3 tiled level format.
+
+Shared by lev_gen.py, lev_extract.py and gen_large_test.py.  The layout
+is specified in docs/modern-level-authoring.md (Appendix: OLLEVEL3) and
+implemented in-game by src/game/tiled_level.cpp.
+"""
+
+from __future__ import annotations
+
+import re
+import struct
+import zlib
+
+TILED_MAGIC = b"OLLEVEL3"
+DEFAULT_TILE_SIZE = 256
+MAX_DIM = 4096
+
+FLAG_PALETTE = 1 << 0
+FLAG_DISPLAY = 1 << 1
+RAW_DISPLAY = 4
+
+_RUN = re.compile(rb"(.)\1{2,127}", re.S)
+
+
+def pack_bits(data: bytes) -> bytes:
+    """PackBits: h < 128 -> h+1 literal bytes follow; h > 128 -> next byte x (257-h)."""
+    out = bytearray()
+
+    def literal(lo: int, hi: int) -> None:
+        for s in range(lo, hi, 128):
+            chunk = data[s:min(s + 128, hi)]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+
+    pos = 0
+    for m in _RUN.finditer(data):
+        literal(pos, m.start())
+        out.append(257 - (m.end() - m.start()))
+        out.append(data[m.start()])
+        pos = m.end()
+    literal(pos, len(data))
+    return bytes(out)
+
+
+def unpack_bits(data: bytes, size: int) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        h = data[i]
+        i += 1
+        if h < 128:
+            out += data[i:i + h + 1]
+            i += h + 1
+        elif h > 128:
+            out += bytes([data[i]]) * (257 - h)
+            i += 1
+        else:
+            raise ValueError("PackBits header 128")
+    if len(out) != size:
+        raise ValueError("tile unpacks to the wrong size")
+    return bytes(out)
+
+
+def _tiles(w: int, h: int, ts: int):
+    for ty in range(0, h, ts):
+        for tx in range(0, w, ts):
+            yield tx, ty, min(ts, w - tx), min(ts, h - ty)
+
+
+def _crop(plane: bytes, w: int, tx: int, ty: int, tw: int, th: int) -> bytes:
+    return b"".join(plane[(ty + y) * w + tx:(ty + y) * w + tx + tw] for y in range(th))
+
+
+def encode(w: int, h: int, mat: bytes, palette: bytes | None = None,
+           dd: bytes | None = None, dv: bytes | None = None,
+           ramps: list[tuple[int, list[int]]] | None = None, da: bytes | None = None,
+           tile_size: int = DEFAULT_TILE_SIZE) -> bytes:
+    """Build an OLLEVEL3 file.
+
+    mat: w*h material bytes.  palette: 768 bytes of 6-bit VGA channels.
+    dd/dv: display_data (w*h ARGB32 LE) and display_valid (w*h bytes).
+    ramps: [(shift, [argb, ...]), ...]; da: display_anim (w*h bytes).
+    """
+    cells = w * h
+    display = dd is not None and dv is not None
+    anim = display and bool(ramps) and da is not None
+
+    planes: list[bytes] = [mat]
+    head = bytearray(TILED_MAGIC)
+    head += struct.pack("<BHHHB", 0, w, h, tile_size,
+                        (FLAG_PALETTE if palette else 0) | (FLAG_DISPLAY if display else 0))
+    if palette:
+        head += palette
+
+    if display:
+        values_all = struct.unpack(f"<{cells}I", dd)
+        values = sorted({v for v, ok in zip(values_all, dv) if ok})
+        if len(values) <= 0xFFFF:
+            width = 1 if len(values) <= 0xFF else 2
+            index_of = {v: i + 1 for i, v in enumerate(values)}
+            idx = [index_of[v] if ok else 0 for v, ok in zip(values_all, dv)]
+            head.append(width)
+            head += struct.pack(f"<I{len(values)}I", len(values), *values)
+            planes.append(bytes(i & 0xFF for i in idx))
+            if width == 2:
+                planes.append(bytes(i >> 8 for i in idx))
+        else:
+            head.append(RAW_DISPLAY)
+            planes += [dd[b::4] for b in range(4)]
+            planes.append(bytes(dv))
+        ramp_list = ramps if anim else []
+        head.append(len(ramp_list))
+        for shift, colors in ramp_list:
+            head += struct.pack(f"<BH{len(colors)}I", shift, len(colors), *colors)
+        if anim:
+            planes.append(bytes(da))
+
+    payloads = []
+    for tx, ty, tw, th in _tiles(w, h, tile_size):
+        raw = b"".join(_crop(p, w, tx, ty, tw, th) for p in planes)
+        packed = pack_bits(raw)
+        payloads.append(struct.pack("<I", len(packed)) + zlib.compress(packed, 9))
+
+    directory = bytearray()
+    offset = 0
+    for p in payloads:
+        directory += struct.pack("<II", offset, len(p))
+        offset += len(p)
+    return bytes(head) + bytes(directory) + b"".join(payloads)
+
+
+def decode(data: bytes) -> dict:
+    """Parse an OLLEVEL3 file into the same pieces encode() takes.
+
+    Returns a dict with w, h, mat, palette, dd, dv, ramps, da (absent
+    layers are None / []).  Raises ValueError on malformed input.
+    """
+    if data[:8] != TILED_MAGIC:
+        raise ValueError("not an OLLEVEL3 file")
+    version, w, h, ts, flags = struct.unpack_from("<BHHHB", data, 8)
+    if version != 0 or not (1 <= w <= MAX_DIM and 1 <= h <= MAX_DIM and 1 <= ts <= MAX_DIM):
+        raise ValueError("bad OLLEVEL3 header")
+    pos = 16
+    palette = None
+    if flags & FLAG_PALETTE:
+        palette = data[pos:pos + 768]
+        pos += 768
+
+    width = 0
+    values: list[int] = []
+    ramps: list[tuple[int, list[int]]] = []
+    if flags & FLAG_DISPLAY:
+        width = data[pos]
+        pos += 1
+        if width not in (1, 2, RAW_DISPLAY):
+            raise ValueError(f"bad display index width {width}")
+        if width != RAW_DISPLAY:
+            (count,) = struct.unpack_from("<I", data, pos)
+            values = list(struct.unpack_from(f"<{count}I", data, pos + 4))
+            pos += 4 + count * 4
+        ramp_count = data[pos]
+        pos += 1
+        for _ in range(ramp_count):
+            shift, n = struct.unpack_from("<BH", data, pos)
+            ramps.append((shift, list(struct.unpack_from(f"<{n}I", data, pos + 3))))
+            pos += 3 + n * 4
+    n_planes = 1 + width + (1 if width == RAW_DISPLAY else 0) + (1 if ramps else 0)
+
+    tiles = list(_tiles(w, h, ts))
+    directory = [struct.unpack_from("<II", data, pos + i * 8) for i in range(len(tiles))]
+    base = pos + len(tiles) * 8
+
+    cells = w * h
+    planes = [bytearray(cells) for _ in range(n_planes)]
+    for (tx, ty, tw, th), (off, size) in zip(tiles, directory):
+        payload = data[base + off:base + off + size]
+        (packed_size,) = struct.unpack_from("<I", payload)
+        packed = zlib.decompress(payload[4:])
+        if len(packed) != packed_size:
+            raise ValueError("tile packed size mismatch")
+        n = tw * th
+        raw = unpack_bits(packed, n * n_planes)
+        for p in range(n_planes):
+            src = raw[p * n:(p + 1) * n]
+            for y in range(th):
+                dst = (ty + y) * w + tx
+                planes[p][dst:dst + tw] = src[y * tw:(y + 1) * tw]
+
+    out = {"w": w, "h": h, "mat": bytes(planes[0]), "palette": palette,
+           "dd": None, "dv": None, "ramps": ramps, "da": None}
+    if width == RAW_DISPLAY:
+        dd = bytearray(cells * 4)
+        for b in range(4):
+            dd[b::4] = planes[1 + b]
+        out["dd"], out["dv"] = bytes(dd), bytes(planes[5])
+    elif width:
+        idx = planes[1] if width == 1 else [lo | (hi << 8) for lo, hi in zip(planes[1], planes[2])]
+        out["dd"] = struct.pack(f"<{cells}I", *(values[i - 1] if i else 0 for i in idx))
+        out["dv"] = bytes(1 if i else 0 for i in idx)
+    if ramps:
+        out["da"] = bytes(planes[-1])
+    return out